@@ -46,6 +46,7 @@ struct GraphRenderSequence
     struct Context
     {
         FloatType** audioBuffers;
+        const int* audioBufferSizes;
         MidiBuffer* midiBuffers;
         AudioPlayHead* audioPlayHead;
         int numSamples;
@@ -83,7 +84,7 @@ struct GraphRenderSequence
         currentMidiOutputBuffer.clear();
 
         {
-            const Context context { renderingBuffer.getArrayOfWritePointers(), midiBuffers.begin(), audioPlayHead, numSamples };
+            const Context context { renderingBuffer.getArrayOfWritePointers(), bufferSizes.begin(), midiBuffers.begin(), audioPlayHead, numSamples };
 
             for (auto* op : renderOps)
                 op->perform (context);
@@ -97,23 +98,31 @@ struct GraphRenderSequence
         currentAudioInputBuffer = nullptr;
     }
 
+    // Open Ephys: buffers carrying low-rate streams only use a fraction of the block,
+    // so channel operations only touch the samples reserved for each buffer
+
     void addClearChannelOp (int index)
     {
-        createOp ([=] (const Context& c)    { FloatVectorOperations::clear (c.audioBuffers[index], c.numSamples); });
+        createOp ([=] (const Context& c)    { FloatVectorOperations::clear (c.audioBuffers[index],
+                                                                            jmin (c.numSamples, c.audioBufferSizes[index])); });
     }
 
     void addCopyChannelOp (int srcIndex, int dstIndex)
     {
         createOp ([=] (const Context& c)    { FloatVectorOperations::copy (c.audioBuffers[dstIndex],
                                                                            c.audioBuffers[srcIndex],
-                                                                           c.numSamples); });
+                                                                           jmin (c.numSamples,
+                                                                                 c.audioBufferSizes[srcIndex],
+                                                                                 c.audioBufferSizes[dstIndex])); });
     }
 
     void addAddChannelOp (int srcIndex, int dstIndex)
     {
         createOp ([=] (const Context& c)    { FloatVectorOperations::add (c.audioBuffers[dstIndex],
                                                                           c.audioBuffers[srcIndex],
-                                                                          c.numSamples); });
+                                                                          jmin (c.numSamples,
+                                                                                c.audioBufferSizes[srcIndex],
+                                                                                c.audioBufferSizes[dstIndex])); });
     }
 
     void addClearMidiBufferOp (int index)
@@ -145,8 +154,19 @@ struct GraphRenderSequence
 
     void prepareBuffers (int blockSize)
     {
+        // Open Ephys: every channel still has room for a full block, because processors
+        // see the whole buffer and may use its length. The number of samples reserved for
+        // each buffer by the RenderSequenceBuilder (based on the sample rates of the streams
+        // it carries) only limits how much of it the graph clears and copies.
+        while (bufferSizes.size() < numBuffersNeeded + 1)
+            bufferSizes.add (blockSize);
+
+        for (auto& size : bufferSizes)
+            size = jlimit (0, blockSize, size);
+
         renderingBuffer.setSize (numBuffersNeeded + 1, blockSize);
         renderingBuffer.clear();
+
         currentAudioOutputBuffer.setSize (numBuffersNeeded + 1, blockSize);
         currentAudioOutputBuffer.clear();
 
@@ -177,6 +197,9 @@ struct GraphRenderSequence
 
     int numBuffersNeeded = 0, numMidiBuffersNeeded = 0;
 
+    /** Number of samples reserved for each audio buffer (Open Ephys) */
+    Array<int> bufferSizes;
+
     AudioBuffer<FloatType> renderingBuffer, currentAudioOutputBuffer;
     AudioBuffer<FloatType>* currentAudioInputBuffer = nullptr;
 
@@ -229,7 +252,7 @@ private:
         {
             auto* data = c.audioBuffers[channel];
 
-            for (int i = c.numSamples; --i >= 0;)
+            for (int i = jmin (c.numSamples, c.audioBufferSizes[channel]); --i >= 0;)
             {
                 buffer[writeIndex] = *data;
                 *data++ = buffer[readIndex];
@@ -274,9 +297,16 @@ private:
             AudioBuffer<FloatType> buffer (audioChannels, totalChans, c.numSamples);
 
             if (processor.isSuspended())
-                buffer.clear();
+            {
+                // only clear the samples each channel carries (Open Ephys)
+                for (int i = 0; i < totalChans; ++i)
+                    FloatVectorOperations::clear (audioChannels[i],
+                                                  jmin (c.numSamples, c.audioBufferSizes[audioChannelsToUse.getUnchecked (i)]));
+            }
             else
+            {
                 callProcess (buffer, c.midiBuffers[midiBufferToUse]);
+            }
         }
 
         void callProcess (AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
@@ -341,7 +371,9 @@ template <typename RenderSequence>
 struct RenderSequenceBuilder
 {
     RenderSequenceBuilder (AudioProcessorGraph& g, RenderSequence& s)
-        : graph (g), sequence (s)
+        : graph (g), sequence (s),
+          sampleRate (g.getSampleRate()),
+          blockSize (g.getBlockSize())
     {
 
         LOGG("Creating rendering sequence for graph");
@@ -358,6 +390,8 @@ struct RenderSequenceBuilder
         audioBuffers.add (AssignedBuffer::createReadOnlyEmpty()); // first buffer is read-only zeros
         midiBuffers .add (AssignedBuffer::createReadOnlyEmpty());
 
+        audioBuffers.getReference (readOnlyEmptyBufferIndex).numSamples = blockSize;
+
         int64 start2 = Time::getHighResolutionTicks();
 
         cachedConnections = graph.getConnections();
@@ -382,6 +416,9 @@ struct RenderSequenceBuilder
         s.numBuffersNeeded = audioBuffers.size();
         s.numMidiBuffersNeeded = midiBuffers.size();
 
+        for (auto& b : audioBuffers)
+            s.bufferSizes.add (b.numSamples);
+
         interval = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
 
         LOGG("Finished building rendering sequence in ", interval * 1000, " milliseconds.");
@@ -393,6 +430,10 @@ struct RenderSequenceBuilder
     AudioProcessorGraph& graph;
     RenderSequence& sequence;
 
+    /** Rate and block size the sequence is built for (used to size the buffers of each stream) */
+    const double sampleRate;
+    const int blockSize;
+
     /** Holds information about whether streams are needed later, to speed up rendering ops.
 
         Custom member added for Open Ephys GUI.
@@ -411,15 +452,23 @@ struct RenderSequenceBuilder
     {
         AudioProcessorGraph::NodeAndChannel channel;
 
+        /** Outputs of pass-through nodes that share this buffer with 'channel' */
+        Array<AudioProcessorGraph::NodeAndChannel> aliases;
+
+        /** Largest number of samples per block of any channel this buffer has carried
+            (kept when the buffer is freed, as it describes the buffer rather than its contents) */
+        int numSamples = 0;
+
         static AssignedBuffer createReadOnlyEmpty() noexcept    { return { { zeroNodeID(), 0 } }; }
         static AssignedBuffer createFree() noexcept             { return { { freeNodeID(), 0 } }; }
 
         bool isReadOnlyEmpty() const noexcept                   { return channel.nodeID == zeroNodeID(); }
         bool isFree() const noexcept                            { return channel.nodeID == freeNodeID(); }
         bool isAssigned() const noexcept                        { return ! (isReadOnlyEmpty() || isFree()); }
+        bool contains (AudioProcessorGraph::NodeAndChannel c) const noexcept { return channel == c || aliases.contains (c); }
 
-        void setFree() noexcept                                 { channel = { freeNodeID(), 0 }; }
-        void setAssignedToNonExistentNode() noexcept            { channel = { anonNodeID(), 0 }; }
+        void setFree() noexcept                                 { channel = { freeNodeID(), 0 }; aliases.clearQuick(); }
+        void setAssignedToNonExistentNode() noexcept            { channel = { anonNodeID(), 0 }; aliases.clearQuick(); }
 
     private:
         static NodeID anonNodeID() { return NodeID (0x7ffffffd); }
@@ -510,12 +559,16 @@ struct RenderSequenceBuilder
                 jassert (bufIndex >= 0);
             }
 
+            // a pass-through node only reads its inputs, so it can share the buffer
+            // with other nodes that need it later
             if (inputChan < numOuts
-                 && isBufferNeededLater (ourRenderingIndex, inputChan, src))
+                 && ! (isPassThrough (node) && bufIndex != readOnlyEmptyBufferIndex)
+                 && isBufferNeededLater (ourRenderingIndex, inputChan, src, bufIndex))
             {
                 // can't mess up this channel because it's needed later by another node,
                 // so we need to use a copy of it..
                 auto newFreeBuffer = getFreeBuffer (audioBuffers);
+                reserveSamples (newFreeBuffer, getChannelSize (src));
                 sequence.addCopyChannelOp (bufIndex, newFreeBuffer);
                 //std::cout << "      Buffer is needed later." << std::endl;
                 bufIndex = newFreeBuffer;
@@ -538,7 +591,7 @@ struct RenderSequenceBuilder
             auto src = sources.getReference(i);
             auto sourceBufIndex = getBufferContaining (src);
 
-            if (sourceBufIndex >= 0 && ! isBufferNeededLater (ourRenderingIndex, inputChan, src))
+            if (sourceBufIndex >= 0 && ! isBufferNeededLater (ourRenderingIndex, inputChan, src, sourceBufIndex))
             {
                 // we've found one of our input chans that can be re-used..
                 reusableInputIndex = i;
@@ -563,6 +616,8 @@ struct RenderSequenceBuilder
 
             auto srcIndex = getBufferContaining (sources.getFirst());
 
+            reserveSamples (bufIndex, getChannelSize (sources.getFirst()));
+
             if (srcIndex < 0)
                 sequence.addClearChannelOp (bufIndex);  // if not found, this is probably a feedback loop
             else
@@ -595,12 +650,14 @@ struct RenderSequenceBuilder
                         else // buffer is reused elsewhere, can't be delayed
                         {
                             auto bufferToDelay = getFreeBuffer (audioBuffers);
+                            reserveSamples (bufferToDelay, getChannelSize (src));
                             sequence.addCopyChannelOp (srcIndex, bufferToDelay);
                             sequence.addDelayChannelOp (bufferToDelay, maxLatency - nodeDelay);
                             srcIndex = bufferToDelay;
                         }
                     }
 
+                    reserveSamples (bufIndex, getChannelSize (src));
                     sequence.addAddChannelOp (srcIndex, bufIndex);
                 }
             }
@@ -740,7 +797,20 @@ struct RenderSequenceBuilder
 
             if (inputChan < numOuts)
             {
-                audioBuffers.getReference(index).channel = { node.nodeID, inputChan };
+                reserveSamples (index, getChannelSize ({ node.nodeID, inputChan }));
+
+                auto& buffer = audioBuffers.getReference (index);
+
+                if (isPassThrough (node) && buffer.isAssigned())
+                {
+                    // the data is unchanged, so this output is just another name for the buffer
+                    buffer.aliases.add ({ node.nodeID, inputChan });
+                }
+                else
+                {
+                    buffer.channel = { node.nodeID, inputChan };
+                    buffer.aliases.clearQuick();
+                }
             }
                 
         }
@@ -759,6 +829,8 @@ struct RenderSequenceBuilder
             jassert (index != 0);
             audioChannelsToUse.add (index);
 
+            reserveSamples (index, getChannelSize ({ node.nodeID, outputChan }));
+
             audioBuffers.getReference (index).channel = { node.nodeID, outputChan };
         }
 
@@ -803,6 +875,23 @@ struct RenderSequenceBuilder
         return results;
     }
 
+    /** Number of samples per block needed by a node's output channel, based on the
+        sample rate of its stream (Open Ephys) */
+    int getChannelSize (AudioProcessorGraph::NodeAndChannel output)
+    {
+        if (auto* node = graph.getNodeForId (output.nodeID))
+            return ProcessorGraph::getMaxSamplesForChannel (*node, output.channelIndex, sampleRate, blockSize);
+
+        return blockSize;
+    }
+
+    /** Makes sure an audio buffer can hold at least numSamples samples per block */
+    void reserveSamples (int bufIndex, int numSamples)
+    {
+        auto& buffer = audioBuffers.getReference (bufIndex);
+        buffer.numSamples = jmax (buffer.numSamples, numSamples);
+    }
+
     static int getFreeBuffer (Array<AssignedBuffer>& buffers)
     {
         for (int i = 1; i < buffers.size(); ++i)
@@ -820,7 +909,7 @@ struct RenderSequenceBuilder
 
         for (auto& b : output.isMIDI() ? midiBuffers : audioBuffers)
         {
-            if (b.channel == output)
+            if (b.contains (output))
                 return i;
 
             ++i;
@@ -836,7 +925,7 @@ struct RenderSequenceBuilder
 
         for (auto& b : buffers)
         {
-            if (b.isAssigned() && !isBufferNeededLater(stepIndex, -1, b.channel))
+            if (b.isAssigned() && !isBufferNeededLater(stepIndex, -1, b.channel) && !isAnyAliasNeededLater (stepIndex, -1, b))
             {
                 //std::cout << "  Freeing " << b.channel.nodeID.uid << " : " << b.channel.channelIndex << std::endl;
                 b.setFree();
@@ -850,6 +939,45 @@ struct RenderSequenceBuilder
             
     }
 
+    /** True if the node was flagged by the ProcessorGraph as never writing to its continuous channels */
+    static bool isPassThrough (AudioProcessorGraph::Node& node)
+    {
+        return node.properties.getWithDefault ("pass_through", false);
+    }
+
+    bool isAnyAliasNeededLater (int stepIndexToSearchFrom,
+                                int inputChannelOfIndexToIgnore,
+                                const AssignedBuffer& buffer)
+    {
+        for (auto& alias : buffer.aliases)
+            if (isBufferNeededLater (stepIndexToSearchFrom, inputChannelOfIndexToIgnore, alias))
+                return true;
+
+        return false;
+    }
+
+    /** Same as below, but also checks every other output that shares the buffer containing 'output' */
+    bool isBufferNeededLater (int stepIndexToSearchFrom,
+                              int inputChannelOfIndexToIgnore,
+                              AudioProcessorGraph::NodeAndChannel output,
+                              int bufIndex)
+    {
+        if (isBufferNeededLater (stepIndexToSearchFrom, inputChannelOfIndexToIgnore, output))
+            return true;
+
+        if (bufIndex <= readOnlyEmptyBufferIndex || bufIndex >= audioBuffers.size())
+            return false;
+
+        auto& buffer = audioBuffers.getReference (bufIndex);
+
+        if (buffer.channel != output
+             && buffer.isAssigned()
+             && isBufferNeededLater (stepIndexToSearchFrom, inputChannelOfIndexToIgnore, buffer.channel))
+            return true;
+
+        return isAnyAliasNeededLater (stepIndexToSearchFrom, inputChannelOfIndexToIgnore, buffer);
+    }
+
     bool isBufferNeededLater (int stepIndexToSearchFrom,
                               int inputChannelOfIndexToIgnore,
                               AudioProcessorGraph::NodeAndChannel output) 
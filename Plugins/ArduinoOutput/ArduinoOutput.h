@@ -50,6 +50,9 @@ public:
     /** Searches for events and triggers the Arduino output when appropriate. */
     void process (AudioBuffer<float>& buffer) override;
 
+    /** Does not modify the continuous data */
+    bool isPassThrough() const override { return true; }
+
     /** Handle changes to gate line. */
     void parameterValueChanged(Parameter* parameter) override;
 
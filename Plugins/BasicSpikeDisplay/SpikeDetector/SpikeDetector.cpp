@@ -281,65 +281,77 @@ void SpikeDetector::parameterValueChanged(Parameter* p)
     }
     else if (p->getName().contains("threshold"))
     {
-        
-        FloatParameter* param = (FloatParameter*) p;
-        SpikeChannel* spikeChannel = p->getSpikeChannel();
-        
-        int channelIndex = p->getName().getTrailingIntValue() - 1;
-
-        spikeChannel->thresholder->setThreshold(channelIndex, param->getFloatValue());
+        // applied at the start of the next block
+        queueParameterChange(p);
     }
     else if (p->getName().equalsIgnoreCase("thrshlder_type"))
     {
         
         CategoricalParameter* param = (CategoricalParameter*) p;
         SpikeChannel* spikeChannel = p->getSpikeChannel();
+
+        ThresholderUpdate* update = new ThresholderUpdate();
+
+        String prefix;
         
         if (param->getSelectedString().equalsIgnoreCase("ABS"))
         {
-            spikeChannel->thresholder.reset();
-            spikeChannel->thresholder =
+            update->thresholder =
                 std::make_unique<AbsValueThresholder>(
                 spikeChannel->getNumChannels());
-            
-            for (int ch = 0; ch < spikeChannel->getNumChannels(); ch++)
-            {
-                spikeChannel->thresholder->setThreshold(
-                    ch,
-                    (float) spikeChannel->getParameter("abs_threshold" + String(ch+1))->getValue());
-            }
+            prefix = "abs";
         } else if (param->getSelectedString().equalsIgnoreCase("STD"))
         {
-            spikeChannel->thresholder.reset();
-            spikeChannel->thresholder =
+            update->thresholder =
                 std::make_unique<StdDevThresholder>(
                 spikeChannel->getNumChannels());
-            
-            for (int ch = 0; ch < spikeChannel->getNumChannels(); ch++)
-            {
-                spikeChannel->thresholder->setThreshold(
-                    ch,
-                    (float) spikeChannel->getParameter("std_threshold" + String(ch+1))->getValue());
-            }
-        } else if (param->getSelectedString().equalsIgnoreCase("STD"))
+            prefix = "std";
+        } else if (param->getSelectedString().equalsIgnoreCase("DYN"))
         {
-            spikeChannel->thresholder.reset();
-            spikeChannel->thresholder =
+            update->thresholder =
                 std::make_unique<DynamicThresholder>(
                 spikeChannel->getNumChannels());
+            prefix = "dyn";
+        }
+        else
+        {
+            delete update;
+            return;
+        }
             
-            for (int ch = 0; ch < spikeChannel->getNumChannels(); ch++)
-            {
-                spikeChannel->thresholder->setThreshold(
-                    ch,
-                    (float) spikeChannel->getParameter("dyn_threshold" + String(ch+1))->getValue());
-            }
+        for (int ch = 0; ch < spikeChannel->getNumChannels(); ch++)
+        {
+            update->thresholder->setThreshold(
+                ch,
+                (float) spikeChannel->getParameter(prefix + "_threshold" + String(ch+1))->getValue());
         }
+
+        // the old thresholder is deleted on the message thread once it has been replaced
+        queueParameterChange(p, update);
         
     }
         
 }
 
+void SpikeDetector::applyParameterChange(ParameterChange& change)
+{
+    SpikeChannel* spikeChannel = change.parameter->getSpikeChannel();
+
+    if (spikeChannel == nullptr)
+        return;
+
+    if (ThresholderUpdate* update = dynamic_cast<ThresholderUpdate*>(change.state))
+    {
+        std::swap(spikeChannel->thresholder, update->thresholder);
+    }
+    else if (spikeChannel->thresholder != nullptr)
+    {
+        int channelIndex = change.parameter->getName().getTrailingIntValue() - 1;
+
+        spikeChannel->thresholder->setThreshold(channelIndex, (float) change.value);
+    }
+}
+
 void SpikeDetector::updateSettings()
 {
     settings.update(getDataStreams());
@@ -46,6 +46,14 @@ enum ThresholderType {
     DYN
 };
 
+/** A thresholder created on the message thread, which replaces a
+    spike channel's thresholder at the start of a block*/
+class ThresholderUpdate : public PreparedParameterState
+{
+public:
+    std::unique_ptr<Thresholder> thresholder;
+};
+
 
 /** 
     Thresholder based on signal absolute value.
@@ -198,12 +206,18 @@ public:
     /** Processes an incoming continuous buffer and places new spikes into the event buffer. */
     void process (AudioBuffer<float>& buffer) override;
 
+    /** Only reads the continuous data (overflow samples are copied to a separate buffer) */
+    bool isPassThrough() const override { return true; }
+
     /** Called whenever the signal chain is altered. */
     void updateSettings() override;
     
     /** Parameter changed */
     void parameterValueChanged(Parameter* p) override;
 
+    /** Applies threshold changes and swaps in new thresholders on the audio thread */
+    void applyParameterChange(ParameterChange& change) override;
+
     /** Called when acquisition is started*/
     bool startAcquisition() override;
 
@@ -193,7 +193,7 @@ void SpikeDisplay::refresh()
 }
 
 
-void SpikeDisplay::plotSpike(const Spike* spike, int electrodeNum)
+void SpikeDisplay::plotSpike(const SpikeSnapshot& spike, int electrodeNum)
 {
     spikePlots[electrodeNum]->processSpikeObject(spike);
 }
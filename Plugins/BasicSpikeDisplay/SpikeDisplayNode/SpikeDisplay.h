@@ -69,7 +69,7 @@ public:
     void refresh();
 
     /** Sends a spike to a given spike plot*/
-    void plotSpike(const Spike* spike, int electrodeNum);
+    void plotSpike(const SpikeSnapshot& spike, int electrodeNum);
 
     /** Tells available plots to reverse spike direction*/
     void invertSpikes(bool);
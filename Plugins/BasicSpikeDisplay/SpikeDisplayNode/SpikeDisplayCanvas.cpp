@@ -129,17 +129,13 @@ void SpikeDisplayCanvas::update()
     int scrollHeight = viewport->getViewPositionY();
 
     int nPlots = processor->getNumElectrodes();
-    
-    processor->removeSpikePlots();
 
     spikeDisplay->removePlots();
 
     for (int i = 0; i < nPlots; i++)
     {
-        SpikePlot* sp = spikeDisplay->addSpikePlot(processor->getNumberOfChannelsForElectrode(i), i,
-                                                   processor->getNameForElectrode(i), processor->getSpikeChannel(i)->getIdentifier().toStdString());
-
-        processor->addSpikePlotForElectrode(sp, i);
+        spikeDisplay->addSpikePlot(processor->getNumberOfChannelsForElectrode(i), i,
+                                   processor->getNameForElectrode(i), processor->getSpikeChannel(i)->getIdentifier().toStdString());
 
         std::string cacheKey = processor->getSpikeChannel(i)->getIdentifier().toStdString();
 
@@ -24,7 +24,6 @@
 #include "SpikeDisplayNode.h"
 
 #include "SpikeDisplayEditor.h"
-#include "SpikePlots.h"
 
 #include <stdio.h>
 
@@ -47,8 +46,9 @@ AudioProcessorEditor* SpikeDisplayNode::createEditor()
 void SpikeDisplayNode::updateSettings()
 {
     electrodes.clear();
-    electrodeMap.clear();
+    electrodeForSpikeChannel.clearQuick();
 
+    // the position in spikeChannels becomes each channel's global index
 	for (auto spikeChannel : spikeChannels)
 	{
 
@@ -59,9 +59,17 @@ void SpikeDisplayNode::updateSettings()
             elec->numChannels = spikeChannel->getNumChannels();
             elec->name = spikeChannel->getName();
             elec->spikeChannel = spikeChannel;
+            elec->spikeRing = std::make_unique<SpikeSnapshotRing>(spikeChannel->getNumChannels(),
+                                                                  spikeChannel->getTotalSamples(),
+                                                                  SpikeSnapshotRing::DEFAULT_CAPACITY);
 
+            electrodeForSpikeChannel.add(electrodes.size());
             electrodes.add(elec);
         }
+        else
+        {
+            electrodeForSpikeChannel.add(-1);
+        }
 	}
 }
 
@@ -70,9 +78,9 @@ bool SpikeDisplayNode::startAcquisition()
 {
     SpikeDisplayEditor* editor = (SpikeDisplayEditor*) getEditor();
 
-	for (int i = 0; i < spikeChannels.size(); i ++)
+	for (auto elec : electrodes)
 	{
-		Electrode* elec = electrodes[i];
+		elec->spikeRing->reset();
 	}
 
     editor->enable();
@@ -142,21 +150,15 @@ String SpikeDisplayNode::getNameForElectrode (int i) const
 }
 
 
-void SpikeDisplayNode::addSpikePlotForElectrode (SpikePlot* sp, int i)
-{
-    Electrode* electrode = electrodes[i];
-    electrode->spikePlot = sp;
-
-    electrodeMap[electrode->spikeChannel] = sp;
-}
-
-
-void SpikeDisplayNode::removeSpikePlots()
+SpikeSnapshotRing* SpikeDisplayNode::getSpikeRing (int i) const
 {
-    for (int i = 0; i < getNumElectrodes(); ++i)
+    if (i > -1 && i < electrodes.size())
+    {
+        return electrodes[i]->spikeRing.get();
+    }
+    else
     {
-        Electrode* e = electrodes[i];
-        e->spikePlot = nullptr;
+        return nullptr;
     }
 }
 
@@ -177,7 +179,14 @@ void SpikeDisplayNode::process (AudioBuffer<float>& buffer)
 
 void SpikeDisplayNode::handleSpike(SpikePtr spike)
 {
-    if(electrodeMap.count(spike->getChannelInfo()) > 0)
-        electrodeMap.at(spike->getChannelInfo())->addSpikeToBuffer(spike);
+    const int channelIndex = spike->getChannelInfo()->getGlobalIndex();
+
+    if (channelIndex < 0 || channelIndex >= electrodeForSpikeChannel.size())
+        return;
+
+    const int electrodeIndex = electrodeForSpikeChannel.getUnchecked(channelIndex);
+
+    if (electrodeIndex >= 0)
+        electrodes.getUnchecked(electrodeIndex)->spikeRing->push(*spike);
 }
 
@@ -26,8 +26,9 @@
 
 #include <ProcessorHeaders.h>
 
+#include "SpikeSnapshotRing.h"
+
 class DataViewport;
-class SpikePlot;
 
 /**
   Looks for incoming Spike events and draws them to the SpikeDisplayCanvas.
@@ -49,10 +50,13 @@ public:
     /** Sends incoming spikes to the SpikeDisplayCanvas */
     void process (AudioBuffer<float>& buffer) override;
 
+    /** Does not modify the continuous data */
+    bool isPassThrough() const override { return true; }
+
     /** Informs the SpikeDisplayNode when a redraw is needed*/
     void setParameter(int, float) override;
 
-    /** Called for each incoming spike*/
+    /** Copies each incoming spike into its electrode's ring (no allocation, no locks)*/
 	void handleSpike(SpikePtr spike) override;
 
     /** Creates a display for each incoming spike channel*/
@@ -73,11 +77,8 @@ public:
     /** Returns the total number of available electrodes*/
     int getNumElectrodes() const;
 
-    /** Sets the corresponding spike plot for an electrode*/
-    void addSpikePlotForElectrode (SpikePlot* sp, int i);
-
-    /** Removes pointers to SpikePlot objects*/
-    void removeSpikePlots();
+    /** Returns the ring holding the latest spikes for an electrode, or nullptr if the index is invalid*/
+    SpikeSnapshotRing* getSpikeRing (int i) const;
 
 private:
     
@@ -87,13 +88,15 @@ private:
 
         int numChannels;
 
-        SpikePlot* spikePlot;
         SpikeChannel* spikeChannel;
+
+        std::unique_ptr<SpikeSnapshotRing> spikeRing;
     };
 
     OwnedArray<Electrode> electrodes;
 
-    std::map<const SpikeChannel*, SpikePlot*> electrodeMap;
+    /** Electrode index for each spike channel (by global index), or -1 */
+    Array<int> electrodeForSpikeChannel;
 
     int spikeCount;
     int totalCallbacks;
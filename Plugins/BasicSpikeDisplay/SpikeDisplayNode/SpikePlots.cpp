@@ -27,6 +27,32 @@
 #include "SpikeDisplayCanvas.h"
 #include "SpikeDisplayNode.h"
 
+// Fraction of a waveform's brightness that remains after each frame
+#define WAVEFORM_DECAY 0.85f
+
+// Brightness added by a single waveform (1 = full colour)
+#define WAVEFORM_INTENSITY 0.5f
+
+// Number of frames after which a waveform has faded to black
+#define WAVEFORM_PERSISTENCE_FRAMES 40
+
+// Maximum number of projection points drawn per frame
+#define MAX_PROJECTION_POINTS_PER_FRAME 64
+
+namespace
+{
+    /** Adds a colour to an RGB pixel, saturating at full brightness */
+    inline void addToPixel(uint8* pixel, int red, int green, int blue)
+    {
+        PixelRGB* p = reinterpret_cast<PixelRGB*>(pixel);
+
+        p->setARGB(255,
+                   (uint8) jmin(255, p->getRed() + red),
+                   (uint8) jmin(255, p->getGreen() + green),
+                   (uint8) jmin(255, p->getBlue() + blue));
+    }
+}
+
 SpikePlot::SpikePlot(SpikeDisplayCanvas* sdc, 
                      int elecNum, 
                      int p, 
@@ -92,8 +118,6 @@ SpikePlot::SpikePlot(SpikeDisplayCanvas* sdc,
     monitorButton->addListener(this);
     addAndMakeVisible(monitorButton.get());
 
-    mostRecentSpikes.ensureStorageAllocated(bufferSize);
-
 }
 
 SpikePlot::~SpikePlot()
@@ -123,27 +147,30 @@ void SpikePlot::paint(Graphics& g)
 void SpikePlot::refresh()
 {
 
-    {
-        const ScopedLock myScopedLock(spikeArrayLock);
+    for (auto ax : waveAxes)
+        ax->advanceFrame();
 
-        for (auto spike : mostRecentSpikes)
+    // the ring only keeps the most recent spikes, which bounds the work per frame
+    if (SpikeSnapshotRing* ring = canvas->processor->getSpikeRing(electrodeNumber))
+    {
+        while (ring->pop(snapshot))
         {
-            processSpikeObject(spike);
+            processSpikeObject(snapshot);
         }
-
-        mostRecentSpikes.clearQuick(true);
-        spikesInBuffer = 0;
     }
+
+    for (auto ax : projectionAxes)
+        ax->drawPendingPoints();
     
     repaint();
 }
 
-void SpikePlot::processSpikeObject(const Spike* s)
+void SpikePlot::processSpikeObject(const SpikeSnapshot& s)
 {
 
-    for (int i = 0; i < waveAxes.size(); ++i)
+    for (int i = 0; i < jmin(waveAxes.size(), s.numChannels); ++i)
     {
-        setDetectorThresholdForChannel(i, s->getThreshold(i));
+        setDetectorThresholdForChannel(i, s.getThreshold(i));
     }
 
     // first, check if it's above threshold
@@ -165,17 +192,6 @@ void SpikePlot::processSpikeObject(const Spike* s)
 
 }
 
-void SpikePlot::addSpikeToBuffer(const Spike* spike)
-{
-    if (spikesInBuffer < bufferSize)
-    {
-        const ScopedLock myScopedLock(spikeArrayLock);
-
-        mostRecentSpikes.add(new Spike(*spike));
-        spikesInBuffer++;
-    }
-}
-
 void SpikePlot::initAxes()
 {
     initLimits();
@@ -547,9 +563,8 @@ WaveAxes::WaveAxes(SpikeDisplayCanvas* canvas, int electrodeIndex, int channel_,
     drawGrid(true),
     displayThresholdLevel(0.0f),
     detectorThresholdLevel(0.0f),
-    spikesReceivedSinceLastRedraw(0),
-    spikeIndex(0),
-    bufferSize(5),
+    pendingDecaySteps(0),
+    framesSinceLastSpike(WAVEFORM_PERSISTENCE_FRAMES),
     range(250.0f),
     isOverThresholdSlider(false),
     isDraggingThresholdSlider(false),
@@ -563,24 +578,35 @@ WaveAxes::WaveAxes(SpikeDisplayCanvas* canvas, int electrodeIndex, int channel_,
     thresholdColour = Colours::red;
 
     font = Font("Small Text",10,Font::plain);
-
-    for (int n = 0; n < bufferSize; n++)
-    {
-        spikeBuffer.add(nullptr);
-    }
 }
 
 void WaveAxes::setRange(float r)
 {
     range = r;
 
-    repaint();
+    // the waveforms drawn so far no longer match the axes
+    clear();
+}
+
+void WaveAxes::resized()
+{
+    if (getWidth() > 0 && getHeight() > 0)
+        persistenceImage = Image(Image::RGB, getWidth(), getHeight(), true, SoftwareImageType());
+    else
+        persistenceImage = Image();
+
+    framesSinceLastSpike = WAVEFORM_PERSISTENCE_FRAMES;
+    pendingDecaySteps = 0;
 }
 
 void WaveAxes::paint(Graphics& g)
 {
-    g.setColour(Colours::black);
-    g.fillRect(0,0,getWidth(), getHeight());
+    applyDecay();
+
+    if (persistenceImage.isValid())
+        g.drawImageAt(persistenceImage, 0, 0);
+    else
+        g.fillAll(Colours::black);
 
     // draw the grid lines for the waveforms
     if (drawGrid)
@@ -589,94 +615,114 @@ void WaveAxes::paint(Graphics& g)
     // draw the threshold line and labels
     drawThresholdSlider(g);
 
-    // if no spikes have been received then don't plot anything
-    if (!gotFirstSpike)
+}
+
+void WaveAxes::advanceFrame()
+{
+    if (framesSinceLastSpike < WAVEFORM_PERSISTENCE_FRAMES)
     {
-        return;
+        framesSinceLastSpike++;
+        pendingDecaySteps++;
     }
+}
 
-    for (int spikeNum = 0; spikeNum < bufferSize; spikeNum++)
+void WaveAxes::applyDecay()
+{
+    if (pendingDecaySteps == 0 || !persistenceImage.isValid())
+        return;
+
+    if (framesSinceLastSpike >= WAVEFORM_PERSISTENCE_FRAMES)
+    {
+        // everything has faded out
+        persistenceImage.clear(persistenceImage.getBounds());
+    }
+    else
     {
+        // the decay of several frames is applied in one pass, so hidden plots cost nothing
+        const float factor = std::pow(WAVEFORM_DECAY, float(pendingDecaySteps));
 
-        if (spikeNum != spikeIndex)
+        uint8 table[256];
+
+        for (int i = 0; i < 256; i++)
+            table[i] = (uint8) (i * factor);
+
+        Image::BitmapData bitmap(persistenceImage, Image::BitmapData::readWrite);
+
+        const int bytesPerLine = bitmap.width * bitmap.pixelStride;
+
+        for (int y = 0; y < bitmap.height; y++)
         {
-            plotSpike(spikeBuffer[spikeNum], g);
-        }
+            uint8* line = bitmap.getLinePointer(y);
 
+            for (int i = 0; i < bytesPerLine; i++)
+                line[i] = table[line[i]];
+        }
     }
 
-    plotSpike(spikeBuffer[spikeIndex], g);
-    
-    spikesReceivedSinceLastRedraw = 0;
-
+    pendingDecaySteps = 0;
 }
 
-void WaveAxes::plotSpike(const Spike* s, Graphics& g)
+void WaveAxes::plotSpike(const SpikeSnapshot& s)
 {
-	if (!s) return;
-
-    float h = getHeight();
+    if (!persistenceImage.isValid() || channel >= s.numChannels)
+        return;
 
-    const SpikeChannel* sc = s->getChannelInfo();
+    const int nSamples = s.numSamples;
 
-    if (sc == nullptr)
+    if (nSamples < 2)
         return;
 
-    //compute the spatial width for each waveform sample
-	int nSamples = sc->getTotalSamples();
-	float dx = getWidth() / float(nSamples);
+    // older waveforms must be faded before the new one is added
+    applyDecay();
 
-    if (s->getSortedId() > 0)
-        g.setColour(colours[(s->getSortedId() - 1) % 8]);
-    else
-       g.setColour(Colours::white);
+    framesSinceLastSpike = 0;
 
-    // type corresponds to channel so we need to calculate the starting
-    // sample based upon which channel is getting plotted
-    int sampIdx = nSamples * channel; 
-    
-    int dataSize =s->getChannelInfo()->getDataSize();
-    
-    // prevent crashes when acquisition is not active,
-    // or immediately after acquisition starts
-    //if (   (dataSize < 1)
-    //    || (dataSize > 640)
-    //    || (sampIdx + nSamples > dataSize)
-    //    || (nSamples < 0))
-    //{
-    //    return;
-    //}
-        
-    int dSamples = 1;
-
-    float x = 0.0f;
-	const float* data = s->getDataPointer();
+    Colour colour = Colours::white;
+
+    if (s.sortedId > 0)
+        colour = colours[(s.sortedId - 1) % 8];
+
+    const int red = roundToInt(colour.getRed() * WAVEFORM_INTENSITY);
+    const int green = roundToInt(colour.getGreen() * WAVEFORM_INTENSITY);
+    const int blue = roundToInt(colour.getBlue() * WAVEFORM_INTENSITY);
+
+    Image::BitmapData bitmap(persistenceImage, Image::BitmapData::readWrite);
+
+    const int w = bitmap.width;
+    const int h = bitmap.height;
+
+    // compute the spatial width for each waveform sample
+    const float dx = w / float(nSamples - 1);
+    const float scale = (spikesInverted ? 1.0f : -1.0f) * h / range;
+    const float centre = h / 2.0f;
+
+    // the channel determines where its samples start in the spike data
+	const float* data = s.getDataPointer() + nSamples * channel;
+
+    float y1 = centre + data[0] * scale;
 
 	for (int i = 0; i < nSamples - 1; i++)
 	{
-		//std::cout << s.data[sampIdx] << std::endl;
-
-		float s1, s2;
-
-		if (spikesInverted)
-		{
-			s1 = h / 2 + data[sampIdx] / range * h;
-			s2 = h / 2 + data[sampIdx + 1] / range * h;
-		}
-		else
-		{
-			s1 = h / 2 - data[sampIdx] / range * h;
-			s2 = h / 2 - data[sampIdx + 1] / range * h;
-
-		}
-		
-        g.drawLine(x,
-			s1,
-			x + dx,
-			s2);
-
-		sampIdx += dSamples;
-		x += dx;
+        const float y2 = centre + data[i + 1] * scale;
+
+        const int xStart = roundToInt(i * dx);
+        const int xEnd = jmax(xStart + 1, roundToInt((i + 1) * dx));
+        const float slope = (y2 - y1) / float(xEnd - xStart);
+
+        // fill the column span covered by the segment, so that steep edges stay connected
+        for (int x = jmax(0, xStart); x < jmin(w, xEnd); x++)
+        {
+            const float ya = y1 + slope * (x - xStart);
+            const float yb = ya + slope;
+
+            const int yFirst = jmax(0, roundToInt(jmin(ya, yb)));
+            const int yLast = jmin(h - 1, jmax(yFirst, roundToInt(jmax(ya, yb)) - 1));
+
+            for (int y = yFirst; y <= yLast; y++)
+                addToPixel(bitmap.getPixelPointer(x, y), red, green, blue);
+        }
+
+        y1 = y2;
 	}
 
 }
@@ -725,7 +771,7 @@ void WaveAxes::drawWaveformGrid(Graphics& g)
 
 }
 
-bool WaveAxes::updateSpikeData(const Spike* s)
+bool WaveAxes::updateSpikeData(const SpikeSnapshot& s)
 {
     
     if (!gotFirstSpike)
@@ -733,29 +779,17 @@ bool WaveAxes::updateSpikeData(const Spike* s)
         gotFirstSpike = true;
     }
 
-    if (spikesReceivedSinceLastRedraw < bufferSize)
-    {
-
-        Spike* newSpike = new Spike(*s);
-
-        spikeIndex++;
-        spikeIndex %= bufferSize;
-
-        spikeBuffer.set(spikeIndex, newSpike);
-
-        spikesReceivedSinceLastRedraw++;
-
-    }
+    plotSpike(s);
 
     return true;
 
 }
 
-bool WaveAxes::checkThreshold(const Spike* s)
+bool WaveAxes::checkThreshold(const SpikeSnapshot& s)
 {
-	int nSamples = s->getChannelInfo()->getTotalSamples();
+	int nSamples = s.numSamples;
     int sampIdx = nSamples*type;
-	const float* data = s->getDataPointer();
+	const float* data = s.getDataPointer();
 
     for (int i = 0; i < nSamples-1; i++)
     {
@@ -775,13 +809,11 @@ bool WaveAxes::checkThreshold(const Spike* s)
 void WaveAxes::clear()
 {
 
-    spikeBuffer.clear();
-    spikeIndex = 0;
+    if (persistenceImage.isValid())
+        persistenceImage.clear(persistenceImage.getBounds());
 
-    for (int n = 0; n < bufferSize; n++)
-    {
-        spikeBuffer.add(nullptr);
-    }
+    framesSinceLastSpike = WAVEFORM_PERSISTENCE_FRAMES;
+    pendingDecaySteps = 0;
 
     repaint();
 }
@@ -898,7 +930,9 @@ void WaveAxes::setDisplayThreshold(float threshold)
 ProjectionAxes::ProjectionAxes(SpikeDisplayCanvas* canvas, Projection proj_) : GenericAxes(canvas, PROJECTION_AXES), imageDim(500),
     rangeX(250), rangeY(250), spikesReceivedSinceLastRedraw(0), proj(proj_)
 {
-    projectionImage = Image(Image::RGB, imageDim, imageDim, true);
+    projectionImage = Image(Image::RGB, imageDim, imageDim, true, SoftwareImageType());
+
+    pendingPoints.ensureStorageAllocated(MAX_PROJECTION_POINTS_PER_FRAME);
 
     clear();
 
@@ -921,7 +955,7 @@ void ProjectionAxes::paint(Graphics& g)
                 0, imageDim-rangeY, rangeX, rangeY);
 }
 
-bool ProjectionAxes::updateSpikeData(const Spike* s)
+bool ProjectionAxes::updateSpikeData(const SpikeSnapshot& s)
 {
     if (!gotFirstSpike)
     {
@@ -934,39 +968,53 @@ bool ProjectionAxes::updateSpikeData(const Spike* s)
     // add peaks to image
     Colour col;
 
-    if (s->getSortedId() > 0)
-        col = colours[(s->getSortedId() - 1) % 8];
+    if (s.sortedId > 0)
+        col = colours[(s.sortedId - 1) % 8];
     else
         col = Colours::white;
 
-	const float* data = s->getDataPointer();
-    updateProjectionImage(data[idx1], data[idx2], 1, col);
+    // points beyond the per-frame limit are dropped
+    if (pendingPoints.size() < MAX_PROJECTION_POINTS_PER_FRAME)
+    {
+	    const float* data = s.getDataPointer();
+        pendingPoints.add({ data[idx1], data[idx2], col });
+    }
 
     return true;
 }
 
-void ProjectionAxes::updateProjectionImage(float x, float y, float gain, Colour col)
+void ProjectionAxes::drawPendingPoints()
 {
-    Graphics g(projectionImage);
+    if (pendingPoints.isEmpty())
+        return;
 
-    if (gain != 0)
     {
-		float xf = x;
-        float yf = float(imageDim) - y; // in microvolts
+        Image::BitmapData bitmap(projectionImage, Image::BitmapData::readWrite);
 
-        g.setColour(col);
-        g.fillEllipse(xf,yf,2.0f,2.0f);
+        for (auto& point : pendingPoints)
+        {
+            // one pixel per microvolt; each point is a 2x2 dot
+            const int x = (int) std::floor(point.x);
+            const int y = (int) std::floor(float(imageDim) - point.y);
+
+            for (int py = jmax(0, y); py < jmin(imageDim, y + 2); py++)
+                for (int px = jmax(0, x); px < jmin(imageDim, x + 2); px++)
+                    bitmap.setPixelColour(px, py, point.colour);
+        }
     }
 
+    pendingPoints.clearQuick();
+
+    repaint();
 }
 
-void ProjectionAxes::calcWaveformPeakIdx(const Spike* s, int d1, int d2, int* idx1, int* idx2)
+void ProjectionAxes::calcWaveformPeakIdx(const SpikeSnapshot& s, int d1, int d2, int* idx1, int* idx2)
 {
 
     float max1 = -1*pow(2.0,15);
     float max2 = max1;
-	int nSamples = s->getChannelInfo()->getTotalSamples();
-	const float* data = s->getDataPointer();
+	int nSamples = s.numSamples;
+	const float* data = s.getDataPointer();
 
     for (int i = 0; i < nSamples; i++)
     {
@@ -987,6 +1035,8 @@ void ProjectionAxes::calcWaveformPeakIdx(const Spike* s, int d1, int d2, int* id
 
 void ProjectionAxes::clear()
 {
+    pendingPoints.clearQuick();
+
     projectionImage.clear(Rectangle<int>(0, 0, projectionImage.getWidth(), projectionImage.getHeight()),
                           Colours::black);
 
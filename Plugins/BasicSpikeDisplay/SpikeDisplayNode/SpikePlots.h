@@ -27,6 +27,8 @@
 
 #include <VisualizerWindowHeaders.h>
 
+#include "SpikeSnapshotRing.h"
+
 class SpikeDisplayCanvas;
 class SpikeThresholdCoordinator;
 
@@ -90,11 +92,11 @@ public:
     /** Sets bounds of sub-axes*/
     void resized();
 
-    /** Plots latest spikes in buffer*/
+    /** Plots latest spikes in buffer (called once per frame)*/
     void refresh();
 
     /** Handles an incoming spike*/
-    void processSpikeObject(const Spike* s);
+    void processSpikeObject(const SpikeSnapshot& s);
 
     /** Initializes the WaveAxes and ProjectionAxes*/
     void initAxes();
@@ -139,8 +141,6 @@ public:
 
     SpikeDisplayCanvas* canvas;
 
-    void addSpikeToBuffer(const Spike* spike);
-
     int electrodeNumber;
 
     int nChannels;
@@ -157,10 +157,8 @@ private:
     int nWaveAx;
     int nProjAx;
 
-    const int bufferSize = 5;
-    int spikesInBuffer;
-
-    OwnedArray<Spike> mostRecentSpikes;
+    /** Latest spike read from the electrode's SpikeSnapshotRing */
+    SpikeSnapshot snapshot;
 
     bool limitsChanged;
 
@@ -181,8 +179,6 @@ private:
     String name;
     Font font;
 
-    CriticalSection spikeArrayLock;
-
     WeakReference<SpikeThresholdCoordinator> thresholdCoordinator;
 
 };
@@ -206,7 +202,7 @@ public:
     virtual ~GenericAxes() { }
 
     /** Called when a new spike is received*/
-    virtual bool updateSpikeData(const Spike* s) = 0;
+    virtual bool updateSpikeData(const SpikeSnapshot& s) = 0;
 
     /** Get/set X and Y limits*/
     void setXLims(double xmin, double xmax);
@@ -256,16 +252,22 @@ public:
     ~WaveAxes() {}
 
     /** Adds a new spike*/
-    bool updateSpikeData(const Spike* s);
+    bool updateSpikeData(const SpikeSnapshot& s);
 
     /** Checks whether a spike is above threshold*/
-    bool checkThreshold(const Spike* spike);
+    bool checkThreshold(const SpikeSnapshot& spike);
 
-    /** Draws the component (calls plotSpike)*/
+    /** Draws the persistence image, grid and thresholds*/
     void paint(Graphics& g);
 
-    /** Draws a single spike */
-    void plotSpike(const Spike* s, Graphics& g);
+    /** Re-creates the persistence image to match the new size*/
+    void resized();
+
+    /** Adds a single spike to the persistence image */
+    void plotSpike(const SpikeSnapshot& s);
+
+    /** Fades the waveforms drawn so far (called once per frame)*/
+    void advanceFrame();
 
     /** Removes spikes that have been previously drawn*/
     void clear();
@@ -291,7 +293,7 @@ public:
     void invertSpikes(bool shouldInvert)
     {
         spikesInverted = shouldInvert;
-        repaint();
+        clear();
     }
 
 private:
@@ -314,14 +316,21 @@ private:
 
     void drawThresholdSlider(Graphics& g);
 
-    int spikesReceivedSinceLastRedraw;
+    /** Applies the fading of all frames since the last call */
+    void applyDecay();
 
     Font font;
 
-   OwnedArray<Spike> spikeBuffer;
+    /** Waveforms are added into this image with direct pixel writes,
+        and fade out over a few frames */
+    Image persistenceImage;
+
+    /** Number of frames that have not yet been applied to the image */
+    int pendingDecaySteps;
 
-    int spikeIndex;
-    int bufferSize;
+    /** Number of frames since the last waveform was drawn
+        (once the image has faded to black, it no longer needs to be decayed) */
+    int framesSinceLastSpike;
 
     float range;
 
@@ -353,7 +362,7 @@ public:
     ~ProjectionAxes() { }
 
     /** Called when a new spike is received */
-    bool updateSpikeData(const Spike* s);
+    bool updateSpikeData(const SpikeSnapshot& s);
 
     /** Displays the projection image*/
     void paint(Graphics& g);
@@ -361,6 +370,9 @@ public:
     /** Removes the projection image*/
     void clear();
 
+    /** Draws all points received since the last frame into the projection image */
+    void drawPendingPoints();
+
     void setRange(float, float);
 
     static void n2ProjIdx(Projection proj, int* p1, int* p2);
@@ -371,9 +383,17 @@ private:
 
     Projection proj;
 
-    void updateProjectionImage(float, float, float, Colour);
+    void calcWaveformPeakIdx(const SpikeSnapshot&, int, int, int*, int*);
+
+    struct ProjectionPoint
+    {
+        float x;
+        float y;
+        Colour colour;
+    };
 
-    void calcWaveformPeakIdx(const Spike*, int, int, int*, int*);
+    /** Peaks received since the last frame, drawn in one pass */
+    Array<ProjectionPoint> pendingPoints;
 
     int ampDim1, ampDim2;
 
@@ -0,0 +1,113 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SpikeSnapshotRing.h"
+
+SpikeSnapshotRing::SpikeSnapshotRing(int numChannels_, int numSamples_, int capacity_)
+    : numChannels(jmax(1, numChannels_)),
+      numSamples(jmax(1, numSamples_)),
+      capacity(jmax(1, capacity_)),
+      slotSize(numChannels * (numSamples + 1)),
+      slots(new Slot[capacity]),
+      writeCount(0),
+      readCount(0)
+{
+    values.calloc(size_t(slotSize) * capacity);
+}
+
+
+void SpikeSnapshotRing::push(const Spike& spike)
+{
+    const uint64 index = writeCount.load(std::memory_order_relaxed);
+
+    Slot& slot = slots[index % capacity];
+    float* dest = values + (index % capacity) * slotSize;
+
+    // odd sequence number: slot is being written
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const int channelsToCopy = jmin(numChannels, int(spike.getChannelInfo()->getNumChannels()));
+    const int samplesToCopy = jmin(numSamples, int(spike.getChannelInfo()->getTotalSamples()));
+
+    for (int ch = 0; ch < channelsToCopy; ch++)
+    {
+        dest[ch] = spike.getThreshold(ch);
+
+        FloatVectorOperations::copy(dest + numChannels + ch * numSamples,
+                                    spike.getDataPointer(ch),
+                                    samplesToCopy);
+    }
+
+    slot.sortedId = spike.getSortedId();
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+    writeCount.store(index + 1, std::memory_order_release);
+}
+
+
+bool SpikeSnapshotRing::pop(SpikeSnapshot& snapshot)
+{
+    const uint64 written = writeCount.load(std::memory_order_acquire);
+
+    // older spikes have already been overwritten
+    if (written - readCount > uint64(capacity))
+        readCount = written - capacity;
+
+    if (snapshot.numChannels != numChannels || snapshot.numSamples != numSamples)
+    {
+        snapshot.numChannels = numChannels;
+        snapshot.numSamples = numSamples;
+        snapshot.values.calloc(slotSize);
+    }
+
+    while (readCount < written)
+    {
+        const uint64 index = readCount++;
+        const uint64 expected = 2 * index + 2;
+
+        Slot& slot = slots[index % capacity];
+
+        if (slot.sequence.load(std::memory_order_acquire) != expected)
+            continue; // overwritten by a newer spike
+
+        FloatVectorOperations::copy(snapshot.values, values + (index % capacity) * slotSize, slotSize);
+        snapshot.sortedId = slot.sortedId;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (slot.sequence.load(std::memory_order_relaxed) != expected)
+            continue; // overwritten while it was being copied
+
+        return true;
+    }
+
+    return false;
+}
+
+
+void SpikeSnapshotRing::reset()
+{
+    readCount = writeCount.load(std::memory_order_acquire);
+}
@@ -0,0 +1,121 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SPIKESNAPSHOTRING_H_
+#define SPIKESNAPSHOTRING_H_
+
+#include <ProcessorHeaders.h>
+
+#include <atomic>
+
+/**
+    Copy of the parts of a Spike that are needed to draw it.
+
+    @see SpikeSnapshotRing, SpikePlot
+*/
+struct SpikeSnapshot
+{
+    /** Number of channels in the electrode */
+    int numChannels = 0;
+
+    /** Number of samples per channel */
+    int numSamples = 0;
+
+    /** Sorted ID of the spike (0 = unsorted) */
+    uint16 sortedId = 0;
+
+    /** Thresholds (one per channel), followed by the waveforms (channel by channel) */
+    HeapBlock<float> values;
+
+    /** Returns the waveform samples of all channels */
+    const float* getDataPointer() const { return values + numChannels; }
+
+    /** Returns the detection threshold for a channel */
+    float getThreshold(int chan) const { return values[chan]; }
+};
+
+/**
+    Single-producer / single-consumer ring of spike waveforms for one electrode.
+
+    The audio thread copies each spike into the next slot, overwriting the
+    oldest one if the UI has fallen behind, so pushing a spike is O(1), never
+    blocks and never allocates. Each slot carries a sequence number that is odd
+    while it is being written, so that the reader can detect (and skip) a slot
+    that was overwritten while it was being copied.
+
+    Because only the last 'capacity' spikes are kept, the number of spikes the
+    UI draws per frame is bounded whatever the spike rate.
+
+    @see SpikeDisplayNode
+*/
+class SpikeSnapshotRing
+{
+public:
+
+    /** Creates a ring for spikes with the given number of channels and samples per channel */
+    SpikeSnapshotRing(int numChannels, int numSamples, int capacity);
+
+    /** Destructor */
+    ~SpikeSnapshotRing() { }
+
+    /** Copies a spike into the ring (audio thread) */
+    void push(const Spike& spike);
+
+    /** Copies the oldest unread spike into 'snapshot', allocating its storage if needed.
+        Returns false if there are no new spikes (message thread) */
+    bool pop(SpikeSnapshot& snapshot);
+
+    /** Discards all unread spikes (message thread) */
+    void reset();
+
+    /** Default number of spikes kept per electrode */
+    static const int DEFAULT_CAPACITY = 10;
+
+private:
+
+    struct Slot
+    {
+        std::atomic<uint64> sequence { 0 };
+        uint16 sortedId = 0;
+    };
+
+    const int numChannels;
+    const int numSamples;
+    const int capacity;
+
+    /** Number of floats per slot (thresholds + waveforms) */
+    const int slotSize;
+
+    std::unique_ptr<Slot[]> slots;
+    HeapBlock<float> values;
+
+    /** Total number of spikes pushed */
+    std::atomic<uint64> writeCount;
+
+    /** Total number of spikes read or skipped (reader only) */
+    uint64 readCount;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpikeSnapshotRing);
+};
+
+#endif  // SPIKESNAPSHOTRING_H_
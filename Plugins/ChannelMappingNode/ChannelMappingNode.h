@@ -95,6 +95,9 @@ public:
     /** Channel remap happens automatically via channel connections; does nothing*/
     void process (AudioBuffer<float>& buffer) override;
 
+    /** Channels are routed by the graph, so the data itself is never modified */
+    bool isPassThrough() const override { return true; }
+
     /** Informs downstream plugins of channel remapping*/
     void updateSettings() override;
 
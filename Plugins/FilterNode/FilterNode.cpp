@@ -30,30 +30,10 @@ void BandpassFilterSettings::createFilters(int numChannels, float sampleRate_, d
 
     sampleRate = sampleRate_;
 
-    filters.clear();
-
-    for (int n = 0; n < numChannels; ++n)
-    {
-        filters.add(new Dsp::SmoothedFilterDesign
-            <Dsp::Butterworth::Design::BandPass    // design type
-            <2>,                                   // order
-            1,                                     // number of channels (must be const)
-            Dsp::DirectFormII>(1));               // realization
-
-    }
-
-    updateFilters(lowCut, highCut);
+    designFilters(filters, numChannels, sampleRate, lowCut, highCut);
 }
 
-void BandpassFilterSettings::updateFilters(double lowCut, double highCut)
-{
-    for (int n = 0; n < filters.size(); n++)
-    {
-        setFilterParameters(lowCut, highCut, n);
-    }
-}
-
-void BandpassFilterSettings::setFilterParameters(double lowCut, double highCut, int channel)
+void BandpassFilterSettings::designFilters(OwnedArray<BandpassFilter>& filters, int numChannels, float sampleRate, double lowCut, double highCut)
 {
     Dsp::Params params;
     params[0] = sampleRate;                 // sample rate
@@ -61,7 +41,14 @@ void BandpassFilterSettings::setFilterParameters(double lowCut, double highCut,
     params[2] = (highCut + lowCut) / 2;     // center frequency
     params[3] = highCut - lowCut;           // bandwidth
 
-    filters[channel]->setParams(params);
+    filters.clear();
+
+    for (int n = 0; n < numChannels; ++n)
+    {
+        BandpassFilter* filter = new BandpassFilter();
+        filter->setParams(params);
+        filters.add(filter);
+    }
 }
 
 
@@ -140,6 +127,21 @@ AudioProcessorEditor* FilterNode::createEditor()
 // filter->reset()
 // filter->process()
 
+Array<int> FilterNode::getSelectedChannels(const DataStream* stream)
+{
+    Array<int> channels;
+
+    for (auto localChannelIndex : *((*stream)["Channels"].getArray()))
+    {
+        int index = (int) localChannelIndex;
+
+        if (index >= 0 && index < stream->getChannelCount())
+            channels.add(index);
+    }
+
+    return channels;
+}
+
 void FilterNode::updateSettings()
 {
     settings.update(getDataStreams());
@@ -152,6 +154,8 @@ void FilterNode::updateSettings()
             (*stream)["low_cut"],
             (*stream)["high_cut"]
         );
+
+        settings[stream->getStreamId()]->channels = getSelectedChannels(stream);
     }
 }
 
@@ -161,35 +165,71 @@ void FilterNode::parameterValueChanged(Parameter* param)
     
     uint16 currentStream = param->getStreamId();
 
-    if (param->getName().equalsIgnoreCase("low_cut"))
+    DataStream* stream = getDataStream(currentStream);
+
+    if (stream == nullptr || settings[currentStream] == nullptr)
+        return;
+
+    if (param->getName().equalsIgnoreCase("low_cut") || param->getName().equalsIgnoreCase("high_cut"))
     {
 
-        if ((*getDataStream(currentStream))["low_cut"] >= (*getDataStream(currentStream))["high_cut"])
+        if ((*stream)["low_cut"] >= (*stream)["high_cut"])
         {
-            getDataStream(currentStream)->getParameter("low_cut")->restorePreviousValue();
+            param->restorePreviousValue();
             return;
         }
-            
 
-        settings[currentStream]->updateFilters(
-            (*getDataStream(currentStream))["low_cut"],
-            (*getDataStream(currentStream))["high_cut"]
-            );
+        // design the new filters here, and swap them in at the start of the next block
+        BandpassFilterUpdate* update = new BandpassFilterUpdate();
+
+        BandpassFilterSettings::designFilters(update->filters,
+            stream->getChannelCount(),
+            stream->getSampleRate(),
+            (*stream)["low_cut"],
+            (*stream)["high_cut"]
+        );
+
+        queueParameterChange(param, update);
     }
-    else if (param->getName().equalsIgnoreCase("high_cut"))
+    else if (param->getName().equalsIgnoreCase("Channels"))
     {
 
-        if ((*getDataStream(currentStream))["high_cut"] <= (*getDataStream(currentStream))["low_cut"])
-        {
-            getDataStream(currentStream)->getParameter("high_cut")->restorePreviousValue();
-            return;
-        }
+        BandpassFilterUpdate* update = new BandpassFilterUpdate();
 
-        settings[currentStream]->updateFilters(
-            (*getDataStream(currentStream))["low_cut"],
-            (*getDataStream(currentStream))["high_cut"]
-        );
+        update->channels = getSelectedChannels(stream);
+        update->updateChannels = true;
+
+        queueParameterChange(param, update);
+    }
+}
+
+
+void FilterNode::applyParameterChange(ParameterChange& change)
+{
+
+    BandpassFilterUpdate* update = dynamic_cast<BandpassFilterUpdate*>(change.state);
+
+    BandpassFilterSettings* streamSettings = settings[change.streamId];
+
+    if (update == nullptr || streamSettings == nullptr)
+        return;
+
+    if (update->filters.size() > 0 && update->filters.size() == streamSettings->filters.size())
+    {
+        for (int n = 0; n < update->filters.size(); n++)
+            update->filters[n]->copyStateFrom(*streamSettings->filters[n]);
+
+        // the old filters end up in the update, which is deleted off the audio thread
+        streamSettings->filters.swapWith(update->filters);
+    }
+    else
+    {
+        // the stream's channels changed after the update was built; the next update will apply
+        jassert(update->filters.size() == 0);
     }
+
+    if (update->updateChannels)
+        streamSettings->channels.swapWith(update->channels);
 }
 
 
@@ -203,19 +243,15 @@ void FilterNode::process (AudioBuffer<float>& buffer)
         {
             BandpassFilterSettings* streamSettings = settings[stream->getStreamId()];
             
-            const uint16 streamId = stream->getStreamId();
-            const uint32 numSamples = getNumSamplesInBlock(streamId);
+            StreamBuffer streamBuffer = getStreamBuffer(buffer, stream->getStreamId());
 
-            for (auto localChannelIndex : *((*stream)["Channels"].getArray()))
+            for (auto localChannelIndex : streamSettings->channels)
             {
-                int globalChannelIndex = getGlobalChannelIndex(stream->getStreamId(), (int) localChannelIndex);
-
-                float* ptr = buffer.getWritePointer(globalChannelIndex);
+                float* ptr = streamBuffer.getWritePointer(localChannelIndex);
 
-                streamSettings->filters[localChannelIndex]->process(numSamples, &ptr);
+                streamSettings->filters[localChannelIndex]->process(streamBuffer.getNumSamples(), &ptr);
 
             }
         }
     }
 }
-
@@ -28,6 +28,27 @@
 #include <DspLib.h>
 
 
+typedef Dsp::SmoothedFilterDesign
+    <Dsp::Butterworth::Design::BandPass    // design type
+    <2>,                                   // order
+    1,                                     // number of channels (must be const)
+    Dsp::DirectFormII> BandpassFilterDesign;  // realization
+
+/** Bandpass filter for one channel*/
+
+class BandpassFilter : public BandpassFilterDesign
+{
+
+public:
+
+    /** Constructor*/
+    BandpassFilter() : BandpassFilterDesign(1) { }
+
+    /** Continues from another filter's state, so that replacing a filter does not restart it*/
+    void copyStateFrom(const BandpassFilter& other) { m_state = other.m_state; }
+
+};
+
 /** Holds settings for one stream's filters*/
 
 class BandpassFilterSettings
@@ -42,16 +63,35 @@ public:
     float sampleRate;
 
     /** Holds the filters for one stream*/
-    OwnedArray<Dsp::Filter> filters;
+    OwnedArray<BandpassFilter> filters;
+
+    /** Local indices of the channels to filter*/
+    Array<int> channels;
 
     /** Creates new filters when input settings change*/
     void createFilters(int numChannels, float sampleRate, double lowCut, double highCut);
 
-    /** Updates filters when parameters change*/
-    void updateFilters(double lowCut, double highCut);
+    /** Creates a set of filters with the given cutoffs*/
+    static void designFilters(OwnedArray<BandpassFilter>& filters, int numChannels, float sampleRate, double lowCut, double highCut);
 
-    /** Sets filter parameters for one channel*/
-    void setFilterParameters(double lowCut, double highCut, int channel);
+};
+
+/** New filters and/or channel selection for one stream, prepared on the message thread
+    and swapped in at the start of a block*/
+
+class BandpassFilterUpdate : public PreparedParameterState
+{
+
+public:
+
+    /** New filters (empty if the cutoffs did not change)*/
+    OwnedArray<BandpassFilter> filters;
+
+    /** New channel selection*/
+    Array<int> channels;
+
+    /** True if 'channels' should replace the current selection*/
+    bool updateChannels = false;
 
 };
 
@@ -81,6 +121,9 @@ public:
     /** Called whenever a parameter's value is changed (called by GenericProcessor::setParameter())*/
     void parameterValueChanged(Parameter* param) override;
 
+    /** Swaps in the filters or channel selection prepared in parameterValueChanged()*/
+    void applyParameterChange(ParameterChange& change) override;
+
     /** Called when upstream settings are changed.*/
     void updateSettings() override;
 
@@ -88,7 +131,8 @@ private:
 
     StreamSettings<BandpassFilterSettings> settings;
 
-    void setFilterParameters (double, double, int);
+    /** Returns the local indices stored in a stream's "Channels" parameter*/
+    static Array<int> getSelectedChannels(const DataStream* stream);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterNode);
 };
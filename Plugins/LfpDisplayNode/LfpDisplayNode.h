@@ -61,6 +61,9 @@ public:
     /** Pushes incoming data into a drawing buffer*/
     void process (AudioBuffer<float>& buffer) override;
 
+    /** Only reads the continuous data */
+    bool isPassThrough() const override { return true; }
+
     /** Used to set display trigger channels*/
     void setParameter (int parameterIndex, float newValue) override;
 
@@ -0,0 +1,68 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HilbertTransformer.h"
+
+HilbertTransformer::HilbertTransformer(int delay_)
+    : delay(jmax(1, delay_))
+{
+    taps.calloc(delay + 1);
+
+    for (int k = 1; k <= delay; k += 2)
+    {
+        const float window = 0.54f + 0.46f * std::cos(MathConstants<float>::pi * k / (delay + 1));
+
+        taps[k] = 2.0f / (MathConstants<float>::pi * k) * window;
+    }
+
+    scratch.calloc(getHistorySize() + CHUNK_SIZE);
+    real.calloc(CHUNK_SIZE);
+    imag.calloc(CHUNK_SIZE);
+}
+
+
+void HilbertTransformer::process(const float* input, int numSamples, float* history)
+{
+    jassert(numSamples <= CHUNK_SIZE);
+
+    numSamples = jmin(numSamples, int(CHUNK_SIZE));
+
+    const int historySize = getHistorySize();
+
+    FloatVectorOperations::copy(scratch, history, historySize);
+    FloatVectorOperations::copy(scratch + historySize, input, numSamples);
+
+    // output i is centred on scratch[i + delay]
+    const float* centre = scratch + delay;
+
+    FloatVectorOperations::copy(real, centre, numSamples);
+    FloatVectorOperations::clear(imag, numSamples);
+
+    // y[n] = sum over odd k of h[k] * (x[n - k] - x[n + k]), one tap pair at a time across the block
+    for (int k = 1; k <= delay; k += 2)
+    {
+        FloatVectorOperations::addWithMultiply(imag, centre - k, taps[k], numSamples);
+        FloatVectorOperations::addWithMultiply(imag, centre + k, -taps[k], numSamples);
+    }
+
+    FloatVectorOperations::copy(history, scratch + numSamples, historySize);
+}
@@ -0,0 +1,86 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __HILBERTTRANSFORMER_H_7C31A9E2__
+#define __HILBERTTRANSFORMER_H_7C31A9E2__
+
+#include <ProcessorHeaders.h>
+
+/**
+    Block-based FIR Hilbert transformer, used to estimate the
+    phase of a band-limited signal from its analytic signal.
+
+    The filter has 2 * delay + 1 taps (Hamming-windowed), so its output
+    lags the input by 'delay' samples. Callers keep the last 2 * delay
+    input samples of each channel in a history buffer, so that one
+    transformer can be shared by all of the channels of a stream.
+
+    @see PhaseDetector
+*/
+class HilbertTransformer
+{
+public:
+    /** Designs the filter */
+    HilbertTransformer(int delay);
+
+    /** Destructor */
+    ~HilbertTransformer() { }
+
+    /** Computes the analytic signal for up to CHUNK_SIZE new input samples.
+
+        'history' must hold getHistorySize() samples, and is updated. Output
+        sample i (see getReal() and getImag()) corresponds to input sample i - delay.
+    */
+    void process(const float* input, int numSamples, float* history);
+
+    /** Returns the real part of the last output (the delayed input) */
+    const float* getReal() const { return real; }
+
+    /** Returns the imaginary part of the last output */
+    const float* getImag() const { return imag; }
+
+    /** Returns the group delay, in samples */
+    int getDelay() const { return delay; }
+
+    /** Returns the number of input samples that must be kept between calls */
+    int getHistorySize() const { return 2 * delay; }
+
+    /** Maximum number of samples per call to process() */
+    static const int CHUNK_SIZE = 1024;
+
+private:
+
+    const int delay;
+
+    /** Taps h[k] for k = 0 ... delay (h[-k] = -h[k], and even taps are 0) */
+    HeapBlock<float> taps;
+
+    /** History followed by the new input samples */
+    HeapBlock<float> scratch;
+
+    HeapBlock<float> real;
+    HeapBlock<float> imag;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HilbertTransformer);
+};
+
+#endif  // __HILBERTTRANSFORMER_H_7C31A9E2__
@@ -24,58 +24,49 @@
 #include "PhaseDetector.h"
 #include "PhaseDetectorEditor.h"
 
+#define MAX_PHASE_CHANNELS 16
+
+// the Hilbert filter costs about one multiply-add per sample of delay, per sample and channel
+#define MAX_HILBERT_MS 50
+#define MAX_HILBERT_DELAY 1024
+
+// samples after each trigger until the output line is turned off
+#define OUTPUT_PULSE_SAMPLES 2001
+
+// samples per pass of the sign/slope extraction
+#define PHASE_CHUNK_SIZE 1024
+
+// smoothing of the instantaneous frequency used to predict the phase
+#define FREQUENCY_SMOOTHING 0.01f
+
 PhaseDetectorSettings::PhaseDetectorSettings() :
-    samplesSinceTrigger(0),
-    lastSample(0.0f),
     isActive(true),
-    wasTriggered(false),
+    outputLineChanged(false),
+    lastOutputLine(0),
     detectorType(PEAK),
-    currentPhase(NO_PHASE),
-    triggerChannel(0),
     outputLine(0),
-    gateLine(0)
+    gateLine(0),
+    eventChannel(nullptr)
 {
-
+    // never allocates on the audio thread
+    linesToClear.ensureStorageAllocated(MAX_PHASE_CHANNELS);
 }
 
-TTLEventPtr PhaseDetectorSettings::createEvent(int64 sample_number, bool state)
+TTLEventPtr PhaseDetectorSettings::createEvent(int64 sample_number, int line, bool state)
 {
 
     TTLEventPtr event = TTLEvent::createTTLEvent(eventChannel,
                                                  sample_number,
-                                                 outputLine,
+                                                 line,
                                                  state);
 
-    if (state)
-    {
-        samplesSinceTrigger = 0;
-        wasTriggered = true;
-    }
-    else {
-        wasTriggered = false;
-    }
-
-    return event;
-}
-
-
-TTLEventPtr PhaseDetectorSettings::clearOutputLine(int64 sample_number)
-{
-
-    TTLEventPtr event = TTLEvent::createTTLEvent(eventChannel,
-                                                 sample_number,
-                                                 lastOutputLine,
-                                                 false);
-
-    outputLineChanged = false;
-
     return event;
 }
 
 PhaseDetector::PhaseDetector() : GenericProcessor ("Phase Detector")
 {
 
-    addSelectedChannelsParameter(Parameter::STREAM_SCOPE, "Channel", "The continuous channel to analyze", 1);
+    addSelectedChannelsParameter(Parameter::STREAM_SCOPE, "Channel", "The continuous channels to analyze (channel n drives TTL_out + n)", MAX_PHASE_CHANNELS);
     addIntParameter(Parameter::STREAM_SCOPE, "TTL_out", "The output TTL line", 1, 1, 16);
     addIntParameter(Parameter::STREAM_SCOPE,"gate_line", "The input TTL line for gating the signal (0 = off)", 0, 0, 16);
     addCategoricalParameter(Parameter::STREAM_SCOPE,
@@ -87,6 +78,14 @@ PhaseDetector::PhaseDetector() : GenericProcessor ("Phase Detector")
          "RISING ZERO-CROSSING"
           },
         0);
+    addCategoricalParameter(Parameter::STREAM_SCOPE,
+        "estimator",
+        "How the phase is estimated",
+        { "ZERO-CROSSING",
+          "HILBERT"
+          },
+        0);
+    addIntParameter(Parameter::STREAM_SCOPE, "hilbert_ms", "Length of the Hilbert filter (ms)", 50, 1, MAX_HILBERT_MS);
 }
 
 AudioProcessorEditor* PhaseDetector::createEditor()
@@ -102,20 +101,11 @@ void PhaseDetector::parameterValueChanged(Parameter* param)
     {
         settings[param->getStreamId()]->detectorType = DetectorType((int) param->getValue());
     } 
-    else if (param->getName().equalsIgnoreCase("Channel"))
+    else if (param->getName().equalsIgnoreCase("Channel")
+             || param->getName().equalsIgnoreCase("estimator")
+             || param->getName().equalsIgnoreCase("hilbert_ms"))
     {
-        Array<var>* array = param->getValue().getArray();
-        
-        if (array->size() > 0)
-        {
-            int localIndex = int(array->getFirst());
-            int globalIndex = getDataStream(param->getStreamId())->getContinuousChannels()[localIndex]->getGlobalIndex();
-            settings[param->getStreamId()]->triggerChannel = globalIndex;
-        }
-        else
-        {
-            settings[param->getStreamId()]->triggerChannel = -1;
-        }
+        queueDetectorState(param);
     } 
     else if (param->getName().equalsIgnoreCase("TTL_out"))
     {
@@ -130,18 +120,100 @@ void PhaseDetector::parameterValueChanged(Parameter* param)
 
 }
 
+void PhaseDetector::queueDetectorState(Parameter* param)
+{
+    DataStream* stream = getDataStream(param->getStreamId());
+
+    if (stream == nullptr)
+        return;
+
+    PhaseDetectorState* state = new PhaseDetectorState();
+
+    state->estimator = PhaseEstimator((int) (*stream)["estimator"]);
+
+    if (state->estimator == HILBERT)
+    {
+        // the delay is half the filter length
+        const int delay = jmin(roundToInt(stream->getSampleRate() * (int) (*stream)["hilbert_ms"] / 2000.0f),
+                               MAX_HILBERT_DELAY);
+
+        state->hilbert = std::make_unique<HilbertTransformer>(delay);
+    }
+
+    Array<var>* array = stream->getParameter("Channel")->getValue().getArray();
+
+    for (int i = 0; array != nullptr && i < jmin(array->size(), MAX_PHASE_CHANNELS); i++)
+    {
+        int localIndex = int(array->getUnchecked(i));
+
+        if (localIndex < 0 || localIndex >= stream->getChannelCount())
+            continue;
+
+        PhaseChannel* channel = new PhaseChannel();
+
+        channel->channel = stream->getContinuousChannels()[localIndex]->getGlobalIndex();
+
+        if (state->hilbert != nullptr)
+        {
+            channel->history.calloc(state->hilbert->getHistorySize());
+            channel->samplesUntilValid = state->hilbert->getHistorySize();
+        }
+
+        state->channels.add(channel);
+    }
+
+    queueParameterChange(param, state);
+}
+
+void PhaseDetector::applyParameterChange(ParameterChange& change)
+{
+    PhaseDetectorState* incoming = dynamic_cast<PhaseDetectorState*>(change.state);
+    PhaseDetectorSettings* module = settings[change.streamId];
+
+    if (incoming == nullptr || module == nullptr)
+        return;
+
+    PhaseDetectorState* previous = module->state.get();
+
+    if (previous != nullptr)
+    {
+        for (int i = 0; i < previous->channels.size(); i++)
+        {
+            PhaseChannel* oldChannel = previous->channels[i];
+
+            if (i < incoming->channels.size())
+            {
+                // the nth channel keeps driving the same line, so its pulse carries over
+                PhaseChannel* newChannel = incoming->channels[i];
+
+                newChannel->wasTriggered = oldChannel->wasTriggered;
+                newChannel->offSampleNumber = oldChannel->offSampleNumber;
+
+                if (newChannel->channel == oldChannel->channel)
+                {
+                    newChannel->lastSample = oldChannel->lastSample;
+                    newChannel->currentPhase = oldChannel->currentPhase;
+                }
+            }
+            else if (oldChannel->wasTriggered && module->linesToClear.size() < MAX_PHASE_CHANNELS)
+            {
+                module->linesToClear.add(module->outputLine + i);
+            }
+        }
+    }
+
+    // the previous state ends up in the change, and is deleted off the audio thread
+    module->state.release();
+    module->state.reset(incoming);
+    change.state = previous;
+}
+
 void PhaseDetector::updateSettings()
 {
     settings.update(getDataStreams());
 
 	for (auto stream : getDataStreams())
 	{
-        // update "settings" objects
-        parameterValueChanged(stream->getParameter("phase"));
-        parameterValueChanged(stream->getParameter("Channel"));
-        parameterValueChanged(stream->getParameter("TTL_out"));
-        parameterValueChanged(stream->getParameter("gate_line"));
-
         EventChannel::Settings s{
             EventChannel::Type::TTL,
             "Phase detector output",
@@ -151,9 +223,18 @@ void PhaseDetector::updateSettings()
 
         };
 
+        // room for one line per channel above the highest TTL_out
+        s.maxTTLBits = 16 + MAX_PHASE_CHANNELS;
+
 		eventChannels.add(new EventChannel(s));
         eventChannels.getLast()->addProcessor(processorInfo.get());
         settings[stream->getStreamId()]->eventChannel = eventChannels.getLast();
+
+        // update "settings" objects
+        parameterValueChanged(stream->getParameter("phase"));
+        parameterValueChanged(stream->getParameter("Channel"));
+        parameterValueChanged(stream->getParameter("TTL_out"));
+        parameterValueChanged(stream->getParameter("gate_line"));
 	}
 }
 
@@ -175,6 +256,123 @@ void PhaseDetector::handleTTLEvent (TTLEventPtr event)
 }
 
 
+/** Returns the phase a sample starts (the checks are mutually exclusive), or NO_PHASE */
+static inline uint8 getPhaseCode(float sample, float lastSample)
+{
+    // branchless, so that the loops below can be vectorized
+    return uint8(FALLING_POS * ((sample < lastSample) & (sample > 0.0f))
+               + FALLING_NEG * ((sample < 0.0f) & (lastSample >= 0.0f))
+               + RISING_NEG * ((sample > lastSample) & (sample < 0.0f))
+               + RISING_POS * ((sample > 0.0f) & (lastSample <= 0.0f)));
+}
+
+
+/** Wraps a phase into [-pi, pi) */
+static inline float wrapPhase(float phase)
+{
+    return phase - MathConstants<float>::twoPi * std::floor((phase + MathConstants<float>::pi) / MathConstants<float>::twoPi);
+}
+
+
+void PhaseDetector::triggerOutput(PhaseDetectorSettings* module, int index, PhaseChannel* channel,
+                                  int sampleIndex, int64 firstSampleInBlock)
+{
+    const int line = module->outputLine + index;
+    const int64 sampleNumber = firstSampleInBlock + sampleIndex;
+
+    if (channel->wasTriggered && channel->offSampleNumber < sampleNumber)
+    {
+        const int offIndex = jmax(0, int(channel->offSampleNumber - firstSampleInBlock));
+
+        addEvent(module->createEvent(firstSampleInBlock + offIndex, line, false), offIndex);
+    }
+
+    addEvent(module->createEvent(sampleNumber, line, true), sampleIndex);
+
+    channel->wasTriggered = true;
+    channel->offSampleNumber = sampleNumber + OUTPUT_PULSE_SAMPLES;
+}
+
+
+void PhaseDetector::detectZeroCrossings(PhaseDetectorSettings* module, int index, PhaseChannel* channel,
+                                        const float* data, int numSamples, int64 firstSampleInBlock)
+{
+    // PEAK -> FALLING_POS, FALLING_ZERO -> FALLING_NEG, TROUGH -> RISING_NEG, RISING_ZERO -> RISING_POS
+    const uint8 targetPhase = uint8((module->detectorType + 1) % 4 + 1);
+
+    uint8 codes[PHASE_CHUNK_SIZE];
+
+    for (int start = 0; start < numSamples; start += PHASE_CHUNK_SIZE)
+    {
+        const int n = jmin(PHASE_CHUNK_SIZE, numSamples - start);
+        const float* x = data + start;
+
+        codes[0] = getPhaseCode(x[0], channel->lastSample);
+
+        for (int i = 1; i < n; i++)
+            codes[i] = getPhaseCode(x[i], x[i - 1]);
+
+        // only the (rare) samples that start a new phase need any work
+        for (int i = 0; i < n; i++)
+        {
+            if (codes[i] == NO_PHASE || codes[i] == channel->currentPhase)
+                continue;
+
+            channel->currentPhase = PhaseType(codes[i]);
+
+            if (codes[i] == targetPhase)
+                triggerOutput(module, index, channel, start + i, firstSampleInBlock);
+        }
+
+        channel->lastSample = x[n - 1];
+    }
+}
+
+
+void PhaseDetector::detectAnalyticPhase(PhaseDetectorSettings* module, int index, PhaseChannel* channel,
+                                        const float* data, int numSamples, int64 firstSampleInBlock)
+{
+    HilbertTransformer* hilbert = module->state->hilbert.get();
+
+    // PEAK = 0, FALLING_ZERO = pi/2, TROUGH = pi, RISING_ZERO = -pi/2
+    const float targetPhase = wrapPhase(module->detectorType * MathConstants<float>::halfPi);
+
+    for (int start = 0; start < numSamples; start += HilbertTransformer::CHUNK_SIZE)
+    {
+        const int n = jmin(int(HilbertTransformer::CHUNK_SIZE), numSamples - start);
+
+        hilbert->process(data + start, n, channel->history);
+
+        const float* re = hilbert->getReal();
+        const float* im = hilbert->getImag();
+
+        for (int i = 0; i < n; i++)
+        {
+            const float phase = std::atan2(im[i], re[i]);
+
+            channel->frequency += FREQUENCY_SMOOTHING * (wrapPhase(phase - channel->lastPhase) - channel->frequency);
+            channel->lastPhase = phase;
+
+            // the filter output lags by 'delay' samples, so advance it to the current sample
+            const float offset = wrapPhase(phase + channel->frequency * hilbert->getDelay() - targetPhase);
+
+            if (channel->samplesUntilValid > 0)
+            {
+                channel->samplesUntilValid--;
+            }
+            else if (channel->lastPhaseOffset < 0.0f
+                     && channel->lastPhaseOffset > -MathConstants<float>::halfPi
+                     && offset >= 0.0f)
+            {
+                triggerOutput(module, index, channel, start + i, firstSampleInBlock);
+            }
+
+            channel->lastPhaseOffset = offset;
+        }
+    }
+}
+
+
 void PhaseDetector::process (AudioBuffer<float>& buffer)
 {
     checkForEvents();
@@ -186,128 +384,61 @@ void PhaseDetector::process (AudioBuffer<float>& buffer)
         if ((*stream)["enable_stream"])
         {
             PhaseDetectorSettings* module = settings[stream->getStreamId()];
+            PhaseDetectorState* state = module->state.get();
             
             const uint16 streamId = stream->getStreamId();
             const int64 firstSampleInBlock = getFirstSampleNumberForBlock(streamId);
             const uint32 numSamplesInBlock = getNumSamplesInBlock(streamId);
 
-            // check to see if it's active and has a channel
-            if (module->isActive && module->outputLine >= 0
-                && module->triggerChannel >= 0
-                && module->triggerChannel < buffer.getNumChannels())
+            if (state == nullptr)
+                continue;
+
+            // lines left on by channels that were removed
+            for (auto line : module->linesToClear)
+                addEvent(module->createEvent(firstSampleInBlock, line, false), 0);
+
+            module->linesToClear.clearQuick();
+
+            if (module->outputLineChanged)
             {
-                for (int i = 0; i < numSamplesInBlock; ++i)
+                for (int i = 0; i < jmax(1, state->channels.size()); i++)
+                    addEvent(module->createEvent(firstSampleInBlock, module->lastOutputLine + i, false), 0);
+
+                module->outputLineChanged = false;
+            }
+
+            // check to see if it's active
+            if (module->isActive && module->outputLine >= 0 && numSamplesInBlock > 0)
+            {
+                for (int i = 0; i < state->channels.size(); i++)
                 {
-                    const float sample = *buffer.getReadPointer(module->triggerChannel, i);
-
-                    if (sample < module->lastSample
-                        && sample > 0
-                        && module->currentPhase != FALLING_POS)
-                    {
-                        if (module->detectorType == PEAK)
-                        {
-                            TTLEventPtr ptr = module->createEvent(
-                                                                  firstSampleInBlock + i,
-                                                                  true);
-
-                            addEvent(ptr, i);
-
-                            //LOGD("[phase detector] PEAK found!");
-                        }
-
-                        module->currentPhase = FALLING_POS;
-                    }
-                    else if (sample < 0
-                        && module->lastSample >= 0
-                        && module->currentPhase != FALLING_NEG)
-                    {
-                        if (module->detectorType == FALLING_ZERO)
-                        {
-
-                            TTLEventPtr ptr = module->createEvent(
-                                                                  firstSampleInBlock + i,
-                                                                  true);
-
-                            addEvent(ptr, i);
-
-                            //("FALLING ZERO");
-                        }
-
-                        module->currentPhase = FALLING_NEG;
-                    }
-                    else if (sample > module->lastSample
-                        && sample < 0
-                        && module->currentPhase != RISING_NEG)
-                    {
-                        if (module->detectorType == TROUGH)
-                        {
-
-                            TTLEventPtr ptr = module->createEvent(
-                                                                  firstSampleInBlock + i,
-                                                                  true);
-
-                            addEvent(ptr, i);
-
-                            //LOGD("TROUGH");
-                        }
-
-                        module->currentPhase = RISING_NEG;
-                    }
-                    else if (sample > 0
-                        && module->lastSample <= 0
-                        && module->currentPhase != RISING_POS)
-                    {
-                        if (module->detectorType == RISING_ZERO)
-                        {
-                            TTLEventPtr ptr = module->createEvent(
-                                                                  firstSampleInBlock + i,
-                                                                  true);
-
-                            addEvent(ptr, i);
-
-                            //LOGD("RISING ZERO");
-                        }
-
-                        module->currentPhase = RISING_POS;
-                    }
-
-                    module->lastSample = sample;
-
-                    if (module->wasTriggered)
-                    {
-                        if (module->samplesSinceTrigger > 2000)
-                        {
-                            TTLEventPtr ptr = module->createEvent(
-                                                                  firstSampleInBlock + i,
-                                                                  false);
-
-                            addEvent(ptr, i);
-
-                            //LOGD("TURNING OFF");
-                        }
-                        else
-                        {
-                            module->samplesSinceTrigger++;
-                        }
-                    }
-
-                    if (module->outputLineChanged)
-                    {
-                        TTLEventPtr ptr = module->clearOutputLine(
-                                                                 firstSampleInBlock + i);
-
-                        addEvent(ptr, i);
-
-                    }
+                    PhaseChannel* channel = state->channels.getUnchecked(i);
+
+                    if (channel->channel < 0 || channel->channel >= buffer.getNumChannels())
+                        continue;
+
+                    const float* data = buffer.getReadPointer(channel->channel);
+
+                    if (state->estimator == HILBERT && state->hilbert != nullptr)
+                        detectAnalyticPhase(module, i, channel, data, numSamplesInBlock, firstSampleInBlock);
+                    else
+                        detectZeroCrossings(module, i, channel, data, numSamplesInBlock, firstSampleInBlock);
                 }
             }
 
-            // If event is on when 'None' is selected in channel selector, turn off event
-            if (module->wasTriggered && module->triggerChannel < 0)
+            // end the pulses that finish in this block
+            for (int i = 0; i < state->channels.size(); i++)
             {
-                TTLEventPtr ptr = module->createEvent(firstSampleInBlock, false);
+                PhaseChannel* channel = state->channels.getUnchecked(i);
 
-                addEvent(ptr, 0);
+                if (channel->wasTriggered && channel->offSampleNumber < firstSampleInBlock + numSamplesInBlock)
+                {
+                    const int offIndex = jmax(0, int(channel->offSampleNumber - firstSampleInBlock));
+
+                    addEvent(module->createEvent(firstSampleInBlock + offIndex, module->outputLine + i, false), offIndex);
+
+                    channel->wasTriggered = false;
+                }
             }
         }
 
@@ -315,4 +446,3 @@ void PhaseDetector::process (AudioBuffer<float>& buffer)
     }
 }
 
-
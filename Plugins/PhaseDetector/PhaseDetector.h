@@ -26,6 +26,8 @@
 
 #include <ProcessorHeaders.h>
 
+#include "HilbertTransformer.h"
+
 enum PhaseType
 {
     NO_PHASE = 0, RISING_POS, FALLING_POS, FALLING_NEG, RISING_NEG
@@ -36,6 +38,52 @@ enum DetectorType
     PEAK = 0, FALLING_ZERO, TROUGH, RISING_ZERO
 };
 
+enum PhaseEstimator
+{
+    ZERO_CROSSING = 0, HILBERT
+};
+
+/** Phase tracking state for one input channel*/
+struct PhaseChannel
+{
+    /** Global index of the channel*/
+    int channel = -1;
+
+    // zero-crossing estimator
+    float lastSample = 0.0f;
+    PhaseType currentPhase = NO_PHASE;
+
+    // Hilbert estimator
+    HeapBlock<float> history;
+    int samplesUntilValid = 0;
+    float lastPhase = 0.0f;
+    float frequency = 0.0f;
+    float lastPhaseOffset = 0.0f;
+
+    // output pulse
+    bool wasTriggered = false;
+    int64 offSampleNumber = 0;
+};
+
+/** The channels and estimator used by one stream's phase detector.
+    Built on the message thread and swapped in at the start of a block.*/
+class PhaseDetectorState : public PreparedParameterState
+{
+public:
+    /** Constructor*/
+    PhaseDetectorState() { }
+
+    /** Destructor*/
+    ~PhaseDetectorState() { }
+
+    OwnedArray<PhaseChannel> channels;
+
+    PhaseEstimator estimator = ZERO_CROSSING;
+
+    /** Shared by all channels (nullptr unless estimator == HILBERT)*/
+    std::unique_ptr<HilbertTransformer> hilbert;
+};
+
 /** Holds settings for one stream's phase detector*/
 class PhaseDetectorSettings
 {
@@ -47,28 +95,23 @@ public:
     ~PhaseDetectorSettings() { }
 
     /** Creates an event for a particular stream*/
-    TTLEventPtr createEvent(int64 sample_number, bool state);
-    
-    /** Clears the output bit*/
-    TTLEventPtr clearOutputLine(int64 sample_number);
-
-    int samplesSinceTrigger;
-
-    float lastSample;
+    TTLEventPtr createEvent(int64 sample_number, int line, bool state);
 
     bool isActive;
-    bool wasTriggered;
     
     bool outputLineChanged;
     int lastOutputLine;
 
-    PhaseType currentPhase;
     DetectorType detectorType;
 
-    int triggerChannel;
     int outputLine;
     int gateLine;
 
+    /** Output lines that must be cleared at the start of the next block*/
+    Array<int> linesToClear;
+
+    std::unique_ptr<PhaseDetectorState> state;
+
     EventChannel* eventChannel;
 };
 
@@ -76,6 +119,12 @@ public:
     Uses peaks, troughs, and zero crossings to estimate 
     the phase of a continuous signal.
 
+    Up to MAX_PHASE_CHANNELS channels per stream can be tracked at once;
+    the nth selected channel drives output line TTL_out + n. For band-limited
+    signals, the phase can instead be estimated from the analytic signal
+    (see HilbertTransformer), and advanced by the filter delay so that
+    triggers are not delayed.
+
     See Siegle & Wilson (2014) for an example application
     https://elifesciences.org/articles/03061
 
@@ -96,16 +145,37 @@ public:
     /** Emits events at peaks, troughs, or zero-crossings*/
     void process (AudioBuffer<float>& buffer) override;
 
+    /** Only reads the continuous data */
+    bool isPassThrough() const override { return true; }
+
     /** Called when processor needs to update its settings*/
     void updateSettings() override;
 
     /** Called when a parameter is updated*/
     void parameterValueChanged(Parameter* param) override;
 
+    /** Swaps in a new channel list or estimator*/
+    void applyParameterChange(ParameterChange& change) override;
+
 private:
     /** Called whenever a new TTL event arrives*/
     void handleTTLEvent (TTLEventPtr event) override;
 
+    /** Builds the channels and estimator for a stream from its parameters, and queues them*/
+    void queueDetectorState(Parameter* param);
+
+    /** Finds peaks, troughs, and zero crossings from the sign and slope of each sample*/
+    void detectZeroCrossings(PhaseDetectorSettings* module, int index, PhaseChannel* channel,
+                             const float* data, int numSamples, int64 firstSampleInBlock);
+
+    /** Finds the samples at which the predicted analytic-signal phase crosses the target phase*/
+    void detectAnalyticPhase(PhaseDetectorSettings* module, int index, PhaseChannel* channel,
+                             const float* data, int numSamples, int64 firstSampleInBlock);
+
+    /** Turns on a channel's output line (ending its previous pulse first if necessary)*/
+    void triggerOutput(PhaseDetectorSettings* module, int index, PhaseChannel* channel,
+                       int sampleIndex, int64 firstSampleInBlock);
+
     StreamSettings<PhaseDetectorSettings> settings;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PhaseDetector);
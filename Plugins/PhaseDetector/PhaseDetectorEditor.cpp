@@ -33,11 +33,13 @@ PhaseDetectorEditor::PhaseDetectorEditor(GenericProcessor* parentNode)
     : GenericEditor(parentNode)
 
 {
-    desiredWidth = 220;
+    desiredWidth = 310;
 
     addSelectedChannelsParameterEditor("Channel", 120, 105);
     addComboBoxParameterEditor("TTL_out", 15, 30);
     addComboBoxParameterEditor("gate_line", 15, 80);
+    addComboBoxParameterEditor("estimator", 220, 30);
+    addTextBoxParameterEditor("hilbert_ms", 220, 80);
 
     Parameter* param = getProcessor()->getParameter("phase");
     addCustomParameterEditor(new DetectorInterface(param), 110, 25);
@@ -48,6 +48,9 @@ public:
     /** Call handleEvent() */
     void process (AudioBuffer<float>& buffer) override;
 
+    /** Does not modify the continuous data */
+    bool isPassThrough() const override { return true; }
+
     /** Respond to incoming events */
     void handleTTLEvent (TTLEventPtr event) override;
 
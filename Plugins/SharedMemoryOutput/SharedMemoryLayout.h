@@ -0,0 +1,188 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SHAREDMEMORYLAYOUT_H_INCLUDED
+#define SHAREDMEMORYLAYOUT_H_INCLUDED
+
+/**
+
+    Layout of the POSIX shared-memory segment written by the Shared Memory Output
+    processor. This header is plain C so that it can be used by external readers
+    (see reader/oe_shm_reader.h).
+
+    The segment is named "/oe_<segment_name>" and contains, in order:
+
+      oe_shm_header                                   (at offset 0)
+      per stream:  oe_shm_channel[num_channels]       (at channel_offset)
+                   float[num_channels][ring_samples]  (at data_offset)
+                   oe_shm_block[OE_SHM_BLOCK_CAPACITY] (at block_offset)
+      oe_shm_event[event_capacity]                    (at event_offset)
+      oe_shm_spike[spike_capacity]                    (at spike_offset)
+
+    All offsets are in bytes from the start of the segment, and all rings have a
+    power-of-two capacity, so an absolute index i lives in slot (i & (capacity - 1)).
+
+    There is a single writer and any number of readers. Nothing ever blocks:
+
+    - The stream descriptors in the header are protected by a seqlock. The writer
+      makes 'seq' odd, updates the descriptors, then makes it even again. Readers
+      copy the descriptors and retry if 'seq' was odd or changed in the meantime.
+      A change of 'seq' also means that all cursors were reset.
+
+    - Each ring has a cursor that counts the total number of items written. Before
+      writing, the writer stores the index it is about to write up to in
+      'write_reserve' (followed by a release fence); it then fills the ring slots and
+      publishes the new 'write_index' with a release store. Readers load
+      'write_index' with an acquire load, copy up to it, issue an acquire fence and
+      then load 'write_reserve': any item older than (write_reserve - capacity) may
+      have been overwritten while it was being copied and must be discarded.
+
+    - Each continuous block has an entry in the stream's block table, giving the
+      sample number and timestamp of its first sample and its position in the ring.
+
+    - When the segment is about to be removed (e.g. the processor is deleted or
+      its size changes), 'state' is set to OE_SHM_STATE_CLOSED and readers should
+      re-open the segment by name.
+
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OE_SHM_MAGIC            0x4853454Fu   /* "OESH" */
+#define OE_SHM_VERSION          1
+#define OE_SHM_MAX_STREAMS      32
+#define OE_SHM_NAME_LENGTH      64
+#define OE_SHM_CHANNEL_NAME_LENGTH 32
+#define OE_SHM_BLOCK_CAPACITY   4096
+#define OE_SHM_MAX_SPIKE_VALUES 384
+
+#define OE_SHM_STATE_STOPPED    0
+#define OE_SHM_STATE_RUNNING    1
+#define OE_SHM_STATE_CLOSED     2
+
+/* Atomic access to the cursors and the seqlock, for C readers (GCC and Clang) */
+#if defined(__GNUC__) || defined(__clang__)
+#define OE_SHM_LOAD_ACQUIRE(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define OE_SHM_STORE_RELEASE(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define OE_SHM_FENCE_ACQUIRE()      __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define OE_SHM_FENCE_RELEASE()      __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+/** A counter written only by the writer, on its own cache line */
+typedef struct oe_shm_cursor
+{
+    uint64_t write_index;   /* total items written (samples per channel, events or spikes) */
+    uint64_t write_reserve; /* index the writer may currently be writing up to */
+    uint64_t block_count;   /* total blocks written (continuous streams only) */
+    uint64_t reserved[5];
+} oe_shm_cursor;
+
+/** Describes one continuous data stream (protected by the header seqlock) */
+typedef struct oe_shm_stream
+{
+    char     name[OE_SHM_NAME_LENGTH];
+    uint16_t stream_id;
+    uint16_t source_node_id;
+    uint32_t num_channels;
+    double   sample_rate;
+    uint64_t ring_samples;      /* capacity of each channel's ring */
+    uint64_t channel_offset;    /* oe_shm_channel[num_channels] */
+    uint64_t data_offset;       /* float[num_channels][ring_samples], one ring per channel */
+    uint64_t block_offset;      /* oe_shm_block[OE_SHM_BLOCK_CAPACITY] */
+} oe_shm_stream;
+
+/** Describes one published continuous channel */
+typedef struct oe_shm_channel
+{
+    char     name[OE_SHM_CHANNEL_NAME_LENGTH];
+    float    bit_volts;
+    uint32_t global_index;      /* index within the processor's input buffer */
+} oe_shm_channel;
+
+/** One processing block of a continuous stream */
+typedef struct oe_shm_block
+{
+    int64_t  sample_number;     /* sample number of the first sample in the block */
+    double   timestamp;         /* synchronized timestamp (s) of the first sample, or -1 */
+    uint64_t ring_index;        /* absolute ring index of the first sample */
+    uint32_t num_samples;
+    uint32_t reserved;
+} oe_shm_block;
+
+/** A TTL event */
+typedef struct oe_shm_event
+{
+    int64_t  sample_number;
+    double   timestamp;
+    uint64_t word;              /* full TTL word after this event */
+    uint16_t stream_id;
+    uint16_t processor_id;
+    uint8_t  line;
+    uint8_t  state;
+    uint8_t  reserved[2];
+} oe_shm_event;
+
+/** A spike; the waveform is stored channel by channel */
+typedef struct oe_shm_spike
+{
+    int64_t  sample_number;
+    double   timestamp;
+    uint16_t stream_id;
+    uint16_t electrode;         /* index of the spike channel within the processor */
+    uint16_t sorted_id;
+    uint16_t num_channels;
+    uint32_t num_samples;       /* per channel */
+    uint32_t reserved;
+    float    waveform[OE_SHM_MAX_SPIKE_VALUES];
+} oe_shm_spike;
+
+typedef struct oe_shm_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t total_size;        /* size of the segment in bytes */
+    uint32_t seq;               /* seqlock sequence number (odd while the layout is being written) */
+    uint32_t state;             /* OE_SHM_STATE_* */
+    uint32_t num_streams;
+    uint32_t reserved;
+    uint64_t event_offset;
+    uint64_t event_capacity;
+    uint64_t spike_offset;
+    uint64_t spike_capacity;
+    uint64_t padding[8];        /* keeps the cursors on their own cache lines */
+
+    oe_shm_stream streams[OE_SHM_MAX_STREAMS];
+
+    oe_shm_cursor stream_cursors[OE_SHM_MAX_STREAMS];
+    oe_shm_cursor event_cursor;
+    oe_shm_cursor spike_cursor;
+} oe_shm_header;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
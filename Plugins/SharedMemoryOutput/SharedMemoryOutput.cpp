@@ -0,0 +1,510 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SharedMemoryOutput.h"
+#include "SharedMemoryOutputEditor.h"
+
+#include <atomic>
+
+#if !JUCE_WINDOWS
+#include <sys/mman.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define EVENT_RING_CAPACITY 65536
+#define SPIKE_RING_CAPACITY 4096
+#define MIN_RING_SAMPLES 8192
+
+static_assert (sizeof (std::atomic<uint64_t>) == sizeof (uint64_t), "Cursors must be plain 64-bit integers");
+static_assert (sizeof (std::atomic<uint32_t>) == sizeof (uint32_t), "The sequence number must be a plain 32-bit integer");
+
+/* The segment is shared with C readers, so the cursors are plain integers that
+   are accessed atomically in place */
+static void storeRelease (uint64_t* cursor, uint64_t value)
+{
+    reinterpret_cast<std::atomic<uint64_t>*> (cursor)->store (value, std::memory_order_release);
+}
+
+/* Announces that the slots up to 'end' are about to be overwritten (see SharedMemoryLayout.h) */
+static void reserve (oe_shm_cursor* cursor, uint64_t end)
+{
+    reinterpret_cast<std::atomic<uint64_t>*> (&cursor->write_reserve)->store (end, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+}
+
+static void storeRelease (uint32_t* value, uint32_t newValue)
+{
+    reinterpret_cast<std::atomic<uint32_t>*> (value)->store (newValue, std::memory_order_release);
+}
+
+static uint64 getRingSize (uint64 minimumSize)
+{
+    uint64 size = MIN_RING_SAMPLES;
+
+    while (size < minimumSize)
+        size <<= 1;
+
+    return size;
+}
+
+/* Keeps every region on its own cache line */
+static uint64 align (uint64 offset)
+{
+    return (offset + 63) & ~uint64 (63);
+}
+
+SharedMemoryOutput::SharedMemoryOutput()
+    : GenericProcessor  ("Shared Memory Output")
+    , header            (nullptr)
+    , base              (nullptr)
+    , mappedSize        (0)
+    , events            (nullptr)
+    , eventCapacity     (0)
+    , eventCount        (0)
+    , spikes            (nullptr)
+    , spikeCapacity     (0)
+    , spikeCount        (0)
+    , isPublishing      (false)
+    , publishEvents     (true)
+    , publishSpikes     (true)
+{
+
+    addStringParameter(Parameter::GLOBAL_SCOPE,
+                       "segment_name",
+                       "Name of the shared-memory segment (opened by readers as /oe_<name>)",
+                       "open-ephys",
+                       true);
+
+    addIntParameter(Parameter::GLOBAL_SCOPE,
+                    "buffer_ms",
+                    "Minimum length of each continuous ring, in milliseconds",
+                    2000,
+                    100,
+                    60000,
+                    true);
+
+    addBooleanParameter(Parameter::GLOBAL_SCOPE,
+                        "events",
+                        "Publish TTL events",
+                        true,
+                        true);
+
+    addBooleanParameter(Parameter::GLOBAL_SCOPE,
+                        "spikes",
+                        "Publish spikes",
+                        true,
+                        true);
+
+    addSelectedChannelsParameter(Parameter::STREAM_SCOPE,
+                                 "Channels",
+                                 "The continuous channels to publish",
+                                 std::numeric_limits<int>::max(),
+                                 true);
+}
+
+
+SharedMemoryOutput::~SharedMemoryOutput()
+{
+    closeSegment();
+}
+
+
+AudioProcessorEditor* SharedMemoryOutput::createEditor()
+{
+    editor = std::make_unique<SharedMemoryOutputEditor> (this);
+    return editor.get();
+}
+
+
+bool SharedMemoryOutput::openSegment (const String& name, size_t size)
+{
+
+    if (base != nullptr && name == segmentName && size == mappedSize)
+        return true;
+
+    closeSegment();
+
+#if JUCE_WINDOWS
+
+    LOGE("Shared Memory Output: POSIX shared memory is not available on Windows.");
+    return false;
+
+#else
+
+    const String path = "/oe_" + name;
+
+    // remove any segment left behind by a previous session, so the size can change
+    shm_unlink (path.toRawUTF8());
+
+    int fd = shm_open (path.toRawUTF8(), O_CREAT | O_RDWR, 0600);
+
+    if (fd < 0)
+    {
+        LOGE("Shared Memory Output: could not create ", path, " (", strerror(errno), ")");
+        return false;
+    }
+
+    if (ftruncate (fd, (off_t) size) != 0)
+    {
+        LOGE("Shared Memory Output: could not resize ", path, " to ", (int64) size, " bytes (", strerror(errno), ")");
+        close (fd);
+        shm_unlink (path.toRawUTF8());
+        return false;
+    }
+
+    void* address = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+
+    if (address == MAP_FAILED)
+    {
+        LOGE("Shared Memory Output: could not map ", path, " (", strerror(errno), ")");
+        shm_unlink (path.toRawUTF8());
+        return false;
+    }
+
+    base = address;
+    mappedSize = size;
+    segmentName = name;
+    header = static_cast<oe_shm_header*> (base);
+
+    LOGC("Shared Memory Output: created ", path, " (", (int64) size / 1024, " kB)");
+
+    return true;
+
+#endif
+}
+
+
+void SharedMemoryOutput::closeSegment()
+{
+    if (base == nullptr)
+        return;
+
+    storeRelease (&header->state, uint32 (OE_SHM_STATE_CLOSED));
+
+#if !JUCE_WINDOWS
+    munmap (base, mappedSize);
+    shm_unlink (("/oe_" + segmentName).toRawUTF8());
+#endif
+
+    base = nullptr;
+    header = nullptr;
+    mappedSize = 0;
+    rings.clear();
+    events = nullptr;
+    spikes = nullptr;
+}
+
+
+bool SharedMemoryOutput::startAcquisition()
+{
+
+    isPublishing = false;
+    rings.clear();
+
+    /* Compute the layout */
+    struct StreamLayout
+    {
+        const DataStream* stream;
+        Array<int> localChannels;
+        uint64 ringSamples;
+        uint64 channelOffset;
+        uint64 dataOffset;
+        uint64 blockOffset;
+    };
+
+    Array<StreamLayout> layouts;
+
+    uint64 offset = align (sizeof (oe_shm_header));
+
+    for (auto stream : getDataStreams())
+    {
+        if (layouts.size() == OE_SHM_MAX_STREAMS)
+        {
+            LOGE("Shared Memory Output: only the first ", OE_SHM_MAX_STREAMS, " streams are published.");
+            break;
+        }
+
+        StreamLayout layout;
+        layout.stream = stream;
+
+        Array<var>* selected = (*stream)["Channels"].getArray();
+
+        if (selected != nullptr)
+        {
+            for (auto& channel : *selected)
+                layout.localChannels.add (int (channel));
+        }
+
+        const int bufferMs = (int) getParameter ("buffer_ms")->getValue();
+
+        layout.ringSamples = getRingSize (uint64 (stream->getSampleRate() * bufferMs / 1000.0));
+
+        layout.channelOffset = offset;
+        offset = align (offset + layout.localChannels.size() * sizeof (oe_shm_channel));
+
+        layout.dataOffset = offset;
+        offset = align (offset + layout.localChannels.size() * layout.ringSamples * sizeof (float));
+
+        layout.blockOffset = offset;
+        offset = align (offset + OE_SHM_BLOCK_CAPACITY * sizeof (oe_shm_block));
+
+        layouts.add (layout);
+    }
+
+    const uint64 eventOffset = offset;
+    offset = align (offset + EVENT_RING_CAPACITY * sizeof (oe_shm_event));
+
+    const uint64 spikeOffset = offset;
+    offset = align (offset + SPIKE_RING_CAPACITY * sizeof (oe_shm_spike));
+
+    publishEvents = (bool) getParameter ("events")->getValue();
+    publishSpikes = (bool) getParameter ("spikes")->getValue();
+
+    if (!openSegment (getParameter ("segment_name")->getValue().toString(), (size_t) offset))
+        return true; // don't prevent acquisition from starting
+
+    /* Write the layout under the seqlock */
+    const uint32 seq = header->seq;
+    storeRelease (&header->seq, seq + 1);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    header->magic = OE_SHM_MAGIC;
+    header->version = OE_SHM_VERSION;
+    header->total_size = offset;
+    header->num_streams = (uint32) layouts.size();
+    header->event_offset = eventOffset;
+    header->event_capacity = EVENT_RING_CAPACITY;
+    header->spike_offset = spikeOffset;
+    header->spike_capacity = SPIKE_RING_CAPACITY;
+
+    for (int i = 0; i < layouts.size(); ++i)
+    {
+        const StreamLayout& layout = layouts.getReference (i);
+        oe_shm_stream& desc = header->streams[i];
+
+        zerostruct (desc);
+        layout.stream->getName().copyToUTF8 (desc.name, OE_SHM_NAME_LENGTH);
+        desc.stream_id = layout.stream->getStreamId();
+        desc.source_node_id = (uint16) layout.stream->getSourceNodeId();
+        desc.num_channels = (uint32) layout.localChannels.size();
+        desc.sample_rate = layout.stream->getSampleRate();
+        desc.ring_samples = layout.ringSamples;
+        desc.channel_offset = layout.channelOffset;
+        desc.data_offset = layout.dataOffset;
+        desc.block_offset = layout.blockOffset;
+
+        StreamRing* ring = new StreamRing();
+        ring->streamId = desc.stream_id;
+        ring->data = at<float> (layout.dataOffset);
+        ring->blocks = at<oe_shm_block> (layout.blockOffset);
+        ring->cursor = &header->stream_cursors[i];
+        ring->ringSamples = layout.ringSamples;
+        ring->writeIndex = 0;
+        ring->blockCount = 0;
+
+        oe_shm_channel* channelInfo = at<oe_shm_channel> (layout.channelOffset);
+
+        for (int ch = 0; ch < layout.localChannels.size(); ++ch)
+        {
+            const ContinuousChannel* channel = layout.stream->getContinuousChannels()[layout.localChannels[ch]];
+
+            zerostruct (channelInfo[ch]);
+            channel->getName().copyToUTF8 (channelInfo[ch].name, OE_SHM_CHANNEL_NAME_LENGTH);
+            channelInfo[ch].bit_volts = channel->getBitVolts();
+            channelInfo[ch].global_index = (uint32) channel->getGlobalIndex();
+
+            ring->channels.add (channel->getGlobalIndex());
+        }
+
+        zerostruct (header->stream_cursors[i]);
+        rings.add (ring);
+    }
+
+    zerostruct (header->event_cursor);
+    zerostruct (header->spike_cursor);
+
+    events = at<oe_shm_event> (eventOffset);
+    eventCapacity = EVENT_RING_CAPACITY;
+    eventCount = 0;
+
+    spikes = at<oe_shm_spike> (spikeOffset);
+    spikeCapacity = SPIKE_RING_CAPACITY;
+    spikeCount = 0;
+
+    header->state = OE_SHM_STATE_RUNNING;
+
+    storeRelease (&header->seq, seq + 2);
+
+    isPublishing = true;
+
+    return true;
+}
+
+
+bool SharedMemoryOutput::stopAcquisition()
+{
+    if (header != nullptr)
+        storeRelease (&header->state, uint32 (OE_SHM_STATE_STOPPED));
+
+    isPublishing = false;
+
+    return true;
+}
+
+
+void SharedMemoryOutput::updateSettings()
+{
+    for (auto channel : spikeChannels)
+    {
+        if (channel->getTotalSamples() > OE_SHM_MAX_SPIKE_VALUES)
+        {
+            LOGE("Shared Memory Output: spikes on ", channel->getName(), " have ", channel->getTotalSamples(),
+                 " samples; only the first ", OE_SHM_MAX_SPIKE_VALUES, " samples of the first channel are published.");
+        }
+    }
+}
+
+
+void SharedMemoryOutput::parameterValueChanged (Parameter* parameter)
+{
+    if (parameter->getName() == "events")
+        publishEvents = (bool) parameter->getValue();
+    else if (parameter->getName() == "spikes")
+        publishSpikes = (bool) parameter->getValue();
+}
+
+
+void SharedMemoryOutput::process (AudioBuffer<float>& buffer)
+{
+
+    if (!isPublishing)
+        return;
+
+    checkForEvents (publishSpikes);
+
+    for (auto ring : rings)
+    {
+        const uint32 numSamples = getNumSamplesInBlock (ring->streamId);
+
+        if (numSamples == 0)
+            continue;
+
+        // a block longer than the ring would overwrite itself, so only its end is kept
+        const uint64 skipped = numSamples > ring->ringSamples ? numSamples - ring->ringSamples : 0;
+        const uint64 samplesToWrite = numSamples - skipped;
+
+        const uint64 mask = ring->ringSamples - 1;
+        const uint64 position = (ring->writeIndex + skipped) & mask;
+        const uint64 firstPart = jmin (samplesToWrite, ring->ringSamples - position);
+
+        reserve (ring->cursor, ring->writeIndex + numSamples);
+
+        for (int i = 0; i < ring->channels.size(); ++i)
+        {
+            const float* source = buffer.getReadPointer (ring->channels[i]) + skipped;
+            float* dest = ring->data + i * ring->ringSamples;
+
+            memcpy (dest + position, source, firstPart * sizeof (float));
+
+            if (firstPart < samplesToWrite)
+                memcpy (dest, source + firstPart, (samplesToWrite - firstPart) * sizeof (float));
+        }
+
+        oe_shm_block& block = ring->blocks[ring->blockCount & (OE_SHM_BLOCK_CAPACITY - 1)];
+        block.sample_number = getFirstSampleNumberForBlock (ring->streamId);
+        block.timestamp = getFirstTimestampForBlock (ring->streamId);
+        block.ring_index = ring->writeIndex;
+        block.num_samples = numSamples;
+
+        ring->writeIndex += numSamples;
+        ring->blockCount += 1;
+
+        storeRelease (&ring->cursor->write_index, ring->writeIndex);
+        storeRelease (&ring->cursor->block_count, ring->blockCount);
+    }
+}
+
+
+void SharedMemoryOutput::handleTTLEvent (TTLEventPtr event)
+{
+
+    if (!publishEvents)
+        return;
+
+    reserve (&header->event_cursor, eventCount + 1);
+
+    oe_shm_event& record = events[eventCount & (eventCapacity - 1)];
+
+    record.sample_number = event->getSampleNumber();
+    record.timestamp = event->getTimestampInSeconds();
+    record.word = event->getWord();
+    record.stream_id = event->getStreamId();
+    record.processor_id = event->getProcessorId();
+    record.line = event->getLine();
+    record.state = event->getState() ? 1 : 0;
+
+    storeRelease (&header->event_cursor.write_index, ++eventCount);
+}
+
+
+void SharedMemoryOutput::handleSpike (SpikePtr spike)
+{
+
+    const SpikeChannel* channel = spike->getChannelInfo();
+
+    const uint32 numChannels = channel->getNumChannels();
+    const uint32 numSamples = channel->getTotalSamples();
+
+    reserve (&header->spike_cursor, spikeCount + 1);
+
+    oe_shm_spike& record = spikes[spikeCount & (spikeCapacity - 1)];
+
+    record.sample_number = spike->getSampleNumber();
+    record.timestamp = spike->getTimestampInSeconds();
+    record.stream_id = spike->getStreamId();
+    record.electrode = (uint16) getIndexOfMatchingChannel (channel);
+    record.sorted_id = spike->getSortedId();
+    record.num_channels = (uint16) numChannels;
+
+    // waveforms that don't fit are truncated to whole channels, or to the
+    // start of the first channel if even one channel is too long
+    record.num_samples = numSamples;
+
+    if (numSamples > OE_SHM_MAX_SPIKE_VALUES)
+    {
+        record.num_channels = 1;
+        record.num_samples = OE_SHM_MAX_SPIKE_VALUES;
+    }
+    else if (numChannels * numSamples > OE_SHM_MAX_SPIKE_VALUES)
+    {
+        record.num_channels = (uint16) (OE_SHM_MAX_SPIKE_VALUES / jmax (1u, numSamples));
+    }
+
+    memcpy (record.waveform, spike->getDataPointer(), record.num_channels * record.num_samples * sizeof (float));
+
+    storeRelease (&header->spike_cursor.write_index, ++spikeCount);
+}
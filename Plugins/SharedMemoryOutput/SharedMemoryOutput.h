@@ -0,0 +1,126 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SHAREDMEMORYOUTPUT_H_3F2A9C71__
+#define __SHAREDMEMORYOUTPUT_H_3F2A9C71__
+
+#include <ProcessorHeaders.h>
+
+#include "SharedMemoryLayout.h"
+
+/**
+    Publishes selected continuous channels, TTL events and spikes into a
+    POSIX shared-memory segment, so that processes on the same machine can
+    read them with minimal latency and without copying through sockets.
+
+    The layout of the segment is described in SharedMemoryLayout.h, and
+    reader/oe_shm_reader.h provides a small C library for consumers.
+
+    Shared memory is only available on Linux and macOS.
+
+    @see SharedMemoryLayout.h
+*/
+class SharedMemoryOutput : public GenericProcessor
+{
+public:
+
+    /** Constructor */
+    SharedMemoryOutput();
+
+    /** Destructor (removes the shared-memory segment) */
+    ~SharedMemoryOutput();
+
+    /** Creates the Shared Memory Output editor */
+    AudioProcessorEditor* createEditor() override;
+
+    /** Writes the selected channels of each stream into their rings */
+    void process (AudioBuffer<float>& buffer) override;
+
+    /** Only reads the continuous data */
+    bool isPassThrough() const override { return true; }
+
+    /** Publishes a TTL event */
+    void handleTTLEvent (TTLEventPtr event) override;
+
+    /** Publishes a spike */
+    void handleSpike (SpikePtr spike) override;
+
+    /** Lays out the segment for the current streams and starts publishing */
+    bool startAcquisition() override;
+
+    /** Marks the segment as stopped (readers can still access the last data) */
+    bool stopAcquisition() override;
+
+    /** Warns about spike channels whose waveforms don't fit in a spike record */
+    void updateSettings() override;
+
+    /** Caches the "events" and "spikes" flags for the audio thread */
+    void parameterValueChanged (Parameter* parameter) override;
+
+private:
+
+    /** Per-stream writer state */
+    struct StreamRing
+    {
+        uint16 streamId;
+        Array<int> channels;        // global channel indices in the input buffer
+        float* data;
+        oe_shm_block* blocks;
+        oe_shm_cursor* cursor;
+        uint64 ringSamples;
+        uint64 writeIndex;
+        uint64 blockCount;
+    };
+
+    /** Creates (or reuses) a segment of the given size; returns false on failure */
+    bool openSegment (const String& name, size_t size);
+
+    /** Marks the segment as closed, unmaps it and removes its name */
+    void closeSegment();
+
+    /** Returns the address of an offset within the segment */
+    template <typename T>
+    T* at (uint64 offset) const { return reinterpret_cast<T*> (static_cast<char*> (base) + offset); }
+
+    OwnedArray<StreamRing> rings;
+
+    oe_shm_header* header;
+    void* base;
+    size_t mappedSize;
+    String segmentName;
+
+    oe_shm_event* events;
+    uint64 eventCapacity;
+    uint64 eventCount;
+
+    oe_shm_spike* spikes;
+    uint64 spikeCapacity;
+    uint64 spikeCount;
+
+    bool isPublishing;
+    bool publishEvents;
+    bool publishSpikes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemoryOutput);
+};
+
+#endif
@@ -0,0 +1,37 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemoryOutputEditor.h"
+#include "SharedMemoryOutput.h"
+
+SharedMemoryOutputEditor::SharedMemoryOutputEditor(GenericProcessor* parentNode)
+    : GenericEditor(parentNode)
+{
+    desiredWidth = 220;
+
+    addTextBoxParameterEditor("segment_name", 15, 25);
+    addTextBoxParameterEditor("buffer_ms", 120, 25);
+    addSelectedChannelsParameterEditor("Channels", 15, 75);
+    addCheckBoxParameterEditor("events", 120, 70);
+    addCheckBoxParameterEditor("spikes", 120, 95);
+}
@@ -0,0 +1,504 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "oe_shm_reader.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_ATTEMPTS 10000
+
+struct oe_shm_reader
+{
+    char path[OE_SHM_NAME_LENGTH + 8];
+
+    const uint8_t* base;
+    size_t size;
+    const oe_shm_header* header;
+
+    /* snapshot of the layout, taken under the seqlock */
+    uint32_t seq;
+    uint32_t num_streams;
+    oe_shm_stream streams[OE_SHM_MAX_STREAMS];
+    oe_shm_channel* channels[OE_SHM_MAX_STREAMS];
+    uint64_t event_offset;
+    uint64_t event_capacity;
+    uint64_t spike_offset;
+    uint64_t spike_capacity;
+};
+
+static uint64_t load_relaxed(const uint64_t* value)
+{
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+static int is_power_of_two(uint64_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static int region_is_valid(const oe_shm_reader* reader, uint64_t offset, uint64_t bytes)
+{
+    return offset <= reader->size && bytes <= reader->size - offset;
+}
+
+static void free_channels(oe_shm_reader* reader)
+{
+    uint32_t i;
+
+    for (i = 0; i < OE_SHM_MAX_STREAMS; ++i)
+    {
+        free(reader->channels[i]);
+        reader->channels[i] = NULL;
+    }
+}
+
+static void unmap(oe_shm_reader* reader)
+{
+    if (reader->base != NULL)
+        munmap((void*) reader->base, reader->size);
+
+    reader->base = NULL;
+    reader->header = NULL;
+    reader->size = 0;
+    reader->num_streams = 0;
+    free_channels(reader);
+}
+
+static int map(oe_shm_reader* reader)
+{
+    struct stat info;
+    void* address;
+    int fd = shm_open(reader->path, O_RDONLY, 0);
+
+    if (fd < 0)
+        return OE_SHM_ERR_OPEN;
+
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(oe_shm_header))
+    {
+        close(fd);
+        return OE_SHM_ERR_OPEN;
+    }
+
+    address = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (address == MAP_FAILED)
+        return OE_SHM_ERR_OPEN;
+
+    reader->base = (const uint8_t*) address;
+    reader->size = (size_t) info.st_size;
+    reader->header = (const oe_shm_header*) address;
+
+    if (reader->header->magic != OE_SHM_MAGIC || reader->header->version != OE_SHM_VERSION)
+    {
+        unmap(reader);
+        return OE_SHM_ERR_FORMAT;
+    }
+
+    return OE_SHM_OK;
+}
+
+/* Copies the stream descriptors; returns 1 if they were consistent */
+static int try_snapshot(oe_shm_reader* reader)
+{
+    const oe_shm_header* header = reader->header;
+    uint32_t seq = OE_SHM_LOAD_ACQUIRE(&header->seq);
+    uint32_t i;
+
+    if (seq & 1)
+        return 0;
+
+    reader->num_streams = header->num_streams;
+    reader->event_offset = header->event_offset;
+    reader->event_capacity = header->event_capacity;
+    reader->spike_offset = header->spike_offset;
+    reader->spike_capacity = header->spike_capacity;
+
+    if (reader->num_streams > OE_SHM_MAX_STREAMS)
+        reader->num_streams = OE_SHM_MAX_STREAMS;
+
+    memcpy(reader->streams, header->streams, sizeof(oe_shm_stream) * reader->num_streams);
+
+    for (i = 0; i < reader->num_streams; ++i)
+    {
+        const oe_shm_stream* stream = &reader->streams[i];
+        uint64_t bytes = (uint64_t) stream->num_channels * sizeof(oe_shm_channel);
+
+        free(reader->channels[i]);
+        reader->channels[i] = NULL;
+
+        if (!region_is_valid(reader, stream->channel_offset, bytes))
+            return 0;
+
+        reader->channels[i] = (oe_shm_channel*) malloc(bytes > 0 ? bytes : 1);
+
+        if (reader->channels[i] == NULL)
+            return 0;
+
+        memcpy(reader->channels[i], reader->base + stream->channel_offset, bytes);
+    }
+
+    OE_SHM_FENCE_ACQUIRE();
+
+    if (__atomic_load_n(&header->seq, __ATOMIC_RELAXED) != seq)
+        return 0;
+
+    reader->seq = seq;
+
+    return 1;
+}
+
+static int validate_snapshot(const oe_shm_reader* reader)
+{
+    uint32_t i;
+
+    if (!is_power_of_two(reader->event_capacity)
+        || !is_power_of_two(reader->spike_capacity)
+        || !region_is_valid(reader, reader->event_offset, reader->event_capacity * sizeof(oe_shm_event))
+        || !region_is_valid(reader, reader->spike_offset, reader->spike_capacity * sizeof(oe_shm_spike)))
+        return OE_SHM_ERR_FORMAT;
+
+    for (i = 0; i < reader->num_streams; ++i)
+    {
+        const oe_shm_stream* stream = &reader->streams[i];
+
+        if (!is_power_of_two(stream->ring_samples)
+            || !region_is_valid(reader, stream->data_offset,
+                                (uint64_t) stream->num_channels * stream->ring_samples * sizeof(float))
+            || !region_is_valid(reader, stream->block_offset, OE_SHM_BLOCK_CAPACITY * sizeof(oe_shm_block)))
+            return OE_SHM_ERR_FORMAT;
+    }
+
+    return OE_SHM_OK;
+}
+
+static int snapshot(oe_shm_reader* reader)
+{
+    int attempt;
+
+    for (attempt = 0; attempt < SNAPSHOT_ATTEMPTS; ++attempt)
+    {
+        if (try_snapshot(reader))
+            return validate_snapshot(reader);
+
+        sched_yield();
+    }
+
+    return OE_SHM_ERR_LAYOUT_CHANGED;
+}
+
+/* Returns OE_SHM_OK if the snapshot still describes the segment */
+static int check(const oe_shm_reader* reader)
+{
+    if (reader->header == NULL || OE_SHM_LOAD_ACQUIRE(&reader->header->state) == OE_SHM_STATE_CLOSED)
+        return OE_SHM_ERR_CLOSED;
+
+    if (OE_SHM_LOAD_ACQUIRE(&reader->header->seq) != reader->seq)
+        return OE_SHM_ERR_LAYOUT_CHANGED;
+
+    return OE_SHM_OK;
+}
+
+int oe_shm_open(const char* name, oe_shm_reader** result)
+{
+    int error;
+    oe_shm_reader* reader = (oe_shm_reader*) calloc(1, sizeof(oe_shm_reader));
+
+    *result = NULL;
+
+    if (reader == NULL)
+        return OE_SHM_ERR_OPEN;
+
+    snprintf(reader->path, sizeof(reader->path), "/oe_%s", name);
+
+    error = map(reader);
+
+    if (error == OE_SHM_OK)
+        error = snapshot(reader);
+
+    if (error != OE_SHM_OK)
+    {
+        oe_shm_close(reader);
+        return error;
+    }
+
+    *result = reader;
+
+    return OE_SHM_OK;
+}
+
+void oe_shm_close(oe_shm_reader* reader)
+{
+    if (reader == NULL)
+        return;
+
+    unmap(reader);
+    free(reader);
+}
+
+int oe_shm_refresh(oe_shm_reader* reader)
+{
+    int error;
+
+    if (check(reader) == OE_SHM_ERR_CLOSED)
+    {
+        unmap(reader);
+
+        error = map(reader);
+
+        if (error != OE_SHM_OK)
+            return error;
+    }
+
+    return snapshot(reader);
+}
+
+int oe_shm_state(const oe_shm_reader* reader)
+{
+    if (reader->header == NULL)
+        return OE_SHM_STATE_CLOSED;
+
+    return (int) OE_SHM_LOAD_ACQUIRE(&reader->header->state);
+}
+
+int oe_shm_num_streams(const oe_shm_reader* reader)
+{
+    return (int) reader->num_streams;
+}
+
+const oe_shm_stream* oe_shm_get_stream(const oe_shm_reader* reader, int stream)
+{
+    if (stream < 0 || (uint32_t) stream >= reader->num_streams)
+        return NULL;
+
+    return &reader->streams[stream];
+}
+
+const oe_shm_channel* oe_shm_get_channels(const oe_shm_reader* reader, int stream)
+{
+    if (stream < 0 || (uint32_t) stream >= reader->num_streams)
+        return NULL;
+
+    return reader->channels[stream];
+}
+
+uint64_t oe_shm_stream_write_index(const oe_shm_reader* reader, int stream)
+{
+    if (stream < 0 || (uint32_t) stream >= reader->num_streams)
+        return 0;
+
+    return OE_SHM_LOAD_ACQUIRE(&reader->header->stream_cursors[stream].write_index);
+}
+
+const float* oe_shm_channel_ring(const oe_shm_reader* reader, int stream, int channel)
+{
+    const oe_shm_stream* desc = oe_shm_get_stream(reader, stream);
+
+    if (desc == NULL || channel < 0 || (uint32_t) channel >= desc->num_channels)
+        return NULL;
+
+    return (const float*) (reader->base + desc->data_offset) + (uint64_t) channel * desc->ring_samples;
+}
+
+/* Clamps *position to the readable part of a ring and returns how many items to copy */
+static uint64_t begin_read(uint64_t write_index, uint64_t capacity, uint64_t* position, uint64_t max_items, uint64_t* lost)
+{
+    *lost = 0;
+
+    if (*position > write_index)
+        *position = write_index;
+
+    if (write_index - *position > capacity)
+    {
+        *lost = write_index - capacity - *position;
+        *position = write_index - capacity;
+    }
+
+    return write_index - *position < max_items ? write_index - *position : max_items;
+}
+
+/* Returns how many of the n items starting at position may have been overwritten during the copy */
+static uint64_t end_read(const oe_shm_cursor* cursor, uint64_t capacity, uint64_t position, uint64_t n)
+{
+    uint64_t reserve;
+
+    OE_SHM_FENCE_ACQUIRE();
+
+    reserve = load_relaxed(&cursor->write_reserve);
+
+    if (reserve <= capacity || reserve - capacity <= position)
+        return 0;
+
+    return reserve - capacity - position < n ? reserve - capacity - position : n;
+}
+
+int64_t oe_shm_read_continuous(oe_shm_reader* reader, int stream, uint64_t* position,
+                               float* dest, uint64_t max_samples, uint64_t* dropped)
+{
+    const oe_shm_stream* desc;
+    const oe_shm_cursor* cursor;
+    const float* data;
+    uint64_t capacity, start, n, lost, overwritten, i;
+    uint32_t ch;
+    int error = check(reader);
+
+    if (error != OE_SHM_OK)
+        return error;
+
+    desc = oe_shm_get_stream(reader, stream);
+
+    if (desc == NULL)
+        return OE_SHM_ERR_ARGUMENT;
+
+    cursor = &reader->header->stream_cursors[stream];
+    data = (const float*) (reader->base + desc->data_offset);
+    capacity = desc->ring_samples;
+
+    n = begin_read(OE_SHM_LOAD_ACQUIRE(&cursor->write_index), capacity, position, max_samples, &lost);
+    start = *position & (capacity - 1);
+
+    for (ch = 0; ch < desc->num_channels; ++ch)
+    {
+        const float* ring = data + (uint64_t) ch * capacity;
+        float* out = dest + (uint64_t) ch * max_samples;
+        uint64_t first = capacity - start < n ? capacity - start : n;
+
+        memcpy(out, ring + start, first * sizeof(float));
+        memcpy(out + first, ring, (n - first) * sizeof(float));
+    }
+
+    overwritten = end_read(cursor, capacity, *position, n);
+
+    if (overwritten > 0)
+    {
+        for (ch = 0; ch < desc->num_channels; ++ch)
+        {
+            float* out = dest + (uint64_t) ch * max_samples;
+            memmove(out, out + overwritten, (n - overwritten) * sizeof(float));
+        }
+    }
+
+    i = n - overwritten;
+    *position += n;
+
+    if (dropped != NULL)
+        *dropped = lost + overwritten;
+
+    error = check(reader);
+
+    return error != OE_SHM_OK ? error : (int64_t) i;
+}
+
+int oe_shm_find_block(const oe_shm_reader* reader, int stream, uint64_t ring_index, oe_shm_block* block)
+{
+    const oe_shm_stream* desc = oe_shm_get_stream(reader, stream);
+    const oe_shm_cursor* cursor;
+    const oe_shm_block* blocks;
+    uint64_t count, k;
+
+    if (desc == NULL)
+        return OE_SHM_ERR_ARGUMENT;
+
+    cursor = &reader->header->stream_cursors[stream];
+    blocks = (const oe_shm_block*) (reader->base + desc->block_offset);
+
+    count = OE_SHM_LOAD_ACQUIRE(&cursor->block_count);
+
+    for (k = count; k > 0 && count - k < OE_SHM_BLOCK_CAPACITY; --k)
+    {
+        *block = blocks[(k - 1) & (OE_SHM_BLOCK_CAPACITY - 1)];
+
+        OE_SHM_FENCE_ACQUIRE();
+
+        /* the slot is reused once the writer starts block (k - 1 + capacity) */
+        if (load_relaxed(&cursor->block_count) - (k - 1) >= OE_SHM_BLOCK_CAPACITY)
+            return OE_SHM_ERR_NOT_FOUND;
+
+        if (block->ring_index <= ring_index)
+        {
+            if (ring_index < block->ring_index + block->num_samples)
+                return check(reader);
+
+            return OE_SHM_ERR_NOT_FOUND;
+        }
+    }
+
+    return OE_SHM_ERR_NOT_FOUND;
+}
+
+static int64_t read_records(oe_shm_reader* reader, const oe_shm_cursor* cursor, uint64_t offset, uint64_t capacity,
+                            size_t record_size, uint64_t* position, void* dest, uint64_t max_records, uint64_t* dropped)
+{
+    const uint8_t* ring = reader->base + offset;
+    uint8_t* out = (uint8_t*) dest;
+    uint64_t n, lost, overwritten, i;
+    int error = check(reader);
+
+    if (error != OE_SHM_OK)
+        return error;
+
+    n = begin_read(OE_SHM_LOAD_ACQUIRE(&cursor->write_index), capacity, position, max_records, &lost);
+
+    for (i = 0; i < n; ++i)
+        memcpy(out + i * record_size, ring + ((*position + i) & (capacity - 1)) * record_size, record_size);
+
+    overwritten = end_read(cursor, capacity, *position, n);
+
+    if (overwritten > 0)
+        memmove(out, out + overwritten * record_size, (n - overwritten) * record_size);
+
+    *position += n;
+
+    if (dropped != NULL)
+        *dropped = lost + overwritten;
+
+    error = check(reader);
+
+    return error != OE_SHM_OK ? error : (int64_t) (n - overwritten);
+}
+
+int64_t oe_shm_read_events(oe_shm_reader* reader, uint64_t* position,
+                           oe_shm_event* dest, uint64_t max_events, uint64_t* dropped)
+{
+    if (reader->header == NULL)
+        return OE_SHM_ERR_CLOSED;
+
+    return read_records(reader, &reader->header->event_cursor, reader->event_offset, reader->event_capacity,
+                        sizeof(oe_shm_event), position, dest, max_events, dropped);
+}
+
+int64_t oe_shm_read_spikes(oe_shm_reader* reader, uint64_t* position,
+                           oe_shm_spike* dest, uint64_t max_spikes, uint64_t* dropped)
+{
+    if (reader->header == NULL)
+        return OE_SHM_ERR_CLOSED;
+
+    return read_records(reader, &reader->header->spike_cursor, reader->spike_offset, reader->spike_capacity,
+                        sizeof(oe_shm_spike), position, dest, max_spikes, dropped);
+}
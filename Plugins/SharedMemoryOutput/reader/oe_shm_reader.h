@@ -0,0 +1,126 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OE_SHM_READER_H_INCLUDED
+#define OE_SHM_READER_H_INCLUDED
+
+/**
+
+    Minimal C library for reading the segment published by the Shared Memory
+    Output processor (Linux and macOS).
+
+    Typical use:
+
+        oe_shm_reader* reader;
+        if (oe_shm_open("open-ephys", &reader) != OE_SHM_OK) ...
+
+        uint64_t position = oe_shm_stream_write_index(reader, 0);   // start from "now"
+
+        for (;;)
+        {
+            uint64_t dropped;
+            int64_t n = oe_shm_read_continuous(reader, 0, &position, buffer, maxSamples, &dropped);
+
+            if (n == OE_SHM_ERR_LAYOUT_CHANGED || n == OE_SHM_ERR_CLOSED)
+            {
+                oe_shm_refresh(reader);     // acquisition was restarted; all positions restart at 0
+                position = 0;
+            }
+            ...
+        }
+
+    Readers never block the writer and never take locks. Data can also be read
+    in place through oe_shm_channel_ring(), as long as the caller checks the
+    write index afterwards (see SharedMemoryLayout.h).
+
+*/
+
+#include "../SharedMemoryLayout.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OE_SHM_OK                   0
+#define OE_SHM_ERR_OPEN            -1   /* the segment does not exist or could not be mapped */
+#define OE_SHM_ERR_FORMAT          -2   /* the segment has an unknown magic number or version */
+#define OE_SHM_ERR_LAYOUT_CHANGED  -3   /* the writer restarted; call oe_shm_refresh() */
+#define OE_SHM_ERR_CLOSED          -4   /* the writer removed the segment; call oe_shm_refresh() */
+#define OE_SHM_ERR_ARGUMENT        -5   /* invalid stream or channel index */
+#define OE_SHM_ERR_NOT_FOUND       -6   /* the requested block is no longer in the block table */
+
+typedef struct oe_shm_reader oe_shm_reader;
+
+/** Maps the segment named "/oe_<name>" and takes a snapshot of its layout */
+int oe_shm_open(const char* name, oe_shm_reader** reader);
+
+/** Unmaps the segment and frees the reader */
+void oe_shm_close(oe_shm_reader* reader);
+
+/** Takes a new snapshot of the layout, re-opening the segment if it was closed or replaced */
+int oe_shm_refresh(oe_shm_reader* reader);
+
+/** Returns OE_SHM_STATE_STOPPED, OE_SHM_STATE_RUNNING or OE_SHM_STATE_CLOSED */
+int oe_shm_state(const oe_shm_reader* reader);
+
+/** Returns the number of published continuous streams */
+int oe_shm_num_streams(const oe_shm_reader* reader);
+
+/** Returns the snapshot of a stream's descriptor, or NULL */
+const oe_shm_stream* oe_shm_get_stream(const oe_shm_reader* reader, int stream);
+
+/** Returns the snapshot of a stream's channel descriptors, or NULL */
+const oe_shm_channel* oe_shm_get_channels(const oe_shm_reader* reader, int stream);
+
+/** Returns the number of samples per channel written so far to a stream */
+uint64_t oe_shm_stream_write_index(const oe_shm_reader* reader, int stream);
+
+/** Returns the ring of one channel (sample i is at ring[i & (ring_samples - 1)]), or NULL */
+const float* oe_shm_channel_ring(const oe_shm_reader* reader, int stream, int channel);
+
+/** Copies samples [*position, write index) of all channels of a stream into dest, laid out
+    as dest[channel * max_samples + i], and advances *position. Samples that were already
+    overwritten are skipped and counted in *dropped. Returns the number of samples per
+    channel copied, or a negative error code. */
+int64_t oe_shm_read_continuous(oe_shm_reader* reader, int stream, uint64_t* position,
+                               float* dest, uint64_t max_samples, uint64_t* dropped);
+
+/** Finds the block that contains a given ring index, to recover its sample number and timestamp */
+int oe_shm_find_block(const oe_shm_reader* reader, int stream, uint64_t ring_index, oe_shm_block* block);
+
+/** Copies TTL events [*position, event count) into dest and advances *position.
+    Returns the number of events copied, or a negative error code. */
+int64_t oe_shm_read_events(oe_shm_reader* reader, uint64_t* position,
+                           oe_shm_event* dest, uint64_t max_events, uint64_t* dropped);
+
+/** Copies spikes [*position, spike count) into dest and advances *position.
+    Returns the number of spikes copied, or a negative error code. */
+int64_t oe_shm_read_spikes(oe_shm_reader* reader, uint64_t* position,
+                           oe_shm_spike* dest, uint64_t max_spikes, uint64_t* dropped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -21,71 +21,187 @@
 
 */
 
-#include "VisualizerPlugin.h"
+#include "RateViewer.h"
 
 #include "VisualizerPluginEditor.h"
 
 
-VisualizerPlugin::VisualizerPlugin() 
-    : GenericProcessor("Visualizer Plugin")
+RateViewer::RateViewer() 
+    : GenericProcessor("Rate Viewer"),
+      triggerLine(-1)
 {
-
+    addIntParameter(Parameter::GLOBAL_SCOPE, "bin_size", "Size of each spike count bin (ms)", 10, 1, 1000, true);
+    addCategoricalParameter(Parameter::GLOBAL_SCOPE, "smoothing", "Smoothing applied to the binned rates", { "None", "Exponential", "Boxcar" }, 1);
+    addIntParameter(Parameter::GLOBAL_SCOPE, "window", "Exponential time constant / boxcar width (ms)", 100, 1, 10000, true);
+    addIntParameter(Parameter::GLOBAL_SCOPE, "trigger_line", "The TTL line that triggers the peri-event histograms (0 = off)", 0, 0, 16);
+    addIntParameter(Parameter::GLOBAL_SCOPE, "pre_ms", "Time before each trigger (ms)", 500, 0, 5000, true);
+    addIntParameter(Parameter::GLOBAL_SCOPE, "post_ms", "Time after each trigger (ms)", 1000, 1, 5000, true);
 }
 
 
-VisualizerPlugin::~VisualizerPlugin()
+RateViewer::~RateViewer()
 {
 
 }
 
 
-AudioProcessorEditor* VisualizerPlugin::createEditor()
+AudioProcessorEditor* RateViewer::createEditor()
 {
     editor = std::make_unique<VisualizerPluginEditor>(this);
     return editor.get();
 }
 
 
-void VisualizerPlugin::updateSettings()
+void RateViewer::updateSettings()
+{
+    createCounters();
+}
+
+
+void RateViewer::createCounters()
+{
+    counters.clear();
+    counterForSpikeChannel.clearQuick();
+    countersForStream.clear();
+
+    SpikeRateSettings settings;
+
+    settings.binSizeMs = getParameter("bin_size")->getValue();
+    settings.smoothingWindowMs = getParameter("window")->getValue();
+    settings.preTriggerMs = getParameter("pre_ms")->getValue();
+    settings.postTriggerMs = getParameter("post_ms")->getValue();
+
+    const RateSmoothing smoothing = RateSmoothing(int(getParameter("smoothing")->getValue()));
+
+    // the position in spikeChannels becomes each channel's global index
+    for (auto spikeChannel : spikeChannels)
+    {
+        if (!spikeChannel->isValid())
+        {
+            counterForSpikeChannel.add(-1);
+            continue;
+        }
+
+        SpikeRateCounter* counter = new SpikeRateCounter(spikeChannel->getName(),
+                                                         spikeChannel->getStreamId(),
+                                                         spikeChannel->getSampleRate(),
+                                                         settings);
+
+        counter->setSmoothing(smoothing);
+
+        counterForSpikeChannel.add(counters.size());
+        countersForStream[spikeChannel->getStreamId()].add(counter);
+        counters.add(counter);
+    }
+}
+
+
+const SpikeRateCounter* RateViewer::getRateCounter(int index) const
+{
+    if (index > -1 && index < counters.size())
+        return counters[index];
+    else
+        return nullptr;
+}
+
+
+bool RateViewer::startAcquisition()
 {
+    for (auto counter : counters)
+        counter->reset();
+
+    return true;
+}
 
 
+void RateViewer::parameterValueChanged(Parameter* param)
+{
+    if (param->getName().equalsIgnoreCase("smoothing") || param->getName().equalsIgnoreCase("trigger_line"))
+    {
+        queueParameterChange(param);
+    }
+    else
+    {
+        // the binning can only change while acquisition is inactive
+        createCounters();
+    }
+}
+
+
+void RateViewer::applyParameterChange(ParameterChange& change)
+{
+    if (change.parameter->getName().equalsIgnoreCase("smoothing"))
+    {
+        for (auto counter : counters)
+            counter->setSmoothing(RateSmoothing(int(change.value)));
+    }
+    else if (change.parameter->getName().equalsIgnoreCase("trigger_line"))
+    {
+        triggerLine = int(change.value) - 1;
+    }
 }
 
 
-void VisualizerPlugin::process(AudioBuffer<float>& buffer)
+void RateViewer::process(AudioBuffer<float>& buffer)
 {
 
     checkForEvents(true);
+
+    // close the bins that ended in this block, even if they have no spikes
+    for (auto& streamCounters : countersForStream)
+    {
+        const int64 blockEnd = getFirstSampleNumberForBlock(streamCounters.first)
+                             + getNumSamplesInBlock(streamCounters.first);
+
+        for (auto counter : streamCounters.second)
+            counter->advanceTo(blockEnd);
+    }
 	 
 }
 
 
-void VisualizerPlugin::handleTTLEvent(TTLEventPtr event)
+void RateViewer::handleTTLEvent(TTLEventPtr event)
 {
+    if (triggerLine < 0 || event->getLine() != triggerLine || !event->getState())
+        return;
+
+    auto it = countersForStream.find(event->getStreamId());
 
+    if (it == countersForStream.end())
+        return;
+
+    for (auto counter : it->second)
+        counter->addTrigger(event->getSampleNumber());
 }
 
 
-void VisualizerPlugin::handleSpike(SpikePtr spike)
+void RateViewer::handleSpike(SpikePtr spike)
 {
+    const int channelIndex = spike->getChannelInfo()->getGlobalIndex();
+
+    if (channelIndex < 0 || channelIndex >= counterForSpikeChannel.size())
+        return;
+
+    const int counterIndex = counterForSpikeChannel.getUnchecked(channelIndex);
 
+    if (counterIndex >= 0)
+        counters.getUnchecked(counterIndex)->addSpike(spike->getSampleNumber());
 }
 
 
-void VisualizerPlugin::handleBroadcastMessage(String message)
+void RateViewer::handleBroadcastMessage(String message)
 {
 
 }
 
 
-void VisualizerPlugin::saveCustomParametersToXml(XmlElement* parentElement)
+void RateViewer::saveCustomParametersToXml(XmlElement* parentElement)
 {
 
 }
 
 
-void VisualizerPlugin::loadCustomParametersFromXml(XmlElement* parentElement)
+void RateViewer::loadCustomParametersFromXml(XmlElement* parentElement)
 {
 
 }
\ No newline at end of file
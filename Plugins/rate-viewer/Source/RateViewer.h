@@ -22,25 +22,31 @@
 */
 
 //This prevents include loops. We recommend changing the macro to a name suitable for your plugin
-#ifndef VISUALIZERPLUGIN_H_DEFINED
-#define VISUALIZERPLUGIN_H_DEFINED
+#ifndef RATEVIEWER_H_DEFINED
+#define RATEVIEWER_H_DEFINED
 
 #include <ProcessorHeaders.h>
 
+#include "SpikeRateCounter.h"
+
+#include <map>
 
 /** 
-	A plugin that includes a canvas for displaying incoming data
-	or an extended settings interface.
+	Displays the firing rate of every incoming electrode, along with
+	peri-event rate histograms triggered on a TTL line.
+
+	Spikes are counted in bins of sample numbers on the audio thread
+	(see SpikeRateCounter); the canvas reads the binned rates without locking.
 */
 
 class RateViewer : public GenericProcessor
 {
 public:
 	/** The class constructor, used to initialize any members.*/
-	VisualizerPlugin();
+	RateViewer();
 
 	/** The class destructor, used to deallocate memory*/
-	~VisualizerPlugin();
+	~RateViewer();
 
 	/** If the processor has a custom editor, this method must be defined to instantiate it. */
 	AudioProcessorEditor* createEditor() override;
@@ -51,16 +57,28 @@ public:
 		will be passed to downstream plugins. */
 	void updateSettings() override;
 
+	/** Clears all counts before acquisition starts */
+	bool startAcquisition() override;
+
 	/** Defines the functionality of the processor.
 		The process method is called every time a new data buffer is available.
 		Visualizer plugins typically use this method to send data to the canvas for display purposes */
 	void process(AudioBuffer<float>& buffer) override;
 
+	/** Only reads the continuous data */
+	bool isPassThrough() const override { return true; }
+
 	/** Handles events received by the processor
 		Called automatically for each received event whenever checkForEvents() is called from
 		the plugin's process() method */
 	void handleTTLEvent(TTLEventPtr event) override;
 
+	/** Rebuilds the counters when the binning changes, and queues smoothing and trigger changes */
+	void parameterValueChanged(Parameter* param) override;
+
+	/** Applies smoothing and trigger changes at the start of a block */
+	void applyParameterChange(ParameterChange& change) override;
+
 	/** Handles spikes received by the processor
 		Called automatically for each received spike whenever checkForEvents(true) is called from 
 		the plugin's process() method */
@@ -78,11 +96,31 @@ public:
 		Parameter objects*/
 	void loadCustomParametersFromXml(XmlElement* parentElement) override;
 
+	/** Returns the number of electrodes */
+	int getNumCounters() const { return counters.size(); }
+
+	/** Returns the rate counter for an electrode, or nullptr if the index is invalid */
+	const SpikeRateCounter* getRateCounter(int index) const;
+
 private:
 
+	/** Creates a counter for each incoming electrode, using the current parameter values */
+	void createCounters();
+
+	OwnedArray<SpikeRateCounter> counters;
+
+	/** Counter index for each spike channel (by global index), or -1 */
+	Array<int> counterForSpikeChannel;
+
+	/** Counters that use each stream's sample numbers */
+	std::map<uint16, Array<SpikeRateCounter*>> countersForStream;
+
+	/** TTL line that triggers the peri-event histograms (0-based, -1 = off) */
+	int triggerLine;
+
 	/** Generates an assertion if this class leaks */
-	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VisualizerPlugin);
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RateViewer);
 
 };
 
-#endif // VISUALIZERPLUGIN_H_DEFINED
\ No newline at end of file
+#endif // RATEVIEWER_H_DEFINED
\ No newline at end of file
@@ -0,0 +1,256 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SpikeRateCounter.h"
+
+#define RATE_DISPLAY_MS 10000
+
+SpikeRateCounter::SpikeRateCounter(const String& name_, uint16 streamId_, float sampleRate, const SpikeRateSettings& settings)
+    : name(name_),
+      streamId(streamId_),
+      binSize(jmax(1, roundToInt(sampleRate * settings.binSizeMs / 1000.0f))),
+      binSeconds(float(binSize) / jmax(1.0f, sampleRate)),
+      boxcarBins(jmax(1, roundToInt(float(settings.smoothingWindowMs) / settings.binSizeMs))),
+      alpha(1.0f - std::exp(-float(settings.binSizeMs) / jmax(1, settings.smoothingWindowMs))),
+      preBins((settings.preTriggerMs + settings.binSizeMs - 1) / settings.binSizeMs),
+      postBins(jmax(1, (settings.postTriggerMs + settings.binSizeMs - 1) / settings.binSizeMs)),
+      currentBin(-1),
+      currentCount(0),
+      historySize(jmax(boxcarBins, preBins + postBins) + 1),
+      firstValidBin(0),
+      boxcarSum(0),
+      exponentialRate(0.0f),
+      smoothing(int(RateSmoothing::EXPONENTIAL)),
+      numActiveTriggers(0),
+      numDisplayBins(jmax(1, RATE_DISPLAY_MS / settings.binSizeMs)),
+      rateRingSize(2 * numDisplayBins),
+      rateRing(new std::atomic<float>[rateRingSize]),
+      numRatesWritten(0),
+      histogramCounts(new std::atomic<uint32>[preBins + postBins]),
+      numTriggers(0)
+{
+    countHistory.calloc(historySize);
+
+    reset();
+}
+
+
+int64 SpikeRateCounter::getBinIndex(int64 sampleNumber) const
+{
+    return jmax(int64(0), sampleNumber) / binSize;
+}
+
+
+void SpikeRateCounter::addSpike(int64 sampleNumber)
+{
+    // closes any bins before this spike
+    advanceTo(sampleNumber);
+
+    // spikes that arrive after their bin was closed are counted in the current one
+    currentCount++;
+}
+
+
+void SpikeRateCounter::advanceTo(int64 sampleNumber)
+{
+    const int64 bin = getBinIndex(sampleNumber);
+
+    if (currentBin < 0)
+    {
+        currentBin = bin;
+        firstValidBin = bin;
+        return;
+    }
+
+    if (bin - currentBin > historySize)
+    {
+        // after a long gap, restart from an empty history instead of closing every bin in it
+        closeBin();
+
+        currentBin = bin;
+        firstValidBin = bin;
+        boxcarSum = 0;
+        numActiveTriggers = 0;
+
+        return;
+    }
+
+    while (currentBin < bin)
+        closeBin();
+}
+
+
+void SpikeRateCounter::closeBin()
+{
+    const int64 bin = currentBin;
+    const int count = currentCount;
+
+    // boxcar: drop the bin that leaves the window (before its slot can be reused)
+    if (bin - boxcarBins >= firstValidBin)
+        boxcarSum -= countHistory[(bin - boxcarBins) % historySize];
+
+    countHistory[bin % historySize] = count;
+    boxcarSum += count;
+
+    const float rate = count / binSeconds;
+
+    exponentialRate += alpha * (rate - exponentialRate);
+
+    float value;
+
+    switch (RateSmoothing(smoothing.load(std::memory_order_relaxed)))
+    {
+    case RateSmoothing::EXPONENTIAL:
+        value = exponentialRate;
+        break;
+    case RateSmoothing::BOXCAR:
+        value = boxcarSum / (jmin(int64(boxcarBins), bin - firstValidBin + 1) * binSeconds);
+        break;
+    default:
+        value = rate;
+    }
+
+    const int64 numWritten = numRatesWritten.load(std::memory_order_relaxed);
+    rateRing[numWritten % rateRingSize].store(value, std::memory_order_relaxed);
+    numRatesWritten.store(numWritten + 1, std::memory_order_release);
+
+    // add the bin to every trigger window that contains it
+    const int numHistogramBins = preBins + postBins;
+
+    int i = 0;
+
+    while (i < numActiveTriggers)
+    {
+        const int64 offset = bin - (activeTriggers[i] - preBins);
+
+        if (offset >= 0 && offset < numHistogramBins && count > 0)
+            histogramCounts[offset].fetch_add(uint32(count), std::memory_order_relaxed);
+
+        if (offset >= numHistogramBins - 1)
+            activeTriggers[i] = activeTriggers[--numActiveTriggers];
+        else
+            i++;
+    }
+
+    currentCount = 0;
+    currentBin++;
+}
+
+
+void SpikeRateCounter::addTrigger(int64 sampleNumber)
+{
+    if (currentBin < 0)
+        advanceTo(sampleNumber);
+
+    const int64 triggerBin = getBinIndex(sampleNumber);
+    const int64 firstBin = triggerBin - preBins;
+    const int64 endBin = firstBin + preBins + postBins;
+
+    if (endBin > currentBin && numActiveTriggers == MAX_ACTIVE_TRIGGERS)
+        return; // too many overlapping windows
+
+    // bins that are already closed come from the history
+    const int64 firstStoredBin = jmax(firstBin, firstValidBin, currentBin - historySize);
+
+    for (int64 bin = firstStoredBin; bin < jmin(endBin, currentBin); bin++)
+    {
+        const int count = countHistory[bin % historySize];
+
+        if (count > 0)
+            histogramCounts[bin - firstBin].fetch_add(uint32(count), std::memory_order_relaxed);
+    }
+
+    // the others are added as they are closed
+    if (endBin > currentBin)
+        activeTriggers[numActiveTriggers++] = triggerBin;
+
+    numTriggers.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void SpikeRateCounter::setSmoothing(RateSmoothing smoothing_)
+{
+    smoothing.store(int(smoothing_), std::memory_order_relaxed);
+}
+
+
+void SpikeRateCounter::reset()
+{
+    currentBin = -1;
+    currentCount = 0;
+    firstValidBin = 0;
+
+    boxcarSum = 0;
+    exponentialRate = 0.0f;
+
+    numActiveTriggers = 0;
+
+    for (int i = 0; i < historySize; i++)
+        countHistory[i] = 0;
+
+    for (int i = 0; i < rateRingSize; i++)
+        rateRing[i].store(0.0f, std::memory_order_relaxed);
+
+    numRatesWritten.store(0);
+
+    for (int i = 0; i < preBins + postBins; i++)
+        histogramCounts[i].store(0, std::memory_order_relaxed);
+
+    numTriggers.store(0);
+}
+
+
+int SpikeRateCounter::getRecentRates(float* dest, int maxBins) const
+{
+    const int64 numWritten = numRatesWritten.load(std::memory_order_acquire);
+
+    // the ring is twice as long as this, so these bins are not being overwritten
+    const int numBins = int(jmin(numWritten, int64(jmin(maxBins, numDisplayBins))));
+
+    for (int i = 0; i < numBins; i++)
+        dest[i] = rateRing[(numWritten - numBins + i) % rateRingSize].load(std::memory_order_relaxed);
+
+    return numBins;
+}
+
+
+float SpikeRateCounter::getCurrentRate() const
+{
+    const int64 numWritten = numRatesWritten.load(std::memory_order_acquire);
+
+    if (numWritten == 0)
+        return 0.0f;
+
+    return rateRing[(numWritten - 1) % rateRingSize].load(std::memory_order_relaxed);
+}
+
+
+void SpikeRateCounter::getHistogram(float* dest) const
+{
+    const uint32 triggers = numTriggers.load(std::memory_order_relaxed);
+
+    const float scale = triggers > 0 ? 1.0f / (triggers * binSeconds) : 0.0f;
+
+    for (int i = 0; i < preBins + postBins; i++)
+        dest[i] = histogramCounts[i].load(std::memory_order_relaxed) * scale;
+}
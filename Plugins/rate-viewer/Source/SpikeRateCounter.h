@@ -0,0 +1,186 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SPIKERATECOUNTER_H_DEFINED
+#define SPIKERATECOUNTER_H_DEFINED
+
+#include <ProcessorHeaders.h>
+
+#include <atomic>
+
+/** Smoothing applied to the binned rates before they are sent to the canvas */
+enum class RateSmoothing
+{
+    NONE = 0,
+    EXPONENTIAL,
+    BOXCAR
+};
+
+/**
+    Settings shared by all of the rate counters of a RateViewer
+
+    @see SpikeRateCounter
+*/
+struct SpikeRateSettings
+{
+    /** Bin size, in ms */
+    int binSizeMs = 10;
+
+    /** Exponential time constant / boxcar width, in ms */
+    int smoothingWindowMs = 100;
+
+    /** Time before each trigger covered by the peri-event histogram, in ms */
+    int preTriggerMs = 500;
+
+    /** Time after each trigger covered by the peri-event histogram, in ms */
+    int postTriggerMs = 1000;
+};
+
+/**
+    Counts the spikes of one electrode in fixed bins of sample numbers.
+
+    Everything that depends on the number of bins is allocated in the constructor,
+    so that the audio thread methods (addSpike, addTrigger, advanceTo, setSmoothing)
+    never allocate, never block and do a constant amount of work per spike.
+
+    Each time a bin is complete, its (optionally smoothed) rate is written into a
+    ring that the canvas reads without locking, and its spike count is added to the
+    peri-event histogram of every trigger whose window contains it.
+
+    @see RateViewer
+*/
+class SpikeRateCounter
+{
+public:
+
+    /** Creates a counter for an electrode recorded at the given sample rate */
+    SpikeRateCounter(const String& name, uint16 streamId, float sampleRate, const SpikeRateSettings& settings);
+
+    /** Destructor */
+    ~SpikeRateCounter() { }
+
+    // AUDIO THREAD
+
+    /** Counts a spike that peaked at this sample number */
+    void addSpike(int64 sampleNumber);
+
+    /** Starts a peri-event histogram window around this sample number */
+    void addTrigger(int64 sampleNumber);
+
+    /** Closes all bins that end at or before this sample number */
+    void advanceTo(int64 sampleNumber);
+
+    /** Changes how the rates sent to the canvas are smoothed */
+    void setSmoothing(RateSmoothing smoothing);
+
+    // MESSAGE THREAD
+
+    /** Clears all counts and histograms (while acquisition is inactive) */
+    void reset();
+
+    /** Copies the most recent rates (in Hz, oldest first) into 'dest',
+        and returns the number of rates copied */
+    int getRecentRates(float* dest, int maxBins) const;
+
+    /** Copies the peri-event histogram (in Hz) into 'dest', which must hold getNumHistogramBins() values */
+    void getHistogram(float* dest) const;
+
+    /** Returns the rate of the most recent bin (in Hz) */
+    float getCurrentRate() const;
+
+    /** Returns the number of triggers included in the histogram */
+    int getNumTriggers() const { return int(numTriggers.load(std::memory_order_relaxed)); }
+
+    /** Returns the maximum number of rates returned by getRecentRates() */
+    int getNumDisplayBins() const { return numDisplayBins; }
+
+    /** Returns the number of bins in the peri-event histogram */
+    int getNumHistogramBins() const { return preBins + postBins; }
+
+    /** Returns the number of histogram bins before the trigger */
+    int getNumPreTriggerBins() const { return preBins; }
+
+    /** Returns the bin size, in seconds */
+    float getBinSizeSeconds() const { return binSeconds; }
+
+    /** Returns the electrode's name */
+    const String& getName() const { return name; }
+
+    /** Returns the ID of the electrode's stream */
+    uint16 getStreamId() const { return streamId; }
+
+private:
+
+    /** Closes the current bin and starts the next one */
+    void closeBin();
+
+    /** Returns the bin containing a sample number */
+    int64 getBinIndex(int64 sampleNumber) const;
+
+    const String name;
+    const uint16 streamId;
+
+    const int binSize;
+    const float binSeconds;
+
+    const int boxcarBins;
+    const float alpha;
+
+    const int preBins;
+    const int postBins;
+
+    // --- audio thread only ---
+
+    /** Index of the bin being counted (-1 until the first spike or block) */
+    int64 currentBin;
+    int currentCount;
+
+    /** Raw spike counts of the most recent bins (at least boxcarBins and preBins long) */
+    HeapBlock<int> countHistory;
+    int historySize;
+    int64 firstValidBin;
+
+    int boxcarSum;
+    float exponentialRate;
+
+    std::atomic<int> smoothing;
+
+    /** Trigger windows that still have bins to come */
+    static const int MAX_ACTIVE_TRIGGERS = 16;
+    int64 activeTriggers[MAX_ACTIVE_TRIGGERS];
+    int numActiveTriggers;
+
+    // --- shared with the canvas ---
+
+    const int numDisplayBins;
+    const int rateRingSize;
+    std::unique_ptr<std::atomic<float>[]> rateRing;
+    std::atomic<int64> numRatesWritten;
+
+    std::unique_ptr<std::atomic<uint32>[]> histogramCounts;
+    std::atomic<uint32> numTriggers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpikeRateCounter);
+};
+
+#endif // SPIKERATECOUNTER_H_DEFINED
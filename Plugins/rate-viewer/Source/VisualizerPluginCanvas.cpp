@@ -29,7 +29,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 VisualizerPluginCanvas::VisualizerPluginCanvas(RateViewer* processor_)
 	: processor(processor_)
 {
+	refreshRate = 10; // Hz
 
+	electrodeSelector = std::make_unique<ComboBox>("Electrode selector");
+	electrodeSelector->addListener(this);
+	addAndMakeVisible(electrodeSelector.get());
+
+	plt.title("Firing rate");
+	plt.xlabel("Time (s)");
+	plt.ylabel("Rate (Hz)");
+	addAndMakeVisible(&plt);
+
+	histogramPlot.title("Peri-event rate");
+	histogramPlot.xlabel("Time from trigger (s)");
+	histogramPlot.ylabel("Rate (Hz)");
+	addAndMakeVisible(&histogramPlot);
+
+	update();
 }
 
 
@@ -41,7 +57,12 @@ VisualizerPluginCanvas::~VisualizerPluginCanvas()
 
 void VisualizerPluginCanvas::resized()
 {
+	electrodeSelector->setBounds(10, 10, 200, 20);
+
+	const int plotHeight = (getHeight() - 50) / 2;
 
+	plt.setBounds(10, 40, getWidth() - 20, plotHeight);
+	histogramPlot.setBounds(10, 50 + plotHeight, getWidth() - 20, plotHeight);
 }
 
 void VisualizerPluginCanvas::refreshState()
@@ -52,13 +73,88 @@ void VisualizerPluginCanvas::refreshState()
 
 void VisualizerPluginCanvas::update()
 {
+	const int selectedId = electrodeSelector->getSelectedId();
+
+	electrodeSelector->clear(dontSendNotification);
+
+	for (int i = 0; i < processor->getNumCounters(); i++)
+		electrodeSelector->addItem(processor->getRateCounter(i)->getName(), i + 1);
+
+	if (selectedId > 0 && selectedId <= processor->getNumCounters())
+		electrodeSelector->setSelectedId(selectedId, dontSendNotification);
+	else if (processor->getNumCounters() > 0)
+		electrodeSelector->setSelectedId(1, dontSendNotification);
 
+	refresh();
+}
+
+
+void VisualizerPluginCanvas::comboBoxChanged(ComboBox* comboBox)
+{
+	refresh();
 }
 
 
 void VisualizerPluginCanvas::refresh()
 {
+	// counters are rebuilt when the settings change, so look this one up every time
+	const SpikeRateCounter* counter = processor->getRateCounter(electrodeSelector->getSelectedId() - 1);
+
+	plt.clear();
+	histogramPlot.clear();
+
+	if (counter == nullptr)
+		return;
+
+	const float binSeconds = counter->getBinSizeSeconds();
+
+	// recent rates, ending now
+	rates.resize(counter->getNumDisplayBins());
+
+	const int numBins = counter->getRecentRates(rates.data(), int(rates.size()));
+
+	rates.resize(numBins);
+	rateTimes.resize(numBins);
+
+	float maxRate = 1.0f;
+
+	for (int i = 0; i < numBins; i++)
+	{
+		rateTimes[i] = (i - numBins + 1) * binSeconds;
+		maxRate = jmax(maxRate, rates[i]);
+	}
+
+	if (numBins > 1)
+		plt.plot(rateTimes, rates, Colours::lightgreen);
+
+	XYRange rateRange { -counter->getNumDisplayBins() * binSeconds, 0.0f, 0.0f, maxRate * 1.1f };
+	plt.setRange(rateRange);
+	plt.show();
+
+	// peri-event histogram
+	const int numHistogramBins = counter->getNumHistogramBins();
+
+	histogram.resize(numHistogramBins);
+	histogramTimes.resize(numHistogramBins);
+
+	counter->getHistogram(histogram.data());
+
+	float maxHistogramRate = 1.0f;
+
+	for (int i = 0; i < numHistogramBins; i++)
+	{
+		histogramTimes[i] = (i - counter->getNumPreTriggerBins()) * binSeconds;
+		maxHistogramRate = jmax(maxHistogramRate, histogram[i]);
+	}
+
+	histogramPlot.title("Peri-event rate (" + String(counter->getNumTriggers()) + " triggers)");
+
+	if (counter->getNumTriggers() > 0)
+		histogramPlot.plot(histogramTimes, histogram, Colours::orange, 1.0f, 1.0f, PlotType::BAR);
 
+	XYRange histogramRange { histogramTimes.front(), histogramTimes.back() + binSeconds, 0.0f, maxHistogramRate * 1.1f };
+	histogramPlot.setRange(histogramRange);
+	histogramPlot.show();
 }
 
 
@@ -30,10 +30,12 @@ class RateViewer;
 
 /**
 * 
-	Draws data in real time
+	Draws the firing rate of the selected electrode, and its
+	peri-event rate histogram
 
 */
-class VisualizerPluginCanvas : public Visualizer
+class VisualizerPluginCanvas : public Visualizer,
+	public ComboBox::Listener
 {
 public:
 
@@ -58,6 +60,9 @@ public:
 	/** Draws the canvas background */
 	void paint(Graphics& g) override;
 
+	/** Changes the selected electrode */
+	void comboBoxChanged(ComboBox* comboBox) override;
+
 private:
 
 	/** Pointer to the processor class */
@@ -66,6 +71,16 @@ private:
 	/** Class for plotting data */
 	InteractivePlot plt;
 
+	/** Plots the peri-event rate histogram */
+	InteractivePlot histogramPlot;
+
+	/** Selects the electrode to display */
+	std::unique_ptr<ComboBox> electrodeSelector;
+
+	/** Scratch buffers for reading the rates */
+	std::vector<float> rateTimes, rates;
+	std::vector<float> histogramTimes, histogram;
+
 	/** Generates an assertion if this class leaks */
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VisualizerPluginCanvas);
 };
@@ -29,10 +29,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 VisualizerPluginEditor::VisualizerPluginEditor(GenericProcessor* p)
-    : VisualizerEditor(p, "Visualizer", 200)
+    : VisualizerEditor(p, "Rates", 270)
 {
 
-    //addSelectedChannelsParameterEditor("Channels", 20, 105);
+    addTextBoxParameterEditor("bin_size", 10, 30);
+    addComboBoxParameterEditor("smoothing", 95, 30);
+    addTextBoxParameterEditor("window", 180, 30);
+
+    addComboBoxParameterEditor("trigger_line", 10, 75);
+    addTextBoxParameterEditor("pre_ms", 95, 75);
+    addTextBoxParameterEditor("post_ms", 180, 75);
 
 }
 
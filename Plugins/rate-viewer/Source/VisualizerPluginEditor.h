@@ -28,7 +28,7 @@
 #include <VisualizerEditorHeaders.h>
 
 /** 
-	The editor for the VisualizerPlugin
+	The editor for the RateViewer
 
 	Includes buttons for opening the canvas in a tab or window
 */
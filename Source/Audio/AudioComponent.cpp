@@ -25,12 +25,19 @@
 #include "AudioComponent.h"
 #include "../AccessClass.h"
 #include "../Processors/ProcessorGraph/ProcessorGraph.h"
+#include "../Processors/RecordNode/RecordNode.h"
 #include <stdio.h>
 
 
 #include "../Utils/Utils.h"
 
-AudioComponent::AudioComponent() : isPlaying(false)
+/** Fraction of a Record Node's buffer above which free-running playback waits for the disk */
+#define RECORD_BUFFER_HIGH_WATER 0.5f
+
+AudioComponent::AudioComponent() : 
+    isPlaying(false),
+    playbackSpeed(1.0),
+    processorGraph(nullptr)
 {
     bool initialized = false;
     while (!initialized)
@@ -142,6 +149,7 @@ int AudioComponent::getBufferSizeMs()
 void AudioComponent::connectToProcessorGraph(AudioProcessorGraph* processorGraph)
 {
 
+    this->processorGraph = processorGraph;
     graphPlayer->setProcessor(processorGraph);
 
 }
@@ -150,6 +158,7 @@ void AudioComponent::disconnectProcessorGraph()
 {
 
     graphPlayer->setProcessor(0);
+    processorGraph = nullptr;
 
 }
 
@@ -201,6 +210,25 @@ bool AudioComponent::beginCallbacks()
     if (!isPlaying)
     {
 
+        if (playbackSpeed != 1.0 && processorGraph != nullptr)
+        {
+            AudioDeviceManager::AudioDeviceSetup setup;
+            deviceManager.getAudioDeviceSetup(setup);
+
+            const int blockSize = setup.bufferSize > 0 ? setup.bufferSize : 1024;
+            const double sampleRate = setup.sampleRate > 0 ? setup.sampleRate : 44100.0;
+
+            // prepare on the message thread, so the graph's rendering sequence is built before the first block
+            processorGraph->prepareToPlay(sampleRate, blockSize);
+
+            LOGC("Starting free-running callbacks at ", playbackSpeed > 0 ? String(playbackSpeed) + "x" : String("maximum"), " speed.");
+            freeRunThread = std::make_unique<FreeRunThread>(processorGraph, playbackSpeed, sampleRate, blockSize);
+            freeRunning = true;
+            freeRunThread->startThread(9);
+            isPlaying = true;
+            return true;
+        }
+
         if (restartDevice())
         {
             int64 ms = Time::getCurrentTime().toMilliseconds();
@@ -227,11 +255,100 @@ bool AudioComponent::beginCallbacks()
 
 void AudioComponent::endCallbacks()
 {
+    if (freeRunThread != nullptr)
+    {
+        LOGC("Stopping free-running callbacks.");
+        freeRunThread->stopThread(1000);
+        freeRunThread.reset();
+        freeRunning = false;
+
+        if (processorGraph != nullptr)
+            processorGraph->releaseResources();
+
+        isPlaying = false;
+        return;
+    }
+
     LOGC("Removing audio callback.");
     deviceManager.removeAudioCallback(graphPlayer.get());
     isPlaying = false;
 }
 
+void AudioComponent::setPlaybackSpeed(double speed)
+{
+    if (isPlaying)
+    {
+        LOGE("Playback speed cannot be changed while acquisition is active.");
+        return;
+    }
+
+    playbackSpeed = jmax(0.0, speed);
+}
+
+AudioComponent::FreeRunThread::FreeRunThread(AudioProcessorGraph* graph_, double speed_, double sampleRate_, int blockSize_) :
+    Thread("Free-running callbacks"),
+    graph(graph_),
+    speed(speed_),
+    sampleRate(sampleRate_),
+    blockSize(blockSize_)
+{
+    recordNodes = AccessClass::getProcessorGraph()->getRecordNodes();
+}
+
+bool AudioComponent::FreeRunThread::recordBuffersAreFull() const
+{
+    for (auto* node : recordNodes)
+    {
+        if (node->getRecordBufferUsage() > RECORD_BUFFER_HIGH_WATER)
+            return true;
+    }
+
+    return false;
+}
+
+void AudioComponent::FreeRunThread::run()
+{
+    AudioBuffer<float> buffer(jmax(1, graph->getTotalNumInputChannels(), graph->getTotalNumOutputChannels()), blockSize);
+    MidiBuffer midiMessages;
+
+    // each block is scheduled relative to the previous one, so rounding in wait() does not accumulate
+    const double blockPeriodMs = speed > 0 ? 1000.0 * double(blockSize) / (sampleRate * speed) : 0.0;
+    double nextBlockTime = Time::getMillisecondCounterHiRes();
+
+    while (!threadShouldExit())
+    {
+        if (recordBuffersAreFull())
+        {
+            wait(1);
+            nextBlockTime = Time::getMillisecondCounterHiRes();
+            continue;
+        }
+
+        if (blockPeriodMs > 0)
+        {
+            const double now = Time::getMillisecondCounterHiRes();
+
+            if (now < nextBlockTime)
+            {
+                wait(jmax(1, int(nextBlockTime - now)));
+                continue;
+            }
+
+            nextBlockTime += blockPeriodMs;
+
+            // don't try to catch up after a long stall (e.g. the thread was descheduled)
+            if (now - nextBlockTime > 100.0 * blockPeriodMs)
+                nextBlockTime = now;
+        }
+
+        buffer.clear();
+        midiMessages.clear();
+
+        const ScopedLock sl(graph->getCallbackLock());
+        graph->processBlock(buffer, midiMessages);
+    }
+}
+
 void AudioComponent::saveStateToXml(XmlElement* parent)
 {
     // JUCE's audioState XML format (includes all info)
@@ -26,6 +26,8 @@
 
 #include "../../JuceLibraryCode/JuceHeader.h"
 
+class RecordNode;
+
 /**
 
   Interfaces with system audio hardware.
@@ -93,14 +95,55 @@ public:
     /** Loads all possible settings from an XML element */
     void loadStateFromXml(XmlElement* parent);
 
+    /** Sets the speed at which the next acquisition runs, as a multiple of real time.
+        At 1.0 the audio device drives the signal chain. Any other value runs the
+        ProcessorGraph from a background thread that is paced to the requested speed
+        (0 = as fast as possible), and that pauses while any Record Node's buffer
+        is more than RECORD_BUFFER_HIGH_WATER full.*/
+    void setPlaybackSpeed(double speed);
+
+    /** Returns the current playback speed (0 = as fast as possible) */
+    double getPlaybackSpeed() const { return playbackSpeed; }
+
+    /** Returns true if the signal chain is being driven by the free-running thread */
+    bool isFreeRunning() const { return freeRunning.load(); }
+
     AudioDeviceManager deviceManager;
 
 private:
 
+    /** Calls the ProcessorGraph in a loop, in place of the audio device */
+    class FreeRunThread : public Thread
+    {
+    public:
+        FreeRunThread(AudioProcessorGraph* graph, double speed, double sampleRate, int blockSize);
+
+        void run() override;
+
+    private:
+        /** Returns true if any Record Node is falling behind */
+        bool recordBuffersAreFull() const;
+
+        AudioProcessorGraph* graph;
+        Array<RecordNode*> recordNodes;
+        double speed;
+        double sampleRate;
+        int blockSize;
+    };
+
     bool isPlaying;
 
+    double playbackSpeed;
+
+    AudioProcessorGraph* processorGraph;
+
     std::unique_ptr<AudioProcessorPlayer> graphPlayer;
 
+    std::unique_ptr<FreeRunThread> freeRunThread;
+
+    /** Mirrors freeRunThread != nullptr, for processors that check it on the audio thread */
+    std::atomic<bool> freeRunning { false };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioComponent);
 
 };
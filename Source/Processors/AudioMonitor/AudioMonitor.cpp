@@ -29,10 +29,11 @@
 AudioMonitor::AudioMonitor()
     : GenericProcessor ("Audio Monitor"),
       destBufferSampleRate(44100.0f),
-      estimatedSamples(1024)
+      estimatedSamples(1024),
+      selectedStream(0),
+      activeStream(-1),
+      producingOutput(false)
 {
-
-    tempBuffer = std::make_unique<AudioSampleBuffer>();
     
     addBooleanParameter(Parameter::GLOBAL_SCOPE,
                         String("mute_audio"),
@@ -50,17 +51,12 @@ AudioMonitor::AudioMonitor()
                                  "Channels to monitor",
                                  4);
 
-    for (int i = 0; i < MAX_CHANNELS; i++)
-    {
-        
-        bandpassfilters.add (new Dsp::SmoothedFilterDesign
+    // the filter is linear, so the selected channels are summed first and filtered once
+    bandpassFilter = std::make_unique<Dsp::SmoothedFilterDesign
                          <Dsp::Butterworth::Design::BandPass    // design type
                          <2>,                                   // order
                          1,                                     // number of channels (must be const)
-                         Dsp::DirectFormII> (1));               // realization
-        
-        antialiasingfilters.add (new Dsp::SmoothedFilterDesign<Dsp::RBJ::Design::LowPass, 1> (1024));
-    }
+                         Dsp::DirectFormII>> (1);               // realization
 
 }
 
@@ -86,10 +82,7 @@ void AudioMonitor::updateSettings()
         {
             selectedStream = stream->getStreamId();
             
-            for (int i = 0; i < activeChannels->size(); i++)
-            {
-                updateFilter(i, selectedStream);
-            }
+            updateFilter(selectedStream);
         }
     }
 }
@@ -121,44 +114,25 @@ void AudioMonitor::prepareToPlay(double sampleRate_, int estimatedSamplesPerBloc
 
 void AudioMonitor::recreateBuffers()
 {
-	numSamplesExpected.clear();
-    sourceBufferSampleRate.clear();
+    resamplers.clear();
     
-    ratio.clear();
+    const int targetLatency = int(estimatedSamples) * AUDIO_MONITOR_LATENCY_BLOCKS;
     
-    for (int i = 0; i < getNumInputs(); i++)
+    for (auto stream : dataStreams)
     {
-        numSamplesExpected.emplace(i,
-                                   continuousChannels[i]->getSampleRate()
-                                   / destBufferSampleRate
-                                   * estimatedSamples);
-        
-        sourceBufferSampleRate.emplace(i, continuousChannels[i]->getSampleRate());
+        auto resampler = std::make_unique<AudioResampler>();
         
-        ratio.emplace(i, sourceBufferSampleRate[i]/destBufferSampleRate);
+        resampler->prepare(stream->getSampleRate(),
+                           destBufferSampleRate,
+                           MIX_BUFFER_SIZE,
+                           targetLatency);
         
+        resamplers[stream->getStreamId()] = std::move(resampler);
     }
-
-    samplesInBackupBuffer.clear();
-    samplesInOverflowBuffer.clear();
-    
-    bufferA.clear();
-    bufferB.clear();
-    bufferSwap.clear();
     
-    for (int i = 0; i < MAX_CHANNELS; i++)
-    {
-
-        samplesInBackupBuffer.emplace(i, 0.0f);
-        samplesInOverflowBuffer.emplace(i, 0.0f);
-
-        bufferA.emplace(i, std::make_unique<AudioBuffer<float>>(1,44100));
-        bufferB.emplace(i, std::make_unique<AudioBuffer<float>>(1,44100));
-        bufferSwap.emplace(i, false);
+    activeStream = -1;
 
-    }
-
-    tempBuffer->setSize(1, 4096);
+    mixBuffer.setSize(1, MIX_BUFFER_SIZE);
 }
 
 
@@ -186,16 +160,13 @@ void AudioMonitor::parameterValueChanged(Parameter* param)
 
             LOGA("Selected channel ", localIndex);
 
-            auto continuousChannels = getDataStream(selectedStream)->getContinuousChannels();
-
-            if (continuousChannels.size() > localIndex)
-            {
-                int globalIndex = continuousChannels[localIndex]->getGlobalIndex();
+        }
 
-                updateFilter(i, selectedStream);
-            }
+        if (activeChannels->size() > 0)
+            updateFilter(selectedStream);
 
-        }
+        // the filter and resampler still hold the previous selection's signal
+        activeStream = -1;
         
         // clear monitored channels on all other streams
         //for (auto stream : dataStreams)
@@ -209,7 +180,7 @@ void AudioMonitor::parameterValueChanged(Parameter* param)
 }
 
 
-void AudioMonitor::updateFilter(int i, uint16 streamId)
+void AudioMonitor::updateFilter(uint16 streamId)
 {
 
     Dsp::Params params1;
@@ -218,18 +189,7 @@ void AudioMonitor::updateFilter(int i, uint16 streamId)
     params1[2] = (7000 + 100) / 2;     // center frequency
     params1[3] = 7000 - 100;           // bandwidth
 
-    bandpassfilters[i]->setParams (params1);
-    
-    double cutoffFreq = destBufferSampleRate / 2; // upsample
-
-    double sampleFreq = destBufferSampleRate;  // upsample
-
-    Dsp::Params params2;
-    params2[0] = sampleFreq; // sample rate
-    params2[1] = cutoffFreq; // cutoff frequency
-    params2[2] = 1.25; //Q //
-
-    antialiasingfilters[i]->setParams(params2);
+    bandpassFilter->setParams (params1);
 
 }
 
@@ -284,6 +244,8 @@ void AudioMonitor::process (AudioBuffer<float>& buffer)
     buffer.clear(totalBufferChannels - 2, 0, buffer.getNumSamples());
     buffer.clear(totalBufferChannels - 1, 0, buffer.getNumSamples());
 
+    producingOutput = false;
+
     if (!getParameter("mute_audio")->getValue())
     {
 
@@ -294,236 +256,69 @@ void AudioMonitor::process (AudioBuffer<float>& buffer)
                 && (*stream)["enable_stream"])
             {
                 
-                AudioSampleBuffer* overflowBuffer;
-                AudioSampleBuffer* backupBuffer;
+                auto it = resamplers.find(selectedStream);
+                
+                if (it == resamplers.end())
+                    continue;
+                
+                AudioResampler* resampler = it->second.get();
+                
+                // start from a clean state when switching streams or channels
+                if (activeStream != int(selectedStream))
+                {
+                    bandpassFilter->reset();
+                    resampler->reset();
+                    activeStream = selectedStream;
+                }
 
                 Array<var>* activeChannels = stream->getParameter("Channels")->getValue().getArray();
-
-                for (int i = 0; i < activeChannels->size(); i++)
+                
+                if (activeChannels->size() == 0)
+                    continue;
+                
+                const Array<ContinuousChannel*>& channels = stream->getContinuousChannels();
+                
+                int samplesAvailable = getNumSamplesInBlock(selectedStream);
+                
+                // 1. sum the selected channels, filter the mix and re-sample it
+                for (int startSample = 0; startSample < samplesAvailable; startSample += MIX_BUFFER_SIZE)
                 {
-
-                    int localIndex = (int) activeChannels->getReference(i);
+                    int numSamples = jmin(samplesAvailable - startSample, MIX_BUFFER_SIZE);
                     
-                    int globalIndex = getDataStream(selectedStream)->getContinuousChannels()[localIndex]->getGlobalIndex();
+                    float* mix = mixBuffer.getWritePointer(0);
                     
-                    tempBuffer->clear();
+                    FloatVectorOperations::clear(mix, numSamples);
 
-                    if (!bufferSwap[i])
-                    {
-                        overflowBuffer = bufferA[i].get();
-                        backupBuffer = bufferB[i].get();
-
-                        bufferSwap[i] = true;
-                    }
-                    else
+                    for (int i = 0; i < activeChannels->size(); i++)
                     {
-                        overflowBuffer = bufferB[i].get();
-                        backupBuffer = bufferA[i].get();
 
-                        bufferSwap[i] = false;
-                    }
-
-                    backupBuffer->clear();
-
-                    samplesInOverflowBuffer[i] = samplesInBackupBuffer[i]; // size of buffer after last round
-                    samplesInBackupBuffer[i] = 0;
-
-                    double orphanedSamples = 0;
-
-                    // 1. copy overflow buffer
-
-                    double samplesToCopyFromOverflowBuffer =
-                        ((samplesInOverflowBuffer[i] <= numSamplesExpected[globalIndex]) ?
-                            samplesInOverflowBuffer[i] :
-                            numSamplesExpected[globalIndex]);
-
-                    // LOGD("Number of samples to copy: ", samplesToCopyFromOverflowBuffer);
-                    
-                    //std::cout << "Copying from overflow buffer: " << samplesToCopyFromOverflowBuffer << std::endl;
-
-                    if (samplesToCopyFromOverflowBuffer > 0) // need to re-add samples from backup buffer
-                    {
-
-                        tempBuffer->addFrom(0,    // destination channel
-                            0,                // destination start sample
-                            *overflowBuffer,  // source
-                            0,                // source channel
-                            0,                // source start sample
-                            (int) samplesToCopyFromOverflowBuffer,    // number of samples
-                            1.0f              // gain to apply
-                        );
-
-                        double leftoverSamples = samplesInOverflowBuffer[i] - samplesToCopyFromOverflowBuffer;
+                        int localIndex = (int) activeChannels->getReference(i);
                         
-                        //std::cout << "Copying to backup buffer: " << leftoverSamples << std::endl;
-
-                        if (leftoverSamples > 0) // move remaining samples to the backup buffer
-                        {
-
-                            backupBuffer->addFrom(0, // destination channel
-                                0,                     // destination start sample
-                                *overflowBuffer,       // source
-                                0,                     // source channel
-                                (int) samplesToCopyFromOverflowBuffer,         // source start sample
-                                (int) leftoverSamples,       // number of samples
-                                1.0f                   // gain to apply
-                            );
-                        }
-
-                        samplesInBackupBuffer[i] = leftoverSamples;
-                    }
-                    
-                    double remainingSamples = double(numSamplesExpected[globalIndex]) - samplesToCopyFromOverflowBuffer;
-
-                    double samplesAvailable = double(getNumSamplesInBlock(selectedStream));
-                    
-                    //std::cout << "Remaining samples: " << remainingSamples << std::endl;
-                    //std::cout << "Samples available: " << samplesAvailable << std::endl;
-
-                    double samplesToCopyFromIncomingBuffer = ((remainingSamples <= samplesAvailable) ?
-                        remainingSamples :
-                        samplesAvailable);
-                    
-                    //std::cout << "Copying from incoming buffer: " << samplesToCopyFromIncomingBuffer << std::endl;
-
-                    if (samplesToCopyFromIncomingBuffer > 0)
-                    {
-
-                        tempBuffer->addFrom(0,                  // destination channel
-                            (int) samplesToCopyFromOverflowBuffer,    // destination start sample
-                            buffer,                             // source
-                            globalIndex,                        // source channel
-                            0,                                  // source start sample
-                            (int) samplesToCopyFromIncomingBuffer,    //  number of samples
-                            1.0f                                // gain to apply
-                        );
-
-                    }
-
-                    orphanedSamples = samplesAvailable - samplesToCopyFromIncomingBuffer;
-                    
-                    //std::cout << "Orphaned samples: " << orphanedSamples << std::endl;
-
-                    if (orphanedSamples > 0 && (samplesInBackupBuffer[i] + orphanedSamples < backupBuffer->getNumSamples()))
-                    {
-
-                        backupBuffer->addFrom(0,          // destination channel
-                            samplesInBackupBuffer[i],     // destination start sample
-                            buffer,                       // source
-                            globalIndex,                  // source channel
-                            (int) remainingSamples,             // source start sample
-                            (int) orphanedSamples,              //  number of samples
-                            1.0f                          // gain to apply
-                        );
-
-                        samplesInBackupBuffer[i] = samplesInBackupBuffer[i] + orphanedSamples;
-
-                    }
-                    
-                    //std::cout << "Total copied: " << samplesToCopyFromOverflowBuffer + samplesToCopyFromIncomingBuffer << std::endl;
-
-                    // now that our tempBuffer is ready, we can filter it and copy it into the
-                    // original buffer
-                    float* ptr = tempBuffer->getWritePointer(0);
-                    
-                    int totalCopied = int(samplesToCopyFromOverflowBuffer + samplesToCopyFromIncomingBuffer);
-                    
-                    if (totalCopied == 0)
-                        continue;
-                    
-                    bandpassfilters[i]->process(totalCopied, &ptr);
-                    
-                    /*if (i == 0)
-                    {
-                        std::cout << "np.array([";
-                        for (int j = 0; j < totalCopied; j++)
-                        {
-                            std::cout << *(tempBuffer->getReadPointer(0, j)) << ", ";
-                        }
+                        if (localIndex < 0 || localIndex >= channels.size())
+                            continue;
                         
-                        std::cout << "])";
-                        std::cout << std::endl;
-                        std::cout << "------------- " << std::endl;
-                    }*/
-
-                    // initialize variables
-                    int sourceBufferPos = 0;
-                    int sourceBufferSize = totalCopied;
-                    double subSampleOffset = 0.0;
-                    int nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-
-                    double destBufferPos;
-                    int targetChannel;
-                    
-                    //std::cout << "Ratio: " << ratio[globalIndex] << std::endl;
-
-                    if (int(getParameter("audio_output")->getValue()) == 0 || int(getParameter("audio_output")->getValue()) == 1)
-                        targetChannel = totalBufferChannels - 2;
-                    else
-                        targetChannel = totalBufferChannels - 1;
-
-                    // code modified from "juce_ResamplingAudioSource.cpp":
-                    for (destBufferPos = 0; destBufferPos < valuesNeeded; destBufferPos++)
-                    {
-                        float alpha = (float) subSampleOffset;
-                        float invAlpha = 1.0f - alpha;
-
-                        buffer.addFrom(targetChannel,    // destChannel
-                            destBufferPos,               // destSampleOffset
-                            *tempBuffer,                 // source
-                            0,                           // sourceChannel
-                            sourceBufferPos,             // sourceSampleOffset
-                            1,                           // number of samples
-                            invAlpha);                   // gain to apply to source
+                        int globalIndex = channels[localIndex]->getGlobalIndex();
                         
-                        buffer.addFrom(targetChannel,    // destChannel
-                            destBufferPos,               // destSampleOffset
-                            *tempBuffer,                 // source
-                            0,                           // sourceChannel
-                            nextPos,                     // sourceSampleOffset
-                            1,                           // number of samples
-                            alpha);                      // gain to apply to source
-
-                        subSampleOffset += ratio[globalIndex];
+                        FloatVectorOperations::add(mix, buffer.getReadPointer(globalIndex, startSample), numSamples);
                         
-                        while (subSampleOffset >= 1.0)
-                        {
-                            //if (++sourceBufferPos >= sourceBufferSize)
-                            //    sourceBufferPos = 0;
-
-                            ++sourceBufferPos;
-                            nextPos = (sourceBufferPos + 1); //% sourceBufferSize;
-                            
-                            if (nextPos >= sourceBufferSize)
-                                nextPos = sourceBufferPos;
-                            
-                            subSampleOffset -= 1.0;
-                        }
-                    }
+                    } // end cycling through channels
                     
-                    //std::cout << "Source buffer pos: " << sourceBufferPos << std::endl;
+                    bandpassFilter->process(numSamples, &mix);
                     
-                    //std::cout << "After upsampling: " << valuesNeeded << std::endl;
-                    
-                    //std::cout << std::endl;
+                    resampler->process(mix, numSamples);
+                }
+                
+                // 2. copy the re-sampled signal to the output
+                int targetChannel;
 
-                    //ptr = buffer.getWritePointer(targetChannel);
-                    //antialiasingfilters[i]->process(destBufferPos, &ptr);
-                    
-                    /*if (i == 0)
-                    {
-                        std::cout << "np.array([";
-                        for (int j = 0; j < valuesNeeded; j++)
-                        {
-                            std::cout << *(buffer.getReadPointer(targetChannel, j)) << ", ";
-                        }
-                        
-                        std::cout << "])";
-                        std::cout << std::endl;
-                        std::cout << "------------- " << std::endl;
-                    }*/
-                    
-                } // end cycling through channels
+                if (int(getParameter("audio_output")->getValue()) == 0 || int(getParameter("audio_output")->getValue()) == 1)
+                    targetChannel = totalBufferChannels - 2;
+                else
+                    targetChannel = totalBufferChannels - 1;
+                
+                resampler->readOutput(buffer.getWritePointer(targetChannel), valuesNeeded);
+
+                producingOutput = true;
 
                 if (int(getParameter("audio_output")->getValue()) == 1)
                 {
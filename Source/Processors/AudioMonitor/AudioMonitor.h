@@ -31,8 +31,16 @@
 #include "../GenericProcessor/GenericProcessor.h"
 #include "../Dsp/Dsp.h"
 
+#include "AudioResampler.h"
+
 #define MAX_CHANNELS 4
 
+/** Size of the buffer that holds the mix of the monitored channels (input samples) */
+#define MIX_BUFFER_SIZE 4096
+
+/** Number of audio blocks buffered after resampling (sets the monitoring latency) */
+#define AUDIO_MONITOR_LATENCY_BLOCKS 2
+
 /**
   Reads data from a file.
 
@@ -48,7 +56,7 @@ public:
     /** Destructor*/
     ~AudioMonitor() { }
 
-    /** Re-samples, filters, and copies selected channels*/
+    /** Mixes the selected channels, then filters and re-samples the mix*/
     void process (AudioBuffer<float>& buffer) override;
     
     /** Creates the custom UI for the AudioMonitor*/
@@ -60,7 +68,7 @@ public:
     /** Updates the audio buffer size*/
 	void updatePlaybackBuffer();
 
-    /** Updates the resampling ratio for each channel*/
+    /** Prepares the resamplers for the current audio device settings*/
     void prepareToPlay(double sampleRate_, int estimatedSamplesPerBlock) override;
     
     /** Called whenever a parameter's value is changed (called by GenericProcessor::setParameter())*/
@@ -70,43 +78,40 @@ public:
     void resetConnections() override;
 
     /** Updates the bandpass filter parameters, given the currently monitored stream*/
-    void updateFilter(int i, uint16 streamId);
+    void updateFilter(uint16 streamId);
     
     /** Allows other processors to configure the Audio Monitor during acquisition*/
     void handleBroadcastMessage(String message) override;
 
+    /** Returns true if the last call to process() wrote audio to the outputs*/
+    bool isProducingOutput() const { return producingOutput.load(); }
+
 private:
     
-    /** Re-sets the copy buffers prior to acquisition*/
+    /** Re-creates the resamplers prior to acquisition*/
     void recreateBuffers();
     
-    std::map<int, std::unique_ptr<AudioBuffer<float>>> bufferA;
-    std::map<int, std::unique_ptr<AudioBuffer<float>>> bufferB;
-
-    /** Per-channel buffer state information*/
-    std::map<int, double> samplesInBackupBuffer;
-    std::map<int, double> samplesInOverflowBuffer;
-    std::map<int, double> sourceBufferSampleRate;
-    std::map<int, bool> bufferSwap;
-    
-    std::map<int, double> numSamplesExpected;
-    std::map<int, double> ratio;
+    /** One resampler per stream, so that switching streams never rebuilds tables during acquisition*/
+    std::map<uint16, std::unique_ptr<AudioResampler>> resamplers;
     
     double destBufferSampleRate;
     double estimatedSamples;
 
-    /** 4 bandpass filters (1 per selected channel)*/
-    OwnedArray<Dsp::Filter> bandpassfilters;
-    
-    /** 4 antialiasing filters (1 per selected channel)*/
-    OwnedArray<Dsp::Filter> antialiasingfilters;
+    /** Bandpass filter applied to the mix of the selected channels*/
+    std::unique_ptr<Dsp::Filter> bandpassFilter;
 
-    /** Holds the data for one channel, before it's copied to the output*/
-    std::unique_ptr<AudioBuffer<float>> tempBuffer;
+    /** Holds the sum of the selected channels, before it's filtered and re-sampled*/
+    AudioBuffer<float> mixBuffer;
     
     /** Only one stream can be monitored at a time*/
     uint16 selectedStream;
 
+    /** Stream whose resampler was used in the last block (-1 if none, or if the selection changed)*/
+    std::atomic<int> activeStream;
+
+    /** Read by the Audio Node to skip its output stage when nothing is being monitored*/
+    std::atomic<bool> producingOutput;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioMonitor);
 };
 
@@ -0,0 +1,310 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "AudioResampler.h"
+
+#include "../../Utils/Utils.h"
+
+// Kaiser window parameter and the stopband attenuation (dB) it gives
+#define KAISER_BETA 8.0
+#define KAISER_ATTENUATION 80.0
+
+namespace
+{
+    /** Zeroth-order modified Bessel function of the first kind */
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        const double halfX = x / 2.0;
+
+        for (int k = 1; k < 50; k++)
+        {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+
+            if (term < sum * 1e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    double sinc(double x)
+    {
+        if (std::abs(x) < 1e-9)
+            return 1.0;
+
+        return std::sin(MathConstants<double>::pi * x) / (MathConstants<double>::pi * x);
+    }
+}
+
+
+AudioResampler::AudioResampler()
+    : upFactor(0),
+      downFactor(0),
+      tapsPerPhase(0),
+      maxInput(0),
+      sourceRate(0),
+      destRate(0),
+      inputPosition(0),
+      phase(0),
+      fifoMask(0),
+      fifoRead(0),
+      fifoWrite(0),
+      fifoCount(0),
+      fifoTarget(0)
+{
+
+}
+
+
+void AudioResampler::findRationalFactor(double sourceRate, double destRate, int& L, int& M)
+{
+    const double ratio = destRate / sourceRate;
+
+    double bestError = std::numeric_limits<double>::max();
+
+    L = 1;
+    M = 1;
+
+    for (int up = 1; up <= MAX_PHASES; up++)
+    {
+        const int down = roundToInt(up / ratio);
+
+        if (down < 1)
+            continue;
+
+        const double error = std::abs(double(up) / down - ratio) / ratio;
+
+        if (error < bestError - 1e-12)
+        {
+            bestError = error;
+            L = up;
+            M = down;
+
+            if (error < 1e-9)
+                break;
+        }
+    }
+}
+
+
+void AudioResampler::prepare(double sourceSampleRate, double destSampleRate, int maxInputSamples, int targetLatency)
+{
+    sourceRate = sourceSampleRate;
+    destRate = destSampleRate;
+
+    findRationalFactor(sourceRate, destRate, upFactor, downFactor);
+
+    if (std::abs(double(upFactor) / downFactor - destRate / sourceRate) > 1e-9 * destRate / sourceRate)
+    {
+        LOGD("Audio resampler: ", sourceRate, " Hz -> ", destRate, " Hz approximated as ",
+             upFactor, "/", downFactor);
+    }
+
+    // when decimating, the filter must be longer to keep the same transition band
+    tapsPerPhase = jmin(MAX_TAPS_PER_PHASE,
+                        int(std::ceil(TAPS_PER_PHASE * jmax(1.0, double(downFactor) / upFactor))));
+
+    // cutoff in cycles per upsampled sample, placed so that the transition band
+    // ends at the Nyquist frequency of the lower of the two rates
+    const int length = upFactor * tapsPerPhase;
+    const double transition = (KAISER_ATTENUATION - 7.95) / (14.36 * length);
+    const double nyquist = 0.5 / jmax(upFactor, downFactor);
+
+    buildTables(jmax(nyquist / 2, nyquist - transition / 2));
+
+    maxInput = jmax(1, maxInputSamples);
+
+    history.allocate(tapsPerPhase - 1 + maxInput, true);
+
+    const int maxOutputPerBlock = int(std::ceil(double(maxInput) * upFactor / downFactor)) + 1;
+
+    fifoTarget = jmax(0, targetLatency);
+
+    const int capacity = nextPowerOfTwo(4 * fifoTarget + 2 * maxOutputPerBlock);
+
+    fifo.allocate(capacity, true);
+    fifoMask = capacity - 1;
+
+    reset();
+
+    LOGD("Audio resampler: ", upFactor, "/", downFactor, ", ", tapsPerPhase, " taps per phase, latency ",
+         getLatencyInSeconds() * 1000.0, " ms");
+}
+
+
+void AudioResampler::buildTables(double cutoff)
+{
+    const int length = upFactor * tapsPerPhase;
+    const double centre = (length - 1) / 2.0;
+    const double windowScale = besselI0(KAISER_BETA);
+
+    HeapBlock<double> prototype(length);
+
+    double sum = 0;
+
+    for (int m = 0; m < length; m++)
+    {
+        const double t = m - centre;
+        const double r = length > 1 ? t / centre : 0.0;
+        const double window = besselI0(KAISER_BETA * std::sqrt(jmax(0.0, 1.0 - r * r))) / windowScale;
+
+        prototype[m] = 2.0 * cutoff * sinc(2.0 * cutoff * t) * window;
+        sum += prototype[m];
+    }
+
+    // unity gain at DC for every branch, on average
+    const double gain = upFactor / sum;
+
+    coefficients.allocate(length, true);
+
+    for (int p = 0; p < upFactor; p++)
+    {
+        float* branch = coefficients + p * tapsPerPhase;
+
+        for (int j = 0; j < tapsPerPhase; j++)
+            branch[j] = float(prototype[(tapsPerPhase - 1 - j) * upFactor + p] * gain);
+    }
+}
+
+
+void AudioResampler::reset()
+{
+    if (!isPrepared())
+        return;
+
+    FloatVectorOperations::clear(history, tapsPerPhase - 1 + maxInput);
+
+    inputPosition = tapsPerPhase - 1;
+    phase = 0;
+
+    fifoRead = 0;
+    fifoWrite = 0;
+    fifoCount = 0;
+
+    for (int i = 0; i < fifoTarget; i++)
+        pushOutput(0.0f);
+}
+
+
+void AudioResampler::pushOutput(float sample)
+{
+    if (fifoCount > fifoMask)
+    {
+        fifoRead = (fifoRead + 1) & fifoMask;
+        fifoCount--;
+    }
+
+    fifo[fifoWrite] = sample;
+    fifoWrite = (fifoWrite + 1) & fifoMask;
+    fifoCount++;
+}
+
+
+void AudioResampler::process(const float* input, int numSamples)
+{
+    if (!isPrepared())
+        return;
+
+    const int historySize = tapsPerPhase - 1;
+
+    while (numSamples > 0)
+    {
+        const int n = jmin(numSamples, maxInput);
+
+        FloatVectorOperations::copy(history + historySize, input, n);
+
+        const int end = historySize + n;
+
+        while (inputPosition < end)
+        {
+            const float* x = history + inputPosition - historySize;
+            const float* c = coefficients + phase * tapsPerPhase;
+
+            float acc = 0.0f;
+
+            for (int j = 0; j < tapsPerPhase; j++)
+                acc += c[j] * x[j];
+
+            pushOutput(acc);
+
+            phase += downFactor;
+            inputPosition += phase / upFactor;
+            phase %= upFactor;
+        }
+
+        inputPosition -= n;
+
+        memmove(history, history + n, sizeof(float) * historySize);
+
+        input += n;
+        numSamples -= n;
+    }
+}
+
+
+void AudioResampler::readOutput(float* dest, int numSamples)
+{
+    if (!isPrepared())
+        return;
+
+    // the input arrived in a burst (or the two clocks drifted apart):
+    // drop the oldest samples to get back to the target latency
+    if (fifoCount > 2 * fifoTarget + numSamples)
+    {
+        const int excess = fifoCount - fifoTarget - numSamples;
+
+        fifoRead = (fifoRead + excess) & fifoMask;
+        fifoCount -= excess;
+    }
+
+    const int available = jmin(numSamples, fifoCount);
+    const int firstPart = jmin(available, fifoMask + 1 - fifoRead);
+
+    FloatVectorOperations::add(dest, fifo + fifoRead, firstPart);
+    FloatVectorOperations::add(dest + firstPart, fifo, available - firstPart);
+
+    fifoRead = (fifoRead + available) & fifoMask;
+    fifoCount -= available;
+
+    // underrun: the missing samples are left silent and the FIFO is primed again,
+    // so that the latency returns to its nominal value
+    if (available < numSamples)
+    {
+        for (int i = 0; i < fifoTarget; i++)
+            pushOutput(0.0f);
+    }
+}
+
+
+double AudioResampler::getLatencyInSeconds() const
+{
+    if (!isPrepared())
+        return 0.0;
+
+    const double filterDelay = (upFactor * tapsPerPhase - 1) / 2.0 / (upFactor * sourceRate);
+
+    return filterDelay + fifoTarget / destRate;
+}
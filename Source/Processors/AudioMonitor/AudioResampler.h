@@ -0,0 +1,132 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __AUDIORESAMPLER_H__
+#define __AUDIORESAMPLER_H__
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Streaming polyphase resampler for a single channel.
+
+    The conversion ratio is approximated by the rational factor L/M (at most
+    MAX_PHASES phases), and the anti-aliasing filter is a Kaiser-windowed sinc
+    that is split into L sub-filters when the resampler is prepared, so that
+    each output sample costs one short dot product and no table is computed
+    on the audio thread.
+
+    Output samples are kept in a FIFO that is primed with a fixed number of
+    samples of silence, which absorbs the variation in the number of input
+    samples per block. The total delay is therefore constant:
+    getLatencyInSeconds() returns the filter delay plus the FIFO target.
+
+    All buffers are allocated in prepare(); process(), readOutput() and reset()
+    are real-time safe.
+
+    @see AudioMonitor
+*/
+class AudioResampler
+{
+public:
+
+    /** Constructor */
+    AudioResampler();
+
+    /** Destructor */
+    ~AudioResampler() { }
+
+    /** Builds the filter tables and buffers for a pair of sample rates.
+        maxInputSamples is the largest number of samples passed to each call to process(),
+        targetLatency is the number of output samples kept in the FIFO. */
+    void prepare(double sourceSampleRate, double destSampleRate, int maxInputSamples, int targetLatency);
+
+    /** Clears the filter history and re-primes the output FIFO */
+    void reset();
+
+    /** Filters and resamples a block of input samples, appending the result to the output FIFO */
+    void process(const float* input, int numSamples);
+
+    /** Adds numSamples output samples to dest, padding with silence if the FIFO runs dry */
+    void readOutput(float* dest, int numSamples);
+
+    /** Returns the interpolation factor (L) */
+    int getUpsamplingFactor() const { return upFactor; }
+
+    /** Returns the decimation factor (M) */
+    int getDownsamplingFactor() const { return downFactor; }
+
+    /** Returns the (constant) delay between input and output */
+    double getLatencyInSeconds() const;
+
+    /** Returns true if prepare() has been called */
+    bool isPrepared() const { return upFactor > 0; }
+
+    /** Maximum number of polyphase branches */
+    static const int MAX_PHASES = 1024;
+
+    /** Number of taps per branch when upsampling */
+    static const int TAPS_PER_PHASE = 32;
+
+    /** Upper bound on the number of taps per branch when downsampling */
+    static const int MAX_TAPS_PER_PHASE = 256;
+
+private:
+
+    /** Finds the smallest L/M (with L <= MAX_PHASES) that best approximates destRate / sourceRate */
+    static void findRationalFactor(double sourceRate, double destRate, int& L, int& M);
+
+    /** Designs the prototype low-pass filter and stores it as L reversed sub-filters */
+    void buildTables(double cutoff);
+
+    /** Appends one sample to the output FIFO, dropping the oldest sample if it is full */
+    void pushOutput(float sample);
+
+    int upFactor;
+    int downFactor;
+    int tapsPerPhase;
+    int maxInput;
+
+    double sourceRate;
+    double destRate;
+
+    /** coefficients[phase * tapsPerPhase + j], ordered to match the history buffer */
+    HeapBlock<float> coefficients;
+
+    /** The last (tapsPerPhase - 1) input samples followed by the current block */
+    HeapBlock<float> history;
+
+    /** Position of the next output sample, in input samples and in phases */
+    int inputPosition;
+    int phase;
+
+    HeapBlock<float> fifo;
+    int fifoMask;
+    int fifoRead;
+    int fifoWrite;
+    int fifoCount;
+    int fifoTarget;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioResampler);
+};
+
+#endif  // __AUDIORESAMPLER_H__
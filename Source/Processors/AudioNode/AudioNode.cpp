@@ -24,10 +24,11 @@
 #include <cmath>
 
 #include "AudioNode.h"
+#include "../AudioMonitor/AudioMonitor.h"
 
 AudioNode::AudioNode()
     : GenericProcessor("Audio Node"), audioEditor(nullptr), volume(0.00001f), noiseGateLevel(0.0f),
-    connectedProcessors(0)
+    bypassed(true), connectedProcessors(0)
 {
 
     resetConnections();
@@ -47,6 +48,7 @@ void AudioNode::resetConnections()
 {
 
     connectedProcessors = 0;
+    monitors.clear();
     
     updatePlaybackBuffer();
 }
@@ -54,6 +56,9 @@ void AudioNode::resetConnections()
 void AudioNode::registerProcessor(const GenericProcessor* sourceNode)
 {
     connectedProcessors++;
+
+    if (sourceNode->isAudioMonitor())
+        monitors.add(sourceNode);
 }
 
 void AudioNode::updateBufferSize()
@@ -84,55 +89,69 @@ void AudioNode::setParameter(int parameterIndex, float newValue)
     else if (parameterIndex == 2)
     {
         // noiseGateLevel level
-        expander.setThreshold(newValue); // in microVolts?
+        for (auto& expander : expanders)
+            expander.setThreshold(newValue); // in microVolts?
+
+    }
+}
 
+bool AudioNode::hasActiveMonitors() const
+{
+    for (auto monitor : monitors)
+    {
+        if (static_cast<const AudioMonitor*>(monitor)->isProducingOutput())
+            return true;
     }
+
+    return false;
+}
+
+void AudioNode::clipAndScale(float* sampleData, int numSamples, float limit, float gain)
+{
+    // one min/max/mul pass, which the compiler vectorises
+    for (int j = 0; j < numSamples; j++)
+        sampleData[j] = jmax(-limit, jmin(limit, sampleData[j])) * gain;
 }
 
 void AudioNode::process(AudioBuffer<float>& buffer)
 {
 
-    if (connectedProcessors > 0)
+    // nothing to play: skip the whole output stage
+    if (connectedProcessors == 0 || volume <= 0.0f || !hasActiveMonitors())
     {
-        float gain;
-
-        int valuesNeeded = buffer.getNumSamples(); // samples needed to fill out the buffer
-
-        int nInputs = buffer.getNumChannels();
-
-        if (nInputs > 0) // we have some channels
-        {
-            
-            for (int i = 0; i < nInputs; i++) // cycle through them all
-            {
-                
-                // Data are floats in units of microvolts, so dividing by bitVolts and 0x7fff (max value for 16b signed)
-                // rescales to between -1 and +1. Audio output starts So, maximum gain applied to maximum data would be 10.
-                
-                for (int j = 0; j < valuesNeeded; j++)
-                {
-                    if (*buffer.getReadPointer(i, j) > 1000)
-                        *buffer.getWritePointer(i, j) = 1000;
-                    
-                    if (*buffer.getReadPointer(i, j) < -1000)
-                        *buffer.getWritePointer(i, j) = -1000;
-                }
-
-                gain = (volume * 0.01f) / (float(0x7fff) * 0.02);
-
-                buffer.applyGain(i, 0, valuesNeeded, gain);
-
-                // Simple implementation of a "noise gate" on audio output
-                expander.process(buffer.getWritePointer(i), // expand the left/right channel
-                                 buffer.getNumSamples());
-            
-            } // end cycling through channels
-
-        }
-    }
-    else {
         buffer.clear();
+
+        bypassed = true;
+
+        return;
+    }
+
+    if (bypassed)
+    {
+        for (auto& expander : expanders)
+            expander.reset();
+
+        bypassed = false;
     }
+
+    int valuesNeeded = buffer.getNumSamples(); // samples needed to fill out the buffer
+
+    int nInputs = jmin(buffer.getNumChannels(), 2);
+
+    // Data are floats in units of microvolts, so dividing by bitVolts and 0x7fff (max value for 16b signed)
+    // rescales to between -1 and +1. Audio output starts So, maximum gain applied to maximum data would be 10.
+    const float gain = (volume * 0.01f) / (float(0x7fff) * 0.02f);
+
+    for (int i = 0; i < nInputs; i++) // cycle through them all
+    {
+        float* samples = buffer.getWritePointer(i);
+
+        clipAndScale(samples, valuesNeeded, CLIP_LEVEL, gain);
+
+        // Simple implementation of a "noise gate" on audio output
+        expanders[i].process(samples, valuesNeeded);
+
+    } // end cycling through channels
     
 }
 
@@ -150,6 +169,12 @@ Expander::Expander()
     setRatio(1.2); // ratio > 1.0 will decrease gain below threshold
 }
 
+void Expander::reset()
+{
+    env = 0.f;
+    gain = 1.f;
+}
+
 void Expander::setThreshold(float value)
 {
     threshold = value;
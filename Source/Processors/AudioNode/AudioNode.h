@@ -43,6 +43,8 @@ public:
   void setRatio(float);
   void setAttack(float);
   void setRelease(float);
+
+  /** Clears the envelope (e.g. after the output was bypassed) */
   void reset();
 
   void process(float* sampleData, int numSamples);
@@ -67,6 +69,10 @@ private:
     the data to the audio device selected in the audio settings
     interface.
 
+  When none of the Audio Monitors produced output in the current
+    block (e.g. no channels are selected), or the volume is zero,
+    the output is simply cleared.
+
   @see GenericProcessor, AudioEditor
 
 */
@@ -106,20 +112,36 @@ public:
     // expand # of inputs for each connected processor
     void registerProcessor(const GenericProcessor* sourceNode);
 
+    /** Maximum absolute value of the incoming data (in microvolts) */
+    static constexpr float CLIP_LEVEL = 1000.0f;
+
     /** A pointer to the AudioNode's editor. */
     std::unique_ptr<AudioEditor> audioEditor;
 
 private:
 
+    /** Returns true if at least one of the connected Audio Monitors wrote to its outputs in this block */
+    bool hasActiveMonitors() const;
+
+    /** Clips each sample to +/- limit and multiplies it by gain, in a single pass */
+    static void clipAndScale(float* sampleData, int numSamples, float limit, float gain);
+
     Array<int> leftChan;
     Array<int> rightChan;
     float volume;
     float noiseGateLevel; // in microvolts
 
-    Expander expander;
+    /** One expander per output channel, so that the envelopes are independent */
+    Expander expanders[2];
+
+    /** True if the previous block was bypassed */
+    bool bypassed;
 
     int connectedProcessors;
 
+    /** Audio Monitors feeding this node */
+    Array<const GenericProcessor*> monitors;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioNode);
 
 };
@@ -27,6 +27,11 @@ DataBuffer::DataBuffer (int chans, int size)
     : abstractFifo  (size)
     , buffer        (chans, size)
     , numChans      (chans)
+    , highWaterMark (0)
+    , numOverruns   (0)
+    , numDroppedSamples (0)
+    , numUnderruns  (0)
+    , hasReturnedData (false)
 {
     sampleNumberBuffer.malloc (size);
     timestampBuffer.malloc (size);
@@ -49,6 +54,9 @@ void DataBuffer::clear()
 
 void DataBuffer::resize (int chans, int size)
 {
+    abstractFifo.setTotalSize (size);
+    abstractFifo.reset();
+
     buffer.setSize (chans, size);
 
     sampleNumberBuffer.malloc (size);
@@ -59,6 +67,36 @@ void DataBuffer::resize (int chans, int size)
     lastTimestamp = -1.0;
 
     numChans = chans;
+
+    resetStats();
+}
+
+
+int DataBuffer::getSize() const { return abstractFifo.getTotalSize(); }
+
+
+DataBufferStats DataBuffer::getStats() const
+{
+    DataBufferStats stats;
+
+    stats.size = abstractFifo.getTotalSize();
+    stats.numSamples = abstractFifo.getNumReady();
+    stats.highWaterMark = highWaterMark.load (std::memory_order_relaxed);
+    stats.numOverruns = numOverruns.load (std::memory_order_relaxed);
+    stats.numDroppedSamples = numDroppedSamples.load (std::memory_order_relaxed);
+    stats.numUnderruns = numUnderruns.load (std::memory_order_relaxed);
+
+    return stats;
+}
+
+
+void DataBuffer::resetStats()
+{
+    highWaterMark.store (0, std::memory_order_relaxed);
+    numOverruns.store (0, std::memory_order_relaxed);
+    numDroppedSamples.store (0, std::memory_order_relaxed);
+    numUnderruns.store (0, std::memory_order_relaxed);
+    hasReturnedData.store (false, std::memory_order_relaxed);
 }
 
 int DataBuffer::addToBuffer (float* data,
@@ -106,6 +144,18 @@ int DataBuffer::addToBuffer (float* data,
     // finish write
     abstractFifo.finishedWrite (idx);
 
+    if (idx < numItems)
+    {
+        numOverruns.fetch_add (1, std::memory_order_relaxed);
+        numDroppedSamples.fetch_add (numItems - idx, std::memory_order_relaxed);
+    }
+
+    // only this thread raises the mark, so no compare-and-swap is needed
+    const int numReady = abstractFifo.getNumReady();
+
+    if (numReady > highWaterMark.load (std::memory_order_relaxed))
+        highWaterMark.store (numReady, std::memory_order_relaxed);
+
     return idx;
 }
 
@@ -119,12 +169,19 @@ int DataBuffer::readAllFromBuffer (AudioBuffer<float>& data,
                                    uint64* eventCodes,
                                    int maxSize,
                                    int dstStartChannel,
-                                   int numChannels)
+                                   int numChannels,
+                                   SampleNumberGapTable* gaps)
 {
     // check to see if the maximum size is smaller than the total number of available ints
     int numReady = abstractFifo.getNumReady();
     int numItems = (maxSize < numReady) ? maxSize : numReady;
 
+    // the source may take a while to deliver its first samples; that is not an underrun
+    if (numReady > 0)
+        hasReturnedData.store (true, std::memory_order_relaxed);
+    else if (hasReturnedData.load (std::memory_order_relaxed))
+        numUnderruns.fetch_add (1, std::memory_order_relaxed);
+
     int startIndex1, blockSize1, startIndex2, blockSize2;
     abstractFifo.prepareToRead (numItems, startIndex1, blockSize1, startIndex2, blockSize2);
 
@@ -167,6 +224,23 @@ int DataBuffer::readAllFromBuffer (AudioBuffer<float>& data,
         memcpy (eventCodes + blockSize1, eventCodeBuffer + startIndex2, blockSize2 * 8);
     }
 
+    if (gaps != nullptr)
+    {
+        gaps->clear();
+
+        if (blockSize1 > 0)
+            findSampleNumberGaps (startIndex1, blockSize1, 0, *gaps);
+
+        if (blockSize2 > 0)
+        {
+            // the wrap-around point is not a gap unless the numbers jump there
+            if (sampleNumberBuffer[startIndex2] != sampleNumberBuffer[startIndex1 + blockSize1 - 1] + 1)
+                gaps->add (blockSize1, sampleNumberBuffer[startIndex2]);
+
+            findSampleNumberGaps (startIndex2, blockSize2, blockSize1, *gaps);
+        }
+    }
+
    // std::cout << "START SAMPLE FOR READ: " << *blockSampleNumber << std::endl;
     
     if (numItems > 0)
@@ -182,3 +256,15 @@ int DataBuffer::readAllFromBuffer (AudioBuffer<float>& data,
 
     return numItems;
 }
+
+
+void DataBuffer::findSampleNumberGaps (int startIndex, int numItems, int blockOffset, SampleNumberGapTable& gaps)
+{
+    const int64* sampleNumbers = sampleNumberBuffer + startIndex;
+
+    for (int i = 1; i < numItems; ++i)
+    {
+        if (sampleNumbers[i] != sampleNumbers[i - 1] + 1)
+            gaps.add (blockOffset + i, sampleNumbers[i]);
+    }
+}
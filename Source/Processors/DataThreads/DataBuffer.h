@@ -25,7 +25,35 @@
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../PluginManager/OpenEphysPlugin.h"
+#include "../Events/SampleNumberGaps.h"
 
+#include <atomic>
+
+/**
+    Fill statistics of a DataBuffer, accumulated since they were last reset.
+
+    See @DataBuffer
+*/
+struct DataBufferStats
+{
+    /** Capacity of the buffer, in samples per channel */
+    int size = 0;
+
+    /** Number of samples waiting to be read */
+    int numSamples = 0;
+
+    /** Largest number of samples that were waiting to be read at once */
+    int highWaterMark = 0;
+
+    /** Number of writes that did not fit in the buffer */
+    int64 numOverruns = 0;
+
+    /** Number of samples lost because the buffer was full */
+    int64 numDroppedSamples = 0;
+
+    /** Number of reads that found the buffer empty, after the first one that returned data */
+    int64 numUnderruns = 0;
+};
 
 /**
     Manages reading and writing data to a circular buffer.
@@ -68,20 +96,42 @@ public:
     /** Returns the number of samples currently available in the buffer.*/
     int getNumSamples() const;
 
-    /** Copies as many samples as possible from the DataBuffer to an AudioBuffer.*/
+    /** Copies as many samples as possible from the DataBuffer to an AudioBuffer.
+
+        Only the sample number and timestamp of the first sample are returned.
+        If 'gaps' is not null, it is filled with the positions of the samples
+        whose sample number does not follow on from the previous one.
+    */
     int readAllFromBuffer (AudioBuffer<float>& data,
                            int64* sampleNumbers,
                            double* timestamps,
                            uint64* eventCodes,
                            int maxSize,
                            int dstStartChannel = 0,
-                           int numChannels = -1);
+                           int numChannels = -1,
+                           SampleNumberGapTable* gaps = nullptr);
 
     /** Resizes the data buffer */
     void resize (int chans, int size);
 
+    /** Returns the capacity of the buffer, in samples per channel */
+    int getSize() const;
+
+    /** Returns the number of channels in the buffer */
+    int getNumChannels() const { return numChans; }
+
+    /** Returns the fill statistics. Safe to call from any thread. */
+    DataBufferStats getStats() const;
+
+    /** Resets the fill statistics (while data is not being written) */
+    void resetStats();
+
 
 private:
+
+    /** Adds the sample number discontinuities of one contiguous region to the table */
+    void findSampleNumberGaps (int startIndex, int numItems, int blockOffset, SampleNumberGapTable& gaps);
+
     AbstractFifo abstractFifo;
     AudioBuffer<float> buffer;
 
@@ -94,6 +144,15 @@ private:
 
     int numChans;
 
+    /** Written by the data thread only */
+    std::atomic<int> highWaterMark;
+    std::atomic<int64> numOverruns;
+    std::atomic<int64> numDroppedSamples;
+
+    /** Written by the audio thread only */
+    std::atomic<int64> numUnderruns;
+    std::atomic<bool> hasReturnedData;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DataBuffer);
 };
 
@@ -26,6 +26,10 @@
 
 #include "../Editors/GenericEditor.h"
 
+// limits on the size (in samples per channel) chosen by adaptBufferSizes()
+#define MIN_ADAPTIVE_BUFFER_SIZE 4096
+#define MAX_ADAPTIVE_BUFFER_SIZE (1 << 20)
+
 DataThread::DataThread (SourceNode* s_)
     : Thread     ("Data Thread"),
       sn(s_)
@@ -62,6 +66,69 @@ DataBuffer* DataThread::getBufferAddress(int streamIdx) const
 }
 
 
+DataBufferStats DataThread::getBufferStats(int streamIdx) const
+{
+    if (DataBuffer* buffer = sourceBuffers[streamIdx])
+        return buffer->getStats();
+
+    return DataBufferStats();
+}
+
+
+void DataThread::resetBufferStats()
+{
+    for (auto buffer : sourceBuffers)
+        buffer->resetStats();
+}
+
+
+void DataThread::adaptBufferSizes()
+{
+    bufferSizeHints.resize(jmax(bufferSizeHints.size(), sourceBuffers.size()));
+
+    for (int i = 0; i < sourceBuffers.size(); i++)
+    {
+        DataBuffer* buffer = sourceBuffers[i];
+        const DataBufferStats stats = buffer->getStats();
+
+        if (stats.highWaterMark == 0)
+            continue; // no data from this stream
+
+        // the buffer must hold its peak twice over; an overflowing one at least doubles
+        int targetSize = nextPowerOfTwo(2 * stats.highWaterMark);
+
+        if (stats.numOverruns > 0)
+            targetSize = jmax(targetSize, 2 * stats.size);
+
+        targetSize = jlimit(MIN_ADAPTIVE_BUFFER_SIZE, MAX_ADAPTIVE_BUFFER_SIZE, targetSize);
+
+        // only shrink when it saves at least half of the buffer
+        if (targetSize > stats.size || 2 * targetSize <= stats.size)
+        {
+            LOGC("Resizing buffer for stream ", i, " from ", stats.size, " to ", targetSize,
+                 " samples (peak: ", stats.highWaterMark, ", overruns: ", stats.numOverruns, ")");
+
+            buffer->resize(buffer->getNumChannels(), targetSize);
+
+            bufferSizeHints.set(i, targetSize);
+        }
+    }
+}
+
+
+void DataThread::applyBufferSizeHints()
+{
+    for (int i = 0; i < jmin(sourceBuffers.size(), bufferSizeHints.size()); i++)
+    {
+        DataBuffer* buffer = sourceBuffers[i];
+        const int size = bufferSizeHints[i];
+
+        if (buffer != nullptr && size > 0 && buffer->getSize() != size)
+            buffer->resize(buffer->getNumChannels(), size);
+    }
+}
+
+
 std::unique_ptr<GenericEditor> DataThread::createEditor (SourceNode*)
 {
     return nullptr;
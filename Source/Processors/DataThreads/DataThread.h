@@ -104,6 +104,10 @@ public:
     /** Allows the DataThread to set its default state, depending on whether the signal chain is loading */
     virtual void initialize(bool signalChainIsLoading) { }
 
+    /** Returns true if initialize(true) can run on a background thread while the signal chain
+          is loading (see GenericProcessor::canInitializeConcurrently()) */
+    virtual bool canInitializeConcurrently() const { return false; }
+
     // ---------------------
     // NON-VIRTUAL METHODS
     // ---------------------
@@ -114,6 +118,21 @@ public:
     /** Returns the address of the DataBuffer that the input source will fill.*/
     DataBuffer* getBufferAddress(int streamIdx) const;
 
+    /** Returns the fill statistics of a stream's DataBuffer.*/
+    DataBufferStats getBufferStats(int streamIdx) const;
+
+    /** Resets the fill statistics of all DataBuffers (called before acquisition starts).*/
+    void resetBufferStats();
+
+    /** Resizes each DataBuffer to hold twice the largest number of samples it held during
+        the last acquisition (more if it overflowed). Only called between acquisitions.
+        The chosen sizes are remembered per stream (see applyBufferSizeHints()).*/
+    void adaptBufferSizes();
+
+    /** Gives each DataBuffer the size chosen by adaptBufferSizes(), after the plugin
+        has recreated or resized its buffers in updateSettings() or resizeBuffers().*/
+    void applyBufferSizeHints();
+
 protected:
 
     // ** Allows the DataThread to broadcast a message other plugins */
@@ -125,6 +144,9 @@ protected:
 
 private:
 
+    /** Buffer size chosen by adaptBufferSizes() for each stream (0 if none) */
+    Array<int> bufferSizeHints;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DataThread);
 };
 
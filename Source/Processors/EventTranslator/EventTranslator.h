@@ -67,6 +67,9 @@ public:
     /** Add latest samples to the signal chain buffer */
     void process (AudioBuffer<float>& buffer) override;
 
+    /** Does not modify the continuous data */
+    bool isPassThrough() const override { return true; }
+
     /** Creates the editor */
     AudioProcessorEditor* createEditor() override;
     
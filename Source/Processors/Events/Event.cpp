@@ -204,9 +204,10 @@ size_t SystemEvent::fillTimestampAndSamplesData(HeapBlock<char>& data,
 	int64 startSampleForBlock,
     double startTimestampForBlock,
 	uint32 nSamplesInBlock,
-	int64 processStartTime)
+	int64 processStartTime,
+	const SampleNumberGapTable* gaps)
 {
-	const int eventSize = EVENT_BASE_SIZE + 4 + 8;
+	const int eventSize = EVENT_BASE_SIZE + 4 + 8 + (gaps != nullptr ? int(gaps->getSerializedSize()) : 0);
 	data.malloc(eventSize);
 	data[0] = SYSTEM_EVENT;													 // 1 byte
 	data[1] = TIMESTAMP_AND_SAMPLES;										 // 1 byte
@@ -218,6 +219,10 @@ size_t SystemEvent::fillTimestampAndSamplesData(HeapBlock<char>& data,
     *reinterpret_cast<double*>(data.getData() + 16) = startTimestampForBlock;// 8 bytes
 	*reinterpret_cast<uint32*>(data.getData() + EVENT_BASE_SIZE) = nSamplesInBlock;		 // 8 bytes
 	*reinterpret_cast<int64*>(data.getData() + EVENT_BASE_SIZE + 4) = processStartTime; // 8 bytes
+
+	if (gaps != nullptr)
+		gaps->serialize(reinterpret_cast<uint8*>(data.getData() + EVENT_BASE_SIZE + 12)); // 4 + 12 bytes per gap
+
 	return eventSize;
 }
 
@@ -275,6 +280,15 @@ int64 SystemEvent::getHiResTicks(const EventPacket& packet)
 	return *reinterpret_cast<const int64*>(packet.getRawData() + EVENT_BASE_SIZE + 4);
 }
 
+void SystemEvent::getSampleNumberGaps(const uint8* data, size_t dataSize, SampleNumberGapTable& gaps)
+{
+	// events without a gap table (e.g. from older plugins) end after the process start time
+	if (dataSize > EVENT_BASE_SIZE + 12)
+		gaps.deserialize(data + EVENT_BASE_SIZE + 12, dataSize - (EVENT_BASE_SIZE + 12));
+	else
+		gaps.clear();
+}
+
 String SystemEvent::getSyncText(const EventPacket& packet)
 {
 	if (getBaseType(packet) != SYSTEM_EVENT && getSystemEventType(packet) != TIMESTAMP_SYNC_TEXT)
@@ -456,6 +470,48 @@ TTLEventPtr TTLEvent::createTTLEvent(EventChannel* channelInfo,
 	return new TTLEvent(channelInfo, sampleNumber, data);
 }
 
+size_t TTLEvent::serializeTTLEvent(const EventChannel* channelInfo,
+	int64 sampleNumber,
+	uint8 line,
+	bool state,
+	uint64 word,
+	void* dstBuffer,
+	size_t dstSize)
+{
+	jassert(channelInfo->getType() == EventChannel::TTL);
+	jassert(channelInfo->getEventMetadataCount() == 0);
+
+	const size_t dataSize = channelInfo->getDataSize();
+	const size_t eventSize = dataSize + EVENT_BASE_SIZE;
+
+	if (eventSize > dstSize || dataSize < 10)
+	{
+		jassertfalse;
+		return 0;
+	}
+
+	// same layout as serializeHeader() + serialize()
+	char* buffer = static_cast<char*>(dstBuffer);
+
+	*(buffer + 0) = PROCESSOR_EVENT;
+	*(buffer + 1) = static_cast<char>(EventChannel::TTL);
+	*(reinterpret_cast<uint16*>(buffer + 2)) = channelInfo->getSourceNodeId();
+	*(reinterpret_cast<uint16*>(buffer + 4)) = channelInfo->getStreamId();
+	*(reinterpret_cast<uint16*>(buffer + 6)) = channelInfo->getLocalIndex();
+	*(reinterpret_cast<juce::int64*>(buffer + 8)) = sampleNumber;
+	*(reinterpret_cast<double*>(buffer + 16)) = -1.0;
+
+	uint8* data = reinterpret_cast<uint8*>(buffer + EVENT_BASE_SIZE);
+
+	zeromem(data, dataSize);
+
+	data[0] = line;
+	data[1] = state;
+	*reinterpret_cast<uint64*>(data + 2) = word;
+
+	return eventSize;
+}
+
 TTLEventPtr TTLEvent::createTTLEvent(const EventChannel* channelInfo, 
                                      int64 sampleNumber,
                                      uint8 line,
@@ -567,6 +623,38 @@ TTLEventPtr TTLEvent::deserialize(const EventPacket& packet, const EventChannel*
 	
 }
 
+TTLEventBatch::TTLEventBatch(int capacity_)
+	: capacity(0),
+	  numEntries(0)
+{
+	setCapacity(capacity_);
+}
+
+void TTLEventBatch::setCapacity(int capacity_)
+{
+	capacity = jmax(0, capacity_);
+	numEntries = 0;
+
+	entries.malloc(jmax(1, capacity));
+}
+
+bool TTLEventBatch::add(int sampleIndex, uint8 line, bool state, uint64 word)
+{
+	if (numEntries >= capacity)
+		return false;
+
+	jassert(numEntries == 0 || sampleIndex >= entries[numEntries - 1].sampleIndex);
+
+	Entry& entry = entries[numEntries++];
+
+	entry.sampleIndex = sampleIndex;
+	entry.line = line;
+	entry.state = state;
+	entry.word = word;
+
+	return true;
+}
+
 TextEvent::TextEvent(const EventChannel* channelInfo, int64 sampleNumber, const String& text, double timestamp)
 	: Event(channelInfo, sampleNumber, timestamp)
 {
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <JuceHeader.h>
 #include "../Settings/EventChannel.h"
+#include "SampleNumberGaps.h"
 
 #define EVENT_BASE_SIZE 24
 
@@ -224,14 +225,15 @@ public:
 
 	};
 
-	/* Create a TIMESTAMP_AND_SAMPLES event */
+	/* Create a TIMESTAMP_AND_SAMPLES event, optionally followed by the block's sample number gaps */
 	static size_t fillTimestampAndSamplesData(HeapBlock<char>& data, 
 		const GenericProcessor* proc, 
 		uint16 streamId, 
 		int64 startSampleForBlock,
         double timestamp,
 		uint32 nSamplesInBlock,
-		int64 processStartTime);
+		int64 processStartTime,
+		const SampleNumberGapTable* gaps = nullptr);
 		
 	/* Create a TIMESTAMP_SYNC_TEXT event */
 	static size_t fillTimestampSyncTextData(HeapBlock<char>& data, 
@@ -249,6 +251,9 @@ public:
 
 	/* Get the sample count from an EventPacket object */
 	static int64 getHiResTicks(const EventPacket& msg);
+
+	/* Get the sample number gaps from a TIMESTAMP_AND_SAMPLES event */
+	static void getSampleNumberGaps(const uint8* data, size_t dataSize, SampleNumberGapTable& gaps);
 	
 	/* Get the sync text from an EventPacket object */
 	static String getSyncText(const EventPacket& msg);
@@ -402,6 +407,16 @@ public:
 	/* Deserialize a TTL event from a raw byte buffer*/
 	static TTLEventPtr deserialize(const uint8* data, const EventChannel* channelInfo);
 
+	/* Serialize a TTL event (on a channel without metadata) directly to a buffer, without
+	   creating a TTLEvent object. Returns the number of bytes written, or 0 if the buffer is too small */
+	static size_t serializeTTLEvent(const EventChannel* channelInfo,
+		int64 sampleNumber,
+		uint8 line,
+		bool state,
+		uint64 word,
+		void* destinationBuffer,
+		size_t bufferSize);
+
 private:
 	/* Prevent the creation of an empty event*/
 	TTLEvent() = delete;
@@ -412,6 +427,58 @@ private:
 	JUCE_LEAK_DETECTOR(TTLEvent);
 };
 
+/**
+*
+* Fixed-capacity list of TTL changes on a single event channel, sorted by sample,
+* which lets a processor emit many TTL events without creating an object (or
+* allocating memory) for each one.
+*
+* @see GenericProcessor::addTTLEvents
+*
+*/
+class PLUGIN_API TTLEventBatch
+{
+public:
+
+	/* A single TTL change */
+	struct Entry
+	{
+		int sampleIndex;
+		uint8 line;
+		bool state;
+		uint64 word;
+	};
+
+	/* Constructor */
+	TTLEventBatch(int capacity = 0);
+
+	/* Changes the maximum number of entries (clears the batch; must not be called on the audio thread) */
+	void setCapacity(int capacity);
+
+	/* Adds a change at a sample index within the current block (must be >= that of the last entry).
+	   Returns false if the batch is full */
+	bool add(int sampleIndex, uint8 line, bool state, uint64 word);
+
+	/* Removes all entries */
+	void clear() { numEntries = 0; }
+
+	/* Returns the number of entries */
+	int size() const { return numEntries; }
+
+	/* Returns true if no more entries can be added */
+	bool isFull() const { return numEntries >= capacity; }
+
+	/* Returns an entry */
+	const Entry& operator[](int index) const { return entries[index]; }
+
+private:
+	HeapBlock<Entry> entries;
+	int capacity;
+	int numEntries;
+
+	JUCE_DECLARE_NON_COPYABLE(TTLEventBatch);
+};
+
 typedef ScopedPointer<TextEvent> TextEventPtr;
 
 /**
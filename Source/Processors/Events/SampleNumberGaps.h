@@ -0,0 +1,174 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SAMPLENUMBERGAPS_H_INCLUDED
+#define SAMPLENUMBERGAPS_H_INCLUDED
+
+#include <JuceHeader.h>
+
+/**
+    A discontinuity inside a block of samples: starting at 'sampleIndex',
+    sample numbers count up from 'sampleNumber' instead of continuing
+    from the previous sample.
+*/
+struct SampleNumberGap
+{
+    /** Index of the first sample after the gap, relative to the start of the block */
+    uint32 sampleIndex;
+
+    /** Sample number of that sample */
+    int64 sampleNumber;
+};
+
+/**
+    Fixed-capacity list of the sample number discontinuities in one block.
+
+    Sample numbers are only sent once per block (in the TIMESTAMP_AND_SAMPLES
+    event), which assumes that they increase by one from sample to sample.
+    When a data source drops or repeats samples, the table records where
+    each new run of sample numbers starts, so that downstream processors and
+    the Record Node can recover the sample number of every sample without
+    passing per-sample arrays around.
+
+    The table never allocates, so it can be filled and read on the audio thread.
+    Gaps beyond MAX_GAPS are not stored, but their number is kept (and
+    serialized) so that readers can tell that the table is incomplete.
+
+    @see DataBuffer, SystemEvent, GenericProcessor::getSampleNumberGapsForBlock
+*/
+class SampleNumberGapTable
+{
+public:
+
+    /** Maximum number of gaps stored per block */
+    static const int MAX_GAPS = 32;
+
+    /** Size in bytes of each serialized gap */
+    static const size_t GAP_SIZE = 4 + 8;
+
+    /** Size in bytes of the serialized gap and dropped-gap counts */
+    static const size_t HEADER_SIZE = 2 + 2;
+
+    /** Constructor */
+    SampleNumberGapTable() : numGaps(0), numDropped(0) { }
+
+    /** Removes all gaps */
+    void clear()
+    {
+        numGaps = 0;
+        numDropped = 0;
+    }
+
+    /** Adds a gap (in increasing order of sampleIndex). Returns false if the table is full. */
+    bool add(uint32 sampleIndex, int64 sampleNumber)
+    {
+        if (numGaps == MAX_GAPS)
+        {
+            numDropped++;
+            return false;
+        }
+
+        gaps[numGaps++] = { sampleIndex, sampleNumber };
+
+        return true;
+    }
+
+    /** Returns the number of gaps stored */
+    int size() const { return numGaps; }
+
+    /** Returns the number of gaps that did not fit in the table */
+    int getNumDropped() const { return numDropped; }
+
+    /** Returns a gap */
+    const SampleNumberGap& operator[](int index) const { return gaps[index]; }
+
+    /** Returns the sample number of a sample in the block, given the sample number of the first sample */
+    int64 getSampleNumber(int64 firstSampleNumber, uint32 sampleIndex) const
+    {
+        int64 runStart = firstSampleNumber;
+        uint32 runIndex = 0;
+
+        for (int i = 0; i < numGaps && gaps[i].sampleIndex <= sampleIndex; i++)
+        {
+            runStart = gaps[i].sampleNumber;
+            runIndex = gaps[i].sampleIndex;
+        }
+
+        return runStart + (sampleIndex - runIndex);
+    }
+
+    /** Returns the number of bytes written by serialize() */
+    size_t getSerializedSize() const { return HEADER_SIZE + numGaps * GAP_SIZE; }
+
+    /** Writes the gap count and the dropped-gap count, followed by the gaps */
+    void serialize(uint8* data) const
+    {
+        *reinterpret_cast<uint16*>(data) = uint16(numGaps);
+        *reinterpret_cast<uint16*>(data + 2) = uint16(jmin(numDropped, 0xffff));
+
+        data += HEADER_SIZE;
+
+        for (int i = 0; i < numGaps; i++)
+        {
+            memcpy(data, &gaps[i].sampleIndex, 4);
+            memcpy(data + 4, &gaps[i].sampleNumber, 8);
+
+            data += GAP_SIZE;
+        }
+    }
+
+    /** Reads gaps written by serialize(); an empty or truncated buffer gives an empty table */
+    void deserialize(const uint8* data, size_t dataSize)
+    {
+        clear();
+
+        if (dataSize < HEADER_SIZE)
+            return;
+
+        const int count = jmin(int(*reinterpret_cast<const uint16*>(data)),
+                               int((dataSize - HEADER_SIZE) / GAP_SIZE),
+                               MAX_GAPS);
+
+        numDropped = int(*reinterpret_cast<const uint16*>(data + 2));
+
+        data += HEADER_SIZE;
+
+        for (int i = 0; i < count; i++)
+        {
+            memcpy(&gaps[i].sampleIndex, data, 4);
+            memcpy(&gaps[i].sampleNumber, data + 4, 8);
+
+            data += GAP_SIZE;
+        }
+
+        numGaps = count;
+    }
+
+private:
+
+    SampleNumberGap gaps[MAX_GAPS];
+    int numGaps;
+    int numDropped;
+};
+
+#endif  // SAMPLENUMBERGAPS_H_INCLUDED
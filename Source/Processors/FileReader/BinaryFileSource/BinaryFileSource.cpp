@@ -23,6 +23,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "BinaryFileSource.h"
 
+#include "../../../CoreServices.h"
+
+#include <algorithm>
+#include <numeric>
+
 using namespace BinarySource;
 
 BinaryFileSource::BinaryFileSource() 
@@ -72,6 +77,232 @@ bool BinaryFileSource::open(File file)
 	return true;
 }
 
+namespace
+{
+	/* Returns a pointer to the array data of a mapped .npy file, and the number of bytes available */
+	const uint8* getNpyData(const MemoryMappedFile& file, size_t& numBytes)
+	{
+		const uint8* data = static_cast<const uint8*>(file.getData());
+		numBytes = 0;
+
+		if (data == nullptr || file.getSize() < 10)
+			return nullptr;
+
+		uint16 headerLength;
+		memcpy(&headerLength, data + 8, sizeof(uint16));
+
+		size_t dataOffset = 10 + headerLength;
+
+		if (dataOffset > file.getSize())
+			return nullptr;
+
+		numBytes = file.getSize() - dataOffset;
+		return data + dataOffset;
+	}
+
+	/* Reads only the first sample number of a stream, rather than the whole file */
+	int64 readFirstSampleNumber(File file)
+	{
+		FileInputStream stream(file);
+
+		if (stream.failedToOpen() || stream.getTotalLength() < 10)
+			return 0;
+
+		stream.setPosition(8);
+		int headerLength = (uint16) stream.readShort();
+
+		if (!stream.setPosition(10 + headerLength) || stream.getNumBytesRemaining() < (int64) sizeof(int64))
+			return 0;
+
+		return stream.readInt64();
+	}
+}
+
+/**
+	Loads the event streams of a recording in the background, on a pool
+	of worker threads, and reports progress in the status bar.
+*/
+class BinaryFileSource::EventLoader : public Thread
+{
+public:
+
+	EventLoader(BinaryFileSource* owner_)
+		: Thread("Binary Event Loader"),
+		  owner(owner_),
+		  pool(jlimit(1, 4, SystemStats::getNumCpus()))
+	{
+	}
+
+	~EventLoader()
+	{
+		stopThread(5000);
+	}
+
+	void run() override
+	{
+		WeakReference<BinaryFileSource> weakOwner(owner);
+
+		const int numStreams = owner->m_eventStreams.size();
+
+		for (auto stream : owner->m_eventStreams)
+		{
+			pool.addJob([this, stream, weakOwner]
+			{
+				if (!threadShouldExit())
+					loadEventStream(*stream);
+
+				numLoaded++;
+				notify();
+
+				/* The map and the cursors are only modified on the message thread */
+				MessageManager::callAsync([weakOwner, stream]
+				{
+					if (BinaryFileSource* source = weakOwner.get())
+						source->commitEventStream(stream);
+				});
+			});
+		}
+
+		uint32 lastReport = Time::getMillisecondCounter();
+
+		/* Each job wakes this thread when it finishes, so the wait only bounds the status updates */
+		while (numLoaded.load() < numStreams)
+		{
+			if (threadShouldExit())
+			{
+				pool.removeAllJobs(true, 5000);
+				return;
+			}
+
+			wait(500);
+
+			owner->loadingProgress.set(float(numLoaded.load()) / float(numStreams));
+
+			if (Time::getMillisecondCounter() - lastReport > 500)
+			{
+				CoreServices::sendStatusMessage("Loading events: " + String(numLoaded.load()) + " of " + String(numStreams) + " streams");
+				lastReport = Time::getMillisecondCounter();
+			}
+		}
+
+		owner->loadingProgress.set(1.0f);
+
+		LOGD("Loaded ", numStreams, " event streams");
+	}
+
+private:
+
+	BinaryFileSource* owner;
+	std::atomic<int> numLoaded{ 0 };
+	ThreadPool pool;
+};
+
+BinaryFileSource::~BinaryFileSource()
+{
+	m_eventLoader.reset();
+}
+
+void BinaryFileSource::loadEventStream(EventStream& stream)
+{
+	EventInfo& info = stream.pending;
+
+	MemoryMappedFile sampleNumbersMap(stream.sampleNumbersFile, MemoryMappedFile::readOnly);
+	MemoryMappedFile dataMap(stream.dataFile, MemoryMappedFile::readOnly);
+
+	size_t sampleBytes, dataBytes;
+	const uint8* sampleData = getNpyData(sampleNumbersMap, sampleBytes);
+	const uint8* data = getNpyData(dataMap, dataBytes);
+
+	if (sampleData == nullptr || data == nullptr)
+		return;
+
+	const int64* sampleNumbers = reinterpret_cast<const int64*>(sampleData);
+	size_t numEvents = sampleBytes / sizeof(int64);
+
+	if (stream.isText)
+	{
+		/* Fixed-size, null-padded strings ('|S<n>') */
+		const char* header = static_cast<const char*>(dataMap.getData()) + 10;
+		String headerString = String::fromUTF8(header, int(data - reinterpret_cast<const uint8*>(header)));
+		int itemSize = headerString.fromFirstOccurrenceOf("'|S", false, false).getIntValue();
+
+		if (itemSize <= 0)
+			return;
+
+		numEvents = jmin(numEvents, dataBytes / itemSize);
+
+		info.text.resize(numEvents);
+
+		for (size_t i = 0; i < numEvents; i++)
+		{
+			const char* item = reinterpret_cast<const char*>(data) + i * itemSize;
+			int length = 0;
+
+			while (length < itemSize && item[length] != 0)
+				length++;
+
+			info.text[i] = String::fromUTF8(item, length);
+		}
+
+		info.channels.assign(numEvents, 0);
+		info.channelStates.assign(numEvents, 0);
+	}
+	else
+	{
+		const int16* states = reinterpret_cast<const int16*>(data);
+		numEvents = jmin(numEvents, dataBytes / sizeof(int16));
+
+		info.channels.resize(numEvents);
+		info.channelStates.resize(numEvents);
+		info.text.resize(numEvents);
+
+		for (size_t i = 0; i < numEvents; i++)
+		{
+			info.channels[i] = abs(states[i]);
+			info.channelStates[i] = states[i] > 0;
+		}
+	}
+
+	info.timestamps.resize(numEvents);
+
+	for (size_t i = 0; i < numEvents; i++)
+		info.timestamps[i] = sampleNumbers[i] - stream.startSampleNumber;
+
+	sortEvents(info);
+}
+
+void BinaryFileSource::commitEventStream(EventStream* stream)
+{
+	eventInfoMap[stream->name] = std::move(stream->pending);
+	stream->events = &eventInfoMap[stream->name];
+	stream->loaded.store(true, std::memory_order_release);
+
+	/* Report events that playback went past while the stream was still loading */
+	const int64 skippedStart = stream->skippedStart.load();
+	const int64 skippedStop = stream->skippedStop.load();
+
+	if (skippedStart >= 0)
+	{
+		const std::vector<int64>& timestamps = stream->events->timestamps;
+		auto numSkipped = std::lower_bound(timestamps.begin(), timestamps.end(), skippedStop)
+			- std::lower_bound(timestamps.begin(), timestamps.end(), skippedStart);
+
+		if (numSkipped > 0)
+			LOGC("Skipped ", numSkipped, " events from ", stream->name, " that were played back before the stream finished loading");
+	}
+
+	for (auto s : m_eventStreams)
+	{
+		if (!s->loaded.load())
+			return;
+	}
+
+	loadingProgress.set(1.0f);
+
+	if (onLoadingFinished != nullptr)
+		onLoadingFinished();
+}
+
 void BinaryFileSource::fillRecordInfo()
 {
 
@@ -93,9 +324,6 @@ void BinaryFileSource::fillRecordInfo()
 		channelStatesFilename = "states.npy";
 	}
 
-
-	const int maxSensibleFileSize = 2 * 1024 * 1024; 
-
 	var continuousData = m_jsonData["continuous"];
 
 	//create identifiers to speed up stuff
@@ -108,7 +336,8 @@ void BinaryFileSource::fillRecordInfo()
 
 	int numProcessors = continuousData.size();
 
-	std::map<String, int64> startSampleNumbers;
+	/* 1. Index the continuous streams from the JSON file */
+	Array<File> streamDirectories;
 
 	for (int i = 0; i < numProcessors; i++)
 	{
@@ -123,30 +352,12 @@ void BinaryFileSource::fillRecordInfo()
 		String streamName = record[idFolder];
 		streamName = streamName.trimCharactersAtEnd("/");
 
-		File dataFile = m_rootPath.getChildFile("continuous").getChildFile(streamName).getChildFile("continuous.dat");
-		if (!dataFile.existsAsFile()) continue;
-
-		int numChannels = record[idNumChannels];
-		int64 numSamples = (dataFile.getSize() / numChannels) / sizeof(int16);
-
 		info.name = streamName;
 		info.sampleRate = record[idSampleRate];
-		info.numSamples = numSamples;
-		
-		File tsFile = m_rootPath.getChildFile("continuous").getChildFile(streamName).getChildFile(sampleNumbersFilename);
-		if (tsFile.exists())
-		{
-			std::unique_ptr<FileInputStream> tsDataStream = tsFile.createInputStream();
-			MemoryBlock tsData;
-			if (!(tsDataStream->readIntoMemoryBlock(tsData, maxSensibleFileSize))) continue;
-			int64* startTimestamp = (int64*)tsData.getData() + EVENT_HEADER_SIZE_IN_BYTES / 8;
-			info.startTimestamp = *startTimestamp;
-			startSampleNumbers[streamName] = *startTimestamp;
-		}
-		else 
-		{
-			info.startTimestamp = 0;
-		}
+		info.numSamples = 0;
+		info.startTimestamp = 0;
+
+		int numChannels = record[idNumChannels];
 
 		for (int c = 0; c < numChannels; c++)
 		{
@@ -158,29 +369,91 @@ void BinaryFileSource::fillRecordInfo()
 			
 			info.channels.add(cInfo);
 		}
-		
+
 		infoArray.add(info);
-		numRecords++;	
+		streamDirectories.add(m_rootPath.getChildFile("continuous").getChildFile(streamName));
+	}
 
-		m_dataFileArray.add(dataFile);
-		
+	/* 2. Read the sizes and first sample numbers of all streams in parallel */
+	Array<File> dataFiles;
+	dataFiles.insertMultiple(0, File(), infoArray.size());
+
+	{
+		ThreadPool pool(jlimit(1, 8, infoArray.size()));
+
+		std::atomic<int> numRemaining{ infoArray.size() };
+		WaitableEvent allDone;
+
+		for (int i = 0; i < infoArray.size(); i++)
+		{
+			pool.addJob([this, i, &streamDirectories, &dataFiles, sampleNumbersFilename, &numRemaining, &allDone]
+			{
+				struct JobDone
+				{
+					std::atomic<int>& remaining;
+					WaitableEvent& event;
+					~JobDone() { if (--remaining == 0) event.signal(); }
+				} jobDone{ numRemaining, allDone };
+
+				RecordInfo& info = infoArray.getReference(i);
+				File streamDirectory = streamDirectories[i];
+				File dataFile = streamDirectory.getChildFile("continuous.dat");
+
+				if (dataFile.existsAsFile())
+				{
+					info.numSamples = (dataFile.getSize() / info.channels.size()) / sizeof(int16);
+				}
+				else
+				{
+					/* Compressed streams (written by the COMPRESSED record engine) */
+					dataFile = streamDirectory.getChildFile("continuous.packed");
+
+					CompressedBlockReader reader;
+					if (!dataFile.existsAsFile() || !reader.open(dataFile, streamDirectory.getChildFile("block_index.npy")))
+						return;
+
+					info.numSamples = reader.getNumSamples();
+				}
+
+				File tsFile = streamDirectory.getChildFile(sampleNumbersFilename);
+
+				if (tsFile.existsAsFile())
+					info.startTimestamp = readFirstSampleNumber(tsFile);
+
+				dataFiles.getReference(i) = dataFile;
+			});
+		}
+
+		if (infoArray.size() > 0)
+			allDone.wait();
+	}
+
+	std::map<String, int64> startSampleNumbers;
+
+	for (int i = infoArray.size() - 1; i >= 0; i--)
+	{
+		if (dataFiles[i] == File())
+		{
+			infoArray.remove(i);
+			continue;
+		}
+
+		startSampleNumbers[infoArray[i].name] = infoArray[i].startTimestamp;
 	}
 
+	for (auto& dataFile : dataFiles)
+	{
+		if (dataFile != File())
+		{
+			m_dataFileArray.add(dataFile);
+			numRecords++;
+		}
+	}
+
+	/* 3. Index the event streams; their contents are loaded in the background */
 	if (hasEventData)
 	{
-		LOGD("Loading events");
 		var eventData = m_jsonData["events"];
-		
-		/* Create identifiers for efficiency */
-		Identifier idFolder("folder_name");
-		Identifier idChannelName("channel_name");
-		Identifier idDescription("description");
-		Identifier idIdentifier("identifier");
-		Identifier idSampleRate("sample_rate");
-		Identifier idType("type");
-		Identifier idNumChannels("num_channels");
-		Identifier idChannels("channels");
-		Identifier idSourceProcessor("source_processor");
 
 		int numEventProcessors = eventData.size();
 
@@ -189,115 +462,145 @@ void BinaryFileSource::fillRecordInfo()
 
 			var events = eventData[i];
 
-			LOGD("Event processor ", i);
-
 			String streamName = events[idFolder];
 			streamName = streamName.trimCharactersAtEnd("/");
 
-			File sampleNumbersFile = m_rootPath.getChildFile("events").getChildFile(streamName).getChildFile(sampleNumbersFilename);
-			std::unique_ptr<MemoryMappedFile> sampleNumbersMap(new MemoryMappedFile(sampleNumbersFile, MemoryMappedFile::readOnly));
+			File folder = m_rootPath.getChildFile("events").getChildFile(streamName);
+			File sampleNumbersFile = folder.getChildFile(sampleNumbersFilename);
 
-			if (sampleNumbersFile.getSize() == EVENT_HEADER_SIZE_IN_BYTES)
-			{
+			if (!sampleNumbersFile.existsAsFile() || sampleNumbersFile.getSize() <= EVENT_HEADER_SIZE_IN_BYTES)
 				continue;
-			}
-				
 
-			int nEvents = (sampleNumbersFile.getSize() - EVENT_HEADER_SIZE_IN_BYTES) / 8;
+			std::unique_ptr<EventStream> stream = std::make_unique<EventStream>();
+			stream->sampleNumbersFile = sampleNumbersFile;
 
 			if (streamName.contains("TTL"))
 			{
+				stream->name = streamName.substring(0, streamName.lastIndexOf("/TTL"));
+				stream->dataFile = folder.getChildFile(channelStatesFilename);
+				stream->isText = false;
+				stream->startSampleNumber = startSampleNumbers[stream->name];
+			}
+			else if (streamName.equalsIgnoreCase("MessageCenter"))
+			{
+				stream->name = streamName;
+				stream->dataFile = folder.getChildFile("text.npy");
+				stream->isText = true;
+				// Use the first stream's start sample number for the MessageCenter
+				stream->startSampleNumber = startSampleNumbers.size() > 0 ? startSampleNumbers.begin()->second : 0;
+			}
+			else
+			{
+				continue;
+			}
 
-				LOGD("TTL found");
+			/* If several folders map to the same stream, the last one is used */
+			for (int j = m_eventStreams.size() - 1; j >= 0; j--)
+			{
+				if (m_eventStreams[j]->name == stream->name)
+					m_eventStreams.remove(j);
+			}
 
-				File channelStatesFile = m_rootPath.getChildFile("events").getChildFile(streamName).getChildFile(channelStatesFilename);
-				std::unique_ptr<MemoryMappedFile> channelStatesFileMap(new MemoryMappedFile(channelStatesFile, MemoryMappedFile::readOnly));
+			m_eventStreams.add(stream.release());
+		}
 
-				streamName = streamName.substring(0,streamName.lastIndexOf("/TTL"));
+		if (m_eventStreams.size() > 0)
+		{
+			loadingProgress.set(0.0f);
 
-				EventInfo eventInfo;
+			m_eventLoader = std::make_unique<EventLoader>(this);
+			m_eventLoader->startThread();
+		}
+	}
+}
 
-				for (int j = 0; j < nEvents; j++)
-				{
-					
-					int16* data = static_cast<int16*>(channelStatesFileMap->getData()) + (EVENT_HEADER_SIZE_IN_BYTES / 2) + j * sizeof(int16) / 2;
-					eventInfo.channels.push_back(abs(*data));
-					eventInfo.channelStates.push_back(*data > 0);
-					int64* snData = static_cast<int64*>(sampleNumbersMap->getData()) + (EVENT_HEADER_SIZE_IN_BYTES / 8) + j * sizeof(int64) / 8;
-					eventInfo.timestamps.push_back(*snData - startSampleNumbers[streamName]);
-					eventInfo.text.push_back("");
-				}
-				eventInfoMap[streamName] = eventInfo;
-			}
-			else if (streamName.equalsIgnoreCase("MessageCenter"))
-			{
+void BinaryFileSource::sortEvents(EventInfo& info)
+{
+	if (std::is_sorted(info.timestamps.begin(), info.timestamps.end()))
+		return;
 
-				LOGD("Message found");
+	std::vector<size_t> order(info.timestamps.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&info](size_t a, size_t b)
+	{
+		return info.timestamps[a] < info.timestamps[b];
+	});
 
-				File textFile = m_rootPath.getChildFile("events").getChildFile(streamName).getChildFile("text.npy");
+	EventInfo sorted;
+	sorted.channels.reserve(order.size());
+	sorted.channelStates.reserve(order.size());
+	sorted.timestamps.reserve(order.size());
+	sorted.text.reserve(order.size());
 
-				juce::FileInputStream inputStream(textFile);
-				inputStream.skipNextBytes(10); // \x93NUMPY \x01 \x00
-				String line = inputStream.readNextLine();
+	for (size_t i : order)
+	{
+		sorted.channels.push_back(info.channels[i]);
+		sorted.channelStates.push_back(info.channelStates[i]);
+		sorted.timestamps.push_back(info.timestamps[i]);
+		sorted.text.push_back(info.text[i]);
+	}
 
-				uint64 itemSize = std::stoi(line.fromFirstOccurrenceOf("'|S", 0, 0).upToFirstOccurrenceOf("'", 0, 0).toStdString());
+	info = std::move(sorted);
+}
 
-				EventInfo eventInfo;
-				int k_word;
+void BinaryFileSource::addEventsFromCursor(EventCursor& cursor, EventInfo& eventInfo, int64 start, int64 stop, int64 offset)
+{
+	if (cursor.stream == nullptr)
+		return;
 
-				juce::MemoryBlock buffer(itemSize);
-				auto *data = static_cast<char *>(buffer.getData());
+	/* Events that are still loading are skipped; the cursor reseeks once they arrive,
+	   and the skipped range is reported by commitEventStream() */
+	if (!cursor.stream->loaded.load(std::memory_order_acquire))
+	{
+		int64 expected = -1;
+		cursor.stream->skippedStart.compare_exchange_strong(expected, start);
 
-				for (int j = 0; j < nEvents; j++)
-				{
+		if (stop > cursor.stream->skippedStop.load())
+			cursor.stream->skippedStop.store(stop);
 
-					for (int k = 0; k < itemSize; k++)
-					{
-						data[k] = inputStream.readByte();
-						if ((data[k] == 0) || (k == itemSize - 1))
-							k_word = k;
-					} 
-
-					String outString = juce::String::fromUTF8(data, (int)k_word);
-					eventInfo.channels.push_back(0);
-					eventInfo.channelStates.push_back(0);
-					int64 *snData = static_cast<int64 *>(sampleNumbersMap->getData()) + (EVENT_HEADER_SIZE_IN_BYTES / 8) + j * sizeof(int64) / 8;
-					// Use the first stream's start sample number for the MessageCenter
-					int64 startSampleNumber = startSampleNumbers.begin()->second;
-					eventInfo.timestamps.push_back(*snData - startSampleNumber);
-					eventInfo.text.push_back(outString);
-				}
-				eventInfoMap[streamName] = eventInfo;
-			}
-		}
+		return;
 	}
+
+	const EventInfo* events = cursor.stream->events;
+	const std::vector<int64>& timestamps = events->timestamps;
+
+	/* Playback jumped (seek, loop or first block): find the first event at or after start */
+	if (start != cursor.lastStop)
+		cursor.position = std::lower_bound(timestamps.begin(), timestamps.end(), start) - timestamps.begin();
+
+	while (cursor.position < timestamps.size() && timestamps[cursor.position] < stop)
+	{
+		size_t i = cursor.position++;
+
+		eventInfo.channels.push_back(events->channels[i] - 1);
+		eventInfo.channelStates.push_back(events->channelStates[i]);
+		eventInfo.timestamps.push_back(timestamps[i] + offset);
+		eventInfo.text.push_back(events->text[i]);
+	}
+
+	cursor.lastStop = stop;
 }
 
 void BinaryFileSource::processEventData(EventInfo &eventInfo, int64 start, int64 stop)
 {
 
-	int local_start = start % getActiveNumSamples();
-	int local_stop = stop % getActiveNumSamples();
-	int loop_count = start / getActiveNumSamples();
+	int64 numSamples = getActiveNumSamples();
 
-	std::vector<String> includeStreams = {currentStream, "MessageCenter"};
+	int64 local_start = start % numSamples;
+	int64 local_stop = stop % numSamples;
+	int64 loop_offset = (start / numSamples) * numSamples;
 
-	for (int s = 0; s < includeStreams.size(); s++)
+	for (EventCursor* cursor : { &streamEvents, &messageCenterEvents })
 	{
-		EventInfo info = eventInfoMap[includeStreams[s]];
-
-		int i = 0;
-			
-		while (i < info.timestamps.size())
+		if (local_stop >= local_start)
 		{
-			if (info.timestamps[i] >= local_start && info.timestamps[i] < local_stop)
-			{
-				eventInfo.channels.push_back(info.channels[i] - 1);
-				eventInfo.channelStates.push_back((info.channelStates[i]));
-				eventInfo.timestamps.push_back(info.timestamps[i] + loop_count * getActiveNumSamples());
-				eventInfo.text.push_back(info.text[i]);
-			}
-			i++;
+			addEventsFromCursor(*cursor, eventInfo, local_start, local_stop, loop_offset);
+		}
+		else
+		{
+			/* The range wraps around the end of the recording */
+			addEventsFromCursor(*cursor, eventInfo, local_start, numSamples, loop_offset);
+			addEventsFromCursor(*cursor, eventInfo, 0, local_stop, loop_offset + numSamples);
 		}
 	}
 }
@@ -305,7 +608,17 @@ void BinaryFileSource::processEventData(EventInfo &eventInfo, int64 start, int64
 void BinaryFileSource::updateActiveRecord(int index)
 {
     m_dataFile.reset();
-	m_dataFile = std::make_unique<MemoryMappedFile>(m_dataFileArray[index], MemoryMappedFile::readOnly);
+	m_packedReader.reset();
+
+	if (m_dataFileArray[index].hasFileExtension("packed"))
+	{
+		m_packedReader = std::make_unique<CompressedBlockReader>();
+		m_packedReader->open(m_dataFileArray[index], m_dataFileArray[index].getSiblingFile("block_index.npy"));
+	}
+	else
+	{
+		m_dataFile = std::make_unique<MemoryMappedFile>(m_dataFileArray[index], MemoryMappedFile::readOnly);
+	}
 	m_samplePos = 0;
 	numActiveChannels = getActiveNumChannels();
 
@@ -316,6 +629,17 @@ void BinaryFileSource::updateActiveRecord(int index)
 
 	currentStream = m_dataFileArray[index].getParentDirectory().getFileName();
 
+	streamEvents = EventCursor();
+	messageCenterEvents = EventCursor();
+
+	for (auto stream : m_eventStreams)
+	{
+		if (stream->name == currentStream)
+			streamEvents.stream = stream;
+		else if (stream->name == "MessageCenter")
+			messageCenterEvents.stream = stream;
+	}
+
 }
 
 void BinaryFileSource::seekTo(int64 sample)
@@ -336,6 +660,13 @@ int BinaryFileSource::readData(int16* buffer, int nSamples)
 		samplesToRead = nSamples;
 	}
 
+	if (m_packedReader != nullptr)
+	{
+		samplesToRead = m_packedReader->read(m_samplePos, (int) samplesToRead, buffer);
+		m_samplePos += samplesToRead;
+		return samplesToRead;
+	}
+
 	int16* data = static_cast<int16*>(m_dataFile->getData()) + (m_samplePos * numActiveChannels);
 
 	//FIXME: Can crash here (heap overflow?), secondary either to wrong index or scrubbing too fast? Not sure yet. 
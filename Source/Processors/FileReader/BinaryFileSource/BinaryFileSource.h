@@ -26,6 +26,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "../FileSource.h"
 #include "../../../Utils/Utils.h"
+#include "../../RecordNode/BinaryFormat/CompressedBlockFile.h"
+
+#include <atomic>
 
 /** 
 	
@@ -46,7 +49,7 @@ namespace BinarySource
 		BinaryFileSource();
 
 		/** Destructor */
-		~BinaryFileSource() { }
+		~BinaryFileSource();
 
 		/** Attempt to open file and return true if successful */
 		bool open(File file) override;
@@ -72,11 +75,60 @@ namespace BinarySource
 		int64 loopCount;
 
 	private:
+
+		class EventLoader;
+
+		/** The files and load state of one event stream */
+		struct EventStream
+		{
+			String name;
+			File sampleNumbersFile;
+			File dataFile;
+			bool isText;
+			int64 startSampleNumber;
+
+			/** Filled by the EventLoader, then moved into eventInfoMap on the message thread */
+			EventInfo pending;
+
+			const EventInfo* events = nullptr;
+			std::atomic<bool> loaded{ false };
+
+			/** Sample range that playback passed through before the stream was loaded */
+			mutable std::atomic<int64> skippedStart{ -1 };
+			mutable std::atomic<int64> skippedStop{ -1 };
+		};
+
+		/** Playback position within one stream's sorted events */
+		struct EventCursor
+		{
+			const EventStream* stream = nullptr;
+			size_t position = 0;
+			int64 lastStop = -1;
+		};
+
+		/** Reads the memory-mapped event arrays of a stream into its pending EventInfo */
+		static void loadEventStream(EventStream& stream);
+
+		/** Makes a loaded stream available for playback (called on the message thread) */
+		void commitEventStream(EventStream* stream);
+
+		/** Sorts all columns of an EventInfo by timestamp */
+		static void sortEvents(EventInfo& info);
+
+		OwnedArray<EventStream> m_eventStreams;
+		std::unique_ptr<EventLoader> m_eventLoader;
+
+		/** Appends the events in [start, stop) to info, reseeking the cursor if playback jumped */
+		void addEventsFromCursor(EventCursor& cursor, EventInfo& info, int64 start, int64 stop, int64 offset);
+
+		EventCursor streamEvents;
+		EventCursor messageCenterEvents;
 		
 		int numActiveChannels;
 		Array<float> bitVolts;
 
 		std::unique_ptr<MemoryMappedFile> m_dataFile;
+		std::unique_ptr<CompressedBlockReader> m_packedReader;
 		var m_jsonData;
 		Array<File> m_dataFileArray;
 
@@ -87,6 +139,8 @@ namespace BinarySource
 		const unsigned int BYTES_PER_EVENT = 2;
 
 		bool hasEventData;
+
+		JUCE_DECLARE_WEAK_REFERENCEABLE(BinaryFileSource);
 		
 	};
 }
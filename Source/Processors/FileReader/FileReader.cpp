@@ -45,9 +45,13 @@ FileReader::FileReader() : GenericProcessor ("File Reader")
     , currentNumScrubbedSamples (0)
     , startSample               (0)
     , stopSample                (0)
+    , cachePosition             (0)
+    , cacheSizeInSamples        (0)
+    , sampleRemainder           (0.0)
+    , playbackSpeed             (1.0f)
     , loopCount                 (0)
-    , bufferCacheWindow         (0)
     , m_shouldFillBackBuffer    (false)
+    , m_backBufferReady         (true)
 	, m_bufferSize              (1024)
 	, m_sysSampleRate           (44100)
     , playbackActive            (true)
@@ -155,6 +159,11 @@ bool FileReader::playbackIsActive()
     return playbackActive;
 }
 
+void FileReader::setPlaybackSpeed(float speed)
+{
+    playbackSpeed = jmax(0.0f, speed);
+}
+
 int64 FileReader::getCurrentNumTotalSamples()
 {
     return currentNumTotalSamples;
@@ -218,8 +227,8 @@ bool FileReader::setFile (String fullpath)
 
 		if (index < numPluginFileSources)
 		{
-			Plugin::FileSourceInfo sourceInfo = AccessClass::getPluginManager()->getFileSourceInfo(index);
-			input = sourceInfo.creator();
+			FileSourceCreator creator = AccessClass::getPluginManager()->getFileSourceCreator(index);
+			input = creator != nullptr ? creator() : nullptr;
             LOGD("Found input.");
 		}
 		else
@@ -240,6 +249,12 @@ bool FileReader::setFile (String fullpath)
         return false;
     }
 
+    input->onLoadingFinished = [this]
+    {
+        if (AudioProcessorEditor* ed = getEditor())
+            ed->repaint();
+    };
+
     if (! input->openFile (file))
     {
         input = nullptr;
@@ -278,7 +293,7 @@ void FileReader::setActiveRecording (int index)
     currentSample   = 0;
     startSample     = 0;
     stopSample      = currentNumTotalSamples;
-    bufferCacheWindow = 0;
+    cachePosition   = cacheSizeInSamples;
     loopCount = 0;
 
     channelInfo.clear();
@@ -429,10 +444,15 @@ void FileReader::updateSettings()
     m_sysSampleRate = ads.sampleRate;
     m_bufferSize = ads.bufferSize;
     if (m_bufferSize == 0) m_bufferSize = 1024;
-    m_samplesPerBuffer.set(m_bufferSize * (getDefaultSampleRate() / m_sysSampleRate));
+    if (m_sysSampleRate <= 0) m_sysSampleRate = 44100;
+
+    /* Each cache buffer holds BUFFER_WINDOW_CACHE_SIZE of the largest blocks process() can request */
+    const int maxSamplesPerBlock = jmin(int(m_bufferSize), 
+        int(std::ceil(m_bufferSize * (getDefaultSampleRate() / m_sysSampleRate))));
+    cacheSizeInSamples = jmax(1, maxSamplesPerBlock) * BUFFER_WINDOW_CACHE_SIZE;
 
-    bufferA.malloc(currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
-    bufferB.malloc(currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
+    bufferA.malloc(currentNumChannels * cacheSizeInSamples);
+    bufferB.malloc(currentNumChannels * cacheSizeInSamples);
 
     /* Reset stream to start of playback */
     input->seekTo(startSample);
@@ -442,8 +462,10 @@ void FileReader::updateSettings()
     readAndFillBufferCache(bufferA);
 
     readBuffer = &bufferB;
-    bufferCacheWindow = 0;
+    cachePosition = cacheSizeInSamples;
+    sampleRemainder = 0.0;
     m_shouldFillBackBuffer.set(false);
+    m_backBufferReady.set(true);
 
 }
 
@@ -462,6 +484,11 @@ Array<EventInfo> FileReader::getActiveEventInfo()
     return input->getEventInfo();
 }
 
+float FileReader::getEventLoadingProgress()
+{
+    return input ? input->getLoadingProgress() : 1.0f;
+}
+
 String FileReader::handleConfigMessage(String msg)
 {
 
@@ -480,6 +507,8 @@ String FileReader::handleConfigMessage(String msg)
         static_cast<FileReaderEditor*> (getEditor())->setPlaybackStartTime(std::stoi(tokens[1].toStdString()));
     else if (tokens[0] == "stop")
         static_cast<FileReaderEditor*> (getEditor())->setPlaybackStartTime(std::stoi(tokens[1].toStdString()));
+    else if (tokens[0] == "speed")
+        static_cast<FileReaderEditor*> (getEditor())->setPlaybackSpeed(tokens[1].getFloatValue());
     else
         LOGD("Invalid key");
 
@@ -491,33 +520,51 @@ void FileReader::process(AudioBuffer<float>& buffer)
 
     bool switchNeeded = false;
 
-    int samplesNeededPerBuffer = int (float (buffer.getNumSamples()) * (getDefaultSampleRate() / m_sysSampleRate));
+    /* The number of file samples per block is usually not an integer, so the
+       fractional part (and anything cut off by the block or cache size) is carried
+       over to keep playback locked to the file's sample rate */
+    const double exactSamples = double(buffer.getNumSamples()) * (getDefaultSampleRate() / m_sysSampleRate) + sampleRemainder;
+
+    int samplesNeededPerBuffer = jmin(int(exactSamples),
+                                      int(getMaxSamplesInBlock(dataStreams[0]->getStreamId())),
+                                      cacheSizeInSamples);
+
+    sampleRemainder = jmin(exactSamples - samplesNeededPerBuffer, double(cacheSizeInSamples));
 
     if (!playbackActive && totalSamplesAcquired + samplesNeededPerBuffer > stopSample)
     {
-        samplesNeededPerBuffer = stopSample - totalSamplesAcquired;
+        samplesNeededPerBuffer = jmax(int64(0), stopSample - totalSamplesAcquired);
         switchNeeded = true;
     }
-    else
-        m_samplesPerBuffer.set(samplesNeededPerBuffer);
-    // FIXME: needs to account for the fact that the ratio might not be an exact
-    //        integer value
-    
-    // if cache window id == 0, we need to read and cache BUFFER_WINDOW_CACHE_SIZE more buffer windows
-    if (bufferCacheWindow == 0)
-    {
-        switchBuffer();
-    }
 
     //std::cout << "Reading " << samplesNeededPerBuffer << " samples. " << std::endl;
-    
-    for (int i = 0; i < currentNumChannels; ++i)
+
+    int samplesCopied = 0;
+
+    while (samplesCopied < samplesNeededPerBuffer)
     {
-        // offset readBuffer index by current cache window count * buffer window size * num channels
-        input->processChannelData (*readBuffer + (samplesNeededPerBuffer * currentNumChannels * bufferCacheWindow),
-                                buffer.getWritePointer (i, 0),
-                                i,
-                                samplesNeededPerBuffer);
+        // if the front buffer is used up, swap in the next BUFFER_WINDOW_CACHE_SIZE buffer windows
+        if (cachePosition >= cacheSizeInSamples)
+        {
+            if (AccessClass::getAudioComponent()->isFreeRunning())
+                waitForBackBuffer();
+
+            switchBuffer();
+            cachePosition = 0;
+        }
+
+        const int samplesToCopy = jmin(samplesNeededPerBuffer - samplesCopied, cacheSizeInSamples - cachePosition);
+
+        for (int i = 0; i < currentNumChannels; ++i)
+        {
+            input->processChannelData (*readBuffer + (cachePosition * currentNumChannels),
+                                    buffer.getWritePointer (i, samplesCopied),
+                                    i,
+                                    samplesToCopy);
+        }
+
+        cachePosition += samplesToCopy;
+        samplesCopied += samplesToCopy;
     }
 
     setTimestampAndSamples(totalSamplesAcquired, -1.0, samplesNeededPerBuffer, dataStreams[0]->getStreamId()); //TODO: Look at this
@@ -532,12 +579,9 @@ void FileReader::process(AudioBuffer<float>& buffer)
 
     addEventsInRange(start, stop);
 
-    bufferCacheWindow += 1;
-    bufferCacheWindow %= BUFFER_WINDOW_CACHE_SIZE;
-
     if (switchNeeded)
     {
-        bufferCacheWindow = 0;
+        cachePosition = cacheSizeInSamples;
         this->stopThread(100);
     }
 
@@ -593,6 +637,11 @@ void FileReader::setParameter (int parameterIndex, float newValue)
 
             static_cast<FileReaderEditor*> (getEditor())->setCurrentTime (samplesToMilliseconds (currentSample));
             break;
+
+        //set playback speed
+        case 3:
+            setPlaybackSpeed (newValue);
+            break;
     }
 }
 
@@ -613,10 +662,18 @@ void FileReader::switchBuffer()
     else
         readBuffer = &bufferA;
     
+    m_backBufferReady.set(false);
     m_shouldFillBackBuffer.set(true);
     notify();
 }
 
+void FileReader::waitForBackBuffer()
+{
+    // give up after a second, in case the reader thread has been stopped
+    for (int i = 0; i < 200 && !m_backBufferReady.get(); ++i)
+        m_backBufferFilled.wait(5);
+}
+
 HeapBlock<int16>* FileReader::getFrontBuffer()
 {
     return readBuffer;
@@ -636,6 +693,9 @@ void FileReader::run()
         if (m_shouldFillBackBuffer.compareAndSetBool(false, true))
         {
             readAndFillBufferCache(*getBackBuffer());
+
+            m_backBufferReady.set(true);
+            m_backBufferFilled.signal();
         }
         
         wait(30);
@@ -645,8 +705,7 @@ void FileReader::run()
 void FileReader::readAndFillBufferCache(HeapBlock<int16> &cacheBuffer)
 {
 
-    const int samplesNeededPerBuffer = m_samplesPerBuffer.get();
-    const int samplesNeeded = samplesNeededPerBuffer * BUFFER_WINDOW_CACHE_SIZE;
+    const int samplesNeeded = cacheSizeInSamples;
     
     int samplesRead = 0;
     
@@ -84,6 +84,9 @@ public:
     /* Load default example data */
     void initialize(bool signalChainIsLoading) override;
 
+    /* Settings are restored by loadFromXml, so initialize(true) has nothing to do off the message thread */
+    bool canInitializeConcurrently() const override { return true; }
+
     /* Set the current file */
     bool setFile (String fullpath);
 
@@ -102,6 +105,9 @@ public:
     /** Returns a list of EventInfo for the current stream */
     Array<EventInfo> getActiveEventInfo();
 
+    /** Returns the fraction (0-1) of the current file's events that have been loaded */
+    float getEventLoadingProgress();
+
     /** Returns the data sample rate of the current stream */
     float getCurrentSampleRate() const;
 
@@ -126,6 +132,13 @@ public:
     /** Returns true if playback is currently active */
     bool playbackIsActive();
 
+    /** Sets the playback speed as a multiple of real time (0 = as fast as possible).
+        Takes effect at the start of the next acquisition. */
+    void setPlaybackSpeed(float speed);
+
+    /** Returns the playback speed (0 = as fast as possible) */
+    float getPlaybackSpeed() const { return playbackSpeed; }
+
     /** Flag whether to loop or stop at the end of playback */
     bool loopPlayback;
 
@@ -161,7 +174,10 @@ private:
     int64 currentNumScrubbedSamples;
     int64 startSample;
     int64 stopSample;
-    int64 bufferCacheWindow; // the current buffer window to read from readBuffer
+    int cachePosition; // the next sample to read from readBuffer
+    int cacheSizeInSamples; // the number of samples held by each cache buffer
+    double sampleRemainder; // fraction of a sample carried over to the next block
+    float playbackSpeed;
     Array<RecordedChannelInfo> channelInfo;
     int64 loopCount;
     bool playbackActive;
@@ -176,13 +192,19 @@ private:
     HashMap<String, int> supportedExtensions;
     
     Atomic<int> m_shouldFillBackBuffer;
-    Atomic<int> m_samplesPerBuffer;
+    Atomic<int> m_backBufferReady;
+    WaitableEvent m_backBufferFilled;
 
 	unsigned int m_bufferSize;
 	float m_sysSampleRate;
     
     HeapBlock<int16>* getFrontBuffer();
     HeapBlock<int16>* getBackBuffer();
+
+    /** Blocks until the background thread has finished filling the back buffer.
+        Only used when the signal chain is free-running, since the audio device
+        callback must never wait on disk reads. */
+    void waitForBackBuffer();
     
     /** Executes the background thread task */
     void run() override;
@@ -27,6 +27,10 @@
 
 #include <stdio.h>
 
+/* Playback speeds offered by the speed selector, as multiples of real time (0 = as fast as possible) */
+static const float playbackSpeeds[] = { 0.5f, 1.0f, 2.0f, 5.0f, 10.0f, 0.0f };
+static const int numPlaybackSpeeds = sizeof(playbackSpeeds) / sizeof(playbackSpeeds[0]);
+
 ScrubDrawerButton::ScrubDrawerButton(const String &name) : DrawerButton(name) {}
 
 ScrubDrawerButton::~ScrubDrawerButton() {}
@@ -92,6 +96,17 @@ void FullTimeline::paint(Graphics& g)
 
     }
 
+    /* Events are loaded in the background; show how far along it is */
+    float loadingProgress = fileReader->getEventLoadingProgress();
+
+    if (loadingProgress < 1.0f)
+    {
+        g.setColour(Colours::grey);
+        g.setFont(10);
+        g.drawText("Loading events " + String(roundToInt(loadingProgress * 100.0f)) + "%",
+                   getLocalBounds().withTrimmedBottom(tickHeight), Justification::centred);
+    }
+
     /* Draw the 30-second interval */
     g.setColour(Colour(0,0,0));
     g.setOpacity(0.8f);
@@ -504,10 +519,19 @@ FileReaderEditor::FileReaderEditor (GenericProcessor* parentNode)
     addAndMakeVisible (fileNameLabel);
 
     recordSelector = new ComboBox (getNameAndId() + " Recording Selector");
-    recordSelector->setBounds (50, 50, 120, 20);
+    recordSelector->setBounds (50, 50, 85, 20);
     recordSelector->addListener (this);
     addAndMakeVisible (recordSelector);
 
+    speedSelector = new ComboBox (getNameAndId() + " Speed Selector");
+    speedSelector->setBounds (140, 50, 50, 20);
+    speedSelector->setTooltip ("Playback speed (values other than 1x run the signal chain without the audio device)");
+    for (int i = 0; i < numPlaybackSpeeds; ++i)
+        speedSelector->addItem (playbackSpeeds[i] > 0 ? String (playbackSpeeds[i]) + "x" : "Max", i + 1);
+    speedSelector->setSelectedId (2, dontSendNotification);
+    speedSelector->addListener (this);
+    addAndMakeVisible (speedSelector);
+
     currentTime = new DualTimeComponent (this, false);
     currentTime->setBounds (20, 80, 175, 20);
     addAndMakeVisible (currentTime);
@@ -799,6 +823,11 @@ void FileReaderEditor::showScrubInterface(bool show)
         recordSelector->getWidth(), recordSelector->getHeight()
     );
 
+    speedSelector->setBounds(
+        speedSelector->getX() + dX, speedSelector->getY(),
+        speedSelector->getWidth(), speedSelector->getHeight()
+    );
+
     currentTime->setBounds(
         currentTime->getX() + dX, currentTime->getY(),
         currentTime->getWidth(), currentTime->getHeight()
@@ -940,8 +969,28 @@ void FileReaderEditor::setCurrentTime (unsigned int ms)
     currentTime->setTimeMilliseconds (0, ms);
 }
 
+void FileReaderEditor::setPlaybackSpeed(float speed)
+{
+    for (int i = 0; i < numPlaybackSpeeds; ++i)
+    {
+        if (playbackSpeeds[i] == speed)
+        {
+            speedSelector->setSelectedId (i + 1, sendNotification);
+            return;
+        }
+    }
+
+    LOGE("Unsupported playback speed: ", speed);
+}
+
 void FileReaderEditor::comboBoxChanged (ComboBox* combo)
 {
+    if (combo == speedSelector)
+    {
+        fileReader->setParameter (3, playbackSpeeds[combo->getSelectedId() - 1]);
+        return;
+    }
+
     fileReader->setParameter (0, combo->getSelectedId() - 1);
     CoreServices::updateSignalChain (this);
 }
@@ -977,12 +1026,14 @@ void FileReaderEditor::clearEditor()
 void FileReaderEditor::startAcquisition()
 {
     recordSelector->setEnabled (false);
+    speedSelector->setEnabled (false);
     timeLimits->setEnable (false);
 }
 
 void FileReaderEditor::stopAcquisition()
 {
     recordSelector->setEnabled (true);
+    speedSelector->setEnabled (true);
     timeLimits->setEnable (true);
 }
 
@@ -1011,6 +1062,9 @@ void FileReaderEditor::saveCustomParametersToXml (XmlElement* xml)
     childNode = xml->createNewChildElement ("TIME_LIMITS");
     childNode->setAttribute ("start_time",  (double)timeLimits->getTimeMilliseconds (0));
     childNode->setAttribute ("stop_time",   (double)timeLimits->getTimeMilliseconds (1));
+
+    childNode = xml->createNewChildElement ("PLAYBACK");
+    childNode->setAttribute ("speed", fileReader->getPlaybackSpeed());
 }
 
 void FileReaderEditor::loadCustomParametersFromXml (XmlElement* xml)
@@ -1037,6 +1091,10 @@ void FileReaderEditor::loadCustomParametersFromXml (XmlElement* xml)
             setPlaybackStopTime (time);
             timeLimits->setTimeMilliseconds (1, time);
         }
+        else if (element->hasTagName ("PLAYBACK"))
+        {
+            setPlaybackSpeed ((float)element->getDoubleAttribute ("speed", 1.0));
+        }
     }
 }
 
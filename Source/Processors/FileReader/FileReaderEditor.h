@@ -190,6 +190,9 @@ public:
     /** Sets the current recording to playback */
     void setRecording(int index);
 
+    /** Sets the playback speed (multiple of real time, 0 = as fast as possible) */
+    void setPlaybackSpeed(float speed);
+
     /** Controls whether or not to show the file scrubbing interface */
     void showScrubInterface(bool show);
 
@@ -225,6 +228,7 @@ private:
     ScopedPointer<UtilityButton>        fileButton;
     ScopedPointer<Label>                fileNameLabel;
     ScopedPointer<ComboBox>             recordSelector;
+    ScopedPointer<ComboBox>             speedSelector;
     ScopedPointer<DualTimeComponent>    currentTime;
     ScopedPointer<DualTimeComponent>    timeLimits;
 
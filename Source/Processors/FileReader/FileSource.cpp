@@ -97,6 +97,11 @@ const EventInfo& FileSource::getEventInfo()
     return eventInfoMap[currentStream];
 }
 
+float FileSource::getLoadingProgress() const
+{
+    return loadingProgress.get();
+}
+
 
 RecordedChannelInfo FileSource::getChannelInfo (int recordIndex, int channel) const
 {
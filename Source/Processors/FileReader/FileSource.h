@@ -144,6 +144,12 @@ public:
     /** Get the event information for the current stream */
     const EventInfo& getEventInfo();
 
+    /** Returns the fraction (0-1) of data that has been loaded in the background */
+    float getLoadingProgress() const;
+
+    /** Called on the message thread once background loading has finished */
+    std::function<void()> onLoadingFinished;
+
     /** Keep track of how many times the recording has looped */
     int64 loopCount;
 
@@ -169,6 +175,7 @@ protected:
     bool fileOpened;
     int numRecords;
     Atomic<int> activeRecord; // atomic to protect against threaded data race in FileReader
+    Atomic<float> loadingProgress { 1.0f }; // set by File Sources that load data in the background
     String filename;
 
 private:
@@ -22,6 +22,7 @@
 */
 
 #include "GenericProcessor.h"
+#include "RealtimeSafetyMonitor.h"
 
 #include "../../AccessClass.h"
 #include "../../Utils/Utils.h"
@@ -33,6 +34,7 @@
 #include "../Settings/DeviceInfo.h"
 
 #include "../Splitter/Splitter.h"
+#include "../ProcessorGraph/ProcessorGraph.h"
 
 #include "../Merger/Merger.h"
 
@@ -63,9 +65,14 @@ GenericProcessor::GenericProcessor(const String& name)
 	, sendSampleCount(true)
 	, m_name(name)
 	, m_paramsWereLoaded(false)
+	, parameterQueueEnabled(false)
 
 {
 	latencyMeter = std::make_unique<LatencyMeter>(this);
+#if OE_REALTIME_CHECKS
+	realtimeSafetyMonitor = std::make_unique<RealtimeSafetyMonitor>(this);
+#endif
+	parameterChangeQueue = std::make_unique<ParameterChangeQueue>();
 
 	addBooleanParameter(Parameter::STREAM_SCOPE,
         "enable_stream",
@@ -410,6 +417,76 @@ void GenericProcessor::setParameter(int parameterIndex, float newValue)
 }
 
 
+void GenericProcessor::queueParameterChange(Parameter* param, PreparedParameterState* state, int64 sampleNumber)
+{
+	ParameterChange change;
+
+	change.parameter = param;
+	change.sampleNumber = sampleNumber;
+	change.state = state;
+
+	if (param != nullptr)
+	{
+		change.streamId = param->getStreamId();
+
+		var value = param->getValue();
+
+		if (value.isInt() || value.isInt64() || value.isDouble() || value.isBool())
+			change.value = (double) value;
+	}
+
+	if (!parameterQueueEnabled)
+	{
+		applyParameterChange(change);
+		delete change.state;
+		return;
+	}
+
+	if (!parameterChangeQueue->push(change))
+	{
+		LOGE(getName(), " (", getNodeId(), "): parameter change queue is full, dropping change");
+		delete change.state;
+	}
+}
+
+void GenericProcessor::setParameterQueueEnabled(bool enabled)
+{
+	parameterQueueEnabled = enabled;
+
+	if (!enabled)
+	{
+		// the audio callbacks have stopped, so it's safe to apply everything here
+		while (ParameterChange* change = parameterChangeQueue->peek())
+		{
+			applyParameterChange(*change);
+			parameterChangeQueue->retire(change->state);
+			parameterChangeQueue->pop();
+		}
+
+		parameterChangeQueue->collectGarbage();
+	}
+}
+
+void GenericProcessor::applyQueuedParameterChanges()
+{
+	while (ParameterChange* change = parameterChangeQueue->peek())
+	{
+		if (change->sampleNumber >= 0)
+		{
+			auto it = startSamplesForBlock.find(change->streamId);
+
+			// not due yet; later changes wait too, so that the order is preserved
+			if (it != startSamplesForBlock.end() && it->second < change->sampleNumber)
+				break;
+		}
+
+		applyParameterChange(*change);
+
+		parameterChangeQueue->retire(change->state);
+		parameterChangeQueue->pop();
+	}
+}
+
 int GenericProcessor::getNextChannel(bool increment)
 {
 	int chan = nextAvailableChannel;
@@ -546,6 +623,7 @@ void GenericProcessor::clearSettings()
     startSamplesForBlock.clear();
 	numSamplesInBlock.clear();
 	processStartTimes.clear();
+	sampleNumberGapsForBlock.clear();
 
 }
 
@@ -1156,6 +1234,18 @@ uint32 GenericProcessor::getNumSamplesInBlock(uint16 streamId) const
 	return numSamplesInBlock.at(streamId);
 }
 
+uint32 GenericProcessor::getMaxSamplesInBlock(uint16 streamId) const
+{
+    return ProcessorGraph::getMaxSamplesForStream(getDataStream(streamId)->getSampleRate(),
+                                                  AudioProcessor::getSampleRate(),
+                                                  getBlockSize());
+}
+
+StreamBuffer GenericProcessor::getStreamBuffer(AudioBuffer<float>& continuousBuffer, uint16 streamId) const
+{
+    return StreamBuffer(continuousBuffer, getDataStream(streamId), int(getNumSamplesInBlock(streamId)));
+}
+
 int64 GenericProcessor::getFirstSampleNumberForBlock(uint16 streamId) const
 {
 	return startSamplesForBlock.at(streamId);
@@ -1166,11 +1256,17 @@ double GenericProcessor::getFirstTimestampForBlock(uint16 streamId) const
     return startTimestampsForBlock.at(streamId);
 }
 
+const SampleNumberGapTable& GenericProcessor::getSampleNumberGapsForBlock(uint16 streamId) const
+{
+    return sampleNumberGapsForBlock.at(streamId);
+}
+
 
 void GenericProcessor::setTimestampAndSamples(int64 sampleNumber,
                                               double timestamp,
                                               uint32 nSamples,
-                                              uint16 streamId)
+                                              uint16 streamId,
+                                              const SampleNumberGapTable* gaps)
 {
     
 	HeapBlock<char> data;
@@ -1180,7 +1276,8 @@ void GenericProcessor::setTimestampAndSamples(int64 sampleNumber,
         sampleNumber,
         timestamp,
 		nSamples,
-		m_initialProcessTime);
+		m_initialProcessTime,
+		gaps);
 
     
 
@@ -1191,6 +1288,11 @@ void GenericProcessor::setTimestampAndSamples(int64 sampleNumber,
     startSamplesForBlock[streamId] = sampleNumber;
 	processStartTimes[streamId] = m_initialProcessTime;
 
+	if (gaps != nullptr)
+		sampleNumberGapsForBlock[streamId] = *gaps;
+	else
+		sampleNumberGapsForBlock[streamId].clear();
+
 }
 
 int GenericProcessor::getGlobalChannelIndex(uint16 streamId, int localIndex) const
@@ -1236,6 +1338,8 @@ int GenericProcessor::processEventBuffer()
                 startTimestampsForBlock[sourceStreamId] = startTimestamp;
                 numSamplesInBlock[sourceStreamId] = nSamples;
 				processStartTimes[sourceStreamId] = initialTicks;
+
+				SystemEvent::getSampleNumberGaps(dataptr, meta.numBytes, sampleNumberGapsForBlock[sourceStreamId]);
 					
 			}
             else if (static_cast<Event::Type> (*dataptr) == Event::Type::PROCESSOR_EVENT
@@ -1344,6 +1448,103 @@ void GenericProcessor::addEvent(const Event* event, int sampleNum)
     
 }
 
+/** Appends an event in MidiBuffer's layout (time, size, data) */
+static void appendBufferEvent(Array<uint8>& data, int samplePosition, const uint8* bytes, int numBytes)
+{
+	uint8 header[sizeof(int32) + sizeof(uint16)];
+
+	writeUnaligned<int32>(header, samplePosition);
+	writeUnaligned<uint16>(header + sizeof(int32), static_cast<uint16>(numBytes));
+
+	data.addArray(static_cast<const uint8*>(header), int(sizeof(header)));
+	data.addArray(bytes, numBytes);
+}
+
+void GenericProcessor::addTTLEvents(const EventChannel* channel, const TTLEventBatch& batch)
+{
+	if (channel == nullptr || batch.size() == 0)
+		return;
+
+	const uint16 streamId = channel->getStreamId();
+	const int64 firstSampleNumber = getFirstSampleNumberForBlock(streamId);
+
+	// the packets below have no room for metadata, so those channels take the slow path
+	if (channel->getTotalEventMetadataSize() != 0)
+	{
+		for (int i = 0; i < batch.size(); i++)
+		{
+			const TTLEventBatch::Entry& entry = batch[i];
+
+			TTLEventPtr event = TTLEvent::createTTLEvent(channel,
+				firstSampleNumber + entry.sampleIndex,
+				entry.line,
+				entry.state,
+				entry.word);
+
+			addEvent(event, entry.sampleIndex);
+		}
+
+		return;
+	}
+
+	const int packetSize = int(EVENT_BASE_SIZE + channel->getDataSize());
+
+	uint8 packet[EVENT_BASE_SIZE + 64];
+
+	Array<uint8>& merged = ttlMergeBuffer.data;
+
+	merged.clearQuick();
+	merged.ensureStorageAllocated(m_currentMidiBuffer->data.size()
+		+ batch.size() * (int(sizeof(int32) + sizeof(uint16)) + packetSize));
+
+	auto existing = m_currentMidiBuffer->cbegin();
+	const auto end = m_currentMidiBuffer->cend();
+
+	uint64 changedLines = 0;
+	uint64 lineStates = 0;
+
+	for (int i = 0; i < batch.size(); i++)
+	{
+		const TTLEventBatch::Entry& entry = batch[i];
+		const int samplePosition = jmax(0, entry.sampleIndex);
+
+		// events already in the buffer go first, as they would with addEvent()
+		for (; existing != end && (*existing).samplePosition <= samplePosition; ++existing)
+			appendBufferEvent(merged, (*existing).samplePosition, (*existing).data, (*existing).numBytes);
+
+		const size_t size = TTLEvent::serializeTTLEvent(channel,
+			firstSampleNumber + entry.sampleIndex,
+			entry.line,
+			entry.state,
+			entry.word,
+			packet,
+			sizeof(packet));
+
+		if (size > 0)
+			appendBufferEvent(merged, samplePosition, packet, int(size));
+
+		if (entry.line < 64)
+		{
+			const uint64 bit = uint64(1) << entry.line;
+
+			changedLines |= bit;
+			lineStates = entry.state ? (lineStates | bit) : (lineStates & ~bit);
+		}
+	}
+
+	for (; existing != end; ++existing)
+		appendBufferEvent(merged, (*existing).samplePosition, (*existing).data, (*existing).numBytes);
+
+	m_currentMidiBuffer->swapWith(ttlMergeBuffer);
+
+	// the editor only needs the final state of each line
+	for (int line = 0; changedLines != 0; line++, changedLines >>= 1)
+	{
+		if (changedLines & 1)
+			getEditor()->setTTLState(streamId, line, (lineStates >> line) & 1);
+	}
+}
+
 void GenericProcessor::addTTLChannel(String name)
 {
     if (dataStreams.size() == 0)
@@ -1444,7 +1645,15 @@ void GenericProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& even
     
 	processEventBuffer(); // extract buffer sizes and timestamps,
 
+	applyQueuedParameterChanges();
+
+#if OE_REALTIME_CHECKS
+	realtimeSafetyMonitor->beginBlock();
 	process(buffer);
+	realtimeSafetyMonitor->endBlock();
+#else
+	process(buffer);
+#endif
     
 	latencyMeter->setLatestLatency(processStartTimes);
 }
@@ -1970,6 +2179,8 @@ int GenericProcessor::getNumDataStreams() const { return dataStreams.size(); }
 
 GenericEditor* GenericProcessor::getEditor() const { return editor.get(); }
 
+RealtimeSafetyMonitor* GenericProcessor::getRealtimeSafetyMonitor() const { return realtimeSafetyMonitor.get(); }
+
 AudioBuffer<float>* GenericProcessor::getContinuousBuffer() const { return 0; }
 MidiBuffer* GenericProcessor::getEventBuffer() const             { return 0; }
 
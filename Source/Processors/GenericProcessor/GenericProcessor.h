@@ -27,6 +27,7 @@
 #include <JuceHeader.h>
 
 #include "GenericProcessorBase.h"
+#include "ParameterChangeQueue.h"
 
 #include "../Parameter/Parameter.h"
 #include "../../CoreServices.h"
@@ -38,6 +39,7 @@
 #include "../Settings/EventChannel.h"
 #include "../Settings/SpikeChannel.h"
 #include "../Settings/DataStream.h"
+#include "StreamBuffer.h"
 #include "../Settings/InfoObject.h"
 
 #include "../Events/Event.h"
@@ -64,6 +66,7 @@ class DeviceInfo;
 class Spike;
 
 class LatencyMeter;
+class RealtimeSafetyMonitor;
 
 using namespace Plugin;
 
@@ -109,6 +112,10 @@ public:
         streams. Rather than use the default JUCE processBlock() method, processBlock()
         automatically calls process() in order to add the 'nSamples' variable to indicate
         the number of samples in the current buffer.
+
+        The buffer holds the channels of all streams, and its length is set by the audio
+        callback, so continuousBuffer.getNumSamples() must not be used to loop over them.
+        Use getStreamBuffer() to address one stream's channels and valid samples.
     */
     virtual void process (AudioBuffer<float>& continuousBuffer) = 0;
 
@@ -228,6 +235,14 @@ public:
     /** Returns true if a processor is a record node, false otherwise. */
     bool isRecordNode() const;
 
+    /** Returns true if process() never writes to the continuous channels it receives.
+
+        The processor graph can then hand such a processor the same buffers as the
+        processors that follow it, instead of copying the data for each of them.
+        Only override this if the channels are strictly read-only.
+    */
+    virtual bool isPassThrough() const { return false; }
+
     /** Returns true if a processor is able to send its output to a given processor.
 
         Ideally, this should always return true, but there may be special cases
@@ -352,6 +367,27 @@ public:
     /** Called when a parameter value is updated, to allow plugin-specific responses*/
     virtual void parameterValueChanged(Parameter*) { }
 
+    /** Queues a change that affects process(), usually from inside parameterValueChanged().
+
+        While acquisition is active, the change is applied on the audio thread at the start
+        of the first block that begins at or after sampleNumber (or at the start of the next
+        block if sampleNumber is negative), by calling applyParameterChange(). Anything costly
+        (e.g. designing filters) should be done beforehand and passed as 'state', which is
+        deleted on the message thread once it's no longer needed.
+
+        While acquisition is inactive, the change is applied immediately.
+    */
+    void queueParameterChange(Parameter* param, PreparedParameterState* state = nullptr, int64 sampleNumber = -1);
+
+    /** Called for each queued parameter change, at the start of a block (on the audio thread
+        while acquisition is active). Swap in the prepared state here and leave whatever it
+        replaces in change.state. Must not allocate, free, or block.*/
+    virtual void applyParameterChange(ParameterChange& change) { }
+
+    /** Called by the ProcessorGraph before the audio callbacks start (true) and after they stop (false).
+        Disabling the queue applies any changes that are still pending. */
+    void setParameterQueueEnabled(bool enabled);
+
     // BUFFER ACCESS
 
     /** Returns a pointer to the processor's internal continuous buffer, if it exists. */
@@ -386,6 +422,13 @@ public:
     */
     virtual void initialize(bool signalChainIsLoading) { }
 
+    /** Returns true if initialize(true) can run on a background thread while other
+        processors are initializing, e.g. for sources that spend a long time probing
+        hardware. The message thread is blocked until initialization is complete, so
+        processors that touch their editor or need the message thread must return false.
+    */
+    virtual bool canInitializeConcurrently() const { return false; }
+
     /** Method for updating settings, called by ProcessorGraph.*/
     void update();
 
@@ -491,6 +534,9 @@ public:
     /** Sets whether processor will have behaviour like Source, Sink, Splitter, Utility or Merge */
     void setProcessorType (Plugin::Processor::Type processorType);
 
+    /** Returns the object that counts real-time violations inside process() */
+    RealtimeSafetyMonitor* getRealtimeSafetyMonitor() const;
+
 protected:
 
     // --------------------------------------------
@@ -500,17 +546,36 @@ protected:
     /** Used to get the number of samples available in a current block, for a given stream */
     uint32 getNumSamplesInBlock(uint16 streamId) const;
 
+    /** Returns the number of samples of a stream that the graph carries between processors.
+
+        The buffer passed to process() is as long as the audio callback's block, but for
+        slower streams the graph only clears and copies this many samples per channel, so
+        samples beyond it do not reach downstream processors.
+        Sources use this as the upper limit on the number of samples they add per block.
+    */
+    uint32 getMaxSamplesInBlock(uint16 streamId) const;
+
+    /** Returns a view of one stream's channels in the continuous buffer, limited to
+        getNumSamplesInBlock(streamId) samples. Does not allocate. */
+    StreamBuffer getStreamBuffer(AudioBuffer<float>& continuousBuffer, uint16 streamId) const;
+
     /** Used to get the current sample number for a given stream */
     int64 getFirstSampleNumberForBlock(uint16 streamId) const;
     
     /** Used to get the current timestamp for a given stream.*/
     double getFirstTimestampForBlock(uint16 streamId) const;
 
-	/** Used to set the timestamp for a given buffer, for a given DataStream. */
+    /** Returns the places in the current block of a stream where its sample numbers
+        do not increase by one (empty if the samples are contiguous) */
+    const SampleNumberGapTable& getSampleNumberGapsForBlock(uint16 streamId) const;
+
+	/** Used to set the timestamp for a given buffer, for a given DataStream.
+        Sources whose sample numbers can jump within a block pass the gaps in 'gaps'. */
 	void setTimestampAndSamples(int64 startSampleForBlock,
                                 double startTimestampForBlock,
                                 uint32 nSamples,
-                                uint16 streamId);
+                                uint16 streamId,
+                                const SampleNumberGapTable* gaps = nullptr);
     
     // --------------------------------------------
     //     CHANNEL INDEXING
@@ -549,6 +614,12 @@ protected:
     /** Add an event (usually a TTLEventPtr) to the processing buffer */
     void addEvent(const Event* event, int sampleNum);
 
+    /** Adds a batch of TTL events on one channel to the processing buffer. Unlike calling
+        addEvent() for each one, this creates no event objects and merges the whole batch
+        with the buffer in a single pass, so it suits channels with many changes per block.
+        Channels with event metadata fall back to addEvent() for each change. */
+    void addTTLEvents(const EventChannel* channel, const TTLEventBatch& batch);
+
     /** Sends a TEXT event to all other processors, via the MessageCenter, while acquisition is active.
         If recording is active, this message will be recorded */
     void broadcastMessage(String msg);
@@ -659,6 +730,9 @@ private:
     /** Map between stream IDs and buffer timestamps. */
     std::map<uint16, int64> startSamplesForBlock;
 
+    /** Map between stream IDs and sample number discontinuities within the buffer. */
+    std::map<uint16, SampleNumberGapTable> sampleNumberGapsForBlock;
+
     /** Map between stream IDs and start time of process callbacks. */
     std::map<uint16, int64> processStartTimes;
 
@@ -694,6 +768,9 @@ private:
 	MidiBuffer* m_currentMidiBuffer;
     MidiBuffer messageCenterBuffer;
 
+    /** Scratch buffer for addTTLEvents(), swapped with the processing buffer */
+    MidiBuffer ttlMergeBuffer;
+
     typedef std::unordered_map<uint16, 
         std::unordered_map<uint16, 
         std::unordered_map<uint16, 
@@ -719,6 +796,13 @@ private:
 
     Parameter* currentParameter;
 
+    /** Applies the queued parameter changes that are due in the current block */
+    void applyQueuedParameterChanges();
+
+    std::unique_ptr<ParameterChangeQueue> parameterChangeQueue;
+
+    std::atomic<bool> parameterQueueEnabled;
+
     EventChannel* ttlEventChannel;
     Array<bool> ttlLineStates;
 
@@ -726,6 +810,8 @@ private:
 
     std::unique_ptr<LatencyMeter> latencyMeter;
 
+    std::unique_ptr<RealtimeSafetyMonitor> realtimeSafetyMonitor;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GenericProcessor);
 };
 
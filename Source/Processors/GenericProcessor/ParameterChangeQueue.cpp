@@ -0,0 +1,126 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ParameterChangeQueue.h"
+
+ParameterChangeQueue::ParameterChangeQueue(int capacity)
+    : changeFifo(capacity),
+      changes(capacity),
+      // every queued change can retire at most one state, so this can never overflow
+      // as long as the message thread collects garbage before pushing
+      retiredFifo(capacity + 1),
+      retired(capacity + 1)
+{
+
+}
+
+
+ParameterChangeQueue::~ParameterChangeQueue()
+{
+    while (ParameterChange* change = peek())
+    {
+        delete change->state;
+        pop();
+    }
+
+    collectGarbage();
+}
+
+
+bool ParameterChangeQueue::push(const ParameterChange& change)
+{
+    collectGarbage();
+
+    int start1, size1, start2, size2;
+
+    changeFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+        return false;
+
+    changes[size1 > 0 ? start1 : start2] = change;
+
+    changeFifo.finishedWrite(1);
+
+    return true;
+}
+
+
+ParameterChange* ParameterChangeQueue::peek()
+{
+    int start1, size1, start2, size2;
+
+    changeFifo.prepareToRead(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+        return nullptr;
+
+    return &changes[size1 > 0 ? start1 : start2];
+}
+
+
+void ParameterChangeQueue::pop()
+{
+    changeFifo.finishedRead(1);
+}
+
+
+void ParameterChangeQueue::retire(PreparedParameterState* state)
+{
+    if (state == nullptr)
+        return;
+
+    int start1, size1, start2, size2;
+
+    retiredFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+    {
+        // cannot happen (see constructor), but never leak
+        jassertfalse;
+        delete state;
+        return;
+    }
+
+    retired[size1 > 0 ? start1 : start2] = state;
+
+    retiredFifo.finishedWrite(1);
+}
+
+
+void ParameterChangeQueue::collectGarbage()
+{
+    int start1, size1, start2, size2;
+
+    const int numReady = retiredFifo.getNumReady();
+
+    retiredFifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; i++)
+        delete retired[start1 + i];
+
+    for (int i = 0; i < size2; i++)
+        delete retired[start2 + i];
+
+    retiredFifo.finishedRead(size1 + size2);
+}
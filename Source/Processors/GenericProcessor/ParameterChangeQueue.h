@@ -0,0 +1,118 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __PARAMETERCHANGEQUEUE_H_5D2B8E41__
+#define __PARAMETERCHANGEQUEUE_H_5D2B8E41__
+
+#include <JuceHeader.h>
+#include "../PluginManager/OpenEphysPlugin.h"
+
+class Parameter;
+
+/**
+    Base class for anything a processor prepares on the message thread
+    (new filters, a new thresholder, a resized buffer...) so that it
+    can be swapped in on the audio thread when a parameter change is applied.
+*/
+class PLUGIN_API PreparedParameterState
+{
+public:
+
+    /** Destructor (always called off the audio thread) */
+    virtual ~PreparedParameterState() { }
+};
+
+/**
+    A parameter change waiting to be applied at the start of a processing block.
+*/
+struct PLUGIN_API ParameterChange
+{
+    /** The parameter that changed */
+    Parameter* parameter = nullptr;
+
+    /** The stream whose sample numbers are used for 'sampleNumber' */
+    uint16 streamId = 0;
+
+    /** The change is applied at the start of the first block that begins at or
+        after this sample number; -1 applies it at the start of the next block */
+    int64 sampleNumber = -1;
+
+    /** The parameter's value when the change was queued (numeric parameters only) */
+    double value = 0.0;
+
+    /** Optional state prepared off the audio thread. Whatever is left here
+        after the change is applied (e.g. the state it replaced) is deleted
+        on the message thread. */
+    PreparedParameterState* state = nullptr;
+};
+
+/**
+    Lock-free single-producer / single-consumer queue of parameter changes.
+
+    The message thread pushes changes, and the audio thread pops them at the
+    start of each block. States that are no longer needed are sent back
+    through a second queue, so that the audio thread never frees memory.
+
+    @see GenericProcessor::queueParameterChange
+*/
+class PLUGIN_API ParameterChangeQueue
+{
+public:
+
+    /** Constructor */
+    ParameterChangeQueue(int capacity = 256);
+
+    /** Destructor -- deletes any state that is still owned by the queue */
+    ~ParameterChangeQueue();
+
+    /** Adds a change (message thread). Returns false if the queue is full,
+        in which case the caller keeps ownership of the state. */
+    bool push(const ParameterChange& change);
+
+    /** Returns the oldest change without removing it, or nullptr if the queue is empty (audio thread) */
+    ParameterChange* peek();
+
+    /** Removes the oldest change (audio thread) */
+    void pop();
+
+    /** Hands a state back to the message thread for deletion (audio thread) */
+    void retire(PreparedParameterState* state);
+
+    /** Deletes all retired states (message thread) */
+    void collectGarbage();
+
+    /** Returns the number of changes waiting to be applied */
+    int getNumPending() const { return changeFifo.getNumReady(); }
+
+private:
+
+    AbstractFifo changeFifo;
+    HeapBlock<ParameterChange> changes;
+
+    AbstractFifo retiredFifo;
+    HeapBlock<PreparedParameterState*> retired;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterChangeQueue);
+};
+
+#endif  // __PARAMETERCHANGEQUEUE_H_5D2B8E41__
@@ -0,0 +1,428 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "RealtimeSafetyMonitor.h"
+#include "GenericProcessor.h"
+
+#include "../../Utils/Utils.h"
+
+#include <cstdlib>
+#include <new>
+
+#if OE_REALTIME_CHECKS && JUCE_LINUX
+#include <cerrno>
+#include <dlfcn.h>
+#include <pthread.h>
+#endif
+
+namespace
+{
+    /* The monitor of the processor whose process() method is running on this thread.
+       Initial-exec TLS keeps the lookup free of allocations, so it is safe to
+       read from inside the allocation hooks. */
+#if JUCE_LINUX || JUCE_MAC
+    __attribute__((tls_model("initial-exec")))
+#endif
+    thread_local RealtimeSafetyMonitor* currentMonitor = nullptr;
+}
+
+RealtimeSafetyMonitor::RealtimeSafetyMonitor(GenericProcessor* processor_)
+    : processor(processor_),
+      violationsAtBlockStart(0),
+      previousMonitor(nullptr)
+{
+    reset();
+}
+
+void RealtimeSafetyMonitor::reset()
+{
+    allocations = 0;
+    deallocations = 0;
+    lockAcquisitions = 0;
+    totalBlocks = 0;
+    violatingBlocks = 0;
+    maxViolationsPerBlock = 0;
+}
+
+void RealtimeSafetyMonitor::beginBlock()
+{
+    violationsAtBlockStart = allocations.load(std::memory_order_relaxed)
+                           + deallocations.load(std::memory_order_relaxed)
+                           + lockAcquisitions.load(std::memory_order_relaxed);
+
+    previousMonitor = currentMonitor;
+    currentMonitor = this;
+}
+
+void RealtimeSafetyMonitor::endBlock()
+{
+    currentMonitor = previousMonitor;
+
+    const uint64 violations = allocations.load(std::memory_order_relaxed)
+                            + deallocations.load(std::memory_order_relaxed)
+                            + lockAcquisitions.load(std::memory_order_relaxed)
+                            - violationsAtBlockStart;
+
+    totalBlocks.fetch_add(1, std::memory_order_relaxed);
+
+    if (violations > 0)
+    {
+        violatingBlocks.fetch_add(1, std::memory_order_relaxed);
+
+        if (violations > maxViolationsPerBlock.load(std::memory_order_relaxed))
+            maxViolationsPerBlock.store(violations, std::memory_order_relaxed);
+    }
+}
+
+bool RealtimeSafetyMonitor::hasViolations() const
+{
+    return violatingBlocks.load() > 0;
+}
+
+String RealtimeSafetyMonitor::getSummary() const
+{
+    String summary;
+
+    summary << "[" << processor->getNodeId() << "] " << processor->getName() << ": "
+            << String(allocations.load()) << " allocations, "
+            << String(deallocations.load()) << " frees, "
+            << String(lockAcquisitions.load()) << " lock acquisitions in "
+            << String(violatingBlocks.load()) << " of " << String(totalBlocks.load()) << " blocks"
+            << " (max " << String(maxViolationsPerBlock.load()) << " per block)";
+
+    return summary;
+}
+
+bool RealtimeSafetyMonitor::isAvailable()
+{
+#if OE_REALTIME_CHECKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void RealtimeSafetyMonitor::recordAllocation()
+{
+    if (RealtimeSafetyMonitor* monitor = currentMonitor)
+        monitor->allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RealtimeSafetyMonitor::recordDeallocation()
+{
+    if (RealtimeSafetyMonitor* monitor = currentMonitor)
+        monitor->deallocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RealtimeSafetyMonitor::recordLockAcquisition()
+{
+    if (RealtimeSafetyMonitor* monitor = currentMonitor)
+        monitor->lockAcquisitions.fetch_add(1, std::memory_order_relaxed);
+}
+
+String RealtimeSafetyMonitor::createReport(const Array<GenericProcessor*>& processors)
+{
+    StringArray lines;
+
+    for (auto processor : processors)
+    {
+        RealtimeSafetyMonitor* monitor = processor->getRealtimeSafetyMonitor();
+
+        if (monitor != nullptr && monitor->hasViolations())
+            lines.add(monitor->getSummary());
+    }
+
+    if (lines.size() == 0)
+        return String();
+
+    return "Real-time safety report (" + Time::getCurrentTime().toString(true, true) + ")\n"
+           + lines.joinIntoString("\n") + "\n";
+}
+
+void RealtimeSafetyMonitor::startAcquisition(const Array<GenericProcessor*>& processors)
+{
+    if (!isAvailable())
+        return;
+
+    for (auto processor : processors)
+    {
+        if (RealtimeSafetyMonitor* monitor = processor->getRealtimeSafetyMonitor())
+            monitor->reset();
+    }
+}
+
+void RealtimeSafetyMonitor::stopAcquisition(const Array<GenericProcessor*>& processors)
+{
+    if (!isAvailable())
+        return;
+
+    String report = createReport(processors);
+
+    File reportFile = CoreServices::getSavedStateDirectory().getChildFile("realtime_report.txt");
+
+    if (report.isEmpty())
+    {
+        LOGC("Real-time safety check: no violations detected.");
+        reportFile.replaceWithText("No real-time violations detected.\n");
+        return;
+    }
+
+    LOGC(report);
+    reportFile.replaceWithText(report);
+}
+
+/*
+    Allocation and locking hooks.
+
+    On Linux, malloc() and friends (including the aligned variants) are replaced
+    for the whole process (including plugins loaded with dlopen) and forward to
+    glibc's implementation. Mutex acquisitions are caught by interposing
+    pthread_mutex_lock() and pthread_mutex_trylock(), which also covers
+    juce::CriticalSection and std::mutex.
+
+    On other platforms, only the global operator new / delete can be replaced,
+    so direct calls to malloc() and all locking go unnoticed.
+*/
+
+#if OE_REALTIME_CHECKS
+
+#if JUCE_LINUX
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+
+    __attribute__((visibility("default"))) void* malloc(size_t size) __THROW
+    {
+        RealtimeSafetyMonitor::recordAllocation();
+        return __libc_malloc(size);
+    }
+
+    __attribute__((visibility("default"))) void* calloc(size_t count, size_t size) __THROW
+    {
+        RealtimeSafetyMonitor::recordAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    __attribute__((visibility("default"))) void* realloc(void* ptr, size_t size) __THROW
+    {
+        RealtimeSafetyMonitor::recordAllocation();
+        return __libc_realloc(ptr, size);
+    }
+
+    __attribute__((visibility("default"))) void* memalign(size_t alignment, size_t size) __THROW
+    {
+        RealtimeSafetyMonitor::recordAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    __attribute__((visibility("default"))) void* aligned_alloc(size_t alignment, size_t size) __THROW
+    {
+        RealtimeSafetyMonitor::recordAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    __attribute__((visibility("default"))) int posix_memalign(void** ptr, size_t alignment, size_t size) __THROW
+    {
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        RealtimeSafetyMonitor::recordAllocation();
+
+        void* result = __libc_memalign(alignment, size);
+
+        if (result == nullptr)
+            return ENOMEM;
+
+        *ptr = result;
+        return 0;
+    }
+
+    __attribute__((visibility("default"))) void free(void* ptr) __THROW
+    {
+        if (ptr != nullptr)
+            RealtimeSafetyMonitor::recordDeallocation();
+
+        __libc_free(ptr);
+    }
+
+    typedef int (*MutexLockFunction)(pthread_mutex_t*);
+
+    __attribute__((visibility("default"))) int pthread_mutex_lock(pthread_mutex_t* mutex) __THROW
+    {
+        static MutexLockFunction realMutexLock = nullptr;
+
+        if (realMutexLock == nullptr)
+            realMutexLock = (MutexLockFunction) dlsym(RTLD_NEXT, "pthread_mutex_lock");
+
+        RealtimeSafetyMonitor::recordLockAcquisition();
+
+        return realMutexLock(mutex);
+    }
+
+    __attribute__((visibility("default"))) int pthread_mutex_trylock(pthread_mutex_t* mutex) __THROW
+    {
+        static MutexLockFunction realMutexTryLock = nullptr;
+
+        if (realMutexTryLock == nullptr)
+            realMutexTryLock = (MutexLockFunction) dlsym(RTLD_NEXT, "pthread_mutex_trylock");
+
+        RealtimeSafetyMonitor::recordLockAcquisition();
+
+        return realMutexTryLock(mutex);
+    }
+}
+
+#else
+
+void* operator new(std::size_t size)
+{
+    RealtimeSafetyMonitor::recordAllocation();
+
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeSafetyMonitor::recordAllocation();
+
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeSafetyMonitor::recordDeallocation();
+
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
+
+/* Over-aligned allocations: MSVC has no aligned_alloc, and its aligned blocks
+   must be released with _aligned_free */
+static void* allocateAligned(std::size_t size, std::size_t alignment) noexcept
+{
+    if (size == 0)
+        size = 1;
+
+#if JUCE_MSVC
+    return _aligned_malloc(size, alignment);
+#else
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, jmax(alignment, sizeof(void*)), size) == 0 ? ptr : nullptr;
+#endif
+}
+
+static void freeAligned(void* ptr) noexcept
+{
+#if JUCE_MSVC
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    RealtimeSafetyMonitor::recordAllocation();
+
+    if (void* ptr = allocateAligned(size, static_cast<std::size_t>(alignment)))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    RealtimeSafetyMonitor::recordAllocation();
+
+    return allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeSafetyMonitor::recordDeallocation();
+
+    freeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr, alignment);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __REALTIMESAFETYMONITOR_H_3A0C71E2__
+#define __REALTIMESAFETYMONITOR_H_3A0C71E2__
+
+#include <JuceHeader.h>
+#include "../PluginManager/OpenEphysPlugin.h"
+
+#include <atomic>
+
+class GenericProcessor;
+
+/**
+    Counts real-time rule violations (heap allocations, heap frees and
+    mutex acquisitions) that happen while a GenericProcessor is inside
+    its process() method.
+
+    The counters are only incremented when the GUI is built with the
+    OE_REALTIME_CHECKS option enabled. In that case, the global allocation
+    and locking functions are interposed (see RealtimeSafetyMonitor.cpp)
+    and every hit on the audio thread is attributed to the processor
+    whose process() method is currently running.
+
+    Not everything is caught: on Linux, valloc(), pvalloc(), read-write
+    locks, spin locks and semaphores are not interposed; on other
+    platforms only operator new / delete (all forms) are, so direct calls
+    to malloc() and any locking are invisible there.
+
+    A summary of all violations is written to the console and to
+    realtime_report.txt whenever acquisition stops.
+
+    @see GenericProcessor, ProcessorGraph
+*/
+class PLUGIN_API RealtimeSafetyMonitor
+{
+public:
+
+    /** Constructor */
+    RealtimeSafetyMonitor(GenericProcessor* processor);
+
+    /** Called by GenericProcessor::processBlock() before process() */
+    void beginBlock();
+
+    /** Called by GenericProcessor::processBlock() after process() */
+    void endBlock();
+
+    /** Clears all counters (called at the start of acquisition) */
+    void reset();
+
+    /** Returns true if any violation has been recorded since the last reset */
+    bool hasViolations() const;
+
+    /** Returns a one-line summary of the recorded violations */
+    String getSummary() const;
+
+    /** Returns true if the GUI was built with the allocation / lock hooks */
+    static bool isAvailable();
+
+    /** Called by the allocation hooks */
+    static void recordAllocation();
+
+    /** Called by the deallocation hooks */
+    static void recordDeallocation();
+
+    /** Called by the lock hooks */
+    static void recordLockAcquisition();
+
+    /** Builds a report for a list of processors; returns an empty string if
+        none of them violated real-time rules */
+    static String createReport(const Array<GenericProcessor*>& processors);
+
+    /** Resets counters at acquisition start, and writes the report at acquisition stop */
+    static void startAcquisition(const Array<GenericProcessor*>& processors);
+    static void stopAcquisition(const Array<GenericProcessor*>& processors);
+
+private:
+
+    GenericProcessor* processor;
+
+    std::atomic<uint64> allocations;
+    std::atomic<uint64> deallocations;
+    std::atomic<uint64> lockAcquisitions;
+
+    std::atomic<uint64> totalBlocks;
+    std::atomic<uint64> violatingBlocks;
+    std::atomic<uint64> maxViolationsPerBlock;
+
+    uint64 violationsAtBlockStart;
+
+    RealtimeSafetyMonitor* previousMonitor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeSafetyMonitor);
+};
+
+#endif  // __REALTIMESAFETYMONITOR_H_3A0C71E2__
@@ -0,0 +1,94 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2022 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __STREAMBUFFER_H_A3F61C0B__
+#define __STREAMBUFFER_H_A3F61C0B__
+
+#include <JuceHeader.h>
+#include "../PluginManager/OpenEphysPlugin.h"
+#include "../Settings/DataStream.h"
+#include "../Settings/ContinuousChannel.h"
+
+/**
+    The channels of one DataStream within the continuous buffer passed to
+    GenericProcessor::process(), addressed by local channel index and limited
+    to the samples that the stream has in the current block.
+
+    The continuous buffer holds the channels of every stream, and its length
+    is set by the audio callback, so getNumSamples() on it says nothing about
+    a particular stream. A StreamBuffer only refers to the continuous buffer
+    (it never allocates), so it can be created on the audio thread:
+
+        for (auto stream : getDataStreams())
+        {
+            StreamBuffer data = getStreamBuffer(buffer, stream->getStreamId());
+
+            for (int ch = 0; ch < data.getNumChannels(); ch++)
+                FloatVectorOperations::multiply(data.getWritePointer(ch), gain, data.getNumSamples());
+        }
+
+    @see GenericProcessor::getStreamBuffer
+*/
+class PLUGIN_API StreamBuffer
+{
+public:
+
+    /** Constructor */
+    StreamBuffer(AudioBuffer<float>& buffer_, const DataStream* stream_, int numSamples_)
+        : buffer(buffer_), stream(stream_), numSamples(numSamples_) { }
+
+    /** Returns the number of continuous channels in the stream */
+    int getNumChannels() const { return stream->getChannelCount(); }
+
+    /** Returns the number of samples the stream has in the current block */
+    int getNumSamples() const { return numSamples; }
+
+    /** Returns the samples of a channel, given its index within the stream */
+    float* getWritePointer(int localChannel) const
+    {
+        jassert(isPositiveAndBelow(localChannel, getNumChannels()));
+        return buffer.getWritePointer(stream->getContinuousChannel(localChannel)->getGlobalIndex());
+    }
+
+    /** Returns the samples of a channel, given its index within the stream */
+    const float* getReadPointer(int localChannel) const
+    {
+        jassert(isPositiveAndBelow(localChannel, getNumChannels()));
+        return buffer.getReadPointer(stream->getContinuousChannel(localChannel)->getGlobalIndex());
+    }
+
+    /** Clears the stream's samples in the current block */
+    void clear() const
+    {
+        for (int ch = 0; ch < getNumChannels(); ch++)
+            FloatVectorOperations::clear(getWritePointer(ch), numSamples);
+    }
+
+private:
+
+    AudioBuffer<float>& buffer;
+    const DataStream* stream;
+    int numSamples;
+};
+
+#endif  // __STREAMBUFFER_H_A3F61C0B__
@@ -121,6 +121,10 @@ PluginManager::PluginManager()
         SetDllDirectory(installSharedPath.getFullPathName().toRawUTF8());
     }
 
+	manifestFile = File::getSpecialLocation(File::userApplicationDataDirectory)
+				  .getChildFile("Open Ephys")
+				  .getChildFile("plugin-manifest-api" + String(PLUGIN_API_VER) + ".xml");
+
 #elif __linux__
 	File installSharedPath = File::getSpecialLocation(File::userApplicationDataDirectory)
 							.getChildFile("open-ephys")
@@ -138,6 +142,10 @@ PluginManager::PluginManager()
         installSharedPath.createDirectory();
     }
 #endif
+
+#ifndef _WIN32
+	manifestFile = installSharedPath.getSiblingFile("plugin-manifest-api" + String(PLUGIN_API_VER) + ".xml");
+#endif
 }
 
 PluginManager::~PluginManager()
@@ -148,6 +156,11 @@ PluginManager::~PluginManager()
 void PluginManager::loadAllPlugins()
 {
     Array<File> paths;
+
+	int64 start = Time::getHighResolutionTicks();
+
+	loadManifest();
+	manifest.reset(); // only keep entries for the libraries found in this scan
     
 #ifdef __APPLE__
     paths.add(File::getSpecialLocation(File::currentApplicationFile).getChildFile("Contents/PlugIns"));
@@ -186,6 +199,19 @@ void PluginManager::loadAllPlugins()
             loadPlugins(pluginPath);
         }
     }
+
+	saveManifest();
+	cachedManifest.reset();
+
+	int numLoaded = 0;
+
+	for (auto& lib : libArray)
+		if (lib.handle)
+			numLoaded++;
+
+	LOGC("Found ", libArray.size(), " plugin libraries (", numLoaded, " opened, ",
+		 libArray.size() - numLoaded, " from manifest) in ",
+		 Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000, " ms");
 }
 
 void PluginManager::loadPlugins(const File &pluginPath) {
@@ -209,7 +235,12 @@ void PluginManager::loadPlugins(const File &pluginPath) {
 	{
 		LOGD("Loading Plugin: ", foundDLLs[i].getFileNameWithoutExtension(), "... ");
 		
-		int res = loadPlugin(foundDLLs[i].getFullPathName());
+		int res;
+
+		if (const XmlElement* cachedEntry = findCachedLibrary(foundDLLs[i]))
+			res = loadCachedPlugin(cachedEntry);
+		else
+			res = openPlugin(foundDLLs[i].getFullPathName());
 		
 		if (res < 0)
 		{
@@ -222,6 +253,19 @@ void PluginManager::loadPlugins(const File &pluginPath) {
 	}
 }
 
+/** Returns the file whose size and modification time identify a plugin
+    (on macOS, the binary inside the bundle) */
+static File getPluginBinary(const File& pluginFile)
+{
+#ifdef __APPLE__
+	File binary = pluginFile.getChildFile("Contents/MacOS").getChildFile(pluginFile.getFileNameWithoutExtension());
+
+	if (binary.existsAsFile())
+		return binary;
+#endif
+	return pluginFile;
+}
+
 /*
 	 Takes the user-specified plugin and begins
 	 dynamic loading process. We want to ensure that
@@ -230,10 +274,13 @@ void PluginManager::loadPlugins(const File &pluginPath) {
 	 and works inside the same POSIX thread as the GUI.
  */
 
-int PluginManager::loadPlugin(const String& pluginLoc) {
+static bool openLibrary(const String& pluginLoc,
+						decltype(LoadedLibInfo::handle)& handle,
+						Plugin::LibraryInfo& libInfo,
+						PluginInfoFunction& piFunction)
+{
 
 #ifdef _WIN32
-	HINSTANCE handle;
 	const wchar_t* processorLocLPCWSTR = pluginLoc.toWideCharPointer();
 	handle = LoadLibraryW(processorLocLPCWSTR);
 #elif defined(__APPLE__)
@@ -244,7 +291,7 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 															   true);
 															   
 	assert(bundleURL);
-	CF::CFBundleRef handle = CF::CFBundleCreate(CF::kCFAllocatorDefault, bundleURL);
+	handle = CF::CFBundleCreate(CF::kCFAllocatorDefault, bundleURL);
 	CF::CFRelease(bundleURL);
 	CF::CFRelease(processorLocCFString);
 #else
@@ -265,14 +312,13 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	processor stability and to ensure that it doesn't crash due
 	to memory mishaps.
 	*/
-	void *handle = 0;
 	handle = dlopen(processorLocCString,RTLD_GLOBAL|RTLD_NOW);
 #endif
 
 	if (!handle) {
 		ERROR_MSG("Failed to load plugin DLL.");
 		closeHandle(handle);
-		return -1;
+		return false;
 	}
 
 	LibraryInfoFunction infoFunction = 0;
@@ -289,20 +335,21 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	{
 		ERROR_MSG("Failed to load function 'getLibInfo'.");
 		closeHandle(handle);
-		return -1;
+		handle = 0;
+		return false;
 	}
 
-	Plugin::LibraryInfo libInfo;
 	infoFunction(&libInfo);
 
 	if (libInfo.apiVersion != PLUGIN_API_VER)
 	{
 		ERROR_MSG("Invalid Plugin API version");
 		closeHandle(handle);
-		return -1;
+		handle = 0;
+		return false;
 	}
 
-	PluginInfoFunction piFunction = 0;
+	piFunction = 0;
 #ifdef _WIN32
 	piFunction = (PluginInfoFunction)GetProcAddress(handle, "getPluginInfo");
 #elif defined(__APPLE__)
@@ -316,23 +363,64 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	{
         ERROR_MSG("Failed to load function 'getPluginInfo'.");
 		closeHandle(handle);
-		return -1;
+		handle = 0;
+		return false;
 	}
 
+	return true;
+}
+
+int PluginManager::loadPlugin(const String& pluginLoc) {
+
+	int numPlugins = openPlugin(pluginLoc);
+
+	// plugins installed at runtime are known to the next launch without a rescan
+	if (numPlugins >= 0)
+		saveManifest();
+
+	return numPlugins;
+}
+
+int PluginManager::openPlugin(const String& pluginLoc) {
+
+	decltype(LoadedLibInfo::handle) handle = 0;
+	Plugin::LibraryInfo libInfo;
+	PluginInfoFunction piFunction = 0;
+
+	if (!openLibrary(pluginLoc, handle, libInfo, piFunction))
+		return -1;
+
 	LoadedLibInfo lib{};
 	lib.apiVersion = libInfo.apiVersion;
 	lib.name = libInfo.name;
 	lib.libVersion = libInfo.libVersion;
 	lib.numPlugins = libInfo.numPlugins;
 	lib.handle = handle;
+	lib.path = pluginLoc;
 
 	libArray.add(lib);
 
+	File binary = getPluginBinary(File(pluginLoc));
+
+	XmlElement* entry = new XmlElement("LIBRARY");
+	entry->setAttribute("path", pluginLoc);
+	entry->setAttribute("size", String(binary.getSize()));
+	entry->setAttribute("modified", String(binary.getLastModificationTime().toMilliseconds()));
+	entry->setAttribute("name", String(lib.name));
+	entry->setAttribute("version", String(lib.libVersion));
+
+	int numPlugins = 0;
+
 	Plugin::PluginInfo pInfo;
 	for (int i = 0; i < lib.numPlugins; i++)
 	{
 		if (piFunction(i, &pInfo)) //if somehow there are fewer plugins than stated, stop adding
 			break;
+
+		XmlElement* pluginEntry = new XmlElement("PLUGIN");
+		pluginEntry->setAttribute("index", i);
+		pluginEntry->setAttribute("type", (int) pInfo.type);
+
 		switch (pInfo.type)
 		{
 		case Plugin::PROCESSOR:
@@ -343,8 +431,11 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 			info.name = pInfo.processor.name;
 			info.type = pInfo.processor.type;
 			info.libIndex = libArray.size()-1;
+			info.pluginIndex = i;
 			processorPlugins.add(info);
 
+			pluginEntry->setAttribute("name", String(info.name));
+			pluginEntry->setAttribute("processorType", (int) info.type);
 			break;
 		}
 		case Plugin::RECORD_ENGINE:
@@ -354,8 +445,10 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 			info.creator = pInfo.recordEngine.creator;
 			info.name = pInfo.recordEngine.name;
 			info.libIndex = libArray.size() - 1;
+			info.pluginIndex = i;
 			recordEnginePlugins.add(info);
 			
+			pluginEntry->setAttribute("name", String(info.name));
 			break;
 		}
 		case Plugin::DATA_THREAD:
@@ -365,8 +458,10 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 			info.creator = pInfo.dataThread.creator;
 			info.name = pInfo.dataThread.name;
 			info.libIndex = libArray.size() - 1;
+			info.pluginIndex = i;
 			dataThreadPlugins.add(info);
 			
+			pluginEntry->setAttribute("name", String(info.name));
 			break;
 		}
 		case Plugin::FILE_SOURCE:
@@ -376,21 +471,292 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 			info.creator = pInfo.fileSource.creator;
 			info.name = pInfo.fileSource.name;
 			info.extensions = pInfo.fileSource.extensions;
-			info.libIndex = libArray.size();
+			info.libIndex = libArray.size() - 1;
+			info.pluginIndex = i;
 			fileSourcePlugins.add(info);
 			
+			pluginEntry->setAttribute("name", String(info.name));
+			pluginEntry->setAttribute("extensions", String(info.extensions));
 			break;
 		}
 		default:
 		{
 			std::cerr << pluginLoc << " invalid plugin type: " << pInfo.type << std::endl;
+			delete pluginEntry;
+			pluginEntry = nullptr;
+			break;
+		}
+		}
+
+		if (pluginEntry != nullptr)
+		{
+			entry->addChildElement(pluginEntry);
+			numPlugins++;
+		}
+	}
+
+	entry->setAttribute("numPlugins", numPlugins);
+
+	updateManifest(entry);
+
+	return lib.numPlugins;
+}
+
+int PluginManager::loadCachedPlugin(const XmlElement* entry)
+{
+	LoadedLibInfo lib{};
+	lib.apiVersion = PLUGIN_API_VER;
+	lib.name = storeName(entry->getStringAttribute("name"));
+	lib.libVersion = storeName(entry->getStringAttribute("version"));
+	lib.numPlugins = entry->getIntAttribute("numPlugins");
+	lib.handle = 0;
+	lib.path = entry->getStringAttribute("path");
+
+	libArray.add(lib);
+
+	const int libIndex = libArray.size() - 1;
+
+	for (auto* pluginEntry : entry->getChildWithTagNameIterator("PLUGIN"))
+	{
+		const char* name = storeName(pluginEntry->getStringAttribute("name"));
+		const int pluginIndex = pluginEntry->getIntAttribute("index");
+
+		switch (pluginEntry->getIntAttribute("type"))
+		{
+		case Plugin::PROCESSOR:
+		{
+			LoadedPluginInfo<Plugin::ProcessorInfo> info;
+			info.creator = nullptr;
+			info.name = name;
+			info.type = (Plugin::Processor::Type) pluginEntry->getIntAttribute("processorType");
+			info.libIndex = libIndex;
+			info.pluginIndex = pluginIndex;
+			processorPlugins.add(info);
+			break;
+		}
+		case Plugin::RECORD_ENGINE:
+		{
+			LoadedPluginInfo<Plugin::RecordEngineInfo> info;
+			info.creator = nullptr;
+			info.name = name;
+			info.libIndex = libIndex;
+			info.pluginIndex = pluginIndex;
+			recordEnginePlugins.add(info);
 			break;
 		}
+		case Plugin::DATA_THREAD:
+		{
+			LoadedPluginInfo<Plugin::DataThreadInfo> info;
+			info.creator = nullptr;
+			info.name = name;
+			info.libIndex = libIndex;
+			info.pluginIndex = pluginIndex;
+			dataThreadPlugins.add(info);
+			break;
+		}
+		case Plugin::FILE_SOURCE:
+		{
+			LoadedPluginInfo<Plugin::FileSourceInfo> info;
+			info.creator = nullptr;
+			info.name = name;
+			info.extensions = storeName(pluginEntry->getStringAttribute("extensions"));
+			info.libIndex = libIndex;
+			info.pluginIndex = pluginIndex;
+			fileSourcePlugins.add(info);
+			break;
+		}
+		default:
+			break;
 		}
 	}
+
+	updateManifest(new XmlElement(*entry));
+
 	return lib.numPlugins;
 }
 
+bool PluginManager::loadLibrary(int libIndex)
+{
+	if (libIndex < 0 || libIndex >= libArray.size())
+		return false;
+
+	LoadedLibInfo& lib = libArray.getReference(libIndex);
+
+	if (lib.handle)
+		return true;
+
+	LOGC("Loading plugin library ", lib.path);
+
+	decltype(LoadedLibInfo::handle) handle = 0;
+	Plugin::LibraryInfo libInfo;
+	PluginInfoFunction piFunction = 0;
+
+	if (!openLibrary(lib.path, handle, libInfo, piFunction))
+	{
+		LOGE("Failed to load ", lib.path, "; it will be checked again at the next launch");
+
+		// the library changed since it was cached
+		if (manifest != nullptr)
+		{
+			if (auto* entry = manifest->getChildByAttribute("path", lib.path))
+			{
+				manifest->removeChildElement(entry, true);
+				saveManifest();
+			}
+		}
+
+		return false;
+	}
+
+	lib.handle = handle;
+
+	Plugin::PluginInfo pInfo;
+	for (int i = 0; i < libInfo.numPlugins; i++)
+	{
+		if (piFunction(i, &pInfo))
+			break;
+
+		switch (pInfo.type)
+		{
+		case Plugin::PROCESSOR:
+			for (auto& info : processorPlugins)
+				if (info.libIndex == libIndex && info.pluginIndex == i)
+					info.creator = pInfo.processor.creator;
+			break;
+		case Plugin::RECORD_ENGINE:
+			for (auto& info : recordEnginePlugins)
+				if (info.libIndex == libIndex && info.pluginIndex == i)
+					info.creator = pInfo.recordEngine.creator;
+			break;
+		case Plugin::DATA_THREAD:
+			for (auto& info : dataThreadPlugins)
+				if (info.libIndex == libIndex && info.pluginIndex == i)
+					info.creator = pInfo.dataThread.creator;
+			break;
+		case Plugin::FILE_SOURCE:
+			for (auto& info : fileSourcePlugins)
+				if (info.libIndex == libIndex && info.pluginIndex == i)
+					info.creator = pInfo.fileSource.creator;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return true;
+}
+
+ProcessorCreator PluginManager::getProcessorCreator(int index)
+{
+	if (index < 0 || index >= processorPlugins.size())
+		return nullptr;
+
+	if (processorPlugins[index].creator == nullptr)
+		loadLibrary(processorPlugins[index].libIndex);
+
+	return processorPlugins[index].creator;
+}
+
+DataThreadCreator PluginManager::getDataThreadCreator(int index)
+{
+	if (index < 0 || index >= dataThreadPlugins.size())
+		return nullptr;
+
+	if (dataThreadPlugins[index].creator == nullptr)
+		loadLibrary(dataThreadPlugins[index].libIndex);
+
+	return dataThreadPlugins[index].creator;
+}
+
+EngineManagerCreator PluginManager::getRecordEngineCreator(int index)
+{
+	if (index < 0 || index >= recordEnginePlugins.size())
+		return nullptr;
+
+	if (recordEnginePlugins[index].creator == nullptr)
+		loadLibrary(recordEnginePlugins[index].libIndex);
+
+	return recordEnginePlugins[index].creator;
+}
+
+FileSourceCreator PluginManager::getFileSourceCreator(int index)
+{
+	if (index < 0 || index >= fileSourcePlugins.size())
+		return nullptr;
+
+	if (fileSourcePlugins[index].creator == nullptr)
+		loadLibrary(fileSourcePlugins[index].libIndex);
+
+	return fileSourcePlugins[index].creator;
+}
+
+const XmlElement* PluginManager::findCachedLibrary(const File& pluginFile) const
+{
+	if (cachedManifest == nullptr)
+		return nullptr;
+
+	const XmlElement* entry = cachedManifest->getChildByAttribute("path", pluginFile.getFullPathName());
+
+	if (entry == nullptr)
+		return nullptr;
+
+	File binary = getPluginBinary(pluginFile);
+
+	if (entry->getStringAttribute("size") != String(binary.getSize())
+		|| entry->getStringAttribute("modified") != String(binary.getLastModificationTime().toMilliseconds()))
+		return nullptr;
+
+	return entry;
+}
+
+void PluginManager::updateManifest(XmlElement* entry)
+{
+	if (manifest == nullptr)
+	{
+		manifest = std::make_unique<XmlElement>("PLUGINMANIFEST");
+		manifest->setAttribute("apiVersion", PLUGIN_API_VER);
+	}
+
+	if (auto* existing = manifest->getChildByAttribute("path", entry->getStringAttribute("path")))
+		manifest->replaceChildElement(existing, entry);
+	else
+		manifest->addChildElement(entry);
+}
+
+void PluginManager::loadManifest()
+{
+	cachedManifest.reset();
+
+	if (!manifestFile.existsAsFile())
+		return;
+
+	cachedManifest = XmlDocument::parse(manifestFile);
+
+	if (cachedManifest != nullptr
+		&& (!cachedManifest->hasTagName("PLUGINMANIFEST")
+			|| cachedManifest->getIntAttribute("apiVersion") != PLUGIN_API_VER))
+	{
+		cachedManifest.reset();
+	}
+}
+
+void PluginManager::saveManifest()
+{
+	if (manifest == nullptr)
+		return;
+
+	manifestFile.getParentDirectory().createDirectory();
+
+	if (!manifest->writeTo(manifestFile))
+		LOGE("Could not write plugin manifest to ", manifestFile.getFullPathName());
+}
+
+const char* PluginManager::storeName(const String& name)
+{
+	cachedNames.add(name);
+	return cachedNames.getReference(cachedNames.size() - 1).toRawUTF8();
+}
+
 int PluginManager::getNumProcessors() const
 {
 	return processorPlugins.size();
@@ -575,101 +941,17 @@ bool PluginManager::removePlugin(String libName)
 
 	LoadedLibInfo lib = libArray[indexToRemove];
 
-	PluginInfoFunction piFunction = 0;
-#ifdef _WIN32
-	piFunction = (PluginInfoFunction)GetProcAddress(lib.handle, "getPluginInfo");
-#elif defined(__APPLE__)
-    piFunction = (PluginInfoFunction)CFBundleGetFunctionPointerForName(lib.handle, CFSTR("getPluginInfo"));
-#else
-    dlerror();
-	piFunction = (PluginInfoFunction)(dlsym(lib.handle, "getPluginInfo"));
-#endif
-
-	if (!piFunction)
-	{
-        ERROR_MSG("Failed to load function 'getPluginInfo'");
-		closeHandle(lib.handle);
-		return -1;
-	}
+	removePluginsFromLibrary(processorPlugins, indexToRemove);
+	removePluginsFromLibrary(recordEnginePlugins, indexToRemove);
+	removePluginsFromLibrary(dataThreadPlugins, indexToRemove);
+	removePluginsFromLibrary(fileSourcePlugins, indexToRemove);
 
-	Plugin::PluginInfo pInfo;
-	for (int i = 0; i < lib.numPlugins; i++)
+	if (manifest != nullptr)
 	{
-		if (piFunction(i, &pInfo)) //if somehow there are fewer plugins than stated, stop removing
-			break;
-
-		int pluginIndex = -1;
-		switch (pInfo.type)
+		if (auto* entry = manifest->getChildByAttribute("path", lib.path))
 		{
-			case Plugin::PROCESSOR:
-			{
-				LOGD("Removing processor plugin: ", pInfo.processor.name);
-				for(int j = 0; j < processorPlugins.size(); j++)
-				{
-					if(processorPlugins[j].name == pInfo.processor.name)
-						pluginIndex = j;
-					
-					if (processorPlugins[j].libIndex > indexToRemove)
-						processorPlugins[j].setLibIndex(processorPlugins[j].libIndex - 1);
-				}
-				if(pluginIndex != -1)
-					processorPlugins.remove(pluginIndex);
-
-				break;
-			}
-			case Plugin::RECORD_ENGINE:
-			{
-				LOGD("Removing record engine plugin: ", pInfo.recordEngine.name);
-				for(int j = 0; j < recordEnginePlugins.size(); j++)
-				{
-					if(recordEnginePlugins[j].name == pInfo.recordEngine.name)
-						pluginIndex = j;
-					
-					if (recordEnginePlugins[j].libIndex > indexToRemove)
-						recordEnginePlugins[j].setLibIndex(recordEnginePlugins[j].libIndex - 1);
-				}
-				if(pluginIndex != -1)
-					recordEnginePlugins.remove(pluginIndex);
-
-				break;
-			}
-			case Plugin::DATA_THREAD:
-			{
-				LOGD("Removing data thread plugin: ", pInfo.dataThread.name);
-				for(int j = 0; j < dataThreadPlugins.size(); j++)
-				{
-					if(dataThreadPlugins[j].name == pInfo.dataThread.name)
-						pluginIndex = j;
-					
-					if (dataThreadPlugins[j].libIndex > indexToRemove)
-						dataThreadPlugins[j].setLibIndex(dataThreadPlugins[j].libIndex - 1);
-				}
-				if(pluginIndex != -1)
-					dataThreadPlugins.remove(pluginIndex);
-
-				break;
-			}
-			case Plugin::FILE_SOURCE:
-			{
-				LOGD("Removing file source plugin: ", pInfo.fileSource.name);
-				for(int j = 0; j < fileSourcePlugins.size(); j++)
-				{
-					if(fileSourcePlugins[j].name == pInfo.fileSource.name)
-						pluginIndex = j;
-					
-					if (fileSourcePlugins[j].libIndex > indexToRemove)
-						fileSourcePlugins[j].setLibIndex(fileSourcePlugins[j].libIndex - 1);
-				}
-				if(pluginIndex != -1)
-					fileSourcePlugins.remove(pluginIndex);
-
-				break;
-			}
-			default:
-			{
-				LOGE("Invalid plugin");
-				break;
-			}
+			manifest->removeChildElement(entry, true);
+			saveManifest();
 		}
 	}
 
@@ -678,6 +960,23 @@ bool PluginManager::removePlugin(String libName)
 	return true;
 }
 
+template<class T>
+void PluginManager::removePluginsFromLibrary(Array<LoadedPluginInfo<T>>& pluginArray, int libIndex)
+{
+	for (int j = pluginArray.size() - 1; j >= 0; j--)
+	{
+		if (pluginArray[j].libIndex == libIndex)
+		{
+			LOGD("Removing plugin: ", pluginArray[j].name);
+			pluginArray.remove(j);
+		}
+		else if (pluginArray[j].libIndex > libIndex)
+		{
+			pluginArray.getReference(j).setLibIndex(pluginArray[j].libIndex - 1);
+		}
+	}
+}
+
 #if 0
 PluginManager::Plugin::Plugin() {
 }
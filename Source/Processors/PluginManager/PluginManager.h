@@ -49,12 +49,14 @@ struct LoadedLibInfo : public Plugin::LibraryInfo
 #else
 	void* handle;
 #endif
+	String path; // the handle is null until the library is actually loaded
 };
 
 template<class T>
 struct LoadedPluginInfo : public T
 {
 	int libIndex;
+	int pluginIndex; // index passed to the library's getPluginInfo()
 
 	// Setter function to modify the libIndex
 	void setLibIndex(int index)
@@ -70,6 +72,11 @@ class GenericProcessor;
 * 
 	Retrieves information about available plugins
 
+	The names and types of the plugins in each library are kept in a manifest
+	(keyed by the library's path, size and modification time), so libraries
+	that haven't changed are not opened at startup. A library is only loaded
+	when one of its creator functions is first requested.
+
  */
 class PluginManager {
 
@@ -90,6 +97,18 @@ public:
 	/** Loads a plugin at a particular path*/
 	int loadPlugin(const String&);
 
+	/** Returns the creator of a processor plugin, loading its library if needed (nullptr on failure) */
+	ProcessorCreator getProcessorCreator(int index);
+
+	/** Returns the creator of a data thread plugin, loading its library if needed (nullptr on failure) */
+	DataThreadCreator getDataThreadCreator(int index);
+
+	/** Returns the creator of a record engine plugin, loading its library if needed (nullptr on failure) */
+	EngineManagerCreator getRecordEngineCreator(int index);
+
+	/** Returns the creator of a file source plugin, loading its library if needed (nullptr on failure) */
+	FileSourceCreator getFileSourceCreator(int index);
+
 	/** Unloads a plugin (not implemented yet) */
 	//void unloadPlugin(Plugin *);
 
@@ -151,9 +170,42 @@ private:
 	Array<LoadedPluginInfo<Plugin::RecordEngineInfo>> recordEnginePlugins;
 	Array<LoadedPluginInfo<Plugin::FileSourceInfo>> fileSourcePlugins;
 
+	/** Manifest entries from the previous launch, and the ones found (or loaded) in this one */
+	std::unique_ptr<XmlElement> cachedManifest;
+	std::unique_ptr<XmlElement> manifest;
+	File manifestFile;
+
+	/** Storage for the names of plugins whose library hasn't been loaded */
+	StringArray cachedNames;
+
+	/** Loads a library and adds its entry to the manifest, without saving it */
+	int openPlugin(const String& pluginLoc);
+
+	/** Registers the plugins of a library from its manifest entry, without loading it */
+	int loadCachedPlugin(const XmlElement* entry);
+
+	/** Loads a library that was registered from the manifest, and fills in its creators */
+	bool loadLibrary(int libIndex);
+
+	/** Returns the manifest entry from the previous launch for an unchanged library, or nullptr */
+	const XmlElement* findCachedLibrary(const File& pluginFile) const;
+
+	/** Adds or replaces the manifest entry of a library */
+	void updateManifest(XmlElement* entry);
+
+	void loadManifest();
+	void saveManifest();
+
+	/** Returns a pointer to a copy of a string that lives as long as the PluginManager */
+	const char* storeName(const String& name);
+
 	template<class T>
 	bool findPlugin(String name, String libName, const Array<LoadedPluginInfo<T>>& pluginArray, T& pluginInfo) const;
 
+	/** Removes the plugins of a library, and shifts the library indices of the ones after it */
+	template<class T>
+	void removePluginsFromLibrary(Array<LoadedPluginInfo<T>>& pluginArray, int libIndex);
+
 	/* Making the info structures have a constructor complicates the DLL interface. 
 	It's easier to just add some static methods to create empty structures for when the calls fail*/
 	static Plugin::ProcessorInfo getEmptyProcessorInfo();
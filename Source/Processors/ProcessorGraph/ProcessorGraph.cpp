@@ -25,9 +25,11 @@
 #include <utility>
 #include <vector>
 #include <map>
+#include <thread>
 
 #include "ProcessorGraph.h"
 #include "../GenericProcessor/GenericProcessor.h"
+#include "../GenericProcessor/RealtimeSafetyMonitor.h"
 
 #include "../AudioNode/AudioNode.h"
 #include "../RecordNode/RecordNode.h"
@@ -44,12 +46,20 @@
 #include "../ProcessorManager/ProcessorManager.h"
 #include "../../Audio/AudioComponent.h"
 #include "../../AccessClass.h"
+#include "../../Utils/Utils.h"
+
+// Each stream gets room for this multiple of its nominal number of samples per block,
+// so that a source can catch up after a late callback
+#define STREAM_BLOCK_HEADROOM 2.0
+#define STREAM_BLOCK_MARGIN 16
 
 std::map< ChannelKey, bool> ProcessorGraph::bufferLookupMap;
 
 ProcessorGraph::ProcessorGraph() :
     currentNodeId(100),
-    isLoadingSignalChain(false)
+    isLoadingSignalChain(false),
+    settingsUpdateDeferrals(0),
+    settingsUpdater(this)
 {
 
     // The ProcessorGraph will always have 0 inputs (all content is generated within graph)
@@ -493,6 +503,26 @@ void ProcessorGraph::updateSettings(GenericProcessor* processor, bool signalChai
         return;
     }
 
+    if (!signalChainIsLoading)
+    {
+        if (!MessageManager::getInstance()->currentThreadHasLockedMessageManager())
+        {
+            // e.g. a processor initializing on a background thread without the message manager lock
+            requestSettingsUpdate(processor);
+            return;
+        }
+
+        {
+            const ScopedLock lock(dirtyProcessorsLock);
+            dirtyProcessors.addIfNotAlreadyThere(processor);
+        }
+
+        if (settingsUpdateDeferrals == 0)
+            flushSettingsUpdates();
+
+        return;
+    }
+
     getMessageCenter()->addSpecialProcessorChannels();
 
     GenericProcessor* processorToUpdate = processor;
@@ -505,12 +535,14 @@ void ProcessorGraph::updateSettings(GenericProcessor* processor, bool signalChai
         {
             processor->update();
 
-            if (signalChainIsLoading && processor->getSourceNode() != nullptr)
+            if (processor->getSourceNode() != nullptr)
             {
                 processor->loadFromXml();
                 processor->update();
             }
 
+            inputSignatures.set(processor->getNodeId(), getInputSignature(processor));
+
             if (processor->isSplitter())
             {
                 splitters.add((Splitter*) processor);
@@ -528,11 +560,270 @@ void ProcessorGraph::updateSettings(GenericProcessor* processor, bool signalChai
 
     updateViews(processorToUpdate, true);
 
-    if(!signalChainIsLoading)
+}
+
+void ProcessorGraph::requestSettingsUpdate(GenericProcessor* processor)
+{
+    {
+        const ScopedLock lock(dirtyProcessorsLock);
+        dirtyProcessors.addIfNotAlreadyThere(processor);
+    }
+
+    settingsUpdater.triggerAsyncUpdate();
+}
+
+void ProcessorGraph::handlePendingSettingsUpdates()
+{
+    if (settingsUpdateDeferrals == 0 && !isLoadingSignalChain)
+        flushSettingsUpdates();
+}
+
+void ProcessorGraph::deferSettingsUpdates(bool shouldDefer)
+{
+    if (shouldDefer)
     {
-        CoreServices::saveRecoveryConfig();
+        settingsUpdateDeferrals++;
+        return;
     }
 
+    if (settingsUpdateDeferrals == 0 || --settingsUpdateDeferrals > 0)
+        return;
+
+    flushSettingsUpdates();
+}
+
+void ProcessorGraph::flushSettingsUpdates()
+{
+    settingsUpdater.cancelPendingUpdate();
+
+    Array<GenericProcessor*> dirty;
+
+    {
+        const ScopedLock lock(dirtyProcessorsLock);
+        dirty.swapWith(dirtyProcessors);
+    }
+
+    if (dirty.size() == 0)
+        return;
+
+    int64 start = Time::getHighResolutionTicks();
+
+    dirty.removeAllInstancesOf(nullptr);
+
+    getMessageCenter()->addSpecialProcessorChannels();
+
+    // updating a processor reaches everything below it, so the walk only
+    // needs to start at dirty processors that aren't downstream of another one
+    Array<GenericProcessor*> startingProcessors;
+
+    for (auto processor : dirty)
+    {
+        bool coveredByAnotherProcessor = false;
+
+        for (auto other : dirty)
+        {
+            if (other != processor && isDownstreamOf(processor, other))
+            {
+                coveredByAnotherProcessor = true;
+                break;
+            }
+        }
+
+        if (!coveredByAnotherProcessor)
+            startingProcessors.add(processor);
+    }
+
+    Array<GenericProcessor*> updated;
+    int numSkipped = 0;
+
+    for (auto processor : getProcessorsInUpdateOrder(startingProcessors))
+    {
+        bool needsUpdate = dirty.contains(processor);
+
+        if (!needsUpdate)
+        {
+            for (auto source : getSourcesOf(processor))
+            {
+                if (updated.contains(source))
+                {
+                    needsUpdate = true;
+                    break;
+                }
+            }
+
+            // Splitters keep pointers to their source's streams, so they always follow it;
+            // everything else can keep its settings if its inputs look exactly the same
+            if (needsUpdate && !processor->isSplitter() && !processor->isMerger()
+                && inputSignatures.contains(processor->getNodeId())
+                && inputSignatures[processor->getNodeId()] == getInputSignature(processor))
+            {
+                needsUpdate = false;
+            }
+        }
+
+        if (needsUpdate)
+        {
+            processor->update();
+            inputSignatures.set(processor->getNodeId(), getInputSignature(processor));
+            updated.add(processor);
+        }
+        else
+        {
+            numSkipped++;
+        }
+    }
+
+    LOGD("Updated ", updated.size(), " processors (", numSkipped, " unchanged) in ", msSince(start), " milliseconds");
+
+    updateViews(startingProcessors.size() > 0 ? startingProcessors.getFirst() : nullptr, true);
+
+    CoreServices::saveRecoveryConfig();
+}
+
+Array<GenericProcessor*> ProcessorGraph::getSourcesOf(GenericProcessor* processor)
+{
+    Array<GenericProcessor*> sources;
+
+    if (processor->isMerger())
+    {
+        Merger* merger = (Merger*) processor;
+        sources.add(merger->getSourceNode(0));
+        sources.add(merger->getSourceNode(1));
+    }
+    else
+    {
+        sources.add(processor->getSourceNode());
+    }
+
+    sources.removeAllInstancesOf(nullptr);
+
+    return sources;
+}
+
+Array<GenericProcessor*> ProcessorGraph::getDestinationsOf(GenericProcessor* processor)
+{
+    Array<GenericProcessor*> destinations;
+
+    if (processor->isSplitter())
+    {
+        Splitter* splitter = (Splitter*) processor;
+        destinations.add(splitter->getDestNode(0));
+        destinations.add(splitter->getDestNode(1));
+    }
+    else
+    {
+        destinations.add(processor->getDestNode());
+    }
+
+    destinations.removeAllInstancesOf(nullptr);
+
+    return destinations;
+}
+
+Array<GenericProcessor*> ProcessorGraph::getProcessorsInUpdateOrder(const Array<GenericProcessor*>& startingProcessors)
+{
+    // collect everything downstream of the starting processors...
+    Array<GenericProcessor*> affected;
+    Array<GenericProcessor*> toVisit = startingProcessors;
+
+    while (toVisit.size() > 0)
+    {
+        GenericProcessor* processor = toVisit.removeAndReturn(0);
+
+        if (affected.contains(processor))
+            continue;
+
+        affected.add(processor);
+        toVisit.addArray(getDestinationsOf(processor));
+    }
+
+    // ...and order it so that each processor comes after all of its sources
+    // (a Merger fed by two updated branches is only updated once, after both)
+    Array<GenericProcessor*> ordered;
+
+    while (ordered.size() < affected.size())
+    {
+        bool addedProcessor = false;
+
+        for (auto processor : affected)
+        {
+            if (ordered.contains(processor))
+                continue;
+
+            bool sourcesAreReady = true;
+
+            for (auto source : getSourcesOf(processor))
+            {
+                if (affected.contains(source) && !ordered.contains(source))
+                {
+                    sourcesAreReady = false;
+                    break;
+                }
+            }
+
+            if (sourcesAreReady)
+            {
+                ordered.add(processor);
+                addedProcessor = true;
+            }
+        }
+
+        jassert(addedProcessor); // the signal chain should never contain a loop
+
+        if (!addedProcessor)
+            break;
+    }
+
+    return ordered;
+}
+
+int64 ProcessorGraph::getInputSignature(GenericProcessor* processor)
+{
+    String signature;
+
+    for (auto source : getSourcesOf(processor))
+    {
+        signature << source->getNodeId() << (source->isEnabled ? "+" : "-")
+                  << source->getTotalConfigurationObjects() << "|";
+
+        for (auto stream : source->getStreamsForDestNode(processor))
+        {
+            signature << stream->getStreamId() << ":" << stream->getName() << ":"
+                      << stream->getSampleRate() << ":" << stream->getChannelCount() << "|";
+
+            for (auto channel : stream->getContinuousChannels())
+                signature << channel->getName() << "," << channel->getBitVolts() << "," 
+                          << (int) channel->getChannelType() << ";";
+
+            for (auto channel : stream->getEventChannels())
+                signature << channel->getName() << "," << (int) channel->getType() << ","
+                          << channel->getMaxTTLBits() << ";";
+
+            for (auto channel : stream->getSpikeChannels())
+                signature << channel->getName() << "," << (int) channel->getChannelType() << ","
+                          << (int) channel->getPrePeakSamples() << "," << (int) channel->getPostPeakSamples() << ";";
+        }
+    }
+
+    return signature.hashCode64();
+}
+
+bool ProcessorGraph::isDownstreamOf(GenericProcessor* processor, GenericProcessor* upstream)
+{
+    Array<GenericProcessor*> toVisit;
+    toVisit.add(upstream);
+
+    while (toVisit.size() > 0)
+    {
+        GenericProcessor* p = toVisit.removeAndReturn(0);
+
+        if (p == processor)
+            return true;
+
+        toVisit.addArray(getDestinationsOf(p));
+    }
+
+    return false;
 }
 
 void ProcessorGraph::updateViews(GenericProcessor* processor, bool updateGraphViewer)
@@ -671,6 +962,13 @@ void ProcessorGraph::clearSignalChain()
     rootNodes.clear();
     currentNodeId = 100;
 
+    {
+        const ScopedLock lock(dirtyProcessorsLock);
+        dirtyProcessors.clear();
+    }
+
+    inputSignatures.clear();
+
     AccessClass::getGraphViewer()->removeAllNodes();
 
     updateViews(nullptr);
@@ -758,6 +1056,8 @@ void ProcessorGraph::restoreParameters()
 
     LOGDD("Restoring parameters for each processor...");
 
+    int64 start = Time::getHighResolutionTicks();
+
     // first connect the mergers
     for (auto p : getListOfProcessors())
     {
@@ -783,11 +1083,36 @@ void ProcessorGraph::restoreParameters()
 
     isLoadingSignalChain = false;
 
+    LOGC("Signal chain load: restored settings in ", msSince(start), " ms");
+    start = Time::getHighResolutionTicks();
+
+    // processors may request updates while initializing; run them all at once
+    deferSettingsUpdates(true);
+
+    // processors that declare it safe (e.g. sources probing hardware) initialize in
+    // parallel, while the rest initialize in order on the message thread
+    std::vector<std::thread> initializers;
+
+    for (auto p : getListOfProcessors())
+    {
+        if (p->canInitializeConcurrently())
+            initializers.emplace_back([p] { p->initialize(true); });
+    }
+
     for (auto p : getListOfProcessors())
     {
-        p->initialize(true);
+        if (!p->canInitializeConcurrently())
+            p->initialize(true);
     }
 
+    for (auto& initializer : initializers)
+        initializer.join();
+
+    LOGC("Signal chain load: initialized processors in ", msSince(start), " ms (",
+         (int) initializers.size(), " in parallel)");
+
+    deferSettingsUpdates(false);
+
 }
 
 bool ProcessorGraph::allRecordNodesAreSynchronized()
@@ -910,6 +1235,37 @@ int ProcessorGraph::getStreamIdForChannel(Node& node, int channel)
     }
 }
 
+int ProcessorGraph::getMaxSamplesForStream(float streamSampleRate, double graphSampleRate, int blockSize)
+{
+    if (blockSize <= 0 || graphSampleRate <= 0 || streamSampleRate <= 0)
+        return jmax(0, blockSize);
+
+    const double nominalSamples = double(blockSize) * streamSampleRate / graphSampleRate;
+
+    return jmin(blockSize, int(std::ceil(nominalSamples * STREAM_BLOCK_HEADROOM)) + STREAM_BLOCK_MARGIN);
+}
+
+int ProcessorGraph::getMaxSamplesForChannel(Node& node, int channel, double graphSampleRate, int blockSize)
+{
+
+    int nodeId = node.nodeID.uid;
+
+    if (nodeId != OUTPUT_NODE_ID &&
+        nodeId != AUDIO_NODE_ID &&
+        nodeId != MESSAGE_CENTER_ID)
+    {
+        GenericProcessor* p = (GenericProcessor*) node.getProcessor();
+
+        const ContinuousChannel* chan = p->getContinuousChannel(channel);
+
+        if (chan != nullptr)
+            return getMaxSamplesForStream(chan->getSampleRate(), graphSampleRate, blockSize);
+    }
+
+    // audio channels (Audio Monitor outputs, Audio Node) always use the full block
+    return blockSize;
+}
+
 GenericProcessor* ProcessorGraph::getProcessorWithNodeId(int nodeId)
 {
 
@@ -948,6 +1304,9 @@ void ProcessorGraph::clearConnections()
             GenericProcessor* p = (GenericProcessor*) node->getProcessor();
             p->resetConnections();
 
+            // lets the graph share buffers with processors that never write to them
+            node->properties.set("pass_through", p->isPassThrough());
+
         }
     }
 
@@ -1253,6 +1612,13 @@ bool ProcessorGraph::processorWithSameNameExists(const String& name)
 void ProcessorGraph::removeProcessor(GenericProcessor* processor)
 {
 
+    {
+        const ScopedLock lock(dirtyProcessorsLock);
+        dirtyProcessors.removeAllInstancesOf(processor);
+    }
+
+    inputSignatures.remove(processor->getNodeId());
+
     GenericProcessor* originalSource;
 
     if (processor->isMerger())
@@ -1360,6 +1726,31 @@ void ProcessorGraph::removeProcessor(GenericProcessor* processor)
 
 }
 
+double ProcessorGraph::getPlaybackSpeed()
+{
+
+    double speed = -1.0;
+
+    for (auto* processor : getListOfProcessors())
+    {
+        if (!processor->isSource())
+            continue;
+
+        // hardware sources must run in real time
+        if (processor->getName() != "File Reader")
+            return 1.0;
+
+        double readerSpeed = static_cast<FileReader*>(processor)->getPlaybackSpeed();
+
+        // the slowest File Reader sets the pace; 0 means unlimited
+        if (speed < 0 || (readerSpeed > 0 && (speed == 0 || readerSpeed < speed)))
+            speed = readerSpeed;
+    }
+
+    return speed < 0 ? 1.0 : speed;
+
+}
+
 bool ProcessorGraph::isReady()
 {
 
@@ -1443,6 +1834,8 @@ void ProcessorGraph::startAcquisition()
 
     LOGD("ProcessorGraph starting acquisition...");
 
+    Array<GenericProcessor*> processors;
+
     for (int i = 0; i < getNumNodes(); i++)
     {
         Node* node = getNode(i);
@@ -1450,6 +1843,7 @@ void ProcessorGraph::startAcquisition()
         if (node->nodeID != NodeID(OUTPUT_NODE_ID))
         {
             GenericProcessor* p = (GenericProcessor*) node->getProcessor();
+            processors.add(p);
             p->startAcquisition();
 
             if (p->getEditor() != nullptr)
@@ -1459,6 +1853,24 @@ void ProcessorGraph::startAcquisition()
         }
     }
 
+    RealtimeSafetyMonitor::startAcquisition(processors);
+
+}
+
+void ProcessorGraph::setParameterQueuesEnabled(bool enabled)
+{
+
+    for (int i = 0; i < getNumNodes(); i++)
+    {
+        Node* node = getNode(i);
+
+        if (node->nodeID != NodeID(OUTPUT_NODE_ID))
+        {
+            GenericProcessor* p = (GenericProcessor*) node->getProcessor();
+            p->setParameterQueueEnabled(enabled);
+        }
+    }
+
 }
 
 void ProcessorGraph::stopAcquisition()
@@ -1468,6 +1880,8 @@ void ProcessorGraph::stopAcquisition()
 
     bool allClear;
 
+    Array<GenericProcessor*> processors;
+
     for (int i = 0; i < getNumNodes(); i++)
     {
         Node* node = getNode(i);
@@ -1475,6 +1889,7 @@ void ProcessorGraph::stopAcquisition()
         if (node->nodeID != NodeID(OUTPUT_NODE_ID) )
         {
             GenericProcessor* p = (GenericProcessor*) node->getProcessor();
+            processors.add(p);
             LOGD("Disabling ", p->getName());
 
             if (p->getEditor() != nullptr)
@@ -1488,6 +1903,8 @@ void ProcessorGraph::stopAcquisition()
         }
     }
 
+    RealtimeSafetyMonitor::stopAcquisition(processors);
+
 }
 
 void ProcessorGraph::setRecordState(bool isRecording)
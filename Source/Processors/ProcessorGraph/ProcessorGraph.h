@@ -115,12 +115,26 @@ public:
     /* Returns a list of processor editors that are currently visible*/
     Array<GenericEditor*> getVisibleEditors(GenericProcessor* processor);
 
-    /* Updates the settings of all processors downstream of the specified processor*/
+    /* Updates the settings of the specified processor and of the processors downstream of it,
+       together with any other pending requests. Processors that were not changed and whose
+       inputs still look the same are skipped.*/
     void updateSettings(GenericProcessor* processor, bool signalChainIsLoading = false);
 
+    /* Marks a processor as needing an update; all requests made during one turn of the
+       message loop are handled by a single updateSettings() pass.*/
+    void requestSettingsUpdate(GenericProcessor* processor);
+
     /* Updates the views (EditorViewport and GraphView) of all processors downstream of the specified processor*/
     void updateViews(GenericProcessor* processor, bool updateGraphViewer = false);
 
+    /* While deferred, calls to updateSettings() only mark processors as needing an update.
+       When the outermost deferral ends, all of them are updated in a single pass.*/
+    void deferSettingsUpdates(bool shouldDefer);
+
+    /* Enables the processors' parameter change queues while the audio callbacks are running.
+       Disabling them applies any pending changes on the calling thread.*/
+    void setParameterQueuesEnabled(bool enabled);
+
     /* Clears the signal chain.*/
     void clearSignalChain();
 
@@ -130,6 +144,10 @@ public:
     /* Checks if all processors are enabled*/
     bool isReady();
 
+    /* Returns the speed (multiple of real time, 0 = unlimited) at which the signal chain
+       can run. Anything other than 1 requires every source to be a File Reader.*/
+    double getPlaybackSpeed();
+
     /* Creates connections in signal chain*/
     void updateConnections();
 
@@ -193,6 +211,13 @@ public:
     /** Returns the stream ID for a particular node/channel combination */
     static int getStreamIdForChannel(Node& node, int channel);
 
+    /** Returns the number of samples per block reserved in the continuous buffer for a stream.
+        Low-rate streams get proportionally less than the audio callback's block size.*/
+    static int getMaxSamplesForStream(float streamSampleRate, double graphSampleRate, int blockSize);
+
+    /** Returns the number of samples per block reserved for a particular node/channel combination */
+    static int getMaxSamplesForChannel(Node& node, int channel, double graphSampleRate, int blockSize);
+
     /** Re-implementation of JUCE AudioProcessorGraph method that allows faster signal chain rendering */
     static bool isBufferNeededLater(int inputNodeId, int inputIndex, int outputNodeId, int outputIndex, bool* isValid);
 
@@ -221,6 +246,38 @@ private:
 
     /* Connect a processor to the MessageCenter*/
     void connectProcessorToMessageCenter(GenericProcessor* source);
+
+    /* Runs requested settings updates on the next turn of the message loop
+       (AudioProcessorGraph already uses its own AsyncUpdater)*/
+    class SettingsUpdater : public juce::AsyncUpdater
+    {
+    public:
+        SettingsUpdater(ProcessorGraph* graph_) : graph(graph_) { }
+        void handleAsyncUpdate() override { graph->handlePendingSettingsUpdates(); }
+    private:
+        ProcessorGraph* graph;
+    };
+
+    /* Called by the SettingsUpdater*/
+    void handlePendingSettingsUpdates();
+
+    /* Updates every processor marked as dirty, walking only the affected part of the signal chain*/
+    void flushSettingsUpdates();
+
+    /* Returns the processors feeding into a processor (two for a Merger)*/
+    Array<GenericProcessor*> getSourcesOf(GenericProcessor* processor);
+
+    /* Returns the processors fed by a processor (two for a Splitter)*/
+    Array<GenericProcessor*> getDestinationsOf(GenericProcessor* processor);
+
+    /* Returns all processors downstream of the given ones, each after its sources*/
+    Array<GenericProcessor*> getProcessorsInUpdateOrder(const Array<GenericProcessor*>& startingProcessors);
+
+    /* Returns a hash of the streams and channels a processor receives from its sources*/
+    int64 getInputSignature(GenericProcessor* processor);
+
+    /* Returns true if 'processor' is downstream of (or equal to) 'upstream'*/
+    bool isDownstreamOf(GenericProcessor* processor, GenericProcessor* upstream);
     
     Array<GenericProcessor*> rootNodes;
 
@@ -228,6 +285,12 @@ private:
 
     bool isLoadingSignalChain;
 
+    int settingsUpdateDeferrals;
+    Array<GenericProcessor*> dirtyProcessors;
+    CriticalSection dirtyProcessorsLock;
+    HashMap<int, int64> inputSignatures;
+    SettingsUpdater settingsUpdater;
+
 };
 
 
@@ -221,8 +221,12 @@ namespace ProcessorManager
             }
             case Plugin::PROCESSOR:
             {
-                Plugin::ProcessorInfo info = AccessClass::getPluginManager()->getProcessorInfo(description.index);
-                GenericProcessor* proc = info.creator();
+                ProcessorCreator creator = AccessClass::getPluginManager()->getProcessorCreator(description.index);
+
+                if (creator == nullptr)
+                    return nullptr;
+
+                GenericProcessor* proc = creator();
                 proc->setPluginData(Plugin::PROCESSOR, description.index);
                 proc->setProcessorType(description.processorType);
                 return std::unique_ptr<GenericProcessor>(proc);
@@ -230,7 +234,12 @@ namespace ProcessorManager
             case Plugin::DATA_THREAD:
             {
                 Plugin::DataThreadInfo info = AccessClass::getPluginManager()->getDataThreadInfo(description.index);
-                GenericProcessor* proc = new SourceNode(info.name, info.creator);
+                DataThreadCreator creator = AccessClass::getPluginManager()->getDataThreadCreator(description.index);
+
+                if (creator == nullptr)
+                    return nullptr;
+
+                GenericProcessor* proc = new SourceNode(info.name, creator);
                 proc->setPluginData(Plugin::DATA_THREAD, description.index);
                 proc->setProcessorType(Plugin::Processor::SOURCE);
                 return std::unique_ptr<GenericProcessor>(proc);
@@ -261,9 +270,12 @@ namespace ProcessorManager
                     {
                         int libIndex = pm->getLibraryIndexFromPlugin(Plugin::PROCESSOR, i);
                         
-                        if (description.libName.equalsIgnoreCase(pm->getLibraryName(libIndex)))
+                        ProcessorCreator creator;
+
+                        if (description.libName.equalsIgnoreCase(pm->getLibraryName(libIndex))
+                            && (creator = pm->getProcessorCreator(i)) != nullptr)
                         {
-                            proc = info.creator();
+                            proc = creator();
                             proc->setPluginData(Plugin::PROCESSOR, i);
                             proc->setProcessorType(description.processorType);
                             return std::unique_ptr<GenericProcessor>(proc);
@@ -279,9 +291,12 @@ namespace ProcessorManager
                     if (description.name.equalsIgnoreCase(info.name))
                     {
                         int libIndex = pm->getLibraryIndexFromPlugin(Plugin::DATA_THREAD, i);
-                        if (description.libName.equalsIgnoreCase(pm->getLibraryName(libIndex)))
+                        DataThreadCreator creator;
+
+                        if (description.libName.equalsIgnoreCase(pm->getLibraryName(libIndex))
+                            && (creator = pm->getDataThreadCreator(i)) != nullptr)
                         {
-                            proc = new SourceNode(info.name, info.creator);
+                            proc = new SourceNode(info.name, creator);
                             proc->setPluginData(Plugin::DATA_THREAD, i);
                             return std::unique_ptr<GenericProcessor>(proc);
                         }
@@ -32,12 +32,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define MAX_BUFFER_SIZE 40960
 
+/* Event and spike records are staged in memory and written in batches */
+#define EVENT_STAGING_RECORDS 1024
+#define SPIKE_STAGING_BYTES (1024 * 1024)
+#define STAGING_FLUSH_INTERVAL_MS 1000
+
 BinaryRecording::BinaryRecording()
 {
     m_bufferSize = MAX_BUFFER_SIZE;
 	m_scaledBuffer.malloc(MAX_BUFFER_SIZE);
 	m_intBuffer.malloc(MAX_BUFFER_SIZE);
     m_sampleNumberBuffer.malloc(MAX_BUFFER_SIZE);
+
+    m_compressionThreads = jmax(1, SystemStats::getNumCpus() / 2);
 }
 
 BinaryRecording::~BinaryRecording() {}
@@ -141,10 +148,10 @@ void BinaryRecording::openFiles(File rootFolder, int experimentNumber, int recor
         String filename = contPath + datPath + "continuous.dat";
 
         LOGD("Creating file: ", contPath, datPath, "sample_numbers.npy");
-        ScopedPointer<NpyFile> tFile = new NpyFile(contPath + datPath + "sample_numbers.npy", NpyType(BaseType::INT64,1));
+        ScopedPointer<NpyFile> tFile = new NpyFile(contPath + datPath + "sample_numbers.npy", NpyType(BaseType::INT64,1), 1, NpyFile::BACKGROUND_HEADER);
         m_dataTimestampFiles.add(tFile.release());
 
-        ScopedPointer<NpyFile> syncTimestampFile = new NpyFile(contPath + datPath + "timestamps.npy", NpyType(BaseType::DOUBLE,1));
+        ScopedPointer<NpyFile> syncTimestampFile = new NpyFile(contPath + datPath + "timestamps.npy", NpyType(BaseType::DOUBLE,1), 1, NpyFile::BACKGROUND_HEADER);
         m_dataSyncTimestampFiles.add(syncTimestampFile.release());
 
         DynamicObject::Ptr fileJSON = new DynamicObject();
@@ -157,12 +164,29 @@ void BinaryRecording::openFiles(File rootFolder, int experimentNumber, int recor
         fileJSON->setProperty("recorded_processor_id", ch->getNodeId());
         fileJSON->setProperty("num_channels", channelCounts[streamIndex]);
 
-        ScopedPointer<SequentialBlockFile> bFile = new SequentialBlockFile(channelCounts[streamIndex], samplesPerBlock);
+        if (m_compressContinuous)
+        {
+            if (m_compressionPool == nullptr || m_compressionPool->getNumThreads() != m_compressionThreads)
+                m_compressionPool = std::make_unique<ThreadPool>(m_compressionThreads);
+
+            fileJSON->setProperty("compression", "delta-pack");
+
+            ScopedPointer<CompressedBlockFile> cFile = new CompressedBlockFile(channelCounts[streamIndex], m_compressionPool.get(), samplesPerBlock);
 
-        if (bFile->openFile(filename))
-            m_continuousFiles.add(bFile.release());
+            if (cFile->openFile(contPath + datPath + "continuous.packed", contPath + datPath + "block_index.npy"))
+                m_compressedFiles.add(cFile.release());
+            else
+                m_compressedFiles.add(nullptr);
+        }
         else
-            m_continuousFiles.add(nullptr);
+        {
+            ScopedPointer<SequentialBlockFile> bFile = new SequentialBlockFile(channelCounts[streamIndex], samplesPerBlock);
+
+            if (bFile->openFile(filename))
+                m_continuousFiles.add(bFile.release());
+            else
+                m_continuousFiles.add(nullptr);
+        }
 
         fileJSON->setProperty("channels", multiStreamJSON.getReference(streamIndex));
 
@@ -214,13 +238,16 @@ void BinaryRecording::openFiles(File rootFolder, int experimentNumber, int recor
         ScopedPointer<EventRecording> rec = new EventRecording();
 
         rec->data = std::make_unique<NpyFile>(eventPath + eventName + dataFileName + ".npy", type);
-        rec->samples = std::make_unique<NpyFile>(eventPath + eventName + "sample_numbers.npy", NpyType(BaseType::INT64, 1));
-        rec->timestamps = std::make_unique<NpyFile>(eventPath + eventName + "timestamps.npy", NpyType(BaseType::DOUBLE, 1));
+        rec->samples = std::make_unique<NpyFile>(eventPath + eventName + "sample_numbers.npy", NpyType(BaseType::INT64, 1), 1, NpyFile::BACKGROUND_HEADER);
+        rec->timestamps = std::make_unique<NpyFile>(eventPath + eventName + "timestamps.npy", NpyType(BaseType::DOUBLE, 1), 1, NpyFile::BACKGROUND_HEADER);
         if (chan->getType() == EventChannel::TTL && m_saveTTLWords)
         {
             rec->extraFile = std::make_unique<NpyFile>(eventPath + eventName + "full_words.npy", NpyType(BaseType::UINT64, 1));
         }
 
+        size_t dataRecordSize = chan->getType() == EventChannel::TTL ? sizeof(int16) : chan->getDataSize();
+        rec->prepareStaging(EVENT_STAGING_RECORDS, dataRecordSize, rec->extraFile ? sizeof(uint64) : 0);
+
         DynamicObject::Ptr jsonChannel = new DynamicObject();
         jsonChannel->setProperty("folder_name", eventName.replace(File::getSeparatorString(), "/"));
         jsonChannel->setProperty("channel_name", chan->getName());
@@ -302,11 +329,14 @@ void BinaryRecording::openFiles(File rootFolder, int experimentNumber, int recor
         String directoryName = getProcessorString(ch) + ch->getName() + File::getSeparatorString();
 
         rec->data = std::make_unique<NpyFile>(spikePath + directoryName + "waveforms.npy", NpyType(BaseType::INT16, ch->getTotalSamples()), ch->getNumChannels());
-        rec->samples = std::make_unique<NpyFile>(spikePath + directoryName + "sample_numbers.npy", NpyType(BaseType::INT64, 1));
-        rec->timestamps = std::make_unique<NpyFile>(spikePath + directoryName + "timestamps.npy", NpyType(BaseType::DOUBLE, 1));
+        rec->samples = std::make_unique<NpyFile>(spikePath + directoryName + "sample_numbers.npy", NpyType(BaseType::INT64, 1), 1, NpyFile::BACKGROUND_HEADER);
+        rec->timestamps = std::make_unique<NpyFile>(spikePath + directoryName + "timestamps.npy", NpyType(BaseType::DOUBLE, 1), 1, NpyFile::BACKGROUND_HEADER);
         rec->channels = std::make_unique<NpyFile>(spikePath + directoryName + "electrode_indices.npy", NpyType(BaseType::UINT16, 1));
         rec->extraFile = std::make_unique<NpyFile>(spikePath + directoryName + "clusters.npy", NpyType(BaseType::UINT16, 1));
 
+        size_t waveformSize = ch->getTotalSamples() * ch->getNumChannels() * sizeof(int16);
+        rec->prepareStaging(jlimit(16, EVENT_STAGING_RECORDS, int(SPIKE_STAGING_BYTES / waveformSize)), waveformSize, sizeof(uint16));
+
         electrodeJSON->setProperty("folder", directoryName.replace(File::getSeparatorString(),"/"));
         electrodeJSON->setProperty("source_channels", channelJSON);
 
@@ -480,7 +510,9 @@ void BinaryRecording::createChannelMetadata(const MetadataObject* channel, Dynam
 void BinaryRecording::closeFiles()
 {
 
+    /* Staged events and spikes are written when their EventRecording is deleted */
     m_continuousFiles.clear();
+    m_compressedFiles.clear(); // waits for pending compression jobs
     m_eventFiles.clear();
     m_spikeFiles.clear();
 
@@ -514,13 +546,98 @@ void BinaryRecording::writeEventMetadata(const MetadataEvent* event, NpyFile* fi
     }
 }
 
-void BinaryRecording::increaseEventCounts(EventRecording* rec)
+BinaryRecording::EventRecording::~EventRecording()
+{
+    flush();
+}
+
+void BinaryRecording::EventRecording::prepareStaging(int maxRecords, size_t dataRecordSize, size_t extraRecordSize)
+{
+    maxStaged = maxRecords;
+    dataSize = dataRecordSize;
+    extraSize = extraRecordSize;
+    numStaged = 0;
+
+    dataColumn.malloc(maxRecords * dataSize);
+    sampleColumn.malloc(maxRecords);
+    timestampColumn.malloc(maxRecords);
+
+    if (channels)
+        channelColumn.malloc(maxRecords);
+
+    if (extraFile)
+        extraColumn.malloc(maxRecords * extraSize);
+}
+
+void BinaryRecording::EventRecording::stageRecord(int64 sampleNumber, double timestamp, uint16 channel, const void* extra)
 {
-    rec->data->increaseRecordCount();
-    rec->samples->increaseRecordCount();
-    rec->timestamps->increaseRecordCount();
-    if (rec->channels) rec->channels->increaseRecordCount();
-    if (rec->extraFile) rec->extraFile->increaseRecordCount();
+    if (numStaged == 0)
+        firstStagedTime = Time::getMillisecondCounter();
+
+    sampleColumn[numStaged] = sampleNumber;
+    timestampColumn[numStaged] = timestamp;
+
+    if (channels)
+        channelColumn[numStaged] = channel;
+
+    if (extraFile)
+        memcpy(extraColumn.getData() + numStaged * extraSize, extra, extraSize);
+
+    if (++numStaged >= maxStaged)
+        flush();
+}
+
+bool BinaryRecording::EventRecording::isStale(uint32 now, uint32 intervalMs) const
+{
+    return numStaged > 0 && now - firstStagedTime >= intervalMs;
+}
+
+void BinaryRecording::EventRecording::flush()
+{
+    if (numStaged == 0)
+        return;
+
+    /* One sequential write per file, followed by a single record count update */
+    data->writeData(dataColumn.getData(), numStaged * dataSize);
+    data->increaseRecordCount(numStaged);
+
+    samples->writeData(sampleColumn.getData(), numStaged * sizeof(int64));
+    samples->increaseRecordCount(numStaged);
+
+    timestamps->writeData(timestampColumn.getData(), numStaged * sizeof(double));
+    timestamps->increaseRecordCount(numStaged);
+
+    if (channels)
+    {
+        channels->writeData(channelColumn.getData(), numStaged * sizeof(uint16));
+        channels->increaseRecordCount(numStaged);
+    }
+
+    if (extraFile)
+    {
+        extraFile->writeData(extraColumn.getData(), numStaged * extraSize);
+        extraFile->increaseRecordCount(numStaged);
+    }
+
+    numStaged = 0;
+}
+
+void BinaryRecording::endWriteBlock()
+{
+    uint32 now = Time::getMillisecondCounter();
+
+    if (now - m_lastStagingCheck < STAGING_FLUSH_INTERVAL_MS / 4)
+        return;
+
+    m_lastStagingCheck = now;
+
+    for (auto rec : m_eventFiles)
+        if (rec->isStale(now, STAGING_FLUSH_INTERVAL_MS))
+            rec->flush();
+
+    for (auto rec : m_spikeFiles)
+        if (rec->isStale(now, STAGING_FLUSH_INTERVAL_MS))
+            rec->flush();
 }
 
 void BinaryRecording::writeContinuousData(int writeChannel,
@@ -552,11 +669,23 @@ void BinaryRecording::writeContinuousData(int writeChannel,
 	int fileIndex = m_fileIndexes[writeChannel];
 
     /* Write the data to that file */
-	m_continuousFiles[fileIndex]->writeChannel(
-		m_samplesWritten[writeChannel],
-		m_channelIndexes[writeChannel],
-		m_intBuffer.getData(),
-        size);
+    if (m_compressContinuous)
+    {
+        if (m_compressedFiles[fileIndex] != nullptr)
+            m_compressedFiles[fileIndex]->writeChannel(
+                m_samplesWritten[writeChannel],
+                m_channelIndexes[writeChannel],
+                m_intBuffer.getData(),
+                size);
+    }
+    else
+    {
+	    m_continuousFiles[fileIndex]->writeChannel(
+		    m_samplesWritten[writeChannel],
+		    m_channelIndexes[writeChannel],
+		    m_intBuffer.getData(),
+            size);
+    }
     
     m_samplesWritten.set(writeChannel, m_samplesWritten[writeChannel] + size);
 
@@ -564,11 +693,21 @@ void BinaryRecording::writeContinuousData(int writeChannel,
 	if (m_channelIndexes[writeChannel] == 0)
     {
 
-		int64 baseSampleNumber = getLatestSampleNumber(writeChannel);
+		const int64* sampleNumbers = getSampleNumberBuffer();
+
+		if (sampleNumbers != nullptr)
+		{
+			/* Copy the sample numbers, including any gaps reported by the source */
+			memcpy(m_sampleNumberBuffer, sampleNumbers, size * sizeof(int64));
+		}
+		else
+		{
+			int64 baseSampleNumber = getLatestSampleNumber(writeChannel);
 
-		for (int i = 0; i < size; i++)
-            /* Generate int sample number */
-            m_sampleNumberBuffer[i] = baseSampleNumber + i;
+			for (int i = 0; i < size; i++)
+				/* Generate int sample number */
+				m_sampleNumberBuffer[i] = baseSampleNumber + i;
+		}
 
         /* Write int timestamps to disc */
 		m_dataTimestampFiles[fileIndex]->writeData(m_sampleNumberBuffer, size*sizeof(int64));
@@ -584,58 +723,75 @@ void BinaryRecording::writeContinuousData(int writeChannel,
 }
 
 void BinaryRecording::writeEvent(int eventIndex, const EventPacket& event)
+{
+    writeEventPacket(eventIndex, event.getRawData(), (size_t) event.getRawDataSize());
+}
+
+void BinaryRecording::writeEventPacket(int eventIndex, const uint8* data, size_t size)
 {
 
     const EventChannel* info = getEventChannel(eventIndex);
 
-	EventPtr ev = Event::deserialize(event, info);
 	EventRecording* rec = m_eventFiles[eventIndex];
 
     if (!rec) return;
 
-	if (ev->getEventType() == EventChannel::TTL)
-	{
+    /* Read the fields directly from the serialized packet (see Event.h for the layout) */
+    int64 sampleIdx = *reinterpret_cast<const int64*>(data + 8);
+    double ts = *reinterpret_cast<const double*>(data + 16);
+    const uint8* payload = data + EVENT_BASE_SIZE;
 
-        TTLEvent* ttl = static_cast<TTLEvent*>(ev.get());
+	if (info->getType() == EventChannel::TTL)
+	{
 
-        int16 state = (ttl->getLine() + 1) * (ttl->getState() ? 1 : -1);
-		rec->data->writeData(&state, sizeof(int16));
+        uint8 line = payload[0];
+        bool state = payload[1] == 1;
 
-        int64 sampleIdx = ev->getSampleNumber();
-        rec->samples->writeData(&sampleIdx, sizeof(int64));
+        int16 ttlState = (line + 1) * (state ? 1 : -1);
+        memcpy(rec->getNextDataSlot(), &ttlState, sizeof(int16));
 
-        double ts = ev->getTimestampInSeconds();
-        rec->timestamps->writeData(&ts, sizeof(double));
+        uint64 fullWord = *reinterpret_cast<const uint64*>(payload + 2);
 
-        if (rec->extraFile)
-        {
-            uint64 fullWord = ttl->getWord();
-            rec->extraFile->writeData(&fullWord, sizeof(uint64));
-        }
+        rec->stageRecord(sampleIdx, ts, 0, &fullWord);
 
 	}
-	else if (ev->getEventType() == EventChannel::TEXT)
+	else
 	{
+        memcpy(rec->getNextDataSlot(), payload, info->getDataSize());
 
-        TextEvent* text = static_cast<TextEvent*>(ev.get());
-
-        int64 sampleIdx = text->getSampleNumber();
-        rec->samples->writeData(&sampleIdx, sizeof(int64));
-
-        double ts = text->getTimestampInSeconds();
-        rec->timestamps->writeData(&ts, sizeof(double));
-
-		rec->data->writeData(ev->getRawDataPointer(), info->getDataSize());
+        rec->stageRecord(sampleIdx, ts, 0, nullptr);
 	}
 
     // NOT IMPLEMENTED
 	//writeEventMetadata(ev.get(), rec->metaDataFile.get());
 
-	increaseEventCounts(rec);
-
 }
 
 void BinaryRecording::writeSpike(int electrodeIndex, const Spike* spike)
+{
+    writeSpikeData(electrodeIndex,
+                   spike->getDataPointer(),
+                   spike->getSampleNumber(),
+                   spike->getTimestampInSeconds(),
+                   spike->getSortedId());
+}
+
+void BinaryRecording::writeSpikePacket(int electrodeIndex, const uint8* data, size_t size)
+{
+    const SpikeChannel* channel = getSpikeChannel(electrodeIndex);
+
+    /* Waveform samples follow the base header and one threshold per channel (see Spike.h) */
+    const float* waveform = reinterpret_cast<const float*>(data + SPIKE_BASE_SIZE
+                                                           + channel->getNumChannels() * sizeof(float));
+
+    writeSpikeData(electrodeIndex,
+                   waveform,
+                   *reinterpret_cast<const int64*>(data + 8),
+                   *reinterpret_cast<const double*>(data + 16),
+                   *reinterpret_cast<const uint16*>(data + 24));
+}
+
+void BinaryRecording::writeSpikeData(int electrodeIndex, const float* waveform, int64 sampleIdx, double ts, uint16 sortedId)
 {
 
 	const SpikeChannel* channel = getSpikeChannel(electrodeIndex);
@@ -654,27 +810,16 @@ void BinaryRecording::writeSpike(int electrodeIndex, const Spike* spike)
 		m_intBuffer.malloc(totalSamples);
 	}
 
+    /* Convert the waveform straight into the staging buffer */
 	double multFactor = 1 / (float(0x7fff) * channel->getChannelBitVolts(0));
-	FloatVectorOperations::copyWithMultiply(m_scaledBuffer.getData(), spike->getDataPointer(), multFactor, totalSamples);
-	AudioDataConverters::convertFloatToInt16LE(m_scaledBuffer.getData(), m_intBuffer.getData(), totalSamples);
-	rec->data->writeData(m_intBuffer.getData(), totalSamples*sizeof(int16));
-
-	int64 sampleIdx = spike->getSampleNumber();
-	rec->samples->writeData(&sampleIdx, sizeof(int64));
-
-    double ts = spike->getTimestampInSeconds();
-    rec->timestamps->writeData(&ts, sizeof(double));
+	FloatVectorOperations::copyWithMultiply(m_scaledBuffer.getData(), waveform, multFactor, totalSamples);
+	AudioDataConverters::convertFloatToInt16LE(m_scaledBuffer.getData(), rec->getNextDataSlot(), totalSamples);
 
-	rec->channels->writeData(&spikeChannel, sizeof(uint16));
-
-	uint16 sortedId = spike->getSortedId();
-	rec->extraFile->writeData(&sortedId, sizeof(uint16));
+	rec->stageRecord(sampleIdx, ts, spikeChannel, &sortedId);
 
     // NOT IMPLEMENTED
 	//writeEventMetadata(spike, rec->metaDataFile.get());
 
-	increaseEventCounts(rec);
-
 }
 
 void BinaryRecording::writeTimestampSyncText(uint64 streamId, int64 sampleNumber, float sourceSampleRate, String text)
@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../RecordEngine.h"
 
 #include "SequentialBlockFile.h"
+#include "CompressedBlockFile.h"
 #include "NpyFile.h"
 
 class BinaryRecording : public RecordEngine
@@ -69,29 +70,82 @@ public:
 	/** Writes a spike to disk */
 	void writeSpike(int electrodeIndex, const Spike* spike);
 
+	/** Writes a serialized event to disk without deserializing it */
+	void writeEventPacket(int eventIndex, const uint8* data, size_t size) override;
+
+	/** Writes a serialized spike to disk without deserializing it */
+	void writeSpikePacket(int electrodeIndex, const uint8* data, size_t size) override;
+
+	/** Flushes staged events and spikes that have been waiting longer than STAGING_FLUSH_INTERVAL_MS */
+	void endWriteBlock() override;
+
 	/** Writes timestamp sync texts */
 	void writeTimestampSyncText(uint64 streamId, int64 sampleNumber, float sampleRate, String text);
 
 	/** Sets an engine parameter (in this case TTL word writing bool) */
 	void setParameter(EngineParameter& parameter);
 
+protected:
+
+    /** If true, continuous data is written to compressed, block-indexed files instead of continuous.dat */
+    bool m_compressContinuous{ false };
+
+    /** Number of worker threads used to compress continuous data */
+    int m_compressionThreads;
+
 private:
 
+    /** Holds the files for one event channel or electrode, along with columnar
+        staging buffers. Records are appended to the buffers and written to disk
+        with one large write per file when the buffers are full, when the oldest
+        record becomes too old, or when the files are closed. */
     class EventRecording
     {
     public:
 
+        /** Destructor (writes any staged records) */
+        ~EventRecording();
+
 		std::unique_ptr<NpyFile> data;
 		std::unique_ptr<NpyFile> samples;
 		std::unique_ptr<NpyFile> channels;
         std::unique_ptr<NpyFile> extraFile;
         std::unique_ptr<NpyFile> timestamps;
+
+        /** Allocates the staging buffers, given the size in bytes of one record in the data and extra files */
+        void prepareStaging(int maxRecords, size_t dataRecordSize, size_t extraRecordSize);
+
+        /** Returns a pointer to the data column slot of the next record */
+        void* getNextDataSlot() { return dataColumn.getData() + numStaged * dataSize; }
+
+        /** Stages one record (the data column slot must already be filled in), and flushes if the buffers are full */
+        void stageRecord(int64 sampleNumber, double timestamp, uint16 channel, const void* extra);
+
+        /** Returns true if records have been staged for longer than the given interval */
+        bool isStale(uint32 now, uint32 intervalMs) const;
+
+        /** Writes all staged records to disk */
+        void flush();
+
+    private:
+
+        HeapBlock<char> dataColumn;
+        HeapBlock<int64> sampleColumn;
+        HeapBlock<double> timestampColumn;
+        HeapBlock<uint16> channelColumn;
+        HeapBlock<char> extraColumn;
+
+        size_t dataSize = 0;
+        size_t extraSize = 0;
+        int numStaged = 0;
+        int maxStaged = 0;
+        uint32 firstStagedTime = 0;
     };
 
     std::unique_ptr<NpyFile> createEventMetadataFile(const MetadataEventObject* channel, String fileName, DynamicObject* jsonObject);
 	void createChannelMetadata(const MetadataObject* channel, DynamicObject* jsonObject);
     void writeEventMetadata(const MetadataEvent* event, NpyFile* file);
-    void increaseEventCounts(EventRecording* rec);
+    void writeSpikeData(int electrodeIndex, const float* waveform, int64 sampleNumber, double timestamp, uint16 sortedId);
 
     bool m_saveTTLWords{ true };
 
@@ -100,11 +154,14 @@ private:
 	HeapBlock<int64> m_sampleNumberBuffer;
 	int m_bufferSize;
 	int m_syncTimestampBufferSize;
+	uint32 m_lastStagingCheck{ 0 };
 
 	Array<unsigned int> m_channelIndexes;
 	Array<unsigned int> m_fileIndexes;
 
     OwnedArray<SequentialBlockFile> m_continuousFiles;
+    OwnedArray<CompressedBlockFile> m_compressedFiles;
+    std::unique_ptr<ThreadPool> m_compressionPool;
 	OwnedArray<EventRecording> m_eventFiles;
 	OwnedArray<EventRecording> m_spikeFiles;
 
@@ -0,0 +1,479 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2022 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedBlockFile.h"
+
+#include <algorithm>
+
+static const char* const packedFileMagic = "OEPACK";
+
+struct CompressedBlockFile::Block
+{
+    Block(int nChannels, int samplesPerBlock)
+        : samples(nChannels * samplesPerBlock),
+          fill(nChannels),
+          encoded(BLOCK_HEADER_SIZE + nChannels * (sizeof(uint32) + DeltaPackCodec::getMaxEncodedSize(samplesPerBlock)))
+    {
+    }
+
+    void reset(int64 blockIndex, int nChannels)
+    {
+        index = blockIndex;
+        numFullChannels = 0;
+        numSamples = 0;
+        encodedSize = 0;
+        submitted = false;
+        finished = false;
+
+        for (int ch = 0; ch < nChannels; ch++)
+            fill[ch] = 0;
+    }
+
+    int64 index;
+    HeapBlock<int16> samples; // channel-major
+    HeapBlock<int> fill;
+    int numFullChannels;
+    int numSamples;
+
+    HeapBlock<uint8> encoded;
+    size_t encodedSize;
+
+    bool submitted;
+    std::atomic<bool> finished;
+};
+
+CompressedBlockFile::CompressedBlockFile(int nChannels, ThreadPool* pool, int samplesPerBlock) :
+    m_pool(pool),
+    m_nChannels(nChannels),
+    m_samplesPerBlock(samplesPerBlock),
+    m_firstBlockIndex(0),
+    m_numSubmitted(0),
+    m_numJobsRunning(0),
+    maxBlocksInFlight(2 * pool->getNumThreads() + 2)
+{
+}
+
+CompressedBlockFile::~CompressedBlockFile()
+{
+    if (!m_file)
+        return;
+
+    // Drop trailing blocks that never received any data
+    while (m_blocks.size() > 0 && !m_blocks.getLast()->submitted)
+    {
+        Block* block = m_blocks.getLast();
+
+        int maxFill = 0;
+
+        for (int ch = 0; ch < m_nChannels; ch++)
+            maxFill = jmax(maxFill, block->fill[ch]);
+
+        if (maxFill > 0)
+            break;
+
+        m_blocks.removeLast();
+    }
+
+    // Compress the remaining partial blocks, padding short channels with zeroes
+    for (auto block : m_blocks)
+    {
+        if (block->submitted)
+            continue;
+
+        int maxFill = 0;
+
+        for (int ch = 0; ch < m_nChannels; ch++)
+            maxFill = jmax(maxFill, block->fill[ch]);
+
+        for (int ch = 0; ch < m_nChannels; ch++)
+        {
+            if (block->fill[ch] < maxFill)
+                zeromem(block->samples + ch * m_samplesPerBlock + block->fill[ch],
+                        (maxFill - block->fill[ch]) * sizeof(int16));
+        }
+
+        submitBlock(block, maxFill);
+    }
+
+    writeCompressedBlocks(true);
+
+    // a job can still be returning from signal() after its block was written
+    while (m_numJobsRunning.load(std::memory_order_acquire) > 0)
+        Thread::yield();
+
+    m_file->flush();
+}
+
+bool CompressedBlockFile::openFile(String filename, String indexFilename)
+{
+    File file(filename);
+    Result res = file.create();
+    if (res.failed())
+    {
+        std::cerr << "Error creating file " << filename << ":" << res.getErrorMessage() << std::endl;
+        file.deleteFile();
+        Result res = file.create();
+        LOGD("Re-creating file: ", filename);
+    }
+
+    m_file = file.createOutputStream();
+    if (!m_file)
+    {
+        LOGD("Unable to create output stream!");
+        return false;
+    }
+
+    uint16 version = FORMAT_VERSION;
+    uint32 numChannels = m_nChannels;
+    uint32 samplesPerBlock = m_samplesPerBlock;
+
+    m_file->write(packedFileMagic, 6);
+    m_file->write(&version, sizeof(uint16));
+    m_file->write(&numChannels, sizeof(uint32));
+    m_file->write(&samplesPerBlock, sizeof(uint32));
+
+    // Each entry holds the first sample number and the byte offset of a block
+    m_indexFile = std::make_unique<NpyFile>(indexFilename, NpyType(BaseType::INT64, 2), 1, NpyFile::BACKGROUND_HEADER);
+
+    return true;
+}
+
+CompressedBlockFile::Block* CompressedBlockFile::getBlock(int64 blockIndex)
+{
+    if (blockIndex < m_firstBlockIndex)
+        return nullptr; // already written to disk
+
+    while (m_blocks.size() <= blockIndex - m_firstBlockIndex)
+    {
+        Block* block = m_freeBlocks.size() > 0 ? m_freeBlocks.removeAndReturn(m_freeBlocks.size() - 1)
+                                               : new Block(m_nChannels, m_samplesPerBlock);
+
+        block->reset(m_firstBlockIndex + m_blocks.size(), m_nChannels);
+        m_blocks.add(block);
+    }
+
+    return m_blocks[(int) (blockIndex - m_firstBlockIndex)];
+}
+
+bool CompressedBlockFile::writeChannel(uint64 startPos, int channel, int16* data, int nSamples)
+{
+    if (!m_file)
+        return false;
+
+    bool ok = true;
+    int written = 0;
+
+    while (written < nSamples)
+    {
+        uint64 pos = startPos + written;
+        int offset = pos % m_samplesPerBlock;
+        int count = jmin(nSamples - written, m_samplesPerBlock - offset);
+
+        Block* block = getBlock(pos / m_samplesPerBlock);
+
+        if (block == nullptr || block->submitted)
+        {
+            ok = false; // arrived after its block was compressed
+        }
+        else
+        {
+            memcpy(block->samples + channel * m_samplesPerBlock + offset, data + written, count * sizeof(int16));
+
+            if (offset + count > block->fill[channel])
+            {
+                block->fill[channel] = offset + count;
+
+                if (block->fill[channel] == m_samplesPerBlock && ++block->numFullChannels == m_nChannels)
+                    submitBlock(block, m_samplesPerBlock);
+            }
+        }
+
+        written += count;
+    }
+
+    writeCompressedBlocks(false);
+
+    return ok;
+}
+
+void CompressedBlockFile::submitBlock(Block* block, int numSamples)
+{
+    block->numSamples = numSamples;
+    block->submitted = true;
+    m_numSubmitted++;
+    m_numJobsRunning++;
+
+    m_pool->addJob([this, block]
+    {
+        uint8* out = block->encoded.getData();
+        uint8* payload = out + BLOCK_HEADER_SIZE + m_nChannels * sizeof(uint32);
+        uint32 encodedBytes = 0;
+
+        for (int ch = 0; ch < m_nChannels; ch++)
+        {
+            uint32 channelSize = (uint32) DeltaPackCodec::encode(block->samples + ch * m_samplesPerBlock,
+                                                                 block->numSamples,
+                                                                 payload + encodedBytes);
+
+            memcpy(out + BLOCK_HEADER_SIZE + ch * sizeof(uint32), &channelSize, sizeof(uint32));
+            encodedBytes += channelSize;
+        }
+
+        uint32 payloadSize = m_nChannels * sizeof(uint32) + encodedBytes;
+        uint32 numSamples = block->numSamples;
+
+        memcpy(out, &payloadSize, sizeof(uint32));
+        memcpy(out + sizeof(uint32), &numSamples, sizeof(uint32));
+
+        block->encodedSize = BLOCK_HEADER_SIZE + payloadSize;
+        block->finished.store(true, std::memory_order_release);
+
+        m_blockFinished.signal();
+
+        // must be the job's last access to this object (see the destructor)
+        m_numJobsRunning.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+void CompressedBlockFile::writeCompressedBlocks(bool waitForAll)
+{
+    while (m_blocks.size() > 0)
+    {
+        Block* block = m_blocks.getFirst();
+
+        if (!block->submitted)
+            break;
+
+        if (!block->finished.load(std::memory_order_acquire))
+        {
+            // wait if asked to, or if too many blocks are queued for compression
+            if (waitForAll || m_numSubmitted > maxBlocksInFlight)
+            {
+                m_blockFinished.wait(100);
+                continue;
+            }
+
+            break;
+        }
+
+        int64 indexEntry[2] = { block->index * m_samplesPerBlock, m_file->getPosition() };
+        m_indexFile->writeData(indexEntry, sizeof(indexEntry));
+        m_indexFile->increaseRecordCount();
+
+        m_file->write(block->encoded, block->encodedSize);
+
+        m_numSubmitted--;
+        m_firstBlockIndex++;
+        m_freeBlocks.add(m_blocks.removeAndReturn(0));
+    }
+}
+
+CompressedBlockReader::CompressedBlockReader() :
+    m_nChannels(0),
+    m_samplesPerBlock(0),
+    m_numSamples(0),
+    m_cachedBlock(-1),
+    m_cachedNumSamples(0)
+{
+}
+
+bool CompressedBlockReader::open(File dataFile, File indexFile)
+{
+    m_data = std::make_unique<MemoryMappedFile>(dataFile, MemoryMappedFile::readOnly);
+
+    const uint8* data = static_cast<const uint8*>(m_data->getData());
+    size_t size = m_data->getSize();
+
+    if (data == nullptr || size < CompressedBlockFile::FILE_HEADER_SIZE || memcmp(data, packedFileMagic, 6) != 0)
+        return false;
+
+    uint16 version;
+    uint32 numChannels, samplesPerBlock;
+    memcpy(&version, data + 6, sizeof(uint16));
+    memcpy(&numChannels, data + 8, sizeof(uint32));
+    memcpy(&samplesPerBlock, data + 12, sizeof(uint32));
+
+    if (version != CompressedBlockFile::FORMAT_VERSION || numChannels == 0 || samplesPerBlock == 0)
+        return false;
+
+    m_nChannels = numChannels;
+    m_samplesPerBlock = samplesPerBlock;
+    m_blockStarts.clear();
+    m_blockOffsets.clear();
+
+    if (indexFile.existsAsFile())
+    {
+        MemoryMappedFile index(indexFile, MemoryMappedFile::readOnly);
+        const uint8* indexData = static_cast<const uint8*>(index.getData());
+
+        if (indexData != nullptr && index.getSize() > 10)
+        {
+            // entries are read up to the end of the file, so a stale header count is harmless
+            uint16 headerLength;
+            memcpy(&headerLength, indexData + 8, sizeof(uint16));
+
+            size_t entryPos = 10 + headerLength;
+
+            for (; entryPos + 2 * sizeof(int64) <= index.getSize(); entryPos += 2 * sizeof(int64))
+            {
+                int64 entry[2];
+                memcpy(entry, indexData + entryPos, sizeof(entry));
+
+                uint32 payloadSize;
+
+                if (entry[1] < CompressedBlockFile::FILE_HEADER_SIZE || entry[1] + CompressedBlockFile::BLOCK_HEADER_SIZE > (int64) size)
+                    break;
+
+                memcpy(&payloadSize, data + entry[1], sizeof(uint32));
+
+                if (entry[1] + CompressedBlockFile::BLOCK_HEADER_SIZE + payloadSize > (int64) size)
+                    break;
+
+                m_blockStarts.add(entry[0]);
+                m_blockOffsets.add(entry[1]);
+            }
+        }
+    }
+
+    scanBlocks();
+
+    m_numSamples = 0;
+
+    if (m_blockOffsets.size() > 0)
+    {
+        uint32 lastNumSamples;
+        memcpy(&lastNumSamples, data + m_blockOffsets.getLast() + sizeof(uint32), sizeof(uint32));
+        m_numSamples = m_blockStarts.getLast() + lastNumSamples;
+    }
+
+    m_channelBuffer.malloc(m_samplesPerBlock);
+    m_cache.malloc(m_samplesPerBlock * m_nChannels);
+    m_cachedBlock = -1;
+
+    return true;
+}
+
+void CompressedBlockReader::scanBlocks()
+{
+    const uint8* data = static_cast<const uint8*>(m_data->getData());
+    uint64 size = m_data->getSize();
+
+    uint64 offset = CompressedBlockFile::FILE_HEADER_SIZE;
+    int64 nextStart = 0;
+
+    if (m_blockOffsets.size() > 0)
+    {
+        uint32 payloadSize, numSamples;
+        memcpy(&payloadSize, data + m_blockOffsets.getLast(), sizeof(uint32));
+        memcpy(&numSamples, data + m_blockOffsets.getLast() + sizeof(uint32), sizeof(uint32));
+
+        offset = m_blockOffsets.getLast() + CompressedBlockFile::BLOCK_HEADER_SIZE + payloadSize;
+        nextStart = m_blockStarts.getLast() + numSamples;
+    }
+
+    while (offset + CompressedBlockFile::BLOCK_HEADER_SIZE <= size)
+    {
+        uint32 payloadSize, numSamples;
+        memcpy(&payloadSize, data + offset, sizeof(uint32));
+        memcpy(&numSamples, data + offset + sizeof(uint32), sizeof(uint32));
+
+        if (offset + CompressedBlockFile::BLOCK_HEADER_SIZE + payloadSize > size
+            || numSamples == 0 || numSamples > (uint32) m_samplesPerBlock)
+            break; // incomplete block at the end of the file
+
+        m_blockStarts.add(nextStart);
+        m_blockOffsets.add(offset);
+
+        nextStart += numSamples;
+        offset += CompressedBlockFile::BLOCK_HEADER_SIZE + payloadSize;
+    }
+}
+
+bool CompressedBlockReader::loadBlock(int blockIndex)
+{
+    if (blockIndex == m_cachedBlock)
+        return true;
+
+    const uint8* block = static_cast<const uint8*>(m_data->getData()) + m_blockOffsets[blockIndex];
+
+    uint32 payloadSize, numSamples;
+    memcpy(&payloadSize, block, sizeof(uint32));
+    memcpy(&numSamples, block + sizeof(uint32), sizeof(uint32));
+
+    if (numSamples > (uint32) m_samplesPerBlock)
+        return false;
+
+    const uint8* channelSizes = block + CompressedBlockFile::BLOCK_HEADER_SIZE;
+    const uint8* encoded = channelSizes + m_nChannels * sizeof(uint32);
+
+    for (int ch = 0; ch < m_nChannels; ch++)
+    {
+        uint32 channelSize;
+        memcpy(&channelSize, channelSizes + ch * sizeof(uint32), sizeof(uint32));
+
+        if (DeltaPackCodec::decode(encoded, channelSize, numSamples, m_channelBuffer) == 0)
+        {
+            m_cachedBlock = -1;
+            return false;
+        }
+
+        for (uint32 i = 0; i < numSamples; i++)
+            m_cache[i * m_nChannels + ch] = m_channelBuffer[i];
+
+        encoded += channelSize;
+    }
+
+    m_cachedBlock = blockIndex;
+    m_cachedNumSamples = numSamples;
+
+    return true;
+}
+
+int CompressedBlockReader::read(int64 startSample, int numSamples, int16* interleavedOutput)
+{
+    int samplesRead = 0;
+
+    while (samplesRead < numSamples && startSample + samplesRead < m_numSamples)
+    {
+        int64 pos = startSample + samplesRead;
+
+        int blockIndex = int(std::upper_bound(m_blockStarts.begin(), m_blockStarts.end(), pos) - m_blockStarts.begin()) - 1;
+
+        if (blockIndex < 0 || !loadBlock(blockIndex))
+            break;
+
+        int offset = int(pos - m_blockStarts[blockIndex]);
+        int count = jmin(numSamples - samplesRead, m_cachedNumSamples - offset);
+
+        if (count <= 0)
+            break;
+
+        memcpy(interleavedOutput + samplesRead * m_nChannels,
+               m_cache + offset * m_nChannels,
+               count * m_nChannels * sizeof(int16));
+
+        samplesRead += count;
+    }
+
+    return samplesRead;
+}
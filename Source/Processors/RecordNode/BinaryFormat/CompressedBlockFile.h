@@ -0,0 +1,167 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2022 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef COMPRESSEDBLOCKFILE_H
+#define COMPRESSEDBLOCKFILE_H
+
+#include "NpyFile.h"
+#include "DeltaPackCodec.h"
+#include "../../../Utils/Utils.h"
+
+#include "../../PluginManager/PluginClass.h"
+
+#include <atomic>
+
+/**
+
+    Writes int16 data for one stream to a compressed, seekable file.
+
+    Samples are gathered into blocks of samplesPerBlock samples per channel.
+    Full blocks are compressed with the DeltaPackCodec on a shared ThreadPool,
+    and written to disk in order by the thread that calls writeChannel().
+
+    File layout:
+
+        header:  "OEPACK" | uint16 version | uint32 numChannels | uint32 samplesPerBlock
+        blocks:  uint32 payloadSize | uint32 numSamples | numChannels x uint32 encoded channel size
+                 | encoded channels (channel-major)
+
+    The byte offset and first sample number of every block are also written
+    to an (N, 2) int64 .npy index, so readers can seek without scanning.
+
+    @see CompressedBlockReader
+
+ */
+class PLUGIN_API CompressedBlockFile
+{
+public:
+
+    /** Creates a file with nChannels; compression jobs run on the given pool */
+    CompressedBlockFile(int nChannels, ThreadPool* pool, int samplesPerBlock = 4096);
+
+    /** Destructor (compresses and writes any remaining data) */
+    ~CompressedBlockFile();
+
+    /** Opens the data file and the block index file at the requested paths */
+    bool openFile(String filename, String indexFilename);
+
+    /** Writes nSamples of data for a particular channel */
+    bool writeChannel(uint64 startPos, int channel, int16* data, int nSamples);
+
+    /** Size of the file header, in bytes */
+    static const int FILE_HEADER_SIZE = 16;
+
+    /** Size of the fixed part of each block header, in bytes */
+    static const int BLOCK_HEADER_SIZE = 8;
+
+    /** Current file format version */
+    static const uint16 FORMAT_VERSION = 1;
+
+private:
+
+    struct Block;
+
+    /** Returns the block that holds a given sample, creating it if necessary */
+    Block* getBlock(int64 blockIndex);
+
+    /** Hands a block to the compression pool */
+    void submitBlock(Block* block, int numSamples);
+
+    /** Writes compressed blocks to disk, in order; optionally waits for all blocks to finish */
+    void writeCompressedBlocks(bool waitForAll);
+
+    std::unique_ptr<FileOutputStream> m_file;
+    std::unique_ptr<NpyFile> m_indexFile;
+    ThreadPool* m_pool;
+
+    const int m_nChannels;
+    const int m_samplesPerBlock;
+
+    OwnedArray<Block> m_blocks;
+    OwnedArray<Block> m_freeBlocks;
+    int64 m_firstBlockIndex;
+    int m_numSubmitted;
+
+    /** Compression jobs that have not returned yet; the destructor waits for them */
+    std::atomic<int> m_numJobsRunning;
+
+    WaitableEvent m_blockFinished;
+
+    /** Maximum number of blocks waiting for compression before the writer blocks */
+    const int maxBlocksInFlight;
+
+};
+
+/**
+
+    Reads a file written by CompressedBlockFile.
+
+    Blocks are located with the .npy index; any blocks that follow the last
+    indexed one (e.g. after a crash) are found by scanning the block headers.
+    The most recently used block is kept decoded in memory.
+
+ */
+class PLUGIN_API CompressedBlockReader
+{
+public:
+
+    /** Constructor */
+    CompressedBlockReader();
+
+    /** Opens a compressed data file, and its index if it exists */
+    bool open(File dataFile, File indexFile);
+
+    /** Returns the number of channels in the file */
+    int getNumChannels() const { return m_nChannels; }
+
+    /** Returns the total number of samples per channel */
+    int64 getNumSamples() const { return m_numSamples; }
+
+    /** Reads numSamples interleaved samples starting at startSample; returns the number of samples read */
+    int read(int64 startSample, int numSamples, int16* interleavedOutput);
+
+private:
+
+    /** Decodes a block into the cache */
+    bool loadBlock(int blockIndex);
+
+    /** Adds the blocks that follow the last known one, by scanning their headers */
+    void scanBlocks();
+
+    std::unique_ptr<MemoryMappedFile> m_data;
+
+    Array<int64> m_blockStarts;
+    Array<int64> m_blockOffsets;
+
+    int m_nChannels;
+    int m_samplesPerBlock;
+    int64 m_numSamples;
+
+    int m_cachedBlock;
+    int m_cachedNumSamples;
+    HeapBlock<int16> m_channelBuffer;
+    HeapBlock<int16> m_cache;
+
+};
+
+#endif // COMPRESSEDBLOCKFILE_H
@@ -0,0 +1,54 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2022 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "CompressedRecording.h"
+
+CompressedRecording::CompressedRecording()
+{
+    m_compressContinuous = true;
+}
+
+String CompressedRecording::getEngineId() const
+{
+	return "COMPRESSED";
+}
+
+RecordEngineManager* CompressedRecording::getEngineManager()
+{
+    RecordEngineManager* man = new RecordEngineManager("COMPRESSED", "Binary (compressed)",
+                                                       &(engineFactory<CompressedRecording>));
+    EngineParameter* param;
+    param = new EngineParameter(EngineParameter::BOOL, 0, "Record TTL full words", true);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT, 1, "Compression threads",
+                                jmax(1, SystemStats::getNumCpus() / 2), 1, SystemStats::getNumCpus());
+    man->addParameter(param);
+    return man;
+}
+
+void CompressedRecording::setParameter(EngineParameter& parameter)
+{
+    BinaryRecording::setParameter(parameter);
+
+	intParameter(1, m_compressionThreads);
+}
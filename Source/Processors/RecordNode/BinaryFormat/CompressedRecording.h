@@ -0,0 +1,58 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2022 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef COMPRESSEDRECORDING_H
+#define COMPRESSEDRECORDING_H
+
+#include "BinaryRecording.h"
+
+/**
+
+    Variant of the Binary format that stores continuous data losslessly
+    compressed (see DeltaPackCodec), in a "continuous.packed" file with a
+    "block_index.npy" block index for each stream.
+
+    Events, spikes, and the structure.oebin file are identical to those
+    written by the BinaryRecording engine. The File Reader can play back
+    both formats.
+
+ */
+class CompressedRecording : public BinaryRecording
+{
+public:
+
+	/** Constructor */
+	CompressedRecording();
+
+	/** Returns the unique identifier of this RecordEngine */
+	String getEngineId() const override;
+
+    /** Launches the manager for this Record Engine, and instantiates any parameters */
+    static RecordEngineManager* getEngineManager();
+
+	/** Sets an engine parameter (TTL word writing bool, number of compression threads) */
+	void setParameter(EngineParameter& parameter) override;
+
+};
+
+#endif
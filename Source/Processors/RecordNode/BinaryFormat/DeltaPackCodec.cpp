@@ -0,0 +1,194 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2022 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "DeltaPackCodec.h"
+
+namespace
+{
+    inline uint16 zigzag(uint16 value)
+    {
+        // same bits as (v << 1) ^ (v >> 15) for int16 v, without shifting a negative value
+        return (uint16) ((value << 1) ^ (0 - (value >> 15)));
+    }
+
+    inline uint16 unzigzag(uint16 value)
+    {
+        return (uint16) ((value >> 1) ^ (uint16) -(int16) (value & 1));
+    }
+
+    inline int bitWidth(uint16 value)
+    {
+        int bits = 0;
+
+        while (value != 0)
+        {
+            bits++;
+            value >>= 1;
+        }
+
+        return bits;
+    }
+
+    inline uint16 predict(const int16* samples, int i, int order)
+    {
+        if (i == 0)
+            return 0;
+
+        if (order == 1 || i == 1)
+            return (uint16) samples[i - 1];
+
+        return (uint16) (2 * samples[i - 1] - samples[i - 2]);
+    }
+}
+
+size_t DeltaPackCodec::getMaxEncodedSize(int numSamples)
+{
+    int numFrames = (numSamples + FRAME_SIZE - 1) / FRAME_SIZE;
+
+    return 1 + numFrames + numSamples * sizeof(uint16);
+}
+
+void DeltaPackCodec::computeResiduals(const int16* input, int numSamples, int order, uint16* residuals)
+{
+    for (int i = 0; i < numSamples; i++)
+        residuals[i] = zigzag((uint16) ((uint16) input[i] - predict(input, i, order)));
+}
+
+int64 DeltaPackCodec::getPackedBits(const uint16* residuals, int numSamples)
+{
+    int64 totalBits = 0;
+
+    for (int start = 0; start < numSamples; start += FRAME_SIZE)
+    {
+        int count = jmin(FRAME_SIZE, numSamples - start);
+        uint16 mask = 0;
+
+        for (int i = 0; i < count; i++)
+            mask |= residuals[start + i];
+
+        totalBits += 8 + int64(count) * bitWidth(mask);
+    }
+
+    return totalBits;
+}
+
+size_t DeltaPackCodec::encode(const int16* input, int numSamples, uint8* output)
+{
+    HeapBlock<uint16> firstOrder(numSamples);
+    HeapBlock<uint16> secondOrder(numSamples);
+
+    computeResiduals(input, numSamples, 1, firstOrder);
+    computeResiduals(input, numSamples, 2, secondOrder);
+
+    bool useSecondOrder = getPackedBits(secondOrder, numSamples) < getPackedBits(firstOrder, numSamples);
+    const uint16* residuals = useSecondOrder ? secondOrder.getData() : firstOrder.getData();
+
+    uint8* out = output;
+    *out++ = useSecondOrder ? 2 : 1;
+
+    for (int start = 0; start < numSamples; start += FRAME_SIZE)
+    {
+        int count = jmin(FRAME_SIZE, numSamples - start);
+        uint16 mask = 0;
+
+        for (int i = 0; i < count; i++)
+            mask |= residuals[start + i];
+
+        int bits = bitWidth(mask);
+        *out++ = (uint8) bits;
+
+        if (bits == 0)
+            continue;
+
+        /* Pack LSB-first through a 64-bit accumulator */
+        uint64 accumulator = 0;
+        int accumulatedBits = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            accumulator |= uint64(residuals[start + i]) << accumulatedBits;
+            accumulatedBits += bits;
+
+            while (accumulatedBits >= 8)
+            {
+                *out++ = (uint8) accumulator;
+                accumulator >>= 8;
+                accumulatedBits -= 8;
+            }
+        }
+
+        if (accumulatedBits > 0)
+            *out++ = (uint8) accumulator;
+    }
+
+    return out - output;
+}
+
+size_t DeltaPackCodec::decode(const uint8* input, size_t inputSize, int numSamples, int16* output)
+{
+    const uint8* in = input;
+    const uint8* end = input + inputSize;
+
+    if (in >= end)
+        return 0;
+
+    int order = *in++;
+
+    if (order != 1 && order != 2)
+        return 0;
+
+    for (int start = 0; start < numSamples; start += FRAME_SIZE)
+    {
+        int count = jmin(FRAME_SIZE, numSamples - start);
+
+        if (in >= end)
+            return 0;
+
+        int bits = *in++;
+
+        if (bits > 16 || in + (count * bits + 7) / 8 > end)
+            return 0;
+
+        uint64 accumulator = 0;
+        int accumulatedBits = 0;
+        const uint16 mask = (uint16) ((1u << bits) - 1);
+
+        for (int i = 0; i < count; i++)
+        {
+            while (accumulatedBits < bits)
+            {
+                accumulator |= uint64(*in++) << accumulatedBits;
+                accumulatedBits += 8;
+            }
+
+            uint16 residual = (uint16) (accumulator & mask);
+            accumulator >>= bits;
+            accumulatedBits -= bits;
+
+            int index = start + i;
+            output[index] = (int16) (uint16) (unzigzag(residual) + predict(output, index, order));
+        }
+    }
+
+    return in - input;
+}
@@ -0,0 +1,73 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2022 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef DELTAPACKCODEC_H
+#define DELTAPACKCODEC_H
+
+#include "../../../../JuceLibraryCode/JuceHeader.h"
+#include "../../PluginManager/OpenEphysPlugin.h"
+
+/**
+
+    Lossless codec for blocks of int16 samples from a single channel.
+
+    Each sample is predicted from the previous ones (first- or second-order
+    linear prediction, whichever fits the block better), and the residuals
+    are zigzag-encoded and bit-packed in frames of FRAME_SIZE values, each
+    frame using the smallest bit width that holds all of its residuals.
+
+    All arithmetic is done modulo 2^16, so any int16 sequence round-trips
+    exactly.
+
+    Encoded layout:
+        uint8   predictor order (1 or 2)
+        frames: uint8 bit width, followed by ceil(n * width / 8) bytes
+
+ */
+class PLUGIN_API DeltaPackCodec
+{
+public:
+
+    /** Number of residuals that share one bit width */
+    static const int FRAME_SIZE = 128;
+
+    /** Returns an upper bound on the encoded size of numSamples samples */
+    static size_t getMaxEncodedSize(int numSamples);
+
+    /** Encodes numSamples samples into output, and returns the number of bytes written */
+    static size_t encode(const int16* input, int numSamples, uint8* output);
+
+    /** Decodes numSamples samples into output, reading at most inputSize bytes.
+        Returns the number of bytes consumed, or 0 if the input is invalid. */
+    static size_t decode(const uint8* input, size_t inputSize, int numSamples, int16* output);
+
+private:
+
+    /** Computes the residuals for a given predictor order */
+    static void computeResiduals(const int16* input, int numSamples, int order, uint16* residuals);
+
+    /** Returns the number of bits needed to store each frame of residuals, summed over all frames */
+    static int64 getPackedBits(const uint16* residuals, int numSamples);
+};
+
+#endif // DELTAPACKCODEC_H
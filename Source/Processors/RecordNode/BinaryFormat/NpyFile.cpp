@@ -31,7 +31,105 @@ https://github.com/numpy/numpy/blob/master/numpy/lib/format.py
 
 #include "NpyFile.h"
 
-NpyFile::NpyFile(String path, const Array<NpyType>& typeList)
+#if ! JUCE_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* Width of the record count in BACKGROUND_HEADER mode (enough for any int64) */
+#define SHAPE_COUNT_WIDTH 20
+
+/* Maximum delay between data reaching the OS and the header reflecting it */
+#define HEADER_FLUSH_INTERVAL_MS 500
+
+/* BACKGROUND_HEADER files hand their data to the OS in writes of at least this size */
+#define PENDING_WRITE_SIZE (64 * 1024)
+
+/**
+    Background thread that periodically syncs the data of every
+    BACKGROUND_HEADER file to disk and then writes the committed record
+    count into its header, so the record thread never waits on the disk.
+
+    Started when the first file registers, stopped when the last one
+    is destroyed.
+*/
+class NpyFile::HeaderFlusher : public Thread
+{
+public:
+
+    HeaderFlusher() : Thread("NpyFile Header Flusher") { }
+
+    static void addFile(NpyFile* file)
+    {
+        const ScopedLock sl(getLock());
+
+        std::unique_ptr<HeaderFlusher>& flusher = getInstance();
+
+        if (flusher == nullptr)
+        {
+            flusher = std::make_unique<HeaderFlusher>();
+            flusher->startThread();
+        }
+
+        const ScopedLock fl(flusher->filesLock);
+        flusher->files.add(file);
+    }
+
+    static void removeFile(NpyFile* file)
+    {
+        std::unique_ptr<HeaderFlusher> stoppedFlusher;
+
+        {
+            const ScopedLock sl(getLock());
+
+            std::unique_ptr<HeaderFlusher>& flusher = getInstance();
+
+            if (flusher == nullptr)
+                return;
+
+            const ScopedLock fl(flusher->filesLock);
+            flusher->files.removeFirstMatchingValue(file);
+
+            if (flusher->files.size() == 0)
+                stoppedFlusher = std::move(flusher);
+        }
+
+        if (stoppedFlusher != nullptr)
+            stoppedFlusher->stopThread(2 * HEADER_FLUSH_INTERVAL_MS);
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            wait(HEADER_FLUSH_INTERVAL_MS);
+
+            const ScopedLock fl(filesLock);
+
+            for (auto file : files)
+                file->writeCommittedHeader();
+        }
+    }
+
+private:
+
+    static CriticalSection& getLock()
+    {
+        static CriticalSection lock;
+        return lock;
+    }
+
+    static std::unique_ptr<HeaderFlusher>& getInstance()
+    {
+        static std::unique_ptr<HeaderFlusher> instance;
+        return instance;
+    }
+
+    CriticalSection filesLock;
+    Array<NpyFile*> files;
+};
+
+NpyFile::NpyFile(String path, const Array<NpyType>& typeList, HeaderMode mode)
 {
     m_dim1 = 1;
     m_dim2 = 1;
@@ -46,15 +144,18 @@ NpyFile::NpyFile(String path, const Array<NpyType>& typeList)
             m_dim1 = type.getTypeLength();
     }
 
-    if (!openFile(path))
+    if (!openFile(path, mode))
         return;
     
     writeHeader(typeList);
+
+    if (m_backgroundHeader)
+        HeaderFlusher::addFile(this);
 }
 
-NpyFile::NpyFile(String path, NpyType type, unsigned int dim)
+NpyFile::NpyFile(String path, NpyType type, unsigned int dim, HeaderMode mode)
 {
-    if (!openFile(path))
+    if (!openFile(path, mode))
         return;
 
     Array<NpyType> typeList;
@@ -62,9 +163,12 @@ NpyFile::NpyFile(String path, NpyType type, unsigned int dim)
     m_dim1 = dim;
     m_dim2 = type.getTypeLength();
     writeHeader(typeList);
+
+    if (m_backgroundHeader)
+        HeaderFlusher::addFile(this);
 }
 
-bool NpyFile::openFile(String path)
+bool NpyFile::openFile(String path, HeaderMode mode)
 {
     File file(path);
     Result res = file.create();
@@ -76,7 +180,21 @@ bool NpyFile::openFile(String path)
         LOGD("Re-creating file: ", path);
     }
 
-    m_file = file.createOutputStream();
+#if ! JUCE_WINDOWS
+    if (mode == BACKGROUND_HEADER)
+    {
+        m_headerFd = ::open(path.toRawUTF8(), O_WRONLY);
+
+        if (m_headerFd >= 0)
+            m_backgroundHeader = true;
+        else
+            LOGD("Unable to open ", path, " for background header updates, updating in place");
+    }
+#endif
+
+    // in BACKGROUND_HEADER mode the data is buffered in m_pendingData instead, so that
+    // every write to the stream reaches the OS and the committed count is never ahead of it
+    m_file = m_backgroundHeader ? file.createOutputStream(0) : file.createOutputStream();
     
     if (!m_file)
         return false;
@@ -86,12 +204,18 @@ bool NpyFile::openFile(String path)
     return true;
 }
 
-String NpyFile::getShapeString()
+String NpyFile::getShapeString(int64 recordCount) const
 {
     String shape;
     shape.preallocateBytes(32);
     shape = "(";
-    shape += String(m_recordCount) + ",";
+
+    // a fixed-width count keeps the header length constant, so it can be overwritten at any time
+    if (m_backgroundHeader)
+        shape += String(recordCount).paddedRight(' ', SHAPE_COUNT_WIDTH) + ",";
+    else
+        shape += String(recordCount) + ",";
+
     if (m_dim1 > 1)
     {
         shape += " " + String(m_dim1) + ",";
@@ -138,7 +262,7 @@ void NpyFile::writeHeader(const Array<NpyType>& typeList)
     // save byte offset of shape field in .npy file
     // magic + header length field + current string header length:
     m_shapePos = magicLen + sizeof(uint16) + strHeader.length();
-    strHeader += getShapeString(); // inits to 0 records, i.e. 1st dim has length 0
+    strHeader += getShapeString(0); // inits to 0 records, i.e. 1st dim has length 0
     int baseHeaderLen = magicLen + sizeof(uint16) + strHeader.length() + 1; // +1 for newline
     int padlen = nbytesAlign - (baseHeaderLen % nbytesAlign);
     strHeader = strHeader.paddedRight(' ', strHeader.length() + padlen);
@@ -165,7 +289,7 @@ void NpyFile::updateHeader()
         int64 currentPos = m_file->getPosition(); // returns int64, necessary for big files
         if (m_file->setPosition(m_shapePos))
         {
-            String newShape = getShapeString();
+            String newShape = getShapeString(m_recordCount);
             if (m_shapePos + newShape.getNumBytesAsUTF8() + 1 > m_headerLen) // +1 for newline
             {
                 std::cerr << "Error. Header has grown too big to update in-place " << std::endl;
@@ -183,14 +307,77 @@ void NpyFile::updateHeader()
 
 }
 
+void NpyFile::writeCommittedHeader()
+{
+#if ! JUCE_WINDOWS
+    int64 count = m_committedCount.load(std::memory_order_acquire);
+
+    if (count == m_headerCount)
+        return;
+
+    // make the data durable before the header claims it
+#if JUCE_LINUX
+    ::fdatasync(m_headerFd);
+#else
+    ::fsync(m_headerFd);
+#endif
+
+    // a single positional write: the stream's write position is left untouched
+    String newShape = getShapeString(count);
+
+    if (::pwrite(m_headerFd, newShape.toRawUTF8(), newShape.getNumBytesAsUTF8(), (off_t) m_shapePos) < 0)
+    {
+        std::cerr << "Error. Unable to update file header "
+            << m_file->getFile().getFullPathName() << std::endl;
+        return;
+    }
+
+    m_headerCount = count;
+#endif
+}
+
 NpyFile::~NpyFile()
 {
+    if (!m_okOpen)
+        return;
+
+    if (m_backgroundHeader)
+    {
+        HeaderFlusher::removeFile(this);
+
+#if ! JUCE_WINDOWS
+        ::close(m_headerFd);
+#endif
+
+        writePendingData();
+    }
+
     updateHeader();
 }
 
 void NpyFile::writeData(const void* data, size_t size)
 {
-    m_file->write(data, size);
+    if (m_backgroundHeader)
+    {
+        m_pendingData.write(data, size);
+
+        if (m_pendingData.getDataSize() >= PENDING_WRITE_SIZE)
+            writePendingData();
+    }
+    else
+    {
+        m_file->write(data, size);
+    }
+}
+
+void NpyFile::writePendingData()
+{
+    if (m_pendingData.getDataSize() == 0)
+        return;
+
+    // the stream is unbuffered, so this is a single write() with no fsync
+    m_file->write(m_pendingData.getData(), m_pendingData.getDataSize());
+    m_pendingData.reset();
 }
 
 void NpyFile::increaseRecordCount(int count)
@@ -198,7 +385,20 @@ void NpyFile::increaseRecordCount(int count)
     int64 old_recordCount = m_recordCount;
     m_recordCount += count;
     if ((old_recordCount / recordBufferSize) != (m_recordCount / recordBufferSize))
-        updateHeader(); // crossed recordBufferSize threshold, update header
+    {
+        // crossed recordBufferSize threshold, update header
+        if (m_backgroundHeader)
+        {
+            // hand the buffered data to the OS (without syncing it); the flusher
+            // syncs it and then publishes the new count in the header
+            writePendingData();
+            m_committedCount.store(m_recordCount, std::memory_order_release);
+        }
+        else
+        {
+            updateHeader();
+        }
+    }
 }
 
 NpyType::NpyType(String n, BaseType t, size_t l)
@@ -38,6 +38,8 @@ https://github.com/numpy/numpy/blob/master/numpy/lib/format.py
 #include "../../PluginManager/PluginClass.h"
 #include "../../Settings/Metadata.h"
 
+#include <atomic>
+
 /**
 
  Represents the data type (e.g. <i8) of a particular file
@@ -84,12 +86,24 @@ private:
 class PLUGIN_API NpyFile
 {
 public:
+
+    /** How the record count in the header is kept up to date while writing */
+    enum HeaderMode
+    {
+        /** Seek back and rewrite the header every recordBufferSize records */
+        IN_PLACE_HEADER,
+
+        /** Keep a fixed-width shape field that a background thread updates with
+            positional writes, without moving the sequential write position.
+            Falls back to IN_PLACE_HEADER where positional writes are not available. */
+        BACKGROUND_HEADER
+    };
     
     /** Constructor for an array of types */
-    NpyFile(String path, const Array<NpyType>& typeList);
+    NpyFile(String path, const Array<NpyType>& typeList, HeaderMode mode = IN_PLACE_HEADER);
     
     /** Constructor for a 1-dimensional file with a single type */
-    NpyFile(String path, NpyType type, unsigned int dim = 1);
+    NpyFile(String path, NpyType type, unsigned int dim = 1, HeaderMode mode = IN_PLACE_HEADER);
     
     /** Destructor */
     ~NpyFile();
@@ -99,19 +113,28 @@ public:
     
     /** Increases the count of the number of records in the file (must match the number of samples written) */
     void increaseRecordCount(int count = 1);
+
 private:
+
+    class HeaderFlusher;
     
     /** Opens the file at a specified path */
-    bool openFile(String path);
+    bool openFile(String path, HeaderMode mode);
     
     /** Returns a string describing the underlying array shape */
-    String getShapeString();
+    String getShapeString(int64 recordCount) const;
     
     /** Writes the initial file header */
     void writeHeader(const Array<NpyType>& typeList);
     
     /** Updates the header with the total number of samples */
     void updateHeader();
+
+    /** Syncs the data and writes the last committed record count into the header (called by the HeaderFlusher) */
+    void writeCommittedHeader();
+
+    /** BACKGROUND_HEADER mode: hands the buffered data to the OS */
+    void writePendingData();
     
     std::unique_ptr<FileOutputStream> m_file;
     int64 m_headerLen;
@@ -124,6 +147,15 @@ private:
     /** flush file buffer to disk and update the .npy header every this many records: */
     const int recordBufferSize{ 1024 };
 
+    /** BACKGROUND_HEADER mode: data not yet handed to the OS, number of records known to
+        have been handed to the OS, the count currently stored in the header, and the
+        descriptor used for syncing and positional writes */
+    bool m_backgroundHeader{ false };
+    MemoryOutputStream m_pendingData;
+    std::atomic<int64> m_committedCount{ 0 };
+    int64 m_headerCount{ 0 };
+    int m_headerFd{ -1 };
+
 };
 
 #endif
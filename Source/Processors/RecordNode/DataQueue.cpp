@@ -54,6 +54,7 @@ void DataQueue::setTimestampStreamCount(int nStreams)
 		m_FTSFifos.add(new AbstractFifo(m_maxSize));
 	}
 	m_FTSBuffer.setSize(nStreams, m_maxSize);
+	m_sampleNumberBuffer.malloc(size_t(nStreams) * m_maxSize);
 }
 
 void DataQueue::setChannelCount(int nChans)
@@ -105,6 +106,7 @@ void DataQueue::resize(int nBlocks)
 	}
 	m_buffer.setSize(m_numChans, size);
 	m_FTSBuffer.setSize(m_numFTSChans, size);
+	m_sampleNumberBuffer.malloc(size_t(m_numFTSChans) * size);
 }
 
 void DataQueue::fillSampleNumbers(int channel, int index, int size, int64 sampleNumber)
@@ -148,7 +150,7 @@ void DataQueue::fillSampleNumbers(int channel, int index, int size, int64 sample
 	//	std::cout << "DataQueue::latestSampleNumber: " << latestSampleNumber << std::endl;
 }
 
-float DataQueue::writeSynchronizedTimestamps(double start, double step, int destChannel, int64 nSamples)
+float DataQueue::writeSynchronizedTimestamps(double start, double step, int destChannel, int64 nSamples, int64 firstSampleNumber)
 {
 
 	int index1, size1, index2, size2;
@@ -165,9 +167,12 @@ float DataQueue::writeSynchronizedTimestamps(double start, double step, int dest
 	//LOGD("DataQueue::writeSynchronizedTimestampChannel: ", start);
 	//std::cout << destChannel << " " << nSamples << " " << start << " " << start + (double)(size1 * step) + double(size2 * step) << std::endl;
 
+	int64* sampleNumbers = m_sampleNumberBuffer + size_t(destChannel) * m_maxSize;
+
 	for (int i = 0; i < size1; i++)
 	{
 		m_FTSBuffer.setSample(destChannel, index1+i, start+(double)i*step);
+		sampleNumbers[index1 + i] = firstSampleNumber + i;
 	}
 
 	if (size2 > 0)
@@ -175,6 +180,7 @@ float DataQueue::writeSynchronizedTimestamps(double start, double step, int dest
 		for (int i = 0; i < size2; i++)
 		{
 			m_FTSBuffer.setSample(destChannel, index2 + i, start+(double)(size1*step) + double(i*step));
+			sampleNumbers[index2 + i] = firstSampleNumber + size1 + i;
 		}
 	}
 
@@ -224,6 +230,16 @@ float DataQueue::writeChannel(const AudioBuffer<float>& buffer,
 	return 1.0f - (float)m_fifos[destChannel]->getFreeSpace() / (float)m_fifos[destChannel]->getTotalSize();
 }
 
+float DataQueue::getMaxUsage() const
+{
+	float usage = 0.0f;
+
+	for (auto fifo : m_fifos)
+		usage = jmax(usage, 1.0f - (float)fifo->getFreeSpace() / (float)fifo->getTotalSize());
+
+	return usage;
+}
+
 /*
 We could copy the internal circular buffer to an external one, as DataBuffer does. This class
 is, however, intended for disk writing, which is one of the most CPU-critical systems. Just
@@ -241,6 +257,11 @@ const SynchronizedTimestampBuffer& DataQueue::getTimestampBufferReference() cons
 	return m_FTSBuffer;
 }
 
+const int64* DataQueue::getSampleNumberReadPointer(int stream, int index) const
+{
+	return m_sampleNumberBuffer + size_t(stream) * m_maxSize + index;
+}
+
 bool DataQueue::startRead(Array<CircularBufferIndexes>& dataIndexes, 
 		Array<CircularBufferIndexes>& ftsIndexes, 
 		Array<int64>& sampleNumbers, int nMax)
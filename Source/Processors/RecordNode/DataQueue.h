@@ -70,8 +70,8 @@ public:
 	/** Writes an array of data for one channel */
 	float writeChannel(const AudioBuffer<float>& buffer, int srcChannel, int destChannel, int nSamples, int64 sampleNumbers);
 
-	/** Writes an array of timestamps for one stream */
-	float writeSynchronizedTimestamps(double start, double step, int destChannel, int64 nSamples);
+	/** Writes an array of timestamps and sample numbers for one stream */
+	float writeSynchronizedTimestamps(double start, double step, int destChannel, int64 nSamples, int64 firstSampleNumber);
 
 	/** Start reading data for one channel */
 	bool startRead(Array<CircularBufferIndexes>& dataIndexes, Array<CircularBufferIndexes>& ftsIndexes, Array<int64>& sampleNumbers, int nMax);
@@ -85,9 +85,16 @@ public:
 	/** Returns a reference to the timestamp buffer */
 	const SynchronizedTimestampBuffer& getTimestampBufferReference() const;
 
+	/** Returns a pointer to the sample numbers of one stream, starting at a given index
+		(the sample numbers are stored alongside the synchronized timestamps) */
+	const int64* getSampleNumberReadPointer(int stream, int index) const;
+
 	/** Returns the current block size*/
 	int getBlockSize();
 
+	/** Returns the fill fraction (0-1) of the fullest continuous channel buffer */
+	float getMaxUsage() const;
+
 private:
 
 	/** Fills the sample number buffer for a given channel */
@@ -100,6 +107,7 @@ private:
 
 	AudioSampleBuffer m_buffer;
 	SynchronizedTimestampBuffer m_FTSBuffer;
+	HeapBlock<int64> m_sampleNumberBuffer;
 
 	Array<int> m_readSamples;
 	Array<int> m_readFTSSamples;
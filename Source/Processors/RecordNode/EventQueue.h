@@ -26,118 +26,217 @@
 
 #include <JuceHeader.h>
 
-#include <vector>
+#include <atomic>
 
 #include "../Events/Spike.h"
 
-template <class MsgContainer>
-class AsyncEventMessage :
-	public ReferenceCountedObject
-{
-public:
-	AsyncEventMessage(const MsgContainer& m, int64 t, int extra) : 
-		ReferenceCountedObject(),
-		m_data(m),
-		m_timestamp(t),
-		m_extra(extra)
-	{}
-
-	~AsyncEventMessage() {};
+/**
+	Single-producer / single-consumer queue used to pass serialized events and
+	spikes from the RecordNode (audio thread) to the RecordThread.
 
-	const MsgContainer& getData() const { return m_data;  }
-	const int64& getTimestamp() const { return m_timestamp; }
-	const int& getExtra() const { return m_extra;  }
-
-private:
-	const MsgContainer m_data;
-	const int64 m_timestamp;
-	const int m_extra;
-
-};
+	Packets are stored inline in a fixed-size byte ring, each one preceded by a
+	small header holding the packet size, its sample number and an extra value
+	(e.g. the event or electrode index). Nothing is allocated after construction:
+	events can be serialized directly into the ring, and the RecordThread reads
+	them back in place.
 
-template <class EventClass>
+	If the ring is full, incoming packets are dropped and counted, so the
+	RecordNode can report the overrun.
+*/
 class EventQueue
 {
 public:
-	typedef AsyncEventMessage<EventClass> EventContainer;
-	typedef ReferenceCountedObjectPtr<EventContainer> EventClassPtr;
 
-	EventQueue(int size) :
-		m_fifo(size)
+	/** Creates a queue that can hold up to capacityInBytes of packet data */
+	EventQueue(size_t capacityInBytes) :
+		m_capacity(roundUpToRecordAlignment(capacityInBytes))
 	{
-		m_data.resize(size);
+		m_data.allocate(m_capacity, true);
+		reset();
 	}
 
 	~EventQueue()
 	{}
 
+	/** Returns the number of packets waiting to be read */
 	int getRemainingEvents() const
 	{
-		return m_fifo.getNumReady();
+		return m_numEvents.load(std::memory_order_acquire);
+	}
+
+	/** Returns the number of packets dropped because the queue was full */
+	int64 getNumDroppedEvents() const
+	{
+		return m_droppedEvents.load(std::memory_order_relaxed);
 	}
 
+	/** Returns the highest number of bytes that were in use at any time */
+	size_t getHighWaterMark() const
+	{
+		return m_highWaterMark.load(std::memory_order_relaxed);
+	}
+
+	/** Empties the queue and clears the overrun counters. Must not be called while
+		either thread is using the queue. */
 	void reset()
 	{
-		m_data.clear();
-		m_data.resize(m_fifo.getTotalSize());
+		m_writePosition = 0;
+		m_readPosition = 0;
+		m_numEvents = 0;
+		m_droppedEvents = 0;
+		m_highWaterMark = 0;
+	}
+
+	/** Copies a serialized packet into the queue */
+	bool addEvent(const uint8* data, size_t size, int64 sampleNumber, int extra = 0)
+	{
+		uint8* destination = prepareToWrite(size, sampleNumber, extra);
+
+		if (destination == nullptr)
+			return false;
+
+		memcpy(destination, data, size);
+		finishedWrite();
+
+		return true;
 	}
 
-	void resize(int size)
+	/** Copies an EventPacket into the queue */
+	bool addEvent(const EventPacket& packet, int64 sampleNumber, int extra = 0)
 	{
-		m_data.clear();
-		m_fifo.setTotalSize(size);
-		m_data.resize(size);
+		return addEvent(packet.getRawData(), (size_t) packet.getRawDataSize(), sampleNumber, extra);
 	}
 
-	void addEvent(const EventClass& ev, int64 t, int extra = 0)
+	/** Serializes an event (or spike) directly into the queue */
+	bool addEvent(const EventBase& event, size_t size, int64 sampleNumber, int extra = 0)
 	{
-		int pos1, size1, pos2, size2;
-		size1 = 0;
-		m_fifo.prepareToWrite(1, pos1, size1, pos2, size2);
+		uint8* destination = prepareToWrite(size, sampleNumber, extra);
 
-		/* This means there is a buffer overrun. Instead of overwritting the existing data and risking a collision of both threads
-			we just skip the incoming samples. TODO: use this to notify of the overrun and act consequently   */
-		if (size1 > 0)
-		{
-			m_data[pos1] = new EventContainer(ev, t, extra);
-			m_fifo.finishedWrite(1);
-		}
+		if (destination == nullptr)
+			return false;
+
+		event.serialize(destination, size);
+		finishedWrite();
+
+		return true;
 	}
 
-	int getEvents(std::vector<EventClassPtr>& vec, int max)
+	/** Calls callback(const uint8* data, size_t size, int64 sampleNumber, int extra)
+		for up to maxEvents packets (all available packets if maxEvents <= 0).
+		The data pointer is only valid during the callback.
+
+		Returns the number of packets read.
+	*/
+	template <typename Callback>
+	int readEvents(int maxEvents, Callback&& callback)
 	{
-		int pos1, size1, pos2, size2;
-		int numAvailable = m_fifo.getNumReady();
-		int numToRead = ((max < numAvailable) && (max > 0)) ? max : numAvailable;
-		m_fifo.prepareToRead(numToRead, pos1, size1, pos2, size2);
-		vec.resize(numToRead);
-		for (int i = 0; i < size1; ++i)
-		{
-			vec[i] = m_data[pos1 + i];
-		}
-		if (size2 > 0)
+		int numAvailable = m_numEvents.load(std::memory_order_acquire);
+		int numToRead = ((maxEvents < numAvailable) && (maxEvents > 0)) ? maxEvents : numAvailable;
+
+		size_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+
+		for (int i = 0; i < numToRead; ++i)
 		{
-			for (int i = 0; i < size2; ++i)
+			const RecordHeader* header = reinterpret_cast<const RecordHeader*>(m_data + (readPosition % m_capacity));
+
+			if (header->size == WRAP_MARKER)
 			{
-				vec[size1 + i] = m_data[pos2 + i];
+				readPosition += m_capacity - (readPosition % m_capacity);
+				header = reinterpret_cast<const RecordHeader*>(m_data.getData());
 			}
+
+			callback(reinterpret_cast<const uint8*>(header + 1),
+					 (size_t) header->size,
+					 header->sampleNumber,
+					 (int) header->extra);
+
+			readPosition += getRecordSize(header->size);
+
+			m_readPosition.store(readPosition, std::memory_order_release);
+			m_numEvents.fetch_sub(1, std::memory_order_release);
 		}
-		m_fifo.finishedRead(numToRead);
+
 		return numToRead;
 	}
 
 private:
-	std::vector<EventClassPtr> m_data;
-	AbstractFifo m_fifo;
+
+	struct RecordHeader
+	{
+		uint32 size;
+		int32 extra;
+		int64 sampleNumber;
+	};
+
+	static constexpr uint32 WRAP_MARKER = 0xFFFFFFFF;
+	static constexpr size_t RECORD_ALIGNMENT = sizeof(RecordHeader);
+
+	static size_t roundUpToRecordAlignment(size_t size)
+	{
+		return (size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+	}
+
+	static size_t getRecordSize(size_t payloadSize)
+	{
+		return sizeof(RecordHeader) + roundUpToRecordAlignment(payloadSize);
+	}
+
+	/** Reserves contiguous space for one packet and returns a pointer to its payload,
+		or nullptr if the queue is full */
+	uint8* prepareToWrite(size_t size, int64 sampleNumber, int extra)
+	{
+		const size_t recordSize = getRecordSize(size);
+		const size_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+		const size_t readPosition = m_readPosition.load(std::memory_order_acquire);
+
+		const size_t offset = writePosition % m_capacity;
+		const size_t padding = (offset + recordSize > m_capacity) ? m_capacity - offset : 0;
+		const size_t used = writePosition - readPosition;
+
+		if (recordSize > m_capacity || used + padding + recordSize > m_capacity)
+		{
+			/* This means there is a buffer overrun. Instead of overwriting the existing data and risking
+			   a collision of both threads, we drop the incoming packet and count it. */
+			m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		if (padding > 0)
+			reinterpret_cast<RecordHeader*>(m_data + offset)->size = WRAP_MARKER;
+
+		RecordHeader* header = reinterpret_cast<RecordHeader*>(m_data + ((offset + padding) % m_capacity));
+		header->size = (uint32) size;
+		header->extra = (int32) extra;
+		header->sampleNumber = sampleNumber;
+
+		m_pendingWritePosition = writePosition + padding + recordSize;
+
+		if (used + padding + recordSize > m_highWaterMark.load(std::memory_order_relaxed))
+			m_highWaterMark.store(used + padding + recordSize, std::memory_order_relaxed);
+
+		return reinterpret_cast<uint8*>(header + 1);
+	}
+
+	/** Publishes the packet reserved by prepareToWrite() */
+	void finishedWrite()
+	{
+		m_writePosition.store(m_pendingWritePosition, std::memory_order_release);
+		m_numEvents.fetch_add(1, std::memory_order_release);
+	}
+
+	HeapBlock<uint8> m_data;
+	const size_t m_capacity;
+
+	std::atomic<size_t> m_writePosition;
+	std::atomic<size_t> m_readPosition;
+	std::atomic<int> m_numEvents;
+
+	std::atomic<int64> m_droppedEvents;
+	std::atomic<size_t> m_highWaterMark;
+
+	size_t m_pendingWritePosition;
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EventQueue);
 };
-//NOTE: Events are sent as midimessages while spikes as spike objects due to the difference on how they are passed to the record node.
-//Once the probe system is implemented, this will be normalized
-typedef EventQueue<EventPacket> EventMsgQueue;
-typedef EventQueue<Spike> SpikeMsgQueue;
-typedef ReferenceCountedObjectPtr<AsyncEventMessage<EventPacket>> EventMessagePtr;
-typedef ReferenceCountedObjectPtr<AsyncEventMessage<Spike>> SpikeMessagePtr;
 
 #endif  // EVENTQUEUE_H_INCLUDED
-
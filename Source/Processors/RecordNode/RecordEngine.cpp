@@ -26,9 +26,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "EngineConfigWindow.h"
 #include "BinaryFormat/BinaryRecording.h"
+#include "BinaryFormat/CompressedRecording.h"
 
 RecordEngine::RecordEngine()
-	: manager(nullptr), recordNode(nullptr)
+	: manager(nullptr), recordNode(nullptr), sampleNumberBuffer(nullptr)
 {
 }
 
@@ -49,6 +50,19 @@ void RecordEngine::registerManager(RecordEngineManager* recordManager)
 	manager = recordManager;
 }
 
+void RecordEngine::writeEventPacket(int eventChannel, const uint8* data, size_t size)
+{
+	writeEvent(eventChannel, EventPacket(data, (int) size));
+}
+
+void RecordEngine::writeSpikePacket(int electrodeIndex, const uint8* data, size_t size)
+{
+	SpikePtr spike = Spike::deserialize(data, getSpikeChannel(electrodeIndex));
+
+	if (spike != nullptr)
+		writeSpike(electrodeIndex, spike);
+}
+
 const DataStream* RecordEngine::getDataStream(int index) const
 {
     return recordNode->dataStreams[index];
@@ -106,6 +120,16 @@ int64 RecordEngine::getLatestSampleNumber(int channel) const
 	return sampleNumbers[channel];
 }
 
+void RecordEngine::updateSampleNumberBuffer(const int64* sampleNumbers_)
+{
+	sampleNumberBuffer = sampleNumbers_;
+}
+
+const int64* RecordEngine::getSampleNumberBuffer() const
+{
+	return sampleNumberBuffer;
+}
+
 int RecordEngine::getGlobalIndex(int channel) const
 {
 	return globalChannelMap[channel];
@@ -239,7 +263,7 @@ void RecordEngineManager::addParameter(EngineParameter* param)
 
 int RecordEngineManager::getNumOfBuiltInEngines()
 {
-	return 1;
+	return 2;
 }
 
 RecordEngineManager* RecordEngineManager::createBuiltInEngineManager(int index)
@@ -249,6 +273,9 @@ RecordEngineManager* RecordEngineManager::createBuiltInEngineManager(int index)
 	case 0:
 		return BinaryRecording::getEngineManager();
 
+	case 1:
+		return CompressedRecording::getEngineManager();
+
 	default:
 		return nullptr;
 	}
@@ -270,6 +297,11 @@ RecordEngine* RecordEngineManager::instantiateEngine()
 		return new BinaryRecording();
 	}
 
+	if (id == "COMPRESSED")
+	{
+		return new CompressedRecording();
+	}
+
 	return nullptr;
 }
 
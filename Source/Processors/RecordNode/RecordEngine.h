@@ -112,6 +112,18 @@ public:
 	/** Called by configureEngine() */
 	virtual void setParameter(EngineParameter& parameter) { }
 
+	/** Write a serialized event to disk, reading it in place from the RecordThread's queue.
+		The default implementation wraps the data in an EventPacket and calls writeEvent() */
+	virtual void writeEventPacket(int eventChannel, const uint8* data, size_t size);
+
+	/** Write a serialized spike to disk, reading it in place from the RecordThread's queue.
+		The default implementation deserializes the spike and calls writeSpike() */
+	virtual void writeSpikePacket(int electrodeIndex, const uint8* data, size_t size);
+
+	/** Called by the RecordThread after each pass over the data, event and spike queues.
+		Engines that stage writes in memory can use it to flush them periodically */
+	virtual void endWriteBlock() { }
+
 	// ------------------------------------------------------------
 	//                    OTHER METHODS
 	// ------------------------------------------------------------
@@ -131,6 +143,9 @@ public:
 	/** Called at the start of every write block */
 	void updateLatestSampleNumbers(const Array<int64>& sampleNumbers, int channel = -1);
 
+	/** Called before each call to writeContinuousData() with the sample numbers of the samples being written */
+	void updateSampleNumberBuffer(const int64* sampleNumbers);
+
 protected:
 
 	// ------------------------------------------------------------
@@ -170,6 +185,10 @@ protected:
 	/** Gets the current block's first timestamp for a given recorded channel */
 	int64 getLatestSampleNumber(int channel) const;
 
+	/** Gets the sample number of every sample passed to the current writeContinuousData() call.
+		Unlike getLatestSampleNumber() + i, these include any jumps in the sample numbers. May be null. */
+	const int64* getSampleNumberBuffer() const;
+
 	/** Gets the a channel's global index from a recorded channel index */
 	int getGlobalIndex(int channel) const;
 
@@ -184,6 +203,7 @@ protected:
 private:
 
 	Array<int64> sampleNumbers;
+	const int64* sampleNumberBuffer;
 	Array<int> globalChannelMap;
     Array<int> localChannelMap;
 
@@ -20,7 +20,9 @@ EventMonitor::EventMonitor()
 	: receivedEvents(0),
 	  receivedSpikes(0),
       bufferedEvents(0),
-      bufferedSpikes(0)
+      bufferedSpikes(0),
+      droppedEvents(0),
+      droppedSpikes(0)
 {
 }
 
@@ -32,6 +34,8 @@ void EventMonitor::reset()
 	receivedSpikes = 0;
 	bufferedEvents = 0;
 	bufferedSpikes = 0;
+	droppedEvents = 0;
+	droppedSpikes = 0;
 }
 
 void EventMonitor::displayStatus()
@@ -39,6 +43,9 @@ void EventMonitor::displayStatus()
 	LOGD("Record Node received ", receivedEvents, " total EVENTS and sent ", bufferedEvents, " to the RecordThread");
 
 	LOGD("Record Node received ", receivedSpikes, " total SPIKES and sent ", bufferedSpikes, " to the RecordThread");
+
+	if (droppedEvents > 0 || droppedSpikes > 0)
+		LOGE("Record buffer overrun: dropped ", droppedEvents, " EVENTS and ", droppedSpikes, " SPIKES");
 }
 
 RecordNode::RecordNode()
@@ -61,8 +68,8 @@ RecordNode::RecordNode()
 	int bufferSize = ads.bufferSize;
 
 	dataQueue = std::make_unique<DataQueue>(bufferSize, DATA_BUFFER_NBLOCKS);
-	eventQueue = std::make_unique<EventMsgQueue>(EVENT_BUFFER_NEVENTS);
-	spikeQueue = std::make_unique<SpikeMsgQueue>(SPIKE_BUFFER_NSPIKES);
+	eventQueue = std::make_unique<EventQueue>(EVENT_BUFFER_BYTES);
+	spikeQueue = std::make_unique<EventQueue>(SPIKE_BUFFER_BYTES);
 
 	isSyncReady = true;
 
@@ -239,11 +246,8 @@ void RecordNode::handleBroadcastMessage(String msg)
 
         size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
 
-        HeapBlock<char> buffer(size);
-
-        event->serialize(buffer, size);
-
-        eventQueue->addEvent(EventPacket(buffer, size), messageSampleNumber, -1);
+        if (!eventQueue->addEvent(*event, size, messageSampleNumber, -1))
+            eventMonitor->droppedEvents++;
 
     }
 
@@ -730,6 +734,14 @@ bool RecordNode::getRecordingStatus() const
 	return isRecording;
 }
 
+float RecordNode::getRecordBufferUsage() const
+{
+	if (!isRecording || dataQueue == nullptr)
+		return 0.0f;
+
+	return dataQueue->getMaxUsage();
+}
+
 void RecordNode::setRecordEvents(bool recordEvents)
 {
 	this->recordEvents = recordEvents;
@@ -754,13 +766,12 @@ void RecordNode::handleTTLEvent(TTLEventPtr event)
 
 		size_t size = event->getChannelInfo()->getDataSize() + event->getChannelInfo()->getTotalEventMetadataSize() + EVENT_BASE_SIZE;
 
-		HeapBlock<char> buffer(size);
         event->setTimestampInSeconds(synchronizer.convertSampleNumberToTimestamp(event->getStreamId(), sampleNumber));
-		event->serialize(buffer, size);
-
-		eventQueue->addEvent(EventPacket(buffer, size), sampleNumber);
 
-		eventMonitor->bufferedEvents++;
+		if (eventQueue->addEvent(*event, size, sampleNumber))
+			eventMonitor->bufferedEvents++;
+		else
+			eventMonitor->droppedEvents++;
 
 	}
 
@@ -778,7 +789,8 @@ void RecordNode::handleEvent(const EventChannel* eventInfo, const EventPacket& p
 
         Event::setTimestampInSeconds(packet, synchronizer.convertSampleNumberToTimestamp(eventInfo->getStreamId(), sampleNumber));
 
-		eventQueue->addEvent(packet, sampleNumber, eventIndex);
+		if (!eventQueue->addEvent(packet, sampleNumber, eventIndex))
+			eventMonitor->droppedEvents++;
 
 	}
 
@@ -795,7 +807,6 @@ void RecordNode::handleSpike(SpikePtr spike)
         spike->setTimestampInSeconds(synchronizer.convertSampleNumberToTimestamp(spike->getStreamId(),
                                                                     spike->getSampleNumber()));
 		writeSpike(spike, spike->getChannelInfo());
-		eventMonitor->bufferedSpikes++;
 	}
 
 
@@ -805,7 +816,8 @@ void RecordNode::handleTimestampSyncTexts(const EventPacket& packet)
 {
     int64 sampleNumber = Event::getSampleNumber(packet);
 
-    eventQueue->addEvent(packet, sampleNumber, -1);
+    if (!eventQueue->addEvent(packet, sampleNumber, -1))
+        eventMonitor->droppedEvents++;
 }
 
 void RecordNode::process(AudioBuffer<float>& buffer)
@@ -872,14 +884,35 @@ void RecordNode::process(AudioBuffer<float>& buffer)
 
 			if (numSamples > 0)
 			{
-				double first = synchronizer.convertSampleNumberToTimestamp(streamId, sampleNumber);
-				double second = synchronizer.convertSampleNumberToTimestamp(streamId, sampleNumber + 1);
+				// write one run of timestamps per stretch of contiguous sample numbers
+				const SampleNumberGapTable& gaps = getSampleNumberGapsForBlock(streamId);
+
+				uint32 runStart = 0;
+				int64 runSampleNumber = sampleNumber;
 
-				fifoUsage[streamId] = dataQueue->writeSynchronizedTimestamps(
-					first,
-					second - first,
-					streamIndex,
-					numSamples);
+				for (int gap = 0; gap <= gaps.size(); gap++)
+				{
+					const uint32 runEnd = gap < gaps.size() ? jmin(gaps[gap].sampleIndex, numSamples) : numSamples;
+
+					if (runEnd > runStart)
+					{
+						double first = synchronizer.convertSampleNumberToTimestamp(streamId, runSampleNumber);
+						double second = synchronizer.convertSampleNumberToTimestamp(streamId, runSampleNumber + 1);
+
+						fifoUsage[streamId] = dataQueue->writeSynchronizedTimestamps(
+							first,
+							second - first,
+							streamIndex,
+							runEnd - runStart,
+							runSampleNumber);
+					}
+
+					if (gap < gaps.size())
+					{
+						runStart = runEnd;
+						runSampleNumber = gaps[gap].sampleNumber;
+					}
+				}
 
 			}
 
@@ -940,8 +973,18 @@ void RecordNode::writeSpike(const Spike *spike, const SpikeChannel *spikeElectro
 
     int electrodeIndex = getIndexOfMatchingChannel(spikeElectrode);
 
-    if (electrodeIndex >= 0)
-        spikeQueue->addEvent(*spike, spike->getSampleNumber(), electrodeIndex);
+    if (electrodeIndex < 0)
+        return;
+
+    size_t size = SPIKE_BASE_SIZE
+        + spikeElectrode->getDataSize()
+        + spikeElectrode->getTotalEventMetadataSize()
+        + spikeElectrode->getNumChannels() * sizeof(float);
+
+    if (spikeQueue->addEvent(*spike, size, spike->getSampleNumber(), electrodeIndex))
+        eventMonitor->bufferedSpikes++;
+    else
+        eventMonitor->droppedSpikes++;
 
 }
 
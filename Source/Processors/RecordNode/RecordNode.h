@@ -18,8 +18,8 @@
 
 #define WRITE_BLOCK_LENGTH		1024
 #define DATA_BUFFER_NBLOCKS		300
-#define EVENT_BUFFER_NEVENTS	200000
-#define SPIKE_BUFFER_NSPIKES	200000
+#define EVENT_BUFFER_BYTES		(16 * 1024 * 1024)
+#define SPIKE_BUFFER_BYTES		(64 * 1024 * 1024)
 
 #define NIDAQ_BIT_VOLTS			0.001221f
 #define NPX_BIT_VOLTS			0.195f
@@ -59,6 +59,12 @@ public:
 	/* Counts the total of number of events sent to the recording buffer */
 	int bufferedSpikes;
 
+	/* Counts the number of events dropped because the recording buffer was full */
+	int droppedEvents;
+
+	/* Counts the number of spikes dropped because the recording buffer was full */
+	int droppedSpikes;
+
 };
 
 /**
@@ -139,6 +145,9 @@ public:
 	/** Copies incoming data to the record buffer, if recording is active*/
 	void process(AudioBuffer<float>& buffer) override;
 
+	/** Only reads the continuous data */
+	bool isPassThrough() const override { return true; }
+
 	/** Returns a vector of available record engines*/
 	std::vector<RecordEngineManager*> getAvailableRecordEngines();
 
@@ -166,6 +175,10 @@ public:
 	/** Returns true if this Record Node is writing data*/
 	bool getRecordingStatus() const;
 
+	/** Returns how full (0-1) the recording buffer currently is, or 0 if not recording.
+		Used to apply back-pressure when the signal chain is running faster than real time. */
+	float getRecordBufferUsage() const;
+
 	/** Get the last settings.xml in string form. Since the string will be large, returns a const ref.*/
 	const String &getLastSettingsXml() const;
 
@@ -264,8 +277,8 @@ private:
 	int recordingNumber;
 
 	std::unique_ptr<DataQueue> dataQueue;
-	std::unique_ptr<EventMsgQueue> eventQueue;
-    std::unique_ptr<SpikeMsgQueue> spikeQueue;
+	std::unique_ptr<EventQueue> eventQueue;
+    std::unique_ptr<EventQueue> spikeQueue;
 
     int spikeElectrodeIndex;
 
@@ -77,7 +77,7 @@ void RecordThread::setChannelMap(const Array<int>& channels)
 
 }
 
-void RecordThread::setQueuePointers(DataQueue* data, EventMsgQueue* events, SpikeMsgQueue* spikes)
+void RecordThread::setQueuePointers(DataQueue* data, EventQueue* events, EventQueue* spikes)
 {
 	m_dataQueue = data;
 	m_eventQueue = events;
@@ -169,6 +169,9 @@ void RecordThread::writeData(const AudioBuffer<float>& dataBuffer,
 			const double* r = timestampBuffer.getReadPointer(m_timestampBufferChannelArray[chan],
 				dataBufferIdxs[chan].index1);
 
+			m_engine->updateSampleNumberBuffer(m_dataQueue->getSampleNumberReadPointer(m_timestampBufferChannelArray[chan],
+				dataBufferIdxs[chan].index1));
+
 			m_engine->writeContinuousData(
 				chan,					 // write channel (index among all recorded channels)
 				m_channelArray[chan],	 // real channel (index within processor)
@@ -205,6 +208,9 @@ void RecordThread::writeData(const AudioBuffer<float>& dataBuffer,
 
 				m_engine->updateLatestSampleNumbers(sampleNumbers, chan);
 
+				m_engine->updateSampleNumberBuffer(m_dataQueue->getSampleNumberReadPointer(m_timestampBufferChannelArray[chan],
+					dataBufferIdxs[chan].index2));
+
 				m_engine->writeContinuousData(
 					chan, 					// write channel (index among all recorded channels)
 					m_channelArray[chan],	// real channel (index within processor)
@@ -220,51 +226,39 @@ void RecordThread::writeData(const AudioBuffer<float>& dataBuffer,
 
 	m_dataQueue->stopRead();
 
-	std::vector<EventMessagePtr> events;
-	int nEvents = m_eventQueue->getEvents(events, maxEvents);
-
-	for (int ev = 0; ev < nEvents; ++ev)
+	m_eventQueue->readEvents(maxEvents, [this](const uint8* data, size_t size, int64 sampleNumber, int extra)
 	{
-
-		const MidiMessage& event = events[ev]->getData();
-
-		if (SystemEvent::getBaseType(event) == EventBase::Type::SYSTEM_EVENT)
+		if (EventBase::getBaseType(data) == EventBase::Type::SYSTEM_EVENT)
 		{
-			String syncText = SystemEvent::getSyncText(event);
+			EventPacket event(data, (int) size);
 			m_engine->writeTimestampSyncText(SystemEvent::getStreamId(event), SystemEvent::getSampleNumber(event), 0.0f, SystemEvent::getSyncText(event));
 		}
 		else
 		{
-			int processorId = EventBase::getProcessorId(event);
-			int streamId = EventBase::getStreamId(event);
-			int channelIdx = EventBase::getChannelIndex(event);
+			int processorId = EventBase::getProcessorId(data);
+			int streamId = EventBase::getStreamId(data);
+			int channelIdx = EventBase::getChannelIndex(data);
 
 			const EventChannel* chan = recordNode->getEventChannel(processorId, streamId, channelIdx);
 			int eventIndex = recordNode->getIndexOfMatchingChannel(chan);
 
-			m_engine->writeEvent(eventIndex, event);
+			m_engine->writeEventPacket(eventIndex, data, size);
 		}
-	}
+	});
 
-	std::vector<SpikeMessagePtr> spikes;
-	int nSpikes = m_spikeQueue->getEvents(spikes, BLOCK_MAX_WRITE_SPIKES);
-
-	for (int sp = 0; sp < nSpikes; ++sp)
+	m_spikeQueue->readEvents(maxSpikes, [this](const uint8* data, size_t size, int64 sampleNumber, int electrodeIndex)
 	{
-
 		spikesReceived++;
 
-		if (spikes[sp] != nullptr)
+		if (electrodeIndex >= 0)
 		{
-
-			const Spike& spike = spikes[sp]->getData();
-			const SpikeChannel* chan = spike.getChannelInfo();
-			int spikeIndex = recordNode->getIndexOfMatchingChannel(chan);
 			spikesWritten++;
 
-			m_engine->writeSpike(spikeIndex, &spikes[sp]->getData());
+			m_engine->writeSpikePacket(electrodeIndex, data, size);
 		}
-	}
+	});
+
+	m_engine->endWriteBlock();
 }
 
 
@@ -62,7 +62,7 @@ public:
 	void setTimestampChannelMap(const Array<int>& channels);
 
 	/** Sets the pointers to the 3 data queues*/
-	void setQueuePointers(DataQueue* data, EventMsgQueue* events, SpikeMsgQueue* spikes);
+	void setQueuePointers(DataQueue* data, EventQueue* events, EventQueue* spikes);
 
 	/** Runs the thread */
 	void run() override;
@@ -94,8 +94,8 @@ private:
 	Array<int> m_timestampBufferChannelArray;
 
 	DataQueue* m_dataQueue;
-	EventMsgQueue* m_eventQueue;
-	SpikeMsgQueue *m_spikeQueue;
+	EventQueue* m_eventQueue;
+	EventQueue* m_spikeQueue;
 
 	std::atomic<bool> m_receivedFirstBlock;
 	std::atomic<bool> m_cleanExit;
@@ -110,6 +110,11 @@ Array<ContinuousChannel*> DataStream::getContinuousChannels() const
 	return continuousChannels;
 }
 
+ContinuousChannel* DataStream::getContinuousChannel(int localIndex) const
+{
+	return continuousChannels[localIndex];
+}
+
 Array<EventChannel*> DataStream::getEventChannels() const
 {
 	return eventChannels;
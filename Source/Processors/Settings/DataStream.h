@@ -118,6 +118,9 @@ public:
 	/** Gets all of the continuous channels for this stream.*/
 	Array<ContinuousChannel*> getContinuousChannels() const;
 
+	/** Gets one continuous channel by its index within this stream (without copying the array).*/
+	ContinuousChannel* getContinuousChannel(int localIndex) const;
+
 	/** Gets all of the event channels for this stream.*/
 	Array<EventChannel*> getEventChannels() const;
 
@@ -32,12 +32,30 @@
 #include "../Events/Event.h"
 #include "../Settings/DataStream.h"
 
+#if JUCE_MSVC
+#include <intrin.h>
+#endif
+
+// number of TTL words per stream that can be read in one block
+#define EVENT_CODE_BUFFER_SIZE 10000
+
+// number of TTL changes collected before they are added to the event buffer
+#define TTL_BATCH_CAPACITY 4096
+
 SourceNode::SourceNode (const String& name_, DataThreadCreator dataThreadCreator)
-    : GenericProcessor      (name_)
+    : GenericProcessor      (name_),
+      ttlBatch              (TTL_BATCH_CAPACITY)
 {
+    changedSamples.malloc(EVENT_CODE_BUFFER_SIZE);
 
     setProcessorType(Plugin::Processor::SOURCE);
 
+    addBooleanParameter(Parameter::GLOBAL_SCOPE,
+                        String("adaptive_buffers"),
+                        "Resize the DataBuffers after each acquisition to fit the observed peaks",
+                        false,
+                        true);
+
     dataThread = dataThreadCreator (this);
 
     if (dataThread != nullptr)
@@ -78,6 +96,14 @@ DataThread* SourceNode::getThread() const
 	return dataThread;
 }
 
+DataBufferStats SourceNode::getBufferStats(int streamIdx) const
+{
+    if (dataThread != nullptr)
+        return dataThread->getBufferStats(streamIdx);
+
+    return DataBufferStats();
+}
+
 //This is going to be quite slow, since is reallocating everything, but it's the
 //safest way to handle a possible varying number of subprocessors
 void SourceNode::resizeBuffers()
@@ -89,11 +115,12 @@ void SourceNode::resizeBuffers()
 	if (dataThread != nullptr)
 	{
 		dataThread->resizeBuffers();
+		dataThread->applyBufferSizeHints();
 
 		for (int i = 0; i < dataStreams.size(); i++)
 		{
 			inputBuffers.add(dataThread->getBufferAddress(i));
-			eventCodeBuffers.add(new MemoryBlock(10000*sizeof(uint64)));
+			eventCodeBuffers.add(new MemoryBlock(EVENT_CODE_BUFFER_SIZE*sizeof(uint64)));
 			eventStates.add(0);
 		}
 	}
@@ -104,6 +131,11 @@ void SourceNode::initialize(bool signalChainIsLoading)
     dataThread->initialize(signalChainIsLoading);
 }
 
+bool SourceNode::canInitializeConcurrently() const
+{
+    return dataThread != nullptr && dataThread->canInitializeConcurrently();
+}
+
 
 void SourceNode::requestSignalChainUpdate()
 {
@@ -240,6 +272,9 @@ bool SourceNode::startAcquisition()
     {
         stopTimer(); // stop checking for source connection
 
+        dataThread->resetBufferStats();
+        numDroppedGaps = 0;
+
         dataThread->startAcquisition();
         return true;
     }
@@ -254,8 +289,26 @@ bool SourceNode::stopAcquisition()
 {
 
     if (dataThread != nullptr)
+    {
         dataThread->stopAcquisition();
 
+        for (int i = 0; i < dataStreams.size(); i++)
+        {
+            const DataBufferStats stats = dataThread->getBufferStats(i);
+
+            if (stats.numOverruns > 0 || stats.numDroppedSamples > 0)
+                LOGC(getName(), " stream ", i, " buffer overflowed ", stats.numOverruns, " times (",
+                     stats.numDroppedSamples, " samples dropped, peak ", stats.highWaterMark, " of ", stats.size, ")");
+        }
+
+        if (numDroppedGaps > 0)
+            LOGE(getName(), ": ", numDroppedGaps.load(), " sample number gaps did not fit in their block's table (max ",
+                 SampleNumberGapTable::MAX_GAPS, " per block); recorded sample numbers may be wrong after them");
+
+        if (bool(getParameter("adaptive_buffers")->getValue()))
+            dataThread->adaptBufferSizes();
+    }
+
     eventStates.clear();
 
     for (int i = 0; i < dataStreams.size(); i++)
@@ -298,6 +351,62 @@ void SourceNode::broadcastDataThreadMessage(String msg)
     broadcastMessage(msg);
 }
 
+/** Returns the index of the lowest set bit (the word must not be 0) */
+static inline int getLowestSetBit(uint64 word)
+{
+#if JUCE_MSVC
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return int(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+
+/** Writes the indices of the samples whose TTL word differs from the previous one
+    into changedSamples, and returns the number of such samples */
+static int findChangedSamples(const uint64* codes, int numSamples, uint64 lastCode, int* changedSamples)
+{
+    if (numSamples <= 0)
+        return 0;
+
+    int numChanged = 0;
+
+    // branchless: always write the index, only advance past it if it changed
+    changedSamples[numChanged] = 0;
+    numChanged += (codes[0] != lastCode);
+
+    int i = 1;
+
+    // most samples don't change, so check groups of them at once
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        uint64 diff = 0;
+
+        for (int j = 0; j < 8; j++)
+            diff |= codes[i + j] ^ codes[i + j - 1];
+
+        if (diff == 0)
+            continue;
+
+        for (int j = 0; j < 8; j++)
+        {
+            changedSamples[numChanged] = i + j;
+            numChanged += (codes[i + j] != codes[i + j - 1]);
+        }
+    }
+
+    for (; i < numSamples; i++)
+    {
+        changedSamples[numChanged] = i;
+        numChanged += (codes[i] != codes[i - 1]);
+    }
+
+    return numChanged;
+}
+
+
 void SourceNode::process(AudioBuffer<float>& buffer)
 {
 	int copiedChannels = 0;
@@ -310,9 +419,13 @@ void SourceNode::process(AudioBuffer<float>& buffer)
             &sampleNumber,
             &timestamp,
             static_cast<uint64*>(eventCodeBuffers[streamIdx]->getData()),
-            buffer.getNumSamples(),
+            getMaxSamplesInBlock(dataStreams[streamIdx]->getStreamId()),
             copiedChannels,
-            channelsToCopy);
+            channelsToCopy,
+            &sampleNumberGaps);
+
+        if (sampleNumberGaps.getNumDropped() > 0)
+            numDroppedGaps += sampleNumberGaps.getNumDropped();
 
         //std::cout << getNodeId() << " " << streamIdx << " " << nSamples << std::endl;
 
@@ -324,39 +437,53 @@ void SourceNode::process(AudioBuffer<float>& buffer)
 		setTimestampAndSamples(sampleNumber,
                                timestamp,
                                nSamples,
-                               dataStreams[streamIdx]->getStreamId());
+                               dataStreams[streamIdx]->getStreamId(),
+                               &sampleNumberGaps);
 
 		if (eventChannels[streamIdx])
 		{
-            int maxTTLBits = eventChannels[streamIdx]->getMaxTTLBits();
+            const int maxTTLBits = eventChannels[streamIdx]->getMaxTTLBits();
+            const uint64 lineMask = maxTTLBits >= 64 ? ~uint64(0) : (uint64(1) << maxTTLBits) - 1;
+
+            const uint64* codes = static_cast<uint64*>(eventCodeBuffers[streamIdx]->getData());
 
 			uint64 lastCode = eventStates[streamIdx];
 
-			for (int sample = 0; sample < nSamples; ++sample)
+            //Only the samples where the TTL word changed need any work
+            const int numChanged = findChangedSamples(codes,
+                                                      jmin(nSamples, EVENT_CODE_BUFFER_SIZE),
+                                                      lastCode,
+                                                      changedSamples);
+
+            ttlBatch.clear();
+
+			for (int n = 0; n < numChanged; ++n)
 			{
-				uint64 currentCode = *(static_cast<uint64*>(eventCodeBuffers[streamIdx]->getData()) + sample);
-
-				//If there has been no change to the TTL word, avoid doing anything at all here
-				if (lastCode != currentCode)
-				{
-					//Create a TTL event for each bit that has changed
-					for (uint8 c = 0; c < maxTTLBits; ++c)
-					{
-						if (((currentCode >> c) & 0x01) != ((lastCode >> c) & 0x01))
-						{
-							TTLEventPtr event = TTLEvent::createTTLEvent(eventChannels[streamIdx],
-                                sampleNumber + sample,
-                                c,
-                                (currentCode >> c) & 0x01,
-                                currentCode);
-
-							addEvent(event, sample);
-						}
-					}
-
-                    lastCode = currentCode;
-				}
+                const int sample = changedSamples[n];
+				const uint64 currentCode = codes[sample];
+
+				//Create a TTL event for each bit that has changed, lowest line first
+                uint64 changedBits = (currentCode ^ lastCode) & lineMask;
+
+                while (changedBits != 0)
+                {
+                    const int line = getLowestSetBit(changedBits);
+                    changedBits &= changedBits - 1;
+
+                    if (ttlBatch.isFull())
+                    {
+                        addTTLEvents(eventChannels[streamIdx], ttlBatch);
+                        ttlBatch.clear();
+                    }
+
+                    ttlBatch.add(sample, uint8(line), (currentCode >> line) & 0x01, currentCode);
+                }
+
+                lastCode = currentCode;
 			}
+
+            addTTLEvents(eventChannels[streamIdx], ttlBatch);
+
 			eventStates.set(streamIdx, lastCode);
 		}
 	}
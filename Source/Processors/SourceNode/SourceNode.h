@@ -89,11 +89,17 @@ public:
     /* Returns a pointer to the DataThread*/
 	DataThread* getThread() const;
 
+    /* Returns the fill statistics of the DataBuffer for a stream (by index)*/
+    DataBufferStats getBufferStats(int streamIdx) const;
+
     /* Enables editor after a connection to the data source is re-established*/
     bool tryEnablingEditor();
 
     /** Passes initialize command to the DataThread*/
     void initialize(bool signalChainIsLoading) override;
+
+    /** Returns true if the DataThread can be initialized on a background thread*/
+    bool canInitializeConcurrently() const override;
     
 private:
 
@@ -119,8 +125,18 @@ private:
     int64 sampleNumber = 0;
     double timestamp = -1.0;
 
+    /* Sample number discontinuities in the block being read */
+    SampleNumberGapTable sampleNumberGaps;
+
+    /* Gaps that did not fit in a block's table (reported when acquisition stops) */
+    std::atomic<int64> numDroppedGaps { 0 };
+
     OwnedArray<MemoryBlock> eventCodeBuffers;
 	Array<uint64> eventStates;
+
+    /* Scratch space for decoding the TTL words of a block*/
+    HeapBlock<int> changedSamples;
+    TTLEventBatch ttlBatch;
 	Array<EventChannel*> ttlChannels;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SourceNode);
@@ -527,6 +527,11 @@ void ControlPanel::startAcquisition(bool recordingShouldAlsoStart)
             recordEngines[recordSelector->getSelectedId() - 1]->toggleConfigWindow();
 
         graph->updateConnections();
+
+        audio->setPlaybackSpeed(graph->getPlaybackSpeed());
+
+        // parameter changes are applied on the audio thread from now on
+        graph->setParameterQueuesEnabled(true);
         
         if (audio->beginCallbacks()) // starts acquisition callbacks
         {
@@ -549,6 +554,10 @@ void ControlPanel::startAcquisition(bool recordingShouldAlsoStart)
             
             graph->startAcquisition(); // start data flow
         }
+        else
+        {
+            graph->setParameterQueuesEnabled(false);
+        }
     }
 }
 
@@ -562,6 +571,8 @@ void ControlPanel::stopAcquisition()
     graph->stopAcquisition();
 
     audio->endCallbacks();
+
+    graph->setParameterQueuesEnabled(false);
     
     playButton->getNormalImage()->replaceColour(Colours::yellow, defaultButtonColour);
 
@@ -599,9 +610,14 @@ void ControlPanel::updateRecordEngineList()
 	{
 		Plugin::RecordEngineInfo info;
 		info = AccessClass::getPluginManager()->getRecordEngineInfo(i);
+		EngineManagerCreator creator = AccessClass::getPluginManager()->getRecordEngineCreator(i);
+
+		if (creator == nullptr)
+			continue;
+
 		recordSelector->addItem(info.name, id++);
         LOGD("Adding Record Engine: ", info.name);
-		recordEngines.add(info.creator());
+		recordEngines.add(creator());
 	}
 
     if (selectedEngine < 1)
@@ -1070,6 +1086,7 @@ void ControlPanel::disableCallbacks()
 
         LOGD("Stopping audio.");
         audio->endCallbacks();
+        graph->setParameterQueuesEnabled(false);
         LOGD("Disabling processors.");
         
         LOGD("Updating control panel.");
@@ -31,6 +31,7 @@
 #include "../Processors/ProcessorGraph/ProcessorGraph.h"
 #include "EditorViewportActions.h"
 #include "../Processors/PluginManager/OpenEphysPlugin.h"
+#include "../Utils/Utils.h"
 
 const int BORDER_SIZE = 6;
 const int TAB_SIZE = 30;
@@ -1747,11 +1748,18 @@ const String EditorViewport::loadStateFromXml(XmlElement* xml)
     
     MouseCursor::showWaitCursor();
 
+    int64 loadStart = Time::getHighResolutionTicks();
+
     AccessClass::getProcessorList()->loadStateFromXml(xml); // load the processor list settings
     AccessClass::getUIComponent()->loadStateFromXml(xml);   // load the UI settings
 
     AccessClass::getProcessorGraph()->clearSignalChain();
 
+    // collect the updates requested while processors are created, and run them once at the end
+    AccessClass::getProcessorGraph()->deferSettingsUpdates(true);
+
+    int64 stageStart = Time::getHighResolutionTicks();
+
     loadingConfig = true; //Indicate config is being loaded into the GUI
     String description;// = " ";
     int loadOrder = 0;
@@ -1843,8 +1851,16 @@ const String EditorViewport::loadStateFromXml(XmlElement* xml)
 
     }
 
+    LOGC("Signal chain load: created ", loadOrder, " processors in ", msSince(stageStart), " ms");
+
     AccessClass::getProcessorGraph()->restoreParameters();  // loads the processor graph settings
 
+    stageStart = Time::getHighResolutionTicks();
+
+    AccessClass::getProcessorGraph()->deferSettingsUpdates(false);
+
+    LOGC("Signal chain load: updated signal chain in ", msSince(stageStart), " ms");
+
     AccessClass::getDataViewport()->loadStateFromXml(xml);
 
     String error = "Opened ";
@@ -1853,6 +1869,8 @@ const String EditorViewport::loadStateFromXml(XmlElement* xml)
     loadingConfig = false;
 
     MouseCursor::hideWaitCursor();
+
+    LOGC("Signal chain load: finished in ", msSince(loadStart), " ms");
     
     signalChainTabComponent->setScrollOffset(scrollOffset);
     
@@ -26,8 +26,13 @@
 
 #include "../Processors/Parameter/Parameter.h"
 #include "../Processors/GenericProcessor/GenericProcessor.h"
+#include "../Processors/SourceNode/SourceNode.h"
 
 #include <sstream>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include "httplib.h"
 #include "json.hpp"
 
@@ -42,6 +47,13 @@ using json = nlohmann::json;
 
 #define PORT 37497
 
+#define STATUS_CHECK_INTERVAL_MS 100
+#define DEFAULT_POLL_TIMEOUT_MS 30000
+#define MAX_POLL_TIMEOUT_MS 120000
+#define STATUS_STREAM_HEARTBEAT_MS 15000
+#define MAX_STATUS_STREAMS 4
+#define MAX_STATUS_POLLS 4
+
 
 /**
  * HTTP server thread for controlling Processor Parameters via an HTTP API. This starts an HTTP server on port 37497
@@ -55,6 +67,22 @@ using json = nlohmann::json;
  * - PUT /api/status : 
  *          sets the GUI's mode, e.g.: {"mode" : "ACQUIRE"}
  * 
+ * - GET /api/status/poll?since=<version>&timeout_ms=<ms> :
+ *          long poll: returns the mode and recording info (as in GET /api/recording) together
+ *          with a "version" number as soon as the version is greater than 'since', or
+ *          after the timeout (default 30 s) with the current state. Pass the returned
+ *          version as 'since' in the next request to wait for the next change.
+ *          At most 4 polls can wait at once; further requests get a 503.
+ * 
+ * - GET /api/status/stream :
+ *          chunked response that pushes the same JSON object, one per line, whenever
+ *          the mode or recording info changes (and every 15 s as a heartbeat)
+ * 
+ * - GET /api/status/buffers :
+ *          returns the size, current fill, high-water mark, overrun / dropped sample counts
+ *          and underrun count of the DataBuffer of every stream of every Source Node,
+ *          accumulated since acquisition last started
+ * 
  * - PUT /api/message :
  *          sends a broadcast message to all processors, e.g.: {"text" : "Message content"}
  *          only works while acquisition is active
@@ -84,6 +112,13 @@ using json = nlohmann::json;
  * - GET /api/processors/<processor_id>/streams/<stream_index>/parameters/<parameter_name>
  * - PUT /api/processors/<processor_id>/streams/<stream_index>/parameters/<parameter_name>
  * - PUT /api/processors/<processor_id>/config
+ * - PUT /api/parameters :
+ *          applies many parameter changes at once, e.g.:
+ *          {"parameters" : [{"processor" : 100, "name" : "low_cut", "value" : 300},
+ *                           {"processor" : 100, "stream" : 0, "name" : "enable", "value" : false}]}
+ *          Every change is validated before any is applied; if one fails, nothing is changed
+ *          and a 400 response lists the errors. Otherwise all changes are applied under a
+ *          single lock, followed by a single update of the affected part of the signal chain.
  * - PUT /api/processors/add
  * - PUT /api/processors/delete
  * - PUT /api/window
@@ -91,12 +126,16 @@ using json = nlohmann::json;
  * All endpoints are JSON endpoints. The PUT endpoint expects two parameters: "channel" (an integer), and "value",
  * which should have a type matching the type of the parameter.
  */
-class OpenEphysHttpServer : juce::Thread {
+class OpenEphysHttpServer : juce::Thread, juce::Timer {
 public:
 
     explicit OpenEphysHttpServer(ProcessorGraph* graph) :
         graph_(graph),
-        juce::Thread("HttpServer") {}
+        juce::Thread("HttpServer"),
+        statusVersion_(0),
+        stopping_(false),
+        activeStatusStreams_(0),
+        activeStatusPolls_(0) {}
 
     void run() override {
         
@@ -105,6 +144,113 @@ public:
             status_to_json(graph_, &ret);
             res.set_content(ret.dump(), "application/json");
             });
+
+        svr_->Get("/api/status/poll", [this](const httplib::Request& req, httplib::Response& res) {
+            uint64 since = 0;
+            int timeoutMs = DEFAULT_POLL_TIMEOUT_MS;
+
+            if (req.has_param("since"))
+                since = (uint64) jmax((int64) 0, String(req.get_param_value("since")).getLargeIntValue());
+
+            if (req.has_param("timeout_ms"))
+                timeoutMs = jlimit(0, MAX_POLL_TIMEOUT_MS, String(req.get_param_value("timeout_ms")).getIntValue());
+
+            // every waiting poll holds one of the server's worker threads
+            if (++activeStatusPolls_ > MAX_STATUS_POLLS)
+            {
+                --activeStatusPolls_;
+                res.set_content("Too many pending status polls.", "text/plain");
+                res.status = 503;
+                return;
+            }
+
+            json ret;
+
+            {
+                std::unique_lock<std::mutex> lock(statusMutex_);
+
+                statusChanged_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                    [this, since] { return statusVersion_ > since || stopping_; });
+
+                ret = statusSnapshot_;
+                ret["version"] = statusVersion_;
+            }
+
+            --activeStatusPolls_;
+
+            res.set_content(ret.dump(), "application/json");
+            });
+
+        svr_->Get("/api/status/stream", [this](const httplib::Request&, httplib::Response& res) {
+
+            // every open stream holds one of the server's worker threads
+            if (++activeStatusStreams_ > MAX_STATUS_STREAMS)
+            {
+                --activeStatusStreams_;
+                res.set_content("Too many open status streams.", "text/plain");
+                res.status = 503;
+                return;
+            }
+
+            auto lastVersion = std::make_shared<uint64>(0);
+
+            res.set_chunked_content_provider("application/x-ndjson",
+                [this, lastVersion](size_t, httplib::DataSink& sink) {
+                    std::string line;
+
+                    {
+                        std::unique_lock<std::mutex> lock(statusMutex_);
+
+                        statusChanged_.wait_for(lock, std::chrono::milliseconds(STATUS_STREAM_HEARTBEAT_MS),
+                            [this, lastVersion] { return statusVersion_ > *lastVersion || stopping_; });
+
+                        if (stopping_)
+                        {
+                            sink.done();
+                            return true;
+                        }
+
+                        json ret = statusSnapshot_;
+                        ret["version"] = statusVersion_;
+                        *lastVersion = statusVersion_;
+                        line = ret.dump() + "\n";
+                    }
+
+                    return sink.write(line.data(), line.size());
+                },
+                [this](bool) { --activeStatusStreams_; });
+            });
+
+        svr_->Get("/api/status/buffers", [this](const httplib::Request&, httplib::Response& res) {
+            std::vector<json> buffers_json;
+
+            {
+                // the signal chain (and the buffers) can only change on the message thread
+                const MessageManagerLock mml;
+
+                for (auto processor : graph_->getListOfProcessors())
+                {
+                    SourceNode* source = dynamic_cast<SourceNode*>(processor);
+
+                    if (source == nullptr)
+                        continue;
+
+                    for (int i = 0; i < source->getDataStreams().size(); i++)
+                    {
+                        json buffer_json;
+                        buffer_json["processor"] = source->getNodeId();
+                        buffer_json["stream"] = i;
+                        buffer_json["name"] = source->getDataStreams()[i]->getName().toStdString();
+                        buffer_stats_to_json(source->getBufferStats(i), &buffer_json);
+                        buffers_json.push_back(buffer_json);
+                    }
+                }
+            }
+
+            json ret;
+            ret["buffers"] = buffers_json;
+            res.set_content(ret.dump(), "application/json");
+            });
         
         svr_->Put("/api/status", [this](const httplib::Request& req, httplib::Response& res) 
         {
@@ -740,10 +886,15 @@ public:
                     return;
                 }
 
-                parameter->setNextValue(val);
-
                 json ret;
-                parameter_to_json(parameter, &ret);
+
+                {
+                    // only the message thread may queue parameter changes for the audio thread
+                    const MessageManagerLock mml;
+                    parameter->setNextValue(val);
+                    parameter_to_json(parameter, &ret);
+                }
+
                 res.set_content(ret.dump(), "application/json");
             });
         
@@ -813,13 +964,158 @@ public:
                            return;
                        }
 
-                       parameter->setNextValue(val);
-
                        json ret;
-                       parameter_to_json(parameter, &ret);
+
+                       {
+                           // only the message thread may queue parameter changes for the audio thread
+                           const MessageManagerLock mml;
+                           parameter->setNextValue(val);
+                           parameter_to_json(parameter, &ret);
+                       }
+
                        res.set_content(ret.dump(), "application/json");
                    });
 
+        svr_->Put("/api/parameters", [this](const httplib::Request& req, httplib::Response& res) {
+            
+            json request_json;
+            try {
+                request_json = json::parse(req.body);
+            }
+            catch (json::exception& e) {
+                LOGD( "Failed to parse request body." );
+                res.set_content(e.what(), "text/plain");
+                res.status = 400;
+                return;
+            }
+
+            if (!request_json.contains("parameters") || !request_json["parameters"].is_array()) {
+                res.set_content("Request must contain a 'parameters' array.", "text/plain");
+                res.status = 400;
+                return;
+            }
+
+            struct ParameterChange
+            {
+                Parameter* parameter;
+                var value;
+                json target;
+            };
+
+            std::vector<ParameterChange> changes;
+            std::vector<json> errors;
+
+            {
+                const MessageManagerLock mml;
+
+                // resolve and convert everything before changing anything
+                int index = 0;
+
+                for (const auto& entry : request_json["parameters"])
+                {
+                    std::string error;
+                    ParameterChange change { nullptr, var(), json() };
+
+                    try {
+                        if (!entry.contains("processor") || !entry.contains("name") || !entry.contains("value"))
+                        {
+                            error = "Each change must contain 'processor', 'name' and 'value'.";
+                        }
+                        else
+                        {
+                            const json& processorId = entry["processor"];
+                            auto processor = find_processor(processorId.is_number() ? std::to_string(processorId.get<int>())
+                                                                                     : processorId.get<std::string>());
+                            std::string name = entry["name"].get<std::string>();
+
+                            change.target["processor"] = processorId;
+
+                            if (processor == nullptr)
+                            {
+                                error = "Processor not found.";
+                            }
+                            else if (entry.contains("stream"))
+                            {
+                                const json& streamIndex = entry["stream"];
+                                auto stream = find_stream(processor, streamIndex.is_number() ? std::to_string(streamIndex.get<int>())
+                                                                                             : streamIndex.get<std::string>());
+                                change.target["stream"] = streamIndex;
+
+                                if (stream == nullptr)
+                                    error = "Stream not found.";
+                                else
+                                    change.parameter = find_parameter(processor, stream->getStreamId(), name);
+                            }
+                            else
+                            {
+                                change.parameter = find_parameter(processor, name);
+                            }
+
+                            if (error.empty() && change.parameter == nullptr)
+                                error = "Parameter not found.";
+
+                            if (error.empty())
+                            {
+                                change.value = json_to_var(entry["value"]);
+
+                                if (change.value.isUndefined())
+                                    error = "Value could not be converted.";
+                            }
+                        }
+                    }
+                    catch (json::exception& e) {
+                        error = e.what();
+                    }
+
+                    if (error.empty())
+                    {
+                        changes.push_back(change);
+                    }
+                    else
+                    {
+                        json error_json;
+                        error_json["index"] = index;
+                        error_json["error"] = error;
+                        errors.push_back(error_json);
+                    }
+
+                    index++;
+                }
+
+                if (errors.empty())
+                {
+                    graph_->deferSettingsUpdates(true);
+
+                    for (auto& change : changes)
+                        change.parameter->setNextValue(change.value);
+
+                    graph_->deferSettingsUpdates(false);
+                }
+            }
+
+            json ret;
+
+            if (!errors.empty())
+            {
+                ret["errors"] = errors;
+                res.set_content(ret.dump(), "application/json");
+                res.status = 400;
+                return;
+            }
+
+            std::vector<json> parameters_json;
+
+            for (auto& change : changes)
+            {
+                json parameter_json = change.target;
+                parameter_to_json(change.parameter, &parameter_json);
+                parameters_json.push_back(parameter_json);
+            }
+
+            ret["parameters"] = parameters_json;
+            res.set_content(ret.dump(), "application/json");
+            });
+
         svr_->Put("/api/window", [this](const httplib::Request& req, httplib::Response& res) {
             std::string message_str;
             LOGD( "Received PUT WINDOW request" );
@@ -889,10 +1185,23 @@ public:
         if (!svr_) {
             svr_ = std::make_unique<httplib::Server>();
         }
+
+        stopping_ = false;
+        timerCallback();
+        startTimer(STATUS_CHECK_INTERVAL_MS);
+
         startThread();
     }
 
     void stop() {
+        stopTimer();
+
+        {
+            std::lock_guard<std::mutex> lock(statusMutex_);
+            stopping_ = true;
+        }
+        statusChanged_.notify_all();
+
         if (svr_) {
             LOGC("Shutting down HTTP server");
             svr_->stop();
@@ -905,6 +1214,33 @@ private:
     MainWindow* main_;
     ProcessorGraph* graph_;
 
+    json statusSnapshot_;
+    uint64 statusVersion_;
+    bool stopping_;
+    std::mutex statusMutex_;
+    std::condition_variable statusChanged_;
+    std::atomic<int> activeStatusStreams_;
+    std::atomic<int> activeStatusPolls_;
+
+    /** Runs on the message thread; wakes up waiting clients when the status changes */
+    void timerCallback() override {
+        json snapshot;
+        status_to_json(graph_, &snapshot);
+        recording_info_to_json(graph_, &snapshot["recording"]);
+
+        {
+            std::lock_guard<std::mutex> lock(statusMutex_);
+
+            if (statusVersion_ > 0 && snapshot == statusSnapshot_)
+                return;
+
+            statusSnapshot_ = snapshot;
+            statusVersion_++;
+        }
+
+        statusChanged_.notify_all();
+    }
+
     var json_to_var(const json& value) {
         if (value.is_number_integer()) {
             return var(value.get<int>());
@@ -997,6 +1333,16 @@ private:
         }
     }
 
+    inline static void buffer_stats_to_json(const DataBufferStats& stats, json* ret)
+    {
+        (*ret)["size"] = stats.size;
+        (*ret)["samples"] = stats.numSamples;
+        (*ret)["high_water_mark"] = stats.highWaterMark;
+        (*ret)["overruns"] = stats.numOverruns;
+        (*ret)["dropped_samples"] = stats.numDroppedSamples;
+        (*ret)["underruns"] = stats.numUnderruns;
+    }
+
     inline static void parameter_to_json(Parameter* parameter, json* parameter_json)
     {
         (*parameter_json)["name"] = parameter->getName().toStdString();
@@ -9,6 +9,8 @@
 #include <string>
 #include <map>
 
+#include "../../JuceLibraryCode/JuceHeader.h"
+
 /* Log Action -- taken by user */
 #define LOGA(...) \
     OELogger::GetInstance().LOGFile("[open-ephys][action] ", __VA_ARGS__);
@@ -137,6 +139,13 @@ struct func_timer
 };
 
 
+/* Milliseconds elapsed since a Time::getHighResolutionTicks() value (for load timing) */
+inline double msSince(juce::int64 startTicks)
+{
+	return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+}
+
+
 /* Templates for getting keys and values from std::maps */
 
 // From: http://www.lonecpluspluscoder.com/2015/08/13/an-elegant-way-to-extract-keys-from-a-c-map/